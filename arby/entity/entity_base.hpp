@@ -138,6 +138,13 @@ struct entity_handle : entity_handle_base
 
     ~entity_handle() { stop_check(); }
 
+  protected:
+    implementation_type const &
+    get_implementation() const
+    {
+        return impl_;
+    }
+
   private:
     template < class... Args >
     static auto
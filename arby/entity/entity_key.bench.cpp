@@ -0,0 +1,66 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "bench/bench.hpp"
+#include "entity/entity_key.hpp"
+
+#include <string>
+#include <unordered_set>
+
+using namespace arby;
+
+namespace
+{
+entity::entity_key::map_type
+make_fields(int n)
+{
+    auto values = entity::entity_key::map_type();
+    for (int i = 0; i < n; ++i)
+        values.emplace("field" + std::to_string(i), "value" + std::to_string(i));
+    return values;
+}
+}   // namespace
+
+// interning a key whose content is already held elsewhere
+ARBY_BENCHMARK("entity_key/lock", 2, 8, 32)
+{
+    auto fields = make_fields(int(state.arg()));
+    auto held   = entity::entity_key(fields);
+    held.lock();
+    for (auto _ : state)
+    {
+        auto key = entity::entity_key(fields);
+        key.lock();
+        bench::do_not_optimize(key);
+    }
+}
+
+ARBY_BENCHMARK("entity_key/hash", 2, 8, 32)
+{
+    auto key = entity::entity_key(make_fields(int(state.arg())));
+    key.lock();
+    for (auto _ : state)
+        bench::do_not_optimize(std::hash< entity::entity_key >()(key));
+}
+
+ARBY_BENCHMARK("entity_key/unordered_find", 2, 8, 32)
+{
+    auto keys = std::unordered_set< entity::entity_key >();
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto fields = make_fields(int(state.arg()));
+        fields.emplace("id", std::to_string(i));
+        auto key = entity::entity_key(std::move(fields));
+        key.lock();
+        keys.insert(key);
+    }
+    auto probe = *keys.begin();
+    for (auto _ : state)
+        bench::do_not_optimize(keys.find(probe));
+}
@@ -13,6 +13,12 @@
 #include <fmt/ostream.h>
 #include <openssl/sha.h>
 
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+
 namespace arby
 {
 namespace entity
@@ -23,17 +29,12 @@ entity_key::entity_key(map_type values)
 {
 }
 
-std::size_t
-hash_value(const entity_key &key)
-{
-    assert(key.locked());
-    return key.impl_->cpphash;
-}
-
 namespace
 {
+static_assert(std::tuple_size_v< entity_key::sha1_type > == SHA_DIGEST_LENGTH);
+
 void
-stringify(std::string &target, unsigned char const (&digest)[SHA_DIGEST_LENGTH])
+stringify(std::string &target, entity_key::sha1_type const &digest)
 {
     target.resize(SHA_DIGEST_LENGTH * 2);
 
@@ -49,32 +50,118 @@ stringify(std::string &target, unsigned char const (&digest)[SHA_DIGEST_LENGTH])
         *out++ = to_hex(byte & 0xf);
     }
 }
+
+struct sha1_hash
+{
+    std::size_t
+    operator()(entity_key::sha1_type const &digest) const
+    {
+        // the digest is already uniformly distributed
+        std::size_t result;
+        std::memcpy(&result, digest.data(), sizeof(result));
+        return result;
+    }
+};
+
+/// The process-wide table of interned keys, indexed by sha1 digest.
+///
+/// The table does not own the keys. Each interned impl removes itself from the table when the last entity_key
+/// referring to it is destroyed.
+struct key_table
+{
+    std::shared_ptr< entity_key::impl >
+    intern(entity_key::impl candidate)
+    {
+        auto  lock  = std::unique_lock(m_);
+        auto &entry = by_sha1_[candidate.sha1];
+        if (auto existing = entry.weak.lock())
+        {
+            if (existing->values != candidate.values)
+                throw std::logic_error("entity_key: sha1 collision");
+            return existing;
+        }
+
+        auto result = std::shared_ptr< entity_key::impl >(new entity_key::impl(std::move(candidate)),
+                                                          [](entity_key::impl *p)
+                                                          {
+                                                              get().release(p);
+                                                              delete p;
+                                                          });
+        entry.raw  = result.get();
+        entry.weak = result;
+        return result;
+    }
+
+    std::shared_ptr< entity_key::impl >
+    find(entity_key::sha1_type const &digest)
+    {
+        auto lock = std::unique_lock(m_);
+        if (auto i = by_sha1_.find(digest); i != by_sha1_.end())
+            return i->second.weak.lock();
+        return nullptr;
+    }
+
+    void
+    release(entity_key::impl *p)
+    {
+        auto lock = std::unique_lock(m_);
+        // the entry may already have been replaced by a new interned instance if this one expired while another
+        // thread was locking an identical key
+        if (auto i = by_sha1_.find(p->sha1); i != by_sha1_.end() && i->second.raw == p)
+            by_sha1_.erase(i);
+    }
+
+    static key_table &
+    get()
+    {
+        // intentionally leaked so that keys held in other static objects can be safely destroyed at exit
+        static auto *const table = new key_table();
+        return *table;
+    }
+
+  private:
+    struct entry
+    {
+        entity_key::impl                 *raw = nullptr;
+        std::weak_ptr< entity_key::impl > weak;
+    };
+
+    std::mutex                                                        m_;
+    std::unordered_map< entity_key::sha1_type, entry, sha1_hash > by_sha1_;
+};
+
 }   // namespace
 
 void
 entity_key::lock()
 {
-    using boost::hash_combine;
+    assert(!locked());
 
-    assert(locked());
-    assert(impl_->cpphash == 0);
+    impl candidate = impl_.unique() ? std::move(*impl_) : impl_->clone();
+
+    candidate.cpphash = boost::hash_value(candidate.values);
 
     SHA_CTX shactx;
     SHA1_Init(&shactx);
-
-    impl_->cpphash = boost::hash_value(impl_->values);
-
-    for (auto &[k, v] : impl_->values)
+    for (auto &[k, v] : candidate.values)
     {
-        SHA1_Update(&shactx, k.data(), k.size());
-        SHA1_Update(&shactx, v.data(), v.size());
+        // include the terminators so that {"ab": "c"} and {"a": "bc"} produce different digests
+        SHA1_Update(&shactx, k.c_str(), k.size() + 1);
+        SHA1_Update(&shactx, v.c_str(), v.size() + 1);
     }
+    SHA1_Final(candidate.sha1.data(), &shactx);
+    stringify(candidate.sha1hash, candidate.sha1);
 
-    unsigned char digest[SHA_DIGEST_LENGTH];
-    SHA1_Final(digest, &shactx);
-    stringify(impl_->sha1hash, digest);
+    candidate.locked = true;
+    impl_            = key_table::get().intern(std::move(candidate));
+}
 
-    impl_->locked = true;
+std::optional< entity_key >
+entity_key::find(sha1_type const &digest)
+{
+    if (auto p = key_table::get().find(digest))
+        return entity_key(std::move(p));
+    return std::nullopt;
 }
 
 void
@@ -105,30 +192,17 @@ operator<<(std::ostream &os, const entity_key &key)
     return os;
 }
 
-bool
-entity_key::operator==(const entity_key &other) const
-{
-    assert(locked());
-    assert(other.locked());
-
-    if (impl_.get() == other.impl_.get())
-        return true;
-
-    return std::tie(impl_->cpphash, impl_->sha1hash, impl_->values) ==
-           std::tie(other.impl_->cpphash, other.impl_->sha1hash, other.impl_->values);
-}
-
 bool
 entity_key::operator<(entity_key const &other) const
 {
     assert(locked());
     assert(other.locked());
 
-    if (impl_.get() == other.impl_.get())
+    if (impl_ == other.impl_)
         return false;
 
-    return std::tie(impl_->cpphash, impl_->sha1hash, impl_->values) <
-           std::tie(other.impl_->cpphash, other.impl_->sha1hash, other.impl_->values);
+    // interned keys with equal digests are the same object, so the digest is a total order
+    return std::tie(impl_->cpphash, impl_->sha1) < std::tie(other.impl_->cpphash, other.impl_->sha1);
 }
 
 std::string const &
@@ -14,7 +14,9 @@
 
 #include <array>
 #include <cassert>
+#include <map>
 #include <memory>
+#include <optional>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -54,15 +56,27 @@ struct key_values
     std::shared_ptr< std::unordered_map< std::string, std::string > > values_;
 };
 
+/// A set of key/value pairs identifying an entity.
+///
+/// Keys are built up unlocked and then locked. Locking interns the key: every locked key with the same content shares
+/// one canonical implementation whose hash, sha1 digest and sorted fields are computed exactly once. Comparison and
+/// hashing of locked keys are therefore O(1).
 struct entity_key
 {
-    using map_type = std::map< std::string, std::string >;
+    using map_type  = std::map< std::string, std::string >;
+    using sha1_type = std::array< unsigned char, 20 >;
 
     explicit entity_key(map_type values = map_type());
 
     friend std::size_t
-    hash_value(entity_key const &key);
+    hash_value(entity_key const &key)
+    {
+        assert(key.locked());
+        return key.impl_->cpphash;
+    }
 
+    /// Lock the key, replacing its contents with the canonical interned instance.
+    /// @note the key must not be modified after it has been locked.
     void
     lock();
 
@@ -78,8 +92,19 @@ struct entity_key
     std::string const &
     sha1_digest() const;
 
+    /// Find a live locked key by its binary sha1 digest.
+    /// @return the key, or an empty optional if no such key is currently held anywhere in the program.
+    /// @note thread-safe
+    static std::optional< entity_key >
+    find(sha1_type const &digest);
+
     bool
-    operator==(entity_key const &other) const;
+    operator==(entity_key const &other) const
+    {
+        assert(locked());
+        assert(other.locked());
+        return impl_ == other.impl_;
+    }
 
     bool
     operator<(entity_key const &other) const;
@@ -97,6 +122,7 @@ struct entity_key
     {
         map_type    values;
         std::size_t cpphash = 0;
+        sha1_type   sha1    = {};
         std::string sha1hash;
         bool        locked = false;
 
@@ -109,6 +135,7 @@ struct entity_key
         impl(map_type m = map_type())
         : values(std::move(m))
         , cpphash(0)
+        , sha1()
         , sha1hash()
         , locked(false)
         {
@@ -122,9 +149,15 @@ struct entity_key
     };
 
   private:
+    explicit entity_key(std::shared_ptr< impl > interned)
+    : impl_(std::move(interned))
+    {
+    }
+
     std::shared_ptr< impl > const &
     copy_check()
     {
+        assert(!locked());
         if (!impl_.unique())
             impl_ = std::make_shared< impl >(impl_->clone());
         return impl_;
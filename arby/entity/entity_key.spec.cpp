@@ -0,0 +1,83 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+#include "entity/entity_key.hpp"
+
+#include <doctest/doctest.h>
+
+#include <unordered_set>
+
+using namespace arby;
+
+namespace
+{
+entity::entity_key
+make_key(entity::entity_key::map_type values)
+{
+    auto key = entity::entity_key(std::move(values));
+    key.lock();
+    return key;
+}
+
+entity::entity_key::sha1_type
+to_digest(std::string const &hex)
+{
+    auto result = entity::entity_key::sha1_type();
+    for (std::size_t i = 0; i < result.size(); ++i)
+        result[i] = static_cast< unsigned char >(std::stoul(hex.substr(i * 2, 2), nullptr, 16));
+    return result;
+}
+}   // namespace
+
+TEST_SUITE("entity_key")
+{
+    TEST_CASE("identical keys are interned")
+    {
+        auto k1 = make_key({ { "venue", "power_trade" }, { "market", "eth/usd" } });
+
+        auto k2 = entity::entity_key();
+        k2.set("market", "eth/usd");
+        k2.set("venue", "power_trade");
+        k2.lock();
+
+        CHECK(k1 == k2);
+        CHECK_FALSE(k1 < k2);
+        CHECK_FALSE(k2 < k1);
+        CHECK(hash_value(k1) == hash_value(k2));
+        CHECK(k1.sha1_digest() == k2.sha1_digest());
+
+        auto set = std::unordered_set< entity::entity_key >();
+        set.insert(k1);
+        CHECK(set.count(k2) == 1);
+    }
+
+    TEST_CASE("field boundaries are significant")
+    {
+        auto k1 = make_key({ { "ab", "c" } });
+        auto k2 = make_key({ { "a", "bc" } });
+        CHECK_FALSE(k1 == k2);
+        CHECK(k1.sha1_digest() != k2.sha1_digest());
+        CHECK((k1 < k2) != (k2 < k1));
+    }
+
+    TEST_CASE("lookup by sha1")
+    {
+        auto digest = entity::entity_key::sha1_type();
+        {
+            auto key = make_key({ { "venue", "reactive" }, { "sender_comp_id", "arby" } });
+            digest   = to_digest(key.sha1_digest());
+
+            auto found = entity::entity_key::find(digest);
+            REQUIRE(found.has_value());
+            CHECK(*found == key);
+        }
+
+        // the table does not keep keys alive
+        CHECK_FALSE(entity::entity_key::find(digest).has_value());
+    }
+}
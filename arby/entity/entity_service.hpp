@@ -170,6 +170,19 @@ struct entity_service
         return candidate;
     }
 
+    /// Find the live entity handle registered under a locked key.
+    /// @param key is a locked key, typically obtained from entity_key::find
+    /// @return the handle, or an empty pointer if no entity is registered under the key or it has been destroyed.
+    std::shared_ptr< entity_handle_base >
+    lookup(entity_key const &key)
+    {
+        auto &&impl = get_implementation();
+        auto   lock = std::unique_lock(impl->m_);
+        if (auto i = impl->cache_.find(key); i != impl->cache_.end())
+            return i->second.lock();
+        return nullptr;
+    }
+
     /// Add invariants to the invariants set.
     ///
     /// Ther service's invariants are system-configured serivces that entities will require in order to run.
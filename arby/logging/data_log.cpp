@@ -9,38 +9,46 @@
 
 #include "logging/data_log.hpp"
 
+#include <spdlog/spdlog.h>
+
+#include <iterator>
+#include <vector>
+
 namespace arby
 {
 namespace logging
 {
-void
-data_log::impl::do_send(std::shared_ptr< impl > self, error_code ec, std::string s)
-{
-    assert(asioex::on_correct_thread(self->get_executor()));
-    if (!self->channel_.try_send(ec, std::move(s)))
-        self->channel_.async_send(ec, std::move(s), [self](error_code) {});
-}
-
 asio::awaitable< void >
 data_log::impl::run()
 {
-    error_code  ec;
-    std::string current_line;
-    auto        handle_immediate = [&](error_code ec1, std::string s1)
-    {
-        ec           = ec1;
-        current_line = std::move(s1);
-    };
+    constexpr std::size_t max_batch = 64;
+
+    error_code                        ec;
+    std::uint64_t                     reported = 0;
+    std::vector< std::string >        lines;
+    std::vector< asio::const_buffer > buffers;
 
     for (;;)
     {
-        if (!channel_.try_receive(handle_immediate))
-            current_line = co_await channel_.async_receive(asio::redirect_error(asio::use_awaitable, ec));
+        co_await channel_.async_wait(asio::redirect_error(asio::use_awaitable, ec));
         if (ec)
             break;
 
-        current_line += '\n';
-        co_await asio::async_write(stream_, asio::buffer(current_line), asio::redirect_error(asio::use_awaitable, ec));
+        lines.clear();
+        channel_.try_receive_n(std::back_inserter(lines), max_batch);
+        if (auto total = dropped(); total != reported)
+        {
+            spdlog::warn("data_log::impl::{} - {} lines dropped", __func__, total - reported);
+            reported = total;
+        }
+
+        buffers.clear();
+        for (auto &line : lines)
+        {
+            buffers.push_back(asio::buffer(line));
+            buffers.push_back(asio::buffer("\n", 1));
+        }
+        co_await asio::async_write(stream_, buffers, asio::redirect_error(asio::use_awaitable, ec));
         if (ec)
         {
             // spdlog::
@@ -59,17 +67,24 @@ data_log::impl::get_executor() const
 void
 data_log::impl::send(std::string s)
 {
-    dispatch(bind_executor(get_executor(), std::bind(impl::do_send, shared_from_this(), error_code(), std::move(s))));
+    channel_.try_send(std::move(s));
 }
+
 void
 data_log::impl::stop()
 {
-    dispatch(bind_executor(get_executor(), std::bind(impl::do_send, shared_from_this(), asio::error::eof, std::string())));
+    channel_.close();
 }
+
+std::uint64_t
+data_log::impl::dropped() const
+{
+    return channel_.rejected();
+}
+
 data_log::impl::impl(asio::any_io_executor exec, const fs::path &path)
 : exec_(exec)
 , stream_(exec, ::open(path.c_str(), O_CREAT | O_WRONLY | O_APPEND | O_TRUNC, S_IRUSR | S_IWUSR))
-, channel_(exec, 1024)
 {
 }
 
@@ -82,7 +97,7 @@ data_log::data_log(asio::any_io_executor exec, const boost::filesystem::path &pa
 data_log::~data_log()
 {
     if (impl_)
-        dispatch(bind_executor(impl_->get_executor(), std::bind(&impl::stop, impl_)));
+        impl_->stop();
 }
 void
 data_log::send(std::string s)
@@ -90,4 +105,4 @@ data_log::send(std::string s)
     impl_->send(std::move(s));
 }
 }   // namespace logging
-}   // namespace arby
\ No newline at end of file
+}   // namespace arby
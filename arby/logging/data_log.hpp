@@ -13,6 +13,7 @@
 #include "asioex/helpers.hpp"
 #include "config/asio.hpp"
 #include "config/filesystem.hpp"
+#include "util/lockfree_channel.hpp"
 
 namespace arby
 {
@@ -20,8 +21,13 @@ namespace logging
 {
 
 /// @brief Logs data to a file asynchronously
+///
+/// Lines may be sent from any thread. They are queued without locking and written in batches. If the writer falls
+/// behind by more than queue_capacity lines, further lines are dropped and counted.
 struct data_log
 {
+    static constexpr std::size_t queue_capacity = 1024;
+
     struct impl : std::enable_shared_from_this< impl >
     {
         impl(asio::any_io_executor exec, fs::path const &path);
@@ -38,14 +44,14 @@ struct data_log
         asio::any_io_executor const &
         get_executor() const;
 
-      private:
-        static void
-        do_send(std::shared_ptr< impl > self, error_code ec, std::string s);
+        /// @brief The number of lines dropped because the queue was full.
+        std::uint64_t
+        dropped() const;
 
       private:
-        asio::any_io_executor                                        exec_;
-        asio::posix::stream_descriptor                               stream_;
-        asio::experimental::channel< void(error_code, std::string) > channel_;
+        asio::any_io_executor             exec_;
+        asio::posix::stream_descriptor    stream_;
+        util::mpsc_channel< std::string > channel_ { queue_capacity };
     };
 
     data_log(asio::any_io_executor exec, boost::filesystem::path const &path);
@@ -9,19 +9,24 @@
 
 #include "asioex/async_semaphore.hpp"
 #include "asioex/scoped_interrupt.hpp"
+#include "config/signals.hpp"
 #include "config/websocket.hpp"
 #include "power_trade/connector.hpp"
 #include "power_trade/event_listener.hpp"
 #include "power_trade/native_symbol.hpp"
-#include "power_trade/orderbook_listener_impl.hpp"
+#include "power_trade/orderbook_listener.hpp"
 #include "power_trade/tick_logger.hpp"
 #include "reactive/fix_connector.hpp"
 #include "ssl_context.hpp"
+#include "trading/fast_clock.hpp"
 #include "trading/market_key.hpp"
 #include "util/monitor.hpp"
 #include "web/entity_detail_app.hpp"
 #include "web/entity_summary_app.hpp"
 #include "web/http_server.hpp"
+#include "web/instruments_app.hpp"
+#include "web/monitor_app.hpp"
+#include "web/tick_store_app.hpp"
 
 #include <boost/asio.hpp>
 #include <boost/asio/experimental/awaitable_operators.hpp>
@@ -72,7 +77,8 @@ set_up_stdin()
 asio::awaitable< void >
 monitor_quit(asio::cancellation_signal &sig, power_trade::connector &conn)
 {
-    auto sentinel = util::monitor::record("monitor_quit");
+    static const auto probe    = util::monitor::register_probe("monitor_quit");
+    auto              sentinel = util::monitor::record(probe);
     using asio::redirect_error;
     using asio::use_awaitable;
 
@@ -105,7 +111,8 @@ monitor_quit(asio::cancellation_signal &sig, power_trade::connector &conn)
 asio::awaitable< void >
 monitor_keys(std::unordered_map< char, sigs::signal< void() > > &signals)
 {
-    auto sentinel = util::monitor::record(__func__);
+    static const auto probe    = util::monitor::register_probe("monitor_keys");
+    auto              sentinel = util::monitor::record(probe);
     using asio::redirect_error;
     using asio::use_awaitable;
 
@@ -127,18 +134,22 @@ monitor_keys(std::unordered_map< char, sigs::signal< void() > > &signals)
 }
 
 asio::awaitable< void >
-check(ssl::context &sslctx)
+check(ssl::context &sslctx, asio::any_io_executor disk)
 {
     using asio::use_awaitable;
     using namespace std::literals;
 
-    auto sentinel  = util::monitor::record("check");
-    auto this_exec = co_await asio::this_coro::executor;
+    static const auto probe     = util::monitor::register_probe("check");
+    auto              sentinel  = util::monitor::record(probe);
+    auto              this_exec = co_await asio::this_coro::executor;
 
     auto                                               stop_monitor = asio::cancellation_signal();
     std::unordered_map< char, sigs::signal< void() > > key_signals;
     sigs::scoped_connection                            qcon0 = key_signals['q'].connect([&] { asioex::terminate(stop_monitor); });
 
+    // keeps hot-path timestamps in step with the wall clock
+    auto calibrator = trading::fast_clock_calibrator(this_exec);
+
     auto                         svc = entity::entity_service();
     reactive::fix_connector_args reactive_args { .sender_comp_id      = "POWERTRADE_MD_1",
                                                  .target_comp_id      = "SWITCHBOARD_DEMO",
@@ -157,10 +168,16 @@ check(ssl::context &sslctx)
                                        .use_ssl             = true });
     auto rcon = key_signals['r'].connect([&] { reactive.reset(); });
 
+    auto tick_store_root = std::filesystem::temp_directory_path() / "arby-ticks";
+
     auto http_server = web::http_server(this_exec);
     http_server.serve("localhost", "8080");
     http_server.add_app("^/entities/?$", web::http_app::create< web::entity_summary_app >());
     http_server.add_app("^/entities/([0123456789abcdef]{40})(?:.([0-9]+))?/?$", web::http_app::create< web::entity_detail_app >());
+    http_server.add_app("^/monitor/?$", web::http_app::create< web::monitor_app >());
+    http_server.add_app("^/instruments/?$", web::http_app::create< web::instruments_app >());
+    http_server.add_app("^/ticks/([a-z0-9]+)-([a-z0-9]+)/([0-9]+)/(?:([0-9]+)|book)/?$",
+                        web::http_app::create< web::tick_store_app >(tick_store_root, disk));
 
     sigs::scoped_connection qcon1 = key_signals['q'].connect([&] { http_server.shutdown(); });
 
@@ -168,12 +185,16 @@ check(ssl::context &sslctx)
     auto watch1  = std::make_unique< power_trade::event_listener >(con, "heartbeat");
     auto eth_log = std::make_unique< power_trade::tick_logger >(con, "ETH-USD", fs::temp_directory_path() / "eth-usd.txt");
 
-    auto                    watch2 = power_trade::orderbook_listener_impl::create(this_exec, con, trading::spot_key("eth/usd"));
-    sigs::scoped_connection w2con;
-    std::shared_ptr< power_trade::orderbook_snapshot const > snap;
-    std::tie(w2con, snap) = watch2->subscribe([](std::shared_ptr< power_trade::orderbook_snapshot const > snap)
-                                              { spdlog::info("*** snapshot *** {}", snap); });
-    spdlog::info("*** snapshot *** {}", snap);
+    // the book subscribes to the venue while something holds it, and unsubscribes once it has been idle a while
+    auto watch2 = power_trade::orderbook_listener::require(this_exec, con, trading::spot_key("eth/usd"));
+    // restart warm from the last checkpoint, and keep it fresh. Disk writes are kept off the io loop.
+    watch2->checkpoint(std::filesystem::temp_directory_path() / "eth-usd.book", 10s, disk);
+    watch2->record(tick_store_root, disk);
+    // the log line formats the whole book: let it run behind the book rather than stall it
+    auto w2sub = watch2->subscribe(this_exec,
+                                   util::delivery_policy::latest_only,
+                                   [](std::shared_ptr< power_trade::orderbook_snapshot const > snap)
+                                   { spdlog::info("*** snapshot *** {}", snap); });
     //    auto watch3         = power_trade::orderbook_listener_impl::create(this_exec, con, trading::spot_key("btc-usd"));
     //    auto [w3con, snap3] = watch3->subscribe([](std::shared_ptr< power_trade::orderbook_snapshot const > snap)
     //                                            { spdlog::info("*** snapshot *** {}", snap); });
@@ -219,7 +240,7 @@ main(int argc, char **argv)
     try
     {
         //        co_spawn(ioc, watch(), detached);
-        co_spawn(ioc, check(sslctx), detached);
+        co_spawn(ioc, check(sslctx, threadpool.get_executor()), detached);
         ioc.run();
         threadpool.join();
     }
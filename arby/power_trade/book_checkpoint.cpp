@@ -0,0 +1,374 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "book_checkpoint.hpp"
+
+#include <fmt/format.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+namespace arby::power_trade
+{
+namespace
+{
+    template < class Ladder >
+    void
+    encode_side(std::vector< char > &out, Ladder const &ladder, trading::side_type side)
+    {
+        for (auto &[price, level] : ladder)
+        {
+            auto encoded_price = to_checkpoint_decimal(price);
+            for (auto &order : level.orders)
+            {
+                if (order.orderid.size() > checkpoint_order::max_order_id)
+                    throw std::invalid_argument(fmt::format("checkpoint: order id too long: {}", order.orderid));
+
+                auto rec            = checkpoint_order();
+                rec.price           = encoded_price;
+                rec.qty             = to_checkpoint_decimal(order.qty);
+                rec.side            = std::uint8_t(side);
+                rec.order_id_length = std::uint8_t(order.orderid.size());
+                std::memset(rec.order_id, 0, sizeof(rec.order_id));
+                std::memcpy(rec.order_id, order.orderid.data(), order.orderid.size());
+
+                auto p = reinterpret_cast< char const * >(&rec);
+                out.insert(out.end(), p, p + sizeof(rec));
+            }
+        }
+    }
+
+    /// FNV-1a
+    std::uint64_t
+    checksum(std::span< char const > data, std::uint64_t h = 0xcbf29ce484222325ull)
+    {
+        for (auto c : data)
+        {
+            h ^= std::uint8_t(c);
+            h *= 0x100000001b3ull;
+        }
+        return h;
+    }
+
+    std::uint64_t
+    checksum(checkpoint_header header, std::span< char const > records)
+    {
+        header.checksum = 0;
+        auto h          = checksum(std::span(reinterpret_cast< char const * >(&header), sizeof(header)));
+        return checksum(records, h);
+    }
+
+    std::int64_t
+    to_ns(trading::timestamp_type t)
+    {
+        return std::chrono::duration_cast< std::chrono::nanoseconds >(t.time_since_epoch()).count();
+    }
+
+    [[noreturn]] void
+    throw_errno(std::string const &what)
+    {
+        throw std::system_error(errno, std::system_category(), what);
+    }
+}   // namespace
+
+checkpoint_decimal
+to_checkpoint_decimal(trading::price_type const &value)
+{
+    // the shortest exact representation, e.g. "1234.5", "-0.001" or "1e-08"
+    auto text     = value.str();
+    auto result   = checkpoint_decimal { 0, 0, 0 };
+    auto negative = false;
+    auto digits   = 0;
+    auto zeros    = 0;
+    auto pos      = std::size_t(0);
+    auto overflow = [&] { throw std::invalid_argument(fmt::format("checkpoint: {} does not fit a decimal", text)); };
+
+    if (pos < text.size() && text[pos] == '-')
+    {
+        negative = true;
+        ++pos;
+    }
+    auto in_fraction = false;
+    for (; pos < text.size() && text[pos] != 'e'; ++pos)
+    {
+        auto c = text[pos];
+        if (c == '.')
+        {
+            in_fraction = true;
+            continue;
+        }
+        if (c < '0' || c > '9')
+            overflow();
+        if (result.mantissa == 0 && c == '0')
+        {
+            // leading zeros carry no digits
+            if (in_fraction)
+                --result.exponent;
+            continue;
+        }
+        if (in_fraction)
+            --result.exponent;
+        if (c == '0')
+        {
+            // trailing zeros belong in the exponent, so they are only taken into the mantissa once a digit follows
+            ++zeros;
+            continue;
+        }
+        digits += zeros + 1;
+        if (digits > 18)
+            overflow();
+        for (; zeros; --zeros)
+            result.mantissa *= 10;
+        result.mantissa = result.mantissa * 10 + (c - '0');
+    }
+    result.exponent += zeros;
+    if (pos < text.size())
+        result.exponent += std::stoi(text.substr(pos + 1));
+
+    if (result.mantissa == 0)
+        return checkpoint_decimal { 0, 0, 0 };
+    if (negative)
+        result.mantissa = -result.mantissa;
+    return result;
+}
+
+trading::price_type
+from_checkpoint_decimal(checkpoint_decimal const &d)
+{
+    if (d.exponent == 0)
+        return trading::price_type(d.mantissa);
+    return trading::price_type(fmt::format("{}e{}", d.mantissa, d.exponent));
+}
+
+std::vector< char >
+encode_checkpoint(std::string_view market, order_book const &book, std::uint64_t generation, std::uint64_t sequence)
+{
+    if (market.size() >= checkpoint_header::max_market)
+        throw std::invalid_argument(fmt::format("checkpoint: market name too long: {}", market));
+
+    auto header = checkpoint_header();
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, checkpoint_header::expected_magic, sizeof(header.magic));
+    header.version          = checkpoint_header::current_version;
+    header.record_size      = sizeof(checkpoint_order);
+    header.generation       = generation;
+    header.sequence         = sequence;
+    header.upstream_time_ns = to_ns(book.last_update_);
+    header.written_time_ns  = to_ns(std::chrono::system_clock::now());
+    std::memcpy(header.market, market.data(), market.size());
+
+    auto out = std::vector< char >(sizeof(header));
+    out.reserve(sizeof(header) + (book.bid_cache_.size() + book.offer_cache_.size()) * sizeof(checkpoint_order));
+    encode_side(out, book.bids_, trading::buy);
+    header.bid_count = (out.size() - sizeof(header)) / sizeof(checkpoint_order);
+    encode_side(out, book.offers_, trading::sell);
+    header.offer_count = (out.size() - sizeof(header)) / sizeof(checkpoint_order) - header.bid_count;
+
+    auto records = std::span< char const >(out).subspan(sizeof(header));
+    header.checksum = checksum(header, records);
+    std::memcpy(out.data(), &header, sizeof(header));
+    return out;
+}
+
+void
+write_file_atomically(std::filesystem::path const &path, std::span< char const > data)
+{
+    auto tmp = path;
+    tmp += ".tmp";
+
+    auto fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd < 0)
+        throw_errno(fmt::format("open {}", tmp.string()));
+
+    auto fail = [&](std::string const &what)
+    {
+        auto ec = errno;
+        ::close(fd);
+        ::unlink(tmp.c_str());
+        errno = ec;
+        throw_errno(fmt::format("{} {}", what, tmp.string()));
+    };
+
+    while (!data.empty())
+    {
+        auto n = ::write(fd, data.data(), data.size());
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            fail("write");
+        }
+        data = data.subspan(std::size_t(n));
+    }
+    if (::fsync(fd) < 0)
+        fail("fsync");
+    if (::close(fd) < 0)
+    {
+        ::unlink(tmp.c_str());
+        throw_errno(fmt::format("close {}", tmp.string()));
+    }
+
+    if (::rename(tmp.c_str(), path.c_str()) < 0)
+    {
+        auto ec = errno;
+        ::unlink(tmp.c_str());
+        errno = ec;
+        throw_errno(fmt::format("rename {}", path.string()));
+    }
+
+    // make the rename itself durable
+    auto dir = path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+    if (auto dfd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC); dfd >= 0)
+    {
+        ::fsync(dfd);
+        ::close(dfd);
+    }
+}
+
+std::optional< mapped_checkpoint >
+mapped_checkpoint::open(std::filesystem::path const &path)
+{
+    auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        if (errno == ENOENT)
+            return std::nullopt;
+        throw_errno(fmt::format("open {}", path.string()));
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) < 0)
+    {
+        auto ec = errno;
+        ::close(fd);
+        errno = ec;
+        throw_errno(fmt::format("stat {}", path.string()));
+    }
+
+    auto size = std::size_t(st.st_size);
+    if (size < sizeof(checkpoint_header))
+    {
+        ::close(fd);
+        throw std::runtime_error(fmt::format("checkpoint {} is truncated", path.string()));
+    }
+
+    auto p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+        throw_errno(fmt::format("mmap {}", path.string()));
+
+    auto result = mapped_checkpoint(p, size);
+    auto &h     = result.header();
+    auto  error = [&](std::string_view what)
+    { throw std::runtime_error(fmt::format("checkpoint {}: {}", path.string(), what)); };
+
+    if (std::memcmp(h.magic, checkpoint_header::expected_magic, sizeof(h.magic)) != 0)
+        error("not a checkpoint file");
+    if (h.version != checkpoint_header::current_version || h.record_size != sizeof(checkpoint_order))
+        error(fmt::format("unsupported version {}", h.version));
+    if (size != sizeof(checkpoint_header) + (h.bid_count + h.offer_count) * sizeof(checkpoint_order))
+        error("truncated");
+    if (checksum(h, std::span(static_cast< char const * >(p) + sizeof(checkpoint_header), size - sizeof(checkpoint_header))) !=
+        h.checksum)
+        error("checksum mismatch");
+    if (std::find(h.market, h.market + checkpoint_header::max_market, '\0') == h.market + checkpoint_header::max_market)
+        error("malformed market");
+
+    return result;
+}
+
+mapped_checkpoint::mapped_checkpoint(mapped_checkpoint &&other) noexcept
+: data_(std::exchange(other.data_, nullptr))
+, size_(std::exchange(other.size_, 0))
+{
+}
+
+mapped_checkpoint &
+mapped_checkpoint::operator=(mapped_checkpoint &&other) noexcept
+{
+    if (this != &other)
+    {
+        if (data_)
+            ::munmap(const_cast< void * >(data_), size_);
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+mapped_checkpoint::~mapped_checkpoint()
+{
+    if (data_)
+        ::munmap(const_cast< void * >(data_), size_);
+}
+
+std::string_view
+mapped_checkpoint::market() const
+{
+    return std::string_view(header().market);
+}
+
+std::span< checkpoint_order const >
+mapped_checkpoint::records() const
+{
+    auto first = reinterpret_cast< checkpoint_order const * >(static_cast< char const * >(data_) + sizeof(checkpoint_header));
+    return std::span(first, header().bid_count + header().offer_count);
+}
+
+std::span< checkpoint_order const >
+mapped_checkpoint::bids() const
+{
+    return records().first(header().bid_count);
+}
+
+std::span< checkpoint_order const >
+mapped_checkpoint::offers() const
+{
+    return records().subspan(header().bid_count);
+}
+
+trading::timestamp_type
+mapped_checkpoint::upstream_time() const
+{
+    return trading::timestamp_type(
+        std::chrono::duration_cast< trading::timestamp_type::duration >(std::chrono::nanoseconds(header().upstream_time_ns)));
+}
+
+tick_record::snapshot
+mapped_checkpoint::to_snapshot() const
+{
+    auto result = tick_record::snapshot();
+    auto ts     = upstream_time();
+    auto decode = [ts](checkpoint_order const &rec, trading::side_type side)
+    {
+        return tick_record::add { .order_id  = std::string(rec.order_id, rec.order_id_length),
+                                  .price     = from_checkpoint_decimal(rec.price),
+                                  .qty       = from_checkpoint_decimal(rec.qty),
+                                  .timestamp = ts,
+                                  .side      = side };
+    };
+
+    result.bids.reserve(bids().size());
+    for (auto &rec : bids())
+        result.bids.push_back(decode(rec, trading::buy));
+    result.offers.reserve(offers().size());
+    for (auto &rec : offers())
+        result.offers.push_back(decode(rec, trading::sell));
+    return result;
+}
+
+}   // namespace arby::power_trade
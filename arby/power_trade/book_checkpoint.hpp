@@ -0,0 +1,147 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_ARBY_POWER_TRADE_BOOK_CHECKPOINT_HPP
+#define ARBY_ARBY_POWER_TRADE_BOOK_CHECKPOINT_HPP
+
+#include "power_trade/order_book.hpp"
+#include "power_trade/tick_record.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace arby::power_trade
+{
+
+/// @brief A decimal value stored as mantissa * 10^exponent.
+struct checkpoint_decimal
+{
+    std::int64_t mantissa;
+    std::int32_t exponent;
+    std::int32_t reserved;
+};
+
+/// @brief The exact decimal form of a price or quantity.
+/// @throws std::invalid_argument if the value has more than 18 significant digits
+checkpoint_decimal
+to_checkpoint_decimal(trading::price_type const &value);
+
+trading::price_type
+from_checkpoint_decimal(checkpoint_decimal const &d);
+
+/// @brief One order of a book in a checkpoint file.
+struct checkpoint_order
+{
+    static constexpr std::size_t max_order_id = 62;
+
+    checkpoint_decimal price;
+    checkpoint_decimal qty;
+    std::uint8_t       side;
+    std::uint8_t       order_id_length;
+    char               order_id[max_order_id];
+};
+
+/// @brief The start of a checkpoint file. It is followed by the bids, best first, then the offers, best first.
+/// Within a level, orders are in queue order.
+struct checkpoint_header
+{
+    static constexpr char          expected_magic[8] = { 'A', 'R', 'B', 'Y', 'B', 'O', 'O', 'K' };
+    static constexpr std::uint32_t current_version   = 1;
+    static constexpr std::size_t   max_market        = 40;
+
+    char          magic[8];
+    std::uint32_t version;
+    std::uint32_t record_size;
+    std::uint64_t generation;
+    std::uint64_t sequence;
+    std::int64_t  upstream_time_ns;
+    std::int64_t  written_time_ns;
+    std::uint64_t bid_count;
+    std::uint64_t offer_count;
+    std::uint64_t checksum;
+    char          market[max_market];
+};
+
+static_assert(std::is_trivially_copyable_v< checkpoint_order > && std::is_standard_layout_v< checkpoint_order >);
+static_assert(std::is_trivially_copyable_v< checkpoint_header > && std::is_standard_layout_v< checkpoint_header >);
+static_assert(sizeof(checkpoint_header) % alignof(checkpoint_order) == 0);
+
+/// @brief Serialise a book into the bytes of a checkpoint file.
+/// @throws std::invalid_argument if an order id or a decimal value does not fit its field
+std::vector< char >
+encode_checkpoint(std::string_view market, order_book const &book, std::uint64_t generation, std::uint64_t sequence);
+
+/// @brief Replace a file so that a reader sees either the old content or the new, even across a crash.
+///
+/// The data are written to a temporary file alongside, which is flushed to disk and renamed over the target.
+/// @throws std::system_error on failure, in which case the target is unchanged
+void
+write_file_atomically(std::filesystem::path const &path, std::span< char const > data);
+
+/// @brief A read-only view of a checkpoint file, mapped into memory.
+struct mapped_checkpoint
+{
+    /// @brief Map and validate a checkpoint file.
+    /// @return the mapping, or nothing if the file does not exist
+    /// @throws std::runtime_error if the file is truncated, corrupt or of another version
+    static std::optional< mapped_checkpoint >
+    open(std::filesystem::path const &path);
+
+    mapped_checkpoint(mapped_checkpoint &&other) noexcept;
+
+    mapped_checkpoint &
+    operator=(mapped_checkpoint &&other) noexcept;
+
+    ~mapped_checkpoint();
+
+    checkpoint_header const &
+    header() const
+    {
+        return *static_cast< checkpoint_header const * >(data_);
+    }
+
+    std::string_view
+    market() const;
+
+    std::span< checkpoint_order const >
+    bids() const;
+
+    std::span< checkpoint_order const >
+    offers() const;
+
+    trading::timestamp_type
+    upstream_time() const;
+
+    /// @brief The book as an exchange snapshot, for order_book::load. Each order carries the upstream time.
+    tick_record::snapshot
+    to_snapshot() const;
+
+  private:
+    mapped_checkpoint(void const *data, std::size_t size)
+    : data_(data)
+    , size_(size)
+    {
+    }
+
+    std::span< checkpoint_order const >
+    records() const;
+
+    void const *data_;
+    std::size_t size_;
+};
+
+}   // namespace arby::power_trade
+
+#endif   // ARBY_ARBY_POWER_TRADE_BOOK_CHECKPOINT_HPP
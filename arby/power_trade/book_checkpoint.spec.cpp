@@ -0,0 +1,143 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+#include "power_trade/book_checkpoint.hpp"
+
+#include <doctest/doctest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace arby;
+
+namespace
+{
+power_trade::tick_record::add
+make_add(std::string orderid, trading::side_type side, std::string const &price, std::string const &qty)
+{
+    return power_trade::tick_record::add { .order_id  = std::move(orderid),
+                                           .price     = trading::price_type(price),
+                                           .qty       = trading::qty_type(qty),
+                                           .timestamp = std::chrono::system_clock::time_point(std::chrono::seconds(1650000000)),
+                                           .side      = side };
+}
+
+power_trade::order_book
+make_book()
+{
+    auto book = power_trade::order_book();
+    book.add(make_add("b1", trading::buy, "2999.5", "1.25"));
+    book.add(make_add("b2", trading::buy, "2999.5", "0.001"));
+    book.add(make_add("b3", trading::buy, "2998", "100"));
+    book.add(make_add("o1", trading::sell, "3000.25", "0.00000001"));
+    book.add(make_add("o2", trading::sell, "3010", "12345.678"));
+    return book;
+}
+
+struct temp_path
+{
+    temp_path()
+    : path(std::filesystem::temp_directory_path() /
+           ("arby-checkpoint-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count())))
+    {
+    }
+
+    ~temp_path()
+    {
+        std::filesystem::remove(path);
+    }
+
+    std::filesystem::path path;
+};
+}   // namespace
+
+TEST_SUITE("power_trade")
+{
+    TEST_CASE("power_trade::book_checkpoint")
+    {
+        auto book = make_book();
+        auto file = temp_path();
+
+        power_trade::write_file_atomically(file.path, power_trade::encode_checkpoint("eth/usd", book, 3, 42));
+
+        SUBCASE("round trip")
+        {
+            auto cp = power_trade::mapped_checkpoint::open(file.path);
+            REQUIRE(cp);
+            CHECK(cp->market() == "eth/usd");
+            CHECK(cp->header().generation == 3);
+            CHECK(cp->header().sequence == 42);
+            CHECK(cp->bids().size() == 3);
+            CHECK(cp->offers().size() == 2);
+            CHECK(cp->upstream_time() == book.last_update_);
+
+            auto restored = power_trade::order_book();
+            restored.load(cp->to_snapshot());
+            CHECK(restored == book);
+        }
+
+        SUBCASE("rewrite replaces the file")
+        {
+            book.add(make_add("b4", trading::buy, "2997", "1"));
+            power_trade::write_file_atomically(file.path, power_trade::encode_checkpoint("eth/usd", book, 4, 43));
+            auto cp = power_trade::mapped_checkpoint::open(file.path);
+            REQUIRE(cp);
+            CHECK(cp->header().generation == 4);
+            CHECK(cp->bids().size() == 4);
+            CHECK(!std::filesystem::exists(file.path.string() + ".tmp"));
+        }
+
+        SUBCASE("corruption is detected")
+        {
+            {
+                auto f = std::fstream(file.path, std::ios::in | std::ios::out | std::ios::binary);
+                f.seekp(sizeof(power_trade::checkpoint_header) + 3);
+                f.put('\x7f');
+            }
+            CHECK_THROWS_AS(power_trade::mapped_checkpoint::open(file.path), std::runtime_error);
+        }
+
+        SUBCASE("truncation is detected")
+        {
+            std::filesystem::resize_file(file.path, std::filesystem::file_size(file.path) - 1);
+            CHECK_THROWS_AS(power_trade::mapped_checkpoint::open(file.path), std::runtime_error);
+        }
+
+        SUBCASE("a missing file is not an error")
+        {
+            std::filesystem::remove(file.path);
+            CHECK(!power_trade::mapped_checkpoint::open(file.path));
+        }
+    }
+
+    TEST_CASE("power_trade::checkpoint_decimal")
+    {
+        auto round_trip = [](char const *text)
+        {
+            auto value = trading::price_type(text);
+            return power_trade::from_checkpoint_decimal(power_trade::to_checkpoint_decimal(value)) == value;
+        };
+
+        auto d = power_trade::to_checkpoint_decimal(trading::price_type("1e18"));
+        CHECK(d.mantissa == 1);
+        CHECK(d.exponent == 18);
+        CHECK(round_trip("1e18"));
+        CHECK(round_trip("123456789012345678000"));
+        CHECK(round_trip("-0.00000000000000000123456789012345678"));
+        CHECK(round_trip("1.500"));
+
+        d = power_trade::to_checkpoint_decimal(trading::price_type("1.500"));
+        CHECK(d.mantissa == 15);
+        CHECK(d.exponent == -1);
+
+        CHECK_THROWS_AS(power_trade::to_checkpoint_decimal(trading::price_type("1234567890123456789")),
+                        std::invalid_argument);
+    }
+}
@@ -13,8 +13,8 @@ namespace arby
 {
 namespace power_trade
 {
-connector::connector(asio::any_io_executor exec, ssl::context &ioc)
-: impl_(std::make_shared< impl_class >(exec, ioc))
+connector::connector(asio::any_io_executor exec, ssl::context &ioc, endpoint where)
+: impl_(std::make_shared< impl_class >(exec, ioc, std::move(where)))
 {
     impl_->start();
     }
@@ -43,6 +43,26 @@ connector::connector(asio::any_io_executor exec, ssl::context &ioc)
         }
     }
 
+    asio::awaitable< bool >
+    connector::try_send(std::string s)
+    {
+        using asio::co_spawn;
+        using asio::use_awaitable;
+
+        auto this_exec = co_await asio::this_coro::executor;
+        auto my_exec   = impl_->get_executor();
+
+        if (this_exec == my_exec)
+        {
+            co_return impl_->send(s);
+        }
+        else
+        {
+            co_return co_await co_spawn(
+                my_exec, [&]() -> asio::awaitable< bool > { co_return impl_->send(s); }, use_awaitable);
+        }
+    }
+
     asio::awaitable< std::tuple< util::cross_executor_connection, connection_state > >
     connector::watch_connection_state(connection_state_slot slot)
     {
@@ -73,5 +93,29 @@ connector::connector(asio::any_io_executor exec, ssl::context &ioc)
         }
     }
 
+    asio::awaitable< util::cross_executor_connection >
+    connector::watch_book(trading::venue_listing const &listing, book_slot slot)
+    {
+        using asio::co_spawn;
+        using asio::use_awaitable;
+
+        auto this_exec = co_await asio::this_coro::executor;
+        auto my_exec   = impl_->get_executor();
+
+        if (this_exec == my_exec)
+        {
+            co_return util::cross_executor_connection { impl_, impl_->watch_book(listing, std::move(slot)) };
+        }
+        else
+        {
+            co_return co_await co_spawn(
+                my_exec,
+                [&]() -> asio::awaitable< util::cross_executor_connection > {
+                    co_return util::cross_executor_connection { impl_, impl_->watch_book(listing, std::move(slot)) };
+                },
+                use_awaitable);
+        }
+    }
+
 }   // namespace power_trade
 }   // namespace arby
\ No newline at end of file
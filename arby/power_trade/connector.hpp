@@ -11,6 +11,7 @@
 #define ARBY_ARBY_POWER_TRADE_CONNECTOR_HPP
 
 #include "power_trade/detail/connector_impl.hpp"
+#include "util/recycling_allocator.hpp"
 
 namespace arby
 {
@@ -23,11 +24,13 @@ struct connector
     using impl_class            = detail::connector_impl;
     using impl_type             = std::shared_ptr< impl_class >;
     using message_slot          = impl_class::message_slot;
+    using book_slot             = impl_class::book_slot;
     using connection_state_slot = impl_class::connection_state_slot;
     using executor_type         = impl_class::executor_type;
     using inbound_message       = impl_class::inbound_message;
+    using endpoint              = impl_class::endpoint;
 
-    connector(asio::any_io_executor exec, ssl::context &ioc);
+    connector(asio::any_io_executor exec, ssl::context &ioc, endpoint where = {});
 
     ~connector()
     {
@@ -49,18 +52,56 @@ struct connector
         return *this;
     }
 
+    /// @brief Queue a message for sending, without waiting for the result.
+    /// @note if the connector's outbound queue is full the message is dropped and a warning is logged. Use try_send
+    /// to observe backpressure.
     void
     send(std::string s)
     {
-        asio::dispatch(impl_->get_executor(), [s = std::move(s), impl = impl_] { impl->send(std::move(s)); });
+        asio::dispatch(impl_->get_executor(),
+                       util::bind_recycling_allocator([s = std::move(s), impl = impl_] { impl->send(s); }));
     }
 
+    /// @brief Queue a message for sending on the connector's executor.
+    /// @return false if the connector's outbound queue is full and the message was not queued
+    asio::awaitable< bool >
+    try_send(std::string s);
+
     void
     interrupt()
     {
         asio::dispatch(impl_->get_executor(), [impl = impl_] { impl->interrupt(); });
     }
 
+    /// @brief Keep a pre-connected standby socket so that failover costs one websocket upgrade.
+    /// @see detail::connector_impl::keep_standby
+    void
+    keep_standby(bool enable)
+    {
+        asio::dispatch(impl_->get_executor(), [enable, impl = impl_] { impl->keep_standby(enable); });
+    }
+
+    /// @brief Register a book whose readiness counts towards the connector's recovery time.
+    /// @see detail::connector_impl::add_book
+    void
+    add_book(void const *book)
+    {
+        asio::dispatch(impl_->get_executor(), [book, impl = impl_] { impl->add_book(book); });
+    }
+
+    void
+    remove_book(void const *book)
+    {
+        asio::dispatch(impl_->get_executor(), [book, impl = impl_] { impl->remove_book(book); });
+    }
+
+    void
+    report_book_state(void const *book, bool good)
+    {
+        asio::dispatch(impl_->get_executor(),
+                       util::bind_recycling_allocator([book, good, impl = impl_] { impl->report_book_state(book, good); }));
+    }
+
     executor_type const &
     get_executor() const
     {
@@ -85,6 +126,12 @@ struct connector
     asio::awaitable< std::tuple< util::cross_executor_connection, connection_state > >
     watch_connection_state(connection_state_slot slot);
 
+    /// @brief Await the subscription to the order book messages of one listed instrument.
+    /// @see detail::connector_impl::watch_book
+    /// @note as for watch_messages, the slot is executed on the connector's executor
+    asio::awaitable< util::cross_executor_connection >
+    watch_book(trading::venue_listing const &listing, book_slot slot);
+
     impl_type const &
     get_implementation()
     {
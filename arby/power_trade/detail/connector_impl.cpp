@@ -10,6 +10,7 @@
 #include "power_trade/detail/connector_impl.hpp"
 
 #include "asioex/scoped_interrupt.hpp"
+#include "network/backoff.hpp"
 #include "network/connect_ssl.hpp"
 #include "util/monitor.hpp"
 #include "util/truncate.hpp"
@@ -28,9 +29,12 @@ namespace fs = boost::filesystem;
 
 using namespace std::literals;
 
-connector_impl::connector_impl(executor_type exec, ssl::context &sslctx)
+connector_impl::connector_impl(executor_type exec, ssl::context &sslctx, endpoint where)
 : util::has_executor_base(std::move(exec))
 , ssl_ctx_(sslctx)
+, host_(std::move(where.host))
+, port_(std::move(where.port))
+, path_(std::move(where.path))
 {
 }
 
@@ -52,11 +56,16 @@ connector_impl::stop()
                        asioex::terminate(self->stop_);
                    });
 }
-void
-connector_impl::send(std::string s)
+bool
+connector_impl::send(std::string_view s)
 {
-    send_queue_.push_back(std::move(s));
+    if (!send_queue_.push(s))
+    {
+        spdlog::warn("{}::{} : send queue full, rejected {}", classname, __func__, util::truncate(s));
+        return false;
+    }
     send_cv_.cancel();
+    return true;
 }
 
 void
@@ -65,12 +74,22 @@ connector_impl::interrupt()
     interrupt_connection_.emit(asio::cancellation_type::all);
 }
 
+void
+connector_impl::keep_standby(bool enable)
+{
+    keep_standby_ = enable;
+    if (!enable)
+        standby_.reset();
+}
+
 asio::awaitable< void >
 connector_impl::run(std::shared_ptr< connector_impl > self)
 {
     using asio::use_awaitable;
-    auto sentinel = util::monitor::record("power_trade_connector::run");
+    static const auto probe    = util::monitor::register_probe("power_trade_connector::run");
+    auto              sentinel = util::monitor::record(probe);
 
+    auto delay = network::backoff();
     for (; !stopped_;)
     {
         try
@@ -83,16 +102,26 @@ connector_impl::run(std::shared_ptr< connector_impl > self)
         }
         if (stopped_)
             break;
-        auto t = asio::steady_timer(get_executor(), 2s);
-        fmt::print("{}::{} : reconnect delay...\n", classname, __func__);
+
+        // a connection which stayed up for a while resets the backoff so that we reconnect quickly. One that was
+        // dropped immediately is treated as a failed attempt so that we don't hammer the server.
+        if (up_since_ && std::chrono::steady_clock::now() - *up_since_ > 1s)
+            delay.reset();
+        up_since_.reset();
+
+        auto wait = delay.next();
+        spdlog::info("{}::{} : reconnect attempt {} in {}", classname, __func__, delay.attempts(), wait);
+        auto t = asio::steady_timer(get_executor(), wait);
         co_await t.async_wait(use_awaitable);
     }
+    standby_.reset();
 }
 
 asio::awaitable< void >
 connector_impl::run_connection()
 {
-    auto sentinel = util::monitor::record("power_trade_connector::run_connection");
+    static const auto probe    = util::monitor::register_probe("power_trade_connector::run_connection");
+    auto              sentinel = util::monitor::record(probe);
     try
     {
         using asio::bind_cancellation_slot;
@@ -100,9 +129,10 @@ connector_impl::run_connection()
         using asio::use_awaitable;
         using namespace asio::experimental::awaitable_operators;
 
-        auto ws = ws_stream(get_executor(), ssl_ctx_);
+        auto standby = take_standby();
+        auto ws      = standby ? ws_stream(std::move(*standby)) : ws_stream(get_executor(), ssl_ctx_);
 
-        co_await interruptible_connect(ws);
+        co_await interruptible_connect(ws, standby.has_value());
 
         fmt::print("{}::{} : websocket connected!\n", classname, __func__);
 
@@ -123,8 +153,14 @@ connector_impl::run_connection()
 
             auto s0 = asioex::scoped_interrupt((co_await asio::this_coro::cancellation_state).slot(), forward_interrupt("stop"));
             auto s1 = asioex::scoped_interrupt(interrupt_connection_, forward_interrupt("interrupt"));
-            co_await co_spawn(
-                get_executor(), send_loop(ws) || receive_loop(ws), bind_cancellation_slot(forward_signal.slot(), use_awaitable));
+            if (keep_standby_)
+                co_await co_spawn(get_executor(),
+                                  send_loop(ws) || receive_loop(ws) || standby_loop(),
+                                  bind_cancellation_slot(forward_signal.slot(), use_awaitable));
+            else
+                co_await co_spawn(get_executor(),
+                                  send_loop(ws) || receive_loop(ws),
+                                  bind_cancellation_slot(forward_signal.slot(), use_awaitable));
         }
         set_connection_state(asio::error::not_connected);
     }
@@ -142,13 +178,14 @@ connector_impl::run_connection()
 }
 
 asio::awaitable< void >
-connector_impl::interruptible_connect(ws_stream &stream)
+connector_impl::interruptible_connect(ws_stream &stream, bool warm)
 {
     using asio::bind_cancellation_slot;
     using asio::co_spawn;
     using asio::use_awaitable;
 
-    auto sentinel = util::monitor::record(fmt::format("{}::{}()", classname, __func__));
+    static const auto probe    = util::monitor::register_probe("power_trade_connector::interruptible_connect");
+    auto              sentinel = util::monitor::record(probe);
 
     bool interrupted       = false;
     auto cancel_connect    = asio::cancellation_signal();
@@ -168,17 +205,59 @@ connector_impl::interruptible_connect(ws_stream &stream)
         BOOST_SCOPE_EXIT_ALL(my_slot) { my_slot.clear(); };
 
         co_await co_spawn(get_executor(),
-                          network::connect(stream, host_, port_, path_),
+                          warm ? network::upgrade(stream, host_, path_) : network::connect(stream, host_, port_, path_),
                           bind_cancellation_slot(cancel_connect.slot(), use_awaitable));
     }
     if (interrupted)
         throw system_error(asio::error::operation_aborted, "interrupted");
 }
 
+asio::awaitable< void >
+connector_impl::standby_loop()
+{
+    using asio::use_awaitable;
+
+    static const auto probe    = util::monitor::register_probe("power_trade_connector::standby_loop");
+    auto              sentinel = util::monitor::record(probe);
+
+    auto timer = asio::steady_timer(get_executor());
+    for (;;)
+    {
+        if (!standby_ || std::chrono::steady_clock::now() - standby_->connected > standby_max_age / 2)
+        {
+            auto candidate = tls_layer(get_executor(), ssl_ctx_);
+            try
+            {
+                co_await network::connect(candidate, host_, port_);
+                standby_.emplace(standby_connection { std::move(candidate), std::chrono::steady_clock::now() });
+            }
+            catch (system_error &e)
+            {
+                if (e.code() == asio::error::operation_aborted)
+                    throw;
+                spdlog::warn("{}::{} : standby connect failed : {}", classname, __func__, e.what());
+            }
+        }
+        timer.expires_after(standby_max_age / 2);
+        co_await timer.async_wait(use_awaitable);
+    }
+}
+
+auto
+connector_impl::take_standby() -> std::optional< tls_layer >
+{
+    auto result = std::optional< tls_layer >();
+    if (standby_ && std::chrono::steady_clock::now() - standby_->connected < standby_max_age)
+        result.emplace(std::move(standby_->stream));
+    standby_.reset();
+    return result;
+}
+
 asio::awaitable< void >
 connector_impl::send_loop(ws_stream &ws)
 {
-    auto sentinel = util::monitor::record("power_trade_connector::send_loop");
+    static const auto probe    = util::monitor::register_probe("power_trade_connector::send_loop");
+    auto              sentinel = util::monitor::record(probe);
     using asio::redirect_error;
     using asio::use_awaitable;
 
@@ -194,10 +273,19 @@ connector_impl::send_loop(ws_stream &ws)
             }
             if (connstate_.down())
                 break;
-            assert(!send_queue_.empty());
-            fmt::print("{}: sending {}\n", __func__, send_queue_.front());
-            co_await ws.async_write(asio::buffer(send_queue_.front()), use_awaitable);
-            send_queue_.pop_front();
+
+            // drain whatever has been queued, including messages queued while we write, without waiting on the
+            // condition variable between frames
+            for (std::size_t n = 0; n < max_send_batch && !send_queue_.empty(); ++n)
+            {
+                spdlog::debug("{}::{} : sending {}", classname, __func__, util::truncate(send_queue_.front()));
+                co_await ws.async_write(asio::buffer(send_queue_.front()), use_awaitable);
+                send_queue_.pop();
+            }
+
+            // give the receive loop a chance to run before writing the next batch
+            if (!send_queue_.empty())
+                co_await asio::post(get_executor(), use_awaitable);
         }
     }
     catch (std::exception &e)
@@ -210,7 +298,8 @@ connector_impl::send_loop(ws_stream &ws)
 asio::awaitable< void >
 connector_impl::receive_loop(ws_stream &ws)
 {
-    auto sentinel = util::monitor::record("power_trade_connector::receive_loop");
+    static const auto probe    = util::monitor::register_probe("power_trade_connector::receive_loop");
+    auto              sentinel = util::monitor::record(probe);
     using asio::redirect_error;
     using asio::use_awaitable;
 
@@ -256,21 +345,76 @@ connector_impl::receive_loop(ws_stream &ws)
 bool
 connector_impl::handle_message(std::shared_ptr< inbound_message const > pmessage)
 {
-    auto &sig = signal_map_[pmessage->type()];
+    auto  routed = route_book_message(pmessage);
+    auto &sig    = signal_map_[pmessage->type()];
     if (sig.empty())
-        return false;
+        return routed;
     sig(pmessage);
     return true;
 }
 
-boost::signals2::connection
+namespace
+{
+std::optional< tick_code >
+book_tick_code(json::string const &type)
+{
+    if (type == "snapshot")
+        return tick_code::snapshot;
+    if (type == "order_added")
+        return tick_code::add;
+    if (type == "order_deleted")
+        return tick_code::remove;
+    if (type == "order_executed")
+        return tick_code::execute;
+    return std::nullopt;
+}
+}   // namespace
+
+bool
+connector_impl::route_book_message(std::shared_ptr< inbound_message const > const &pmessage)
+{
+    auto code = book_tick_code(pmessage->type());
+    auto body = pmessage->if_object();
+    if (!code || !body)
+        return false;
+
+    // only the spot market is listed
+    auto market = body->if_contains("market_id");
+    if (!market || !market->is_string() || market->get_string() != "0")
+        return false;
+
+    auto symbol = body->if_contains("symbol");
+    if (!symbol || !symbol->is_string())
+        return false;
+    auto id = book_ids_.find(symbol->get_string());
+    if (id == book_ids_.end())
+        return false;
+
+    auto sig = book_signals_.find(id->second);
+    if (!sig || !*sig || (*sig)->empty())
+        return false;
+    (**sig)(pmessage, *code);
+    return true;
+}
+
+util::connection
 connector_impl::watch_messages(json::string message_type, message_slot slot)
 {
     auto &sig = signal_map_[message_type];
     return sig.connect(std::move(slot));
 }
 
-boost::signals2::connection
+util::connection
+connector_impl::watch_book(trading::venue_listing const &listing, book_slot slot)
+{
+    book_ids_.emplace(json::string(listing.native_symbol), listing.id);
+    auto &sig = book_signals_[listing.id];
+    if (!sig)
+        sig = std::make_unique< book_signal >();
+    return sig->connect(std::move(slot));
+}
+
+util::connection
 connector_impl::watch_connection_state(connection_state &current, connection_state_slot slot)
 {
     current = connstate_;
@@ -279,8 +423,37 @@ connector_impl::watch_connection_state(connection_state &current, connection_sta
 void
 connector_impl::set_connection_state(error_code ec)
 {
+    auto was_up = connstate_.up();
     connstate_.set(ec);
+    if (connstate_.up())
+        up_since_ = std::chrono::steady_clock::now();
+    else if (was_up)
+        recovery_.connection_lost();
     connstate_signal_(connstate_);
 }
 
+void
+connector_impl::add_book(void const *book)
+{
+    recovery_.add_book(book);
+}
+
+void
+connector_impl::remove_book(void const *book)
+{
+    recovery_.remove_book(book);
+}
+
+void
+connector_impl::report_book_state(void const *book, bool good)
+{
+    if (recovery_.book_state(book, good))
+        spdlog::info("{}::{} : all books good after {}, worst {} over {} recoveries",
+                     classname,
+                     __func__,
+                     std::chrono::duration_cast< std::chrono::milliseconds >(*recovery_.last_recovery()),
+                     std::chrono::duration_cast< std::chrono::milliseconds >(recovery_.worst_recovery()),
+                     recovery_.recoveries());
+}
+
 }   // namespace arby::power_trade::detail
@@ -13,17 +13,25 @@
 #include "config/json.hpp"
 #include "config/websocket.hpp"
 #include "power_trade/connection_state.hpp"
+#include "power_trade/detail/send_queue.hpp"
+#include "power_trade/recovery_tracker.hpp"
+#include "power_trade/tick_record.hpp"
+#include "trading/fast_clock.hpp"
+#include "trading/instrument_registry.hpp"
 #include "trading/types.hpp"
 #include "util/cross_executor_connection.hpp"
+#include "util/signal.hpp"
 
 #include <boost/asio/awaitable.hpp>
 #include <boost/functional/hash.hpp>
-#include <boost/signals2.hpp>
 #include <boost/unordered_map.hpp>
 
-#include <deque>
+#include <chrono>
 #include <functional>
 #include <iosfwd>
+#include <memory>
+#include <optional>
+#include <string>
 #include <tuple>
 
 namespace arby::power_trade::detail
@@ -136,13 +144,22 @@ struct connector_impl
     using ws_stream                   = websocket::stream< tls_layer >;
     static constexpr char classname[] = "connector_impl";
 
+    /// The maximum number of outbound messages that may be queued before send() rejects new ones
+    static constexpr std::size_t max_queued_sends = 1024;
+
+    /// The maximum number of messages written per wakeup of the send loop before it yields to other work
+    static constexpr std::size_t max_send_batch = 64;
+
+    /// A standby connection older than this is not trusted to still be open and is replaced
+    static constexpr std::chrono::seconds standby_max_age { 30 };
+
     class inbound_message
     {
-        trading::timestamp_type timestamp_;
-        beast::flat_buffer      buffer_;
-        json::value             value_;
-        json::string            type_;
-        json::object const     *object_;
+        trading::fast_clock::time_point timestamp_;
+        beast::flat_buffer              buffer_;
+        json::value                     value_;
+        json::string                    type_;
+        json::object const             *object_;
 
       public:
         inbound_message(std::size_t capacity)
@@ -155,10 +172,17 @@ struct connector_impl
             return *object_;
         }
 
+        /// @return the body of the message, or nullptr if it has none
+        json::object const *
+        if_object() const
+        {
+            return object_;
+        }
+
         beast::flat_buffer &
         prepare()
         {
-            timestamp_ = std::chrono::system_clock::now();
+            timestamp_ = trading::fast_clock::now();
             object_    = nullptr;
             type_.clear();
             value_ = nullptr;
@@ -179,7 +203,8 @@ struct connector_impl
             return type_;
         }
 
-        trading::timestamp_type
+        /// @brief When the message was received. Convert with trading::fast_clock::to_timestamp for display.
+        trading::fast_clock::time_point
         timestamp() const
         {
             return timestamp_;
@@ -188,7 +213,7 @@ struct connector_impl
         void
         commit()
         {
-            timestamp_ = std::chrono::system_clock::now();
+            timestamp_ = trading::fast_clock::now();
             auto v     = view();
             auto v1    = json::string_view(v.begin(), v.end());
             value_     = json::parse(v);
@@ -203,24 +228,29 @@ struct connector_impl
 
     // Note that the signal type is not thread-safe. You must only interact with
     // the signals while on the same executor and thread as the connector
-    using message_signal =
-        boost::signals2::signal_type< void(std::shared_ptr< inbound_message const >),
-                                      boost::signals2::keywords::mutex_type< boost::signals2::dummy_mutex > >::type;
+    using message_signal = util::signal< void(std::shared_ptr< inbound_message const >) >;
+    using message_slot   = message_signal::slot_type;
 
-    using message_slot          = message_signal::slot_type;
-    using message_extended_slot = message_signal::extended_slot_type;
+    using connection_state_signal = util::signal< void(connection_state) >;
+    using connection_state_slot   = connection_state_signal::slot_type;
 
-    using connection_state_signal =
-        boost::signals2::signal_type< void(connection_state),
-                                      boost::signals2::keywords::mutex_type< boost::signals2::dummy_mutex > >::type;
+    // an order book message, with the kind of tick it carries
+    using book_signal = util::signal< void(std::shared_ptr< inbound_message const >, tick_code) >;
+    using book_slot   = book_signal::slot_type;
 
-    using connection_state_slot          = connection_state_signal::slot_type;
-    using connection_state_extended_slot = connection_state_signal::extended_slot_type;
+    /// @brief Where the venue's websocket is served.
+    struct endpoint
+    {
+        std::string host = "35.186.148.56";
+        std::string port = "4321";
+        std::string path = "/";
+    };
 
     /// @brief Constructor
     /// @param exec The internal executor to use for IO
     /// @param sslctx ssl context
-    connector_impl(executor_type exec, ssl::context &sslctx);
+    /// @param where the venue to connect to, which is Power Trade's own unless a stand-in is given
+    connector_impl(executor_type exec, ssl::context &sslctx, endpoint where = {});
 
     asio::awaitable< void >
     connect();
@@ -231,18 +261,53 @@ struct connector_impl
     void
     stop();
 
-    void
-    send(std::string s);
+    /// @brief Queue a text frame for sending.
+    ///
+    /// Messages queued while the connection is down are sent once it comes up.
+    /// @return false if the outbound queue is full. The message is discarded and the caller should back off.
+    bool
+    send(std::string_view s);
 
     void
     interrupt();
 
-    boost::signals2::connection
+    /// @brief Keep a second TLS connection open while connected, so that a reconnect costs only a websocket upgrade.
+    void
+    keep_standby(bool enable);
+
+    util::connection
     watch_messages(json::string message_type, message_slot slot);
 
-    boost::signals2::connection
+    util::connection
     watch_connection_state(connection_state &current, connection_state_slot slot);
 
+    /// @brief Watch the order book messages of one listed instrument.
+    ///
+    /// Snapshots and order events are routed by the instrument id of their symbol, which is looked up once per
+    /// message, so that a book sees only its own messages however many books share the connector. They are also
+    /// delivered to any watch_messages() slots for their type.
+    util::connection
+    watch_book(trading::venue_listing const &listing, book_slot slot);
+
+    /// @brief Register a book whose readiness counts towards recovery time.
+    /// @param book is an opaque identifier, usually the address of the listener maintaining the book
+    void
+    add_book(void const *book);
+
+    void
+    remove_book(void const *book);
+
+    /// @brief Report a change in a registered book's readiness.
+    void
+    report_book_state(void const *book, bool good);
+
+    /// @brief Time from disconnect to all registered books good.
+    recovery_tracker const &
+    recovery() const
+    {
+        return recovery_;
+    }
+
   private:
     asio::awaitable< void >
     run(std::shared_ptr< connector_impl > self);
@@ -256,8 +321,17 @@ struct connector_impl
     asio::awaitable< void >
     receive_loop(ws_stream &ws);
 
+    /// @param warm the TLS layer of the stream is already connected and only needs the websocket upgrade
+    asio::awaitable< void >
+    interruptible_connect(ws_stream &stream, bool warm);
+
+    /// @brief Keep standby_ connected and fresh for as long as the current connection lasts.
     asio::awaitable< void >
-    interruptible_connect(ws_stream &stream);
+    standby_loop();
+
+    /// @brief Take the standby connection if it is fresh enough to use.
+    std::optional< tls_layer >
+    take_standby();
 
     /// @brief Attempt to handle an incoming message
     /// @return boolean value indicating that the message was dispatched to at
@@ -265,6 +339,11 @@ struct connector_impl
     bool
     handle_message(std::shared_ptr< inbound_message const > pmessage);
 
+    /// @brief Deliver an order book message to the books of its instrument.
+    /// @return true if the message was delivered to at least one book
+    bool
+    route_book_message(std::shared_ptr< inbound_message const > const &pmessage);
+
     void
     set_connection_state(error_code ec);
 
@@ -273,7 +352,7 @@ struct connector_impl
     ssl::context &ssl_ctx_;
 
     // parameters
-    std::string const host_ = "35.186.148.56", port_ = "4321", path_ = "/";
+    std::string const host_, port_, path_;
 
     struct sv_comp_equ
     : boost::hash< boost::string_view >
@@ -295,8 +374,23 @@ struct connector_impl
     using signal_map = boost::unordered_map< json::string, message_signal, sv_comp_equ, sv_comp_equ >;
     signal_map signal_map_;
 
+    // book messages are routed by instrument id. Signals are neither copyable nor movable, hence the pointers.
+    using book_id_map = boost::unordered_map< json::string, trading::instrument_id, sv_comp_equ, sv_comp_equ >;
+    book_id_map                                                 book_ids_;
+    trading::instrument_table< std::unique_ptr< book_signal > > book_signals_;
+
+    struct standby_connection
+    {
+        tls_layer                             stream;
+        std::chrono::steady_clock::time_point connected;
+    };
+
     // state
-    std::deque< std::string > send_queue_;
+    std::optional< standby_connection >                      standby_;
+    bool                                                     keep_standby_ = false;
+    recovery_tracker                                         recovery_;
+    std::optional< std::chrono::steady_clock::time_point > up_since_;
+    send_queue                send_queue_ { max_queued_sends };
     asio::steady_timer        send_cv_ { get_executor() };
     asio::cancellation_signal interrupt_connection_;
     asio::cancellation_signal stop_;
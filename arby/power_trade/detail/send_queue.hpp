@@ -0,0 +1,102 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_ARBY_POWER_TRADE_DETAIL_SEND_QUEUE_HPP
+#define ARBY_ARBY_POWER_TRADE_DETAIL_SEND_QUEUE_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace arby::power_trade::detail
+{
+/// A bounded FIFO of outbound text frames.
+///
+/// All slots are allocated at construction and keep their string capacity when popped, so a push only allocates if
+/// the message is longer than anything previously held in that slot.
+/// @note not thread-safe. Use only on the owning connector's executor.
+struct send_queue
+{
+    explicit send_queue(std::size_t capacity, std::size_t reserve = 256)
+    : slots_(capacity)
+    {
+        assert(capacity);
+        for (auto &s : slots_)
+            s.reserve(reserve);
+    }
+
+    /// Append a copy of the message.
+    /// @return false, without modifying the queue, if the queue is full
+    bool
+    push(std::string_view message)
+    {
+        if (full())
+            return false;
+        slots_[(head_ + size_) % slots_.size()].assign(message.begin(), message.end());
+        ++size_;
+        return true;
+    }
+
+    std::string const &
+    front() const
+    {
+        assert(!empty());
+        return slots_[head_];
+    }
+
+    void
+    pop()
+    {
+        assert(!empty());
+        head_ = (head_ + 1) % slots_.size();
+        --size_;
+    }
+
+    void
+    clear()
+    {
+        head_ = 0;
+        size_ = 0;
+    }
+
+    bool
+    empty() const
+    {
+        return size_ == 0;
+    }
+
+    bool
+    full() const
+    {
+        return size_ == slots_.size();
+    }
+
+    std::size_t
+    size() const
+    {
+        return size_;
+    }
+
+    std::size_t
+    capacity() const
+    {
+        return slots_.size();
+    }
+
+  private:
+    std::vector< std::string > slots_;
+    std::size_t                head_ = 0;
+    std::size_t                size_ = 0;
+};
+
+}   // namespace arby::power_trade::detail
+
+#endif   // ARBY_ARBY_POWER_TRADE_DETAIL_SEND_QUEUE_HPP
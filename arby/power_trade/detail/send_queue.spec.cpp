@@ -0,0 +1,51 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "power_trade/detail/send_queue.hpp"
+
+#include <doctest/doctest.h>
+
+using namespace arby::power_trade::detail;
+
+TEST_SUITE("power_trade")
+{
+    TEST_CASE("send_queue")
+    {
+        auto q = send_queue(3);
+        CHECK(q.empty());
+        CHECK(q.push("a"));
+        CHECK(q.push("b"));
+        CHECK(q.push("c"));
+        CHECK(q.full());
+        CHECK_FALSE(q.push("d"));
+        CHECK(q.size() == 3);
+
+        CHECK(q.front() == "a");
+        q.pop();
+        CHECK(q.push("d"));
+        for (auto expected : { "b", "c", "d" })
+        {
+            CHECK(q.front() == expected);
+            q.pop();
+        }
+        CHECK(q.empty());
+    }
+
+    TEST_CASE("send_queue reuses slot capacity")
+    {
+        auto q = send_queue(2, 64);
+        CHECK(q.push("first"));
+        auto data = q.front().data();
+        q.pop();
+        CHECK(q.push("second"));
+        q.pop();
+        CHECK(q.push("third"));
+        CHECK(q.front().data() == data);
+    }
+}
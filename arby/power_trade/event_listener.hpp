@@ -55,9 +55,9 @@ struct event_listener
         on_message(std::shared_ptr< connector::inbound_message const > const &pmessage);
 
       private:
-        std::shared_ptr< connector >       connector_;
-        boost::signals2::scoped_connection status_connection_;
-        boost::signals2::scoped_connection message_connection_;
+        std::shared_ptr< connector > connector_;
+        util::scoped_connection      status_connection_;
+        util::scoped_connection      message_connection_;
     };
 
     using executor_type = impl::executor_type;
@@ -0,0 +1,183 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "power_trade/feed_arbiter.hpp"
+
+#include <boost/functional/hash.hpp>
+#include <fmt/chrono.h>
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <type_traits>
+
+namespace arby::power_trade
+{
+std::size_t
+feed_arbiter::tick_id_hash::operator()(tick_id const &id) const
+{
+    auto seed = std::hash< std::string >()(id.order_id);
+    boost::hash_combine(seed, static_cast< int >(id.code));
+    boost::hash_combine(seed, id.timestamp.time_since_epoch().count());
+    return seed;
+}
+
+feed_arbiter::feed_arbiter(std::size_t legs, std::size_t window)
+: stats_(legs)
+, ring_(window)
+{
+    assert(legs);
+    assert(window);
+    seen_.reserve(window);
+}
+
+auto
+feed_arbiter::identify(tick_record const &tick) -> tick_id
+{
+    return visit(
+        [code = tick.code()](auto const &t) -> tick_id
+        {
+            using type = std::decay_t< decltype(t) >;
+            if constexpr (std::is_same_v< type, tick_record::snapshot >)
+            {
+                assert(!"snapshots are not arbitrated by identity");
+                return tick_id { .code = code, .order_id = {}, .timestamp = {} };
+            }
+            else
+                return tick_id { .code = code, .order_id = t.order_id, .timestamp = t.timestamp };
+        },
+        tick.as_variant());
+}
+
+bool
+feed_arbiter::accept(std::size_t leg, tick_record const &tick, clock::time_point now)
+{
+    auto &stats = stats_[leg];
+    ++stats.received;
+
+    // a single leg needs no arbitration
+    if (stats_.size() == 1)
+    {
+        ++stats.wins;
+        return true;
+    }
+
+    auto id = identify(tick);
+    if (auto i = seen_.find(id); i != seen_.end())
+    {
+        auto lag = now - i->second.first;
+        ++stats.duplicates;
+        stats.total_lag += lag;
+        stats.worst_lag = std::max(stats.worst_lag, lag);
+        // once every leg has delivered its copy there is nothing left to match
+        if (++i->second.copies == stats_.size())
+            seen_.erase(i);
+        return false;
+    }
+
+    if (id.timestamp < horizon_ ||
+        (id.timestamp == horizon_ && std::find(forgotten_.begin(), forgotten_.end(), id) != forgotten_.end()))
+    {
+        ++stats.late;
+        return false;
+    }
+
+    ++stats.wins;
+    if (ring_size_ == ring_.size())
+        forget_oldest();
+    seen_.emplace(id, arrival { .first = now, .copies = 1 });
+    ring_[(ring_head_ + ring_size_++) % ring_.size()] = std::move(id);
+    return true;
+}
+
+void
+feed_arbiter::forget_oldest()
+{
+    auto &oldest = ring_[ring_head_];
+    seen_.erase(oldest);
+
+    // several ticks may share a timestamp, so the horizon is ordered by the whole identity: only those forgotten at
+    // the horizon's own timestamp are late, and a distinct tick at that time is still accepted
+    if (oldest.timestamp > horizon_)
+    {
+        horizon_ = oldest.timestamp;
+        forgotten_.clear();
+    }
+    if (oldest.timestamp == horizon_)
+        forgotten_.push_back(std::move(oldest));
+    ring_head_ = (ring_head_ + 1) % ring_.size();
+    --ring_size_;
+}
+
+void
+feed_arbiter::restart(std::size_t leg, tick_record::snapshot const &snap)
+{
+    seen_.clear();
+    ring_head_ = 0;
+    ring_size_ = 0;
+    forgotten_.clear();
+
+    // everything before the newest order in the snapshot is already applied. At that timestamp only the snapshot's own
+    // orders are, so that a distinct tick sharing it, such as the removal of one of them, is still accepted.
+    auto newest = trading::timestamp_type::min();
+    for (auto const *side : { &snap.bids, &snap.offers })
+        for (auto &order : *side)
+            newest = std::max(newest, order.timestamp);
+    horizon_ = newest;
+    for (auto const *side : { &snap.bids, &snap.offers })
+        for (auto &order : *side)
+            if (order.timestamp == newest)
+                forgotten_.push_back(tick_id { .code = tick_code::add, .order_id = order.order_id, .timestamp = newest });
+    ++stats_[leg].wins;
+}
+
+void
+feed_arbiter::leg_state(std::size_t leg, bool up)
+{
+    stats_[leg].up = up;
+}
+
+bool
+feed_arbiter::any_up() const
+{
+    return std::any_of(stats_.begin(), stats_.end(), [](leg_stats const &s) { return s.up; });
+}
+
+std::string
+feed_arbiter::summary() const
+{
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    std::uint64_t total_wins = 0;
+    for (auto &s : stats_)
+        total_wins += s.wins;
+
+    auto result = std::string();
+    for (std::size_t leg = 0; leg < stats_.size(); ++leg)
+    {
+        auto &s = stats_[leg];
+        if (leg)
+            result += "; ";
+        fmt::format_to(std::back_inserter(result),
+                       "leg {} {}: wins {} ({:.1f}%) received {} late {} lag mean {} worst {}",
+                       leg,
+                       s.up ? "up" : "down",
+                       s.wins,
+                       total_wins ? 100.0 * double(s.wins) / double(total_wins) : 0.0,
+                       s.received,
+                       s.late,
+                       duration_cast< microseconds >(s.mean_lag()),
+                       duration_cast< microseconds >(s.worst_lag));
+    }
+    return result;
+}
+
+}   // namespace arby::power_trade
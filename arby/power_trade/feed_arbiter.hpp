@@ -0,0 +1,131 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_ARBY_POWER_TRADE_FEED_ARBITER_HPP
+#define ARBY_ARBY_POWER_TRADE_FEED_ARBITER_HPP
+
+#include "power_trade/tick_record.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace arby::power_trade
+{
+/// @brief Chooses the first copy of each tick from redundant legs of the same feed.
+///
+/// Incremental ticks are identified by (tick kind, order id, upstream timestamp). The first copy to arrive on any
+/// leg is accepted and later copies are dropped. Identities are remembered for a window of recent ticks. A copy which
+/// arrives after its identity has left the window is dropped as late if its upstream timestamp is older than the
+/// newest forgotten one, or is that timestamp and its identity was forgotten at it.
+///
+/// A book snapshot restarts arbitration: the window is cleared and ticks older than the newest order in the snapshot
+/// are treated as already applied, as are the additions of the snapshot's orders at that timestamp.
+/// @note not thread-safe. Use only on the owning listener's executor.
+struct feed_arbiter
+{
+    using clock = std::chrono::steady_clock;
+
+    struct leg_stats
+    {
+        bool            up         = false;
+        std::uint64_t   received   = 0;   ///< incremental ticks seen on this leg
+        std::uint64_t   wins       = 0;   ///< ticks and snapshots which arrived first on this leg
+        std::uint64_t   duplicates = 0;   ///< copies which another leg delivered first
+        std::uint64_t   late       = 0;   ///< copies which arrived after leaving the window
+        clock::duration total_lag  = clock::duration::zero();
+        clock::duration worst_lag  = clock::duration::zero();
+
+        clock::duration
+        mean_lag() const
+        {
+            return duplicates ? total_lag / static_cast< clock::rep >(duplicates) : clock::duration::zero();
+        }
+    };
+
+    explicit feed_arbiter(std::size_t legs, std::size_t window = 4096);
+
+    /// @brief Offer an incremental tick received on a leg.
+    /// @return true if this is the first copy and should be applied to the book
+    bool
+    accept(std::size_t leg, tick_record const &tick, clock::time_point now = clock::now());
+
+    /// @brief Record that a snapshot received on the leg has been applied to the book.
+    void
+    restart(std::size_t leg, tick_record::snapshot const &snap);
+
+    void
+    leg_state(std::size_t leg, bool up);
+
+    /// @return true if any leg is up
+    bool
+    any_up() const;
+
+    std::size_t
+    legs() const
+    {
+        return stats_.size();
+    }
+
+    leg_stats const &
+    stats(std::size_t leg) const
+    {
+        return stats_[leg];
+    }
+
+    /// A one-line description of each leg's win rate and lag
+    std::string
+    summary() const;
+
+  private:
+    struct tick_id
+    {
+        tick_code               code;
+        std::string             order_id;
+        trading::timestamp_type timestamp;
+
+        bool
+        operator==(tick_id const &) const = default;
+    };
+
+    struct tick_id_hash
+    {
+        std::size_t
+        operator()(tick_id const &id) const;
+    };
+
+    struct arrival
+    {
+        clock::time_point first;
+        std::size_t       copies;
+    };
+
+    static tick_id
+    identify(tick_record const &tick);
+
+    void
+    forget_oldest();
+
+    std::vector< leg_stats >                             stats_;
+    std::unordered_map< tick_id, arrival, tick_id_hash > seen_;
+    std::vector< tick_id >                               ring_;
+    std::size_t                                          ring_head_ = 0;
+    std::size_t                                          ring_size_ = 0;
+
+    // ticks older than horizon_ are late, as are those at it which are in forgotten_
+    std::vector< tick_id >                               forgotten_;
+    trading::timestamp_type                              horizon_ = trading::timestamp_type::min();
+};
+
+}   // namespace arby::power_trade
+
+#endif   // ARBY_ARBY_POWER_TRADE_FEED_ARBITER_HPP
@@ -0,0 +1,161 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "power_trade/feed_arbiter.hpp"
+
+#include <doctest/doctest.h>
+
+#include <string>
+
+using namespace arby;
+using namespace std::literals;
+
+namespace
+{
+power_trade::tick_record
+make_add(std::string const &order_id, std::int64_t nanos)
+{
+    auto payload = std::make_shared< json::object >();
+    (*payload)["order_id"]      = order_id;
+    (*payload)["price"]         = "100.0";
+    (*payload)["quantity"]      = "1";
+    (*payload)["utc_timestamp"] = std::to_string(nanos);
+    (*payload)["side"]          = "buy";
+    return power_trade::tick_record(power_trade::tick_code::add, payload);
+}
+
+power_trade::tick_record
+make_remove(std::string const &order_id, std::int64_t nanos)
+{
+    auto payload = std::make_shared< json::object >();
+    (*payload)["order_id"]      = order_id;
+    (*payload)["utc_timestamp"] = std::to_string(nanos);
+    (*payload)["side"]          = "buy";
+    return power_trade::tick_record(power_trade::tick_code::remove, payload);
+}
+}   // namespace
+
+TEST_SUITE("power_trade")
+{
+    TEST_CASE("feed_arbiter")
+    {
+        using clock = power_trade::feed_arbiter::clock;
+
+        auto t0      = clock::time_point();
+        auto arbiter = power_trade::feed_arbiter(2);
+        arbiter.leg_state(0, true);
+        arbiter.leg_state(1, true);
+
+        // the first copy wins, whichever leg it arrives on
+        CHECK(arbiter.accept(0, make_add("a", 1000), t0));
+        CHECK_FALSE(arbiter.accept(1, make_add("a", 1000), t0 + 5ms));
+        CHECK(arbiter.accept(1, make_add("b", 2000), t0 + 10ms));
+        CHECK_FALSE(arbiter.accept(0, make_add("b", 2000), t0 + 11ms));
+
+        // the same order with a different kind or timestamp is a different tick
+        CHECK(arbiter.accept(0, make_remove("a", 3000), t0 + 20ms));
+        CHECK(arbiter.accept(0, make_add("a", 4000), t0 + 30ms));
+
+        CHECK(arbiter.stats(0).wins == 3);
+        CHECK(arbiter.stats(1).wins == 1);
+        CHECK(arbiter.stats(1).duplicates == 1);
+        CHECK(arbiter.stats(1).worst_lag == 5ms);
+        CHECK(arbiter.stats(0).worst_lag == 1ms);
+
+        // a leg going down does not stop the other
+        arbiter.leg_state(1, false);
+        CHECK(arbiter.any_up());
+        CHECK(arbiter.summary().find("leg 1 down") != std::string::npos);
+    }
+
+    TEST_CASE("feed_arbiter drops copies which fall out of the window")
+    {
+        auto arbiter = power_trade::feed_arbiter(2, 2);
+
+        CHECK(arbiter.accept(0, make_add("a", 1000)));
+        CHECK(arbiter.accept(0, make_add("b", 2000)));
+        CHECK(arbiter.accept(0, make_add("c", 3000)));
+
+        // "a" has been forgotten, but it is older than the window so it must not be applied twice
+        CHECK_FALSE(arbiter.accept(1, make_add("a", 1000)));
+        CHECK(arbiter.stats(1).late == 1);
+        CHECK_FALSE(arbiter.accept(1, make_add("c", 3000)));
+    }
+
+    TEST_CASE("feed_arbiter accepts a new tick at the timestamp of a forgotten one")
+    {
+        auto arbiter = power_trade::feed_arbiter(2, 2);
+
+        CHECK(arbiter.accept(0, make_add("a", 1000)));
+        CHECK(arbiter.accept(0, make_add("b", 1000)));
+        CHECK(arbiter.accept(0, make_add("c", 2000)));
+        CHECK(arbiter.accept(0, make_add("d", 2000)));
+
+        // "a" and "b" have been forgotten, but a distinct tick in the same instant is not late
+        CHECK(arbiter.accept(1, make_add("e", 1000)));
+        CHECK_FALSE(arbiter.accept(1, make_add("a", 1000)));
+        CHECK_FALSE(arbiter.accept(1, make_add("b", 1000)));
+        CHECK(arbiter.stats(1).late == 2);
+
+        // a tick older than the horizon is late whatever its identity
+        CHECK_FALSE(arbiter.accept(1, make_add("f", 500)));
+    }
+
+    TEST_CASE("feed_arbiter restarts on snapshot")
+    {
+        auto arbiter = power_trade::feed_arbiter(2);
+        CHECK(arbiter.accept(0, make_add("a", 1000)));
+
+        auto snap = power_trade::tick_record::snapshot();
+        snap.bids.push_back(power_trade::tick_record::add {
+            .order_id  = "x",
+            .price     = trading::price_type("1"),
+            .qty       = trading::qty_type("1"),
+            .timestamp = trading::timestamp_type(std::chrono::duration_cast< trading::timestamp_type::duration >(5000ns)),
+            .side      = trading::side_type::buy });
+        arbiter.restart(1, snap);
+        CHECK(arbiter.stats(1).wins == 1);
+
+        // ticks already reflected in the snapshot are not applied again
+        CHECK_FALSE(arbiter.accept(0, make_add("b", 4000)));
+        CHECK_FALSE(arbiter.accept(0, make_add("x", 5000)));
+        CHECK(arbiter.accept(0, make_add("c", 6000)));
+    }
+
+    TEST_CASE("feed_arbiter accepts a distinct tick at the snapshot's newest timestamp")
+    {
+        auto at = [](std::chrono::nanoseconds t)
+        { return trading::timestamp_type(std::chrono::duration_cast< trading::timestamp_type::duration >(t)); };
+
+        auto arbiter = power_trade::feed_arbiter(2);
+        auto snap    = power_trade::tick_record::snapshot();
+        snap.bids.push_back(power_trade::tick_record::add { .order_id  = "x",
+                                                            .price     = trading::price_type("1"),
+                                                            .qty       = trading::qty_type("1"),
+                                                            .timestamp = at(5000ns),
+                                                            .side      = trading::side_type::buy });
+        snap.bids.push_back(power_trade::tick_record::add { .order_id  = "w",
+                                                            .price     = trading::price_type("1"),
+                                                            .qty       = trading::qty_type("1"),
+                                                            .timestamp = at(4000ns),
+                                                            .side      = trading::side_type::buy });
+        arbiter.restart(0, snap);
+
+        // the removal of an order in the same instant as the snapshot's newest is not in the snapshot
+        CHECK(arbiter.accept(1, make_remove("x", 5000)));
+        CHECK_FALSE(arbiter.accept(0, make_remove("x", 5000)));
+        CHECK(arbiter.accept(0, make_add("y", 5000)));
+        CHECK(arbiter.stats(1).late == 0);
+
+        // the snapshot's own order at that instant, and anything older, is late
+        CHECK_FALSE(arbiter.accept(1, make_add("x", 5000)));
+        CHECK_FALSE(arbiter.accept(1, make_remove("w", 4000)));
+        CHECK(arbiter.stats(1).late == 2);
+    }
+}
@@ -40,5 +40,16 @@ native_symbol(trading::market_key const &in)
     return visit(converter(), in.as_variant());
 }
 
+trading::venue_listing const &
+require_listing(trading::market_key const &in)
+{
+    auto &registry = trading::instrument_registry::instance();
+    if (auto inst = registry.find(in))
+        if (auto p = registry.find_listing(venue_name, inst->id))
+            return *p;
+    auto sym = native_symbol(in);
+    return registry.list(venue_name, in, trading::instrument_spec { .native_symbol = std::string(sym.begin(), sym.end()) });
+}
+
 }   // namespace power_trade
 }   // namespace arby
\ No newline at end of file
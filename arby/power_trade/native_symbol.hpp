@@ -11,6 +11,7 @@
 #define ARBY_ARBY_POWER_TRADE_NATIVE_SYMBOL_HPP
 
 #include "config/json.hpp"
+#include "trading/instrument_registry.hpp"
 #include "trading/market_key.hpp"
 
 namespace arby
@@ -21,6 +22,13 @@ namespace power_trade
 json::string
 native_symbol(trading::market_key const &in);
 
+/// @brief The name under which power trade lists its markets in the instrument_registry.
+inline constexpr char venue_name[] = "power_trade";
+
+/// @brief List the market on power trade with its native symbol, or find its existing listing.
+trading::venue_listing const &
+require_listing(trading::market_key const &in);
+
 }   // namespace power_trade
 }   // namespace arby
 
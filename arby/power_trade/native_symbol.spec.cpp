@@ -20,4 +20,15 @@ TEST_SUITE("power_trade")
         auto native = power_trade::native_symbol(mk);
         CHECK(native == "USD-JPY");
     }
+
+    TEST_CASE("require_listing")
+    {
+        auto  mk      = trading::market_key(trading::spot_key("usd/chf"));
+        auto &listing = power_trade::require_listing(mk);
+        auto &inst    = trading::instrument_registry::instance()[listing.id];
+        CHECK(inst.name == "usd/chf");
+        CHECK(listing.venue == power_trade::venue_name);
+        CHECK(listing.native_symbol == "USD-CHF");
+        CHECK(&power_trade::require_listing(mk) == &listing);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,147 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "bench/bench.hpp"
+#include "power_trade/order_book.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace arby;
+
+namespace
+{
+std::string
+order_id(int i)
+{
+    // the shape of a power_trade order id
+    return "1651234567" + std::to_string(100000000 + i);
+}
+
+trading::price_type
+price_at(trading::side_type side, int level)
+{
+    auto p = trading::price_type("39628.50");
+    auto d = trading::price_type(level) / 2;
+    return side == trading::buy ? trading::price_type(p - d) : trading::price_type(p + 1 + d);
+}
+
+/// A snapshot with `orders_per_side` orders on each side, four to a level, in exchange order.
+power_trade::tick_record::snapshot
+make_snapshot(int orders_per_side)
+{
+    auto snap = power_trade::tick_record::snapshot();
+    for (int i = 0; i < orders_per_side; ++i)
+        for (auto side : { trading::buy, trading::sell })
+        {
+            auto &v = side == trading::buy ? snap.bids : snap.offers;
+            v.push_back(power_trade::tick_record::add { .order_id = order_id(2 * i + (side == trading::sell)),
+                                                        .price    = price_at(side, i / 4),
+                                                        .qty      = trading::qty_type("0.25"),
+                                                        .side     = side });
+        }
+    return snap;
+}
+
+power_trade::order_book
+make_book(int orders_per_side)
+{
+    auto book = power_trade::order_book();
+    book.load(make_snapshot(orders_per_side));
+    return book;
+}
+
+constexpr int ring_size = 1024;
+}   // namespace
+
+// an order added to and then removed from a book of the given depth, at a spread of levels
+ARBY_BENCHMARK("order_book/add_remove", 100, 1000, 10000)
+{
+    auto depth = int(state.arg());
+    auto book  = make_book(depth);
+    auto adds  = std::vector< power_trade::tick_record::add >();
+    auto rems  = std::vector< power_trade::tick_record::remove >();
+    for (int i = 0; i < ring_size; ++i)
+    {
+        auto side = i % 2 ? trading::buy : trading::sell;
+        auto id   = order_id(10 * depth + i);
+        adds.push_back({ .order_id = id, .price = price_at(side, i % (depth / 4)), .qty = trading::qty_type(1), .side = side });
+        rems.push_back({ .order_id = id, .side = side });
+    }
+
+    std::size_t i = 0;
+    for (auto _ : state)
+    {
+        book.add(adds[i]);
+        book.remove(rems[i]);
+        i = (i + 1) % ring_size;
+    }
+    bench::do_not_optimize(book.aggregate_bids_);
+}
+
+// a partial fill of a resting order
+ARBY_BENCHMARK("order_book/execute", 100, 1000, 10000)
+{
+    auto depth = int(state.arg());
+    auto book  = make_book(depth);
+    auto execs = std::vector< power_trade::tick_record::execute >();
+    for (int i = 0; i < ring_size; ++i)
+    {
+        auto n = i % depth;
+        execs.push_back({ .order_id = order_id(2 * n),
+                          .price    = price_at(trading::buy, n / 4),
+                          .qty      = trading::qty_type("0.00000001"),
+                          .side     = trading::buy });
+    }
+
+    std::size_t i = 0;
+    for (auto _ : state)
+    {
+        book.execute(execs[i]);
+        i = (i + 1) % ring_size;
+    }
+    bench::do_not_optimize(book.aggregate_bids_);
+}
+
+ARBY_BENCHMARK("order_book/load", 1000, 5000, 20000)
+{
+    auto snap = make_snapshot(int(state.arg()));
+    auto book = power_trade::order_book();
+    state.set_items_per_iteration(2.0 * state.arg());
+    for (auto _ : state)
+        book.load(snap);
+    bench::do_not_optimize(book.aggregate_bids_);
+}
+
+// the same snapshot applied order by order, as it was before order_book::load
+ARBY_BENCHMARK("order_book/reset_add", 1000, 5000, 20000)
+{
+    auto snap = make_snapshot(int(state.arg()));
+    auto book = power_trade::order_book();
+    state.set_items_per_iteration(2.0 * state.arg());
+    for (auto _ : state)
+    {
+        book.reset();
+        for (auto &o : snap.bids)
+            book.add(o);
+        for (auto &o : snap.offers)
+            book.add(o);
+    }
+    bench::do_not_optimize(book.aggregate_bids_);
+}
+
+// refreshing a recycled snapshot's book from the live book
+ARBY_BENCHMARK("order_book/copy_assign", 100, 1000, 10000)
+{
+    auto book   = make_book(int(state.arg()));
+    auto target = make_book(int(state.arg()) / 2);
+    for (auto _ : state)
+        target = book;
+    bench::do_not_optimize(target.aggregate_bids_);
+}
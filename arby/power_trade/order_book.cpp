@@ -15,11 +15,165 @@
 #include <fmt/ostream.h>
 
 #include <algorithm>
+#include <cassert>
 #include <chrono>
 #include <iterator>
+#include <memory>
+#include <string_view>
+#include <tuple>
+#include <vector>
 
 namespace arby::power_trade
 {
+namespace
+{
+    /// Index an order, replacing any previous entry for the same id, without building a key unless it is new.
+    template < class Cache, class... Iters >
+    void
+    index_order(Cache &cache, std::string_view orderid, Iters... iters)
+    {
+        auto icache = cache.lower_bound(orderid);
+        if (icache != cache.end() && icache->first == orderid)
+            icache->second = std::make_tuple(iters...);
+        else
+            cache.emplace_hint(icache,
+                               std::piecewise_construct,
+                               std::forward_as_tuple(orderid),
+                               std::forward_as_tuple(iters...));
+    }
+
+    /// Build an empty ladder and its order index from the orders for one side of a snapshot.
+    /// @return the aggregate depth of the side
+    template < class Ladder, class Cache >
+    trading::qty_type
+    load_side(Ladder &ladder, Cache &cache, std::vector< tick_record::add > const &orders)
+    {
+        assert(ladder.empty() && cache.empty());
+
+        auto by_price = [comp = ladder.key_comp()](auto *l, auto *r) { return comp(l->price, r->price); };
+        auto sorted   = std::vector< tick_record::add const * >();
+        sorted.reserve(orders.size());
+        for (auto &o : orders)
+            sorted.push_back(&o);
+
+        // exchanges normally send levels in order, in which case there is nothing to do. A stable sort keeps the
+        // orders within a level in the sequence the exchange sent them.
+        if (!std::is_sorted(sorted.begin(), sorted.end(), by_price))
+            std::stable_sort(sorted.begin(), sorted.end(), by_price);
+
+        using index_entry = std::tuple< std::string_view, typename Ladder::iterator, level_data::qty_list::iterator >;
+        auto index        = std::vector< index_entry >();
+        index.reserve(sorted.size());
+
+        auto total  = trading::qty_type(0);
+        auto ilevel = ladder.end();
+        for (auto *o : sorted)
+        {
+            if (ilevel == ladder.end() || ilevel->first != o->price)
+                ilevel = ladder.emplace_hint(
+                    ladder.end(), std::piecewise_construct, std::forward_as_tuple(o->price), std::forward_as_tuple());
+            auto &detail = ilevel->second;
+            detail.aggregate_depth += o->qty;
+            auto iqty = detail.orders.emplace(detail.orders.end(), o->order_id, o->qty);
+            index.emplace_back(iqty->orderid, ilevel, iqty);
+            total += o->qty;
+        }
+
+        // as with add(), a repeated order id indexes the last order to carry it
+        std::stable_sort(index.begin(),
+                         index.end(),
+                         [](index_entry const &l, index_entry const &r) { return std::get< 0 >(l) < std::get< 0 >(r); });
+        for (auto &[orderid, il, iq] : index)
+            if (!cache.empty() && std::prev(cache.end())->first == orderid)
+                std::prev(cache.end())->second = std::make_tuple(il, iq);
+            else
+                cache.emplace_hint(
+                    cache.end(), std::piecewise_construct, std::forward_as_tuple(orderid), std::forward_as_tuple(il, iq));
+
+        return total;
+    }
+
+    template < class Ladder >
+    void
+    rebuild_profile(trading::depth_profile &profile, Ladder const &ladder)
+    {
+        profile.clear();
+        for (auto ilevel = ladder.begin(); ilevel != ladder.end() && !profile.full(); ++ilevel)
+            profile.push_back(trading::to_double(ilevel->first), trading::to_double(ilevel->second.aggregate_depth));
+    }
+}   // namespace
+
+order_book::order_book()
+: arena_(std::make_unique< arena_type >())
+, last_update_()
+, offers_(arena_.get())
+, offer_cache_(arena_.get())
+, aggregate_offers_(0)
+, bids_(arena_.get())
+, bid_cache_(arena_.get())
+, aggregate_bids_(0)
+{
+}
+
+order_book::order_book(order_book const &other)
+: order_book()
+{
+    *this = other;
+}
+
+order_book &
+order_book::operator=(order_book const &r)
+{
+    if (this == &r)
+        return *this;
+
+    // the ladders are assigned in place, so nodes already held by this book are reused
+    offers_           = r.offers_;
+    aggregate_offers_ = r.aggregate_offers_;
+    bids_             = r.bids_;
+    aggregate_bids_   = r.aggregate_bids_;
+    last_update_      = r.last_update_;
+    bid_profile_      = r.bid_profile_;
+    offer_profile_    = r.offer_profile_;
+    rebuild_caches();
+    return *this;
+}
+
+// the arena is held by pointer, so the containers and the iterators in the caches stay valid as they move with it
+order_book::order_book(order_book &&other) noexcept = default;
+
+order_book &
+order_book::operator=(order_book &&r) noexcept
+{
+    // a pmr container cannot take on another arena, so the book is rebuilt around the one it is given. Destroying it
+    // first lets the containers release their nodes while the arena that holds them still exists.
+    if (this != &r)
+    {
+        std::destroy_at(this);
+        std::construct_at(this, std::move(r));
+    }
+    return *this;
+}
+
+void
+order_book::rebuild_caches()
+{
+    bid_cache_.clear();
+    for (auto iladder = bids_.begin(); iladder != bids_.end(); ++iladder)
+    {
+        auto &[price, detail] = *iladder;
+        for (auto iqty = detail.orders.begin(); iqty != detail.orders.end(); ++iqty)
+            index_order(bid_cache_, iqty->orderid, iladder, iqty);
+    }
+
+    offer_cache_.clear();
+    for (auto iladder = offers_.begin(); iladder != offers_.end(); ++iladder)
+    {
+        auto &[price, detail] = *iladder;
+        for (auto iqty = detail.orders.begin(); iqty != detail.orders.end(); ++iqty)
+            index_order(offer_cache_, iqty->orderid, iladder, iqty);
+    }
+}
 
 std::ostream &
 operator<<(std::ostream &os, const order_book &book)
@@ -76,9 +230,10 @@ order_book::add(tick_record::add const &r)
             ilevel = bids_.emplace(r.price, level_data()).first;
         auto &detail = ilevel->second;
         detail.aggregate_depth += r.qty;
-        auto iqty              = detail.orders.insert(detail.orders.end(), order_qty { .orderid = r.order_id, .qty = r.qty });
-        bid_cache_[r.order_id] = std::make_tuple(ilevel, iqty);
+        auto iqty = detail.orders.emplace(detail.orders.end(), r.order_id, r.qty);
+        index_order(bid_cache_, r.order_id, ilevel, iqty);
         aggregate_bids_ += r.qty;
+        update_profile(r.side, ilevel->first, detail.aggregate_depth);
     }
     else
     {
@@ -87,9 +242,10 @@ order_book::add(tick_record::add const &r)
             ilevel = offers_.emplace(r.price, level_data()).first;
         auto &detail = ilevel->second;
         detail.aggregate_depth += r.qty;
-        auto iqty                = detail.orders.insert(detail.orders.end(), order_qty { .orderid = r.order_id, .qty = r.qty });
-        offer_cache_[r.order_id] = std::make_tuple(ilevel, iqty);
+        auto iqty = detail.orders.emplace(detail.orders.end(), r.order_id, r.qty);
+        index_order(offer_cache_, r.order_id, ilevel, iqty);
         aggregate_offers_ += r.qty;
+        update_profile(r.side, ilevel->first, detail.aggregate_depth);
     }
 }
 
@@ -108,9 +264,15 @@ order_book::remove(tick_record::remove const &tick)
         aggregate_bids_ -= iqty->qty;
         assert(aggregate_bids_ >= 0);
         detail.orders.erase(iqty);
+        auto price = ilevel->first;
+        auto depth = detail.aggregate_depth;
         if (detail.orders.empty())
+        {
             bids_.erase(ilevel);
+            depth = 0;
+        }
         bid_cache_.erase(icache);
+        update_profile(tick.side, price, depth);
     }
     else
     {
@@ -124,14 +286,42 @@ order_book::remove(tick_record::remove const &tick)
         aggregate_offers_ -= iqty->qty;
         assert(aggregate_offers_ >= 0);
         detail.orders.erase(iqty);
+        auto price = ilevel->first;
+        auto depth = detail.aggregate_depth;
         if (detail.orders.empty())
+        {
             offers_.erase(ilevel);
+            depth = 0;
+        }
         offer_cache_.erase(icache);
+        update_profile(tick.side, price, depth);
     }
 
     last_update_ = std::max(tick.timestamp, last_update_);
 }
 
+void
+order_book::update_profile(trading::side_type side, trading::price_type const &price, trading::qty_type const &depth)
+{
+    if (side == trading::buy)
+    {
+        if (!bid_profile_.update(trading::to_double(price), trading::to_double(depth)))
+            rebuild_profile(bid_profile_, bids_);
+    }
+    else
+    {
+        if (!offer_profile_.update(trading::to_double(price), trading::to_double(depth)))
+            rebuild_profile(offer_profile_, offers_);
+    }
+}
+
+void
+order_book::rebuild_profiles()
+{
+    rebuild_profile(bid_profile_, bids_);
+    rebuild_profile(offer_profile_, offers_);
+}
+
 bool
 operator==(order_book const &l, order_book const &r)
 {
@@ -142,39 +332,37 @@ operator==(order_book const &l, order_book const &r)
 void
 order_book::execute(tick_record::execute const &tick)
 {
-
-    if (tick.side == trading::buy)
+    // an execution reduces the resting order by the quantity traded, and removes it once nothing is left
+    auto apply = [&](auto &ladder, auto &cache, trading::qty_type &aggregate)
     {
-        auto icache = bid_cache_.find(tick.order_id);
-        if (icache == bid_cache_.end())
+        auto icache = cache.find(tick.order_id);
+        if (icache == cache.end())
             return;
-        auto &[ilevel, iqty] = icache->second;
-        auto &detail         = ilevel->second;
-        if (iqty->qty -= tick.qty == 0)
+        auto [ilevel, iqty] = icache->second;
+        auto &detail        = ilevel->second;
+        auto  traded        = std::min(tick.qty, iqty->qty);
+        iqty->qty -= traded;
+        detail.aggregate_depth -= traded;
+        aggregate -= traded;
+        auto price = ilevel->first;
+        auto depth = detail.aggregate_depth;
+        if (iqty->qty == 0)
         {
             detail.orders.erase(iqty);
-            bid_cache_.erase(tick.order_id);
+            cache.erase(icache);
             if (detail.orders.empty())
-                bids_.erase(ilevel->first);
+            {
+                ladder.erase(ilevel);
+                depth = 0;
+            }
         }
-        aggregate_bids_ -= tick.qty;
-    }
+        update_profile(tick.side, price, depth);
+    };
+
+    if (tick.side == trading::buy)
+        apply(bids_, bid_cache_, aggregate_bids_);
     else
-    {
-        auto icache = offer_cache_.find(tick.order_id);
-        if (icache == offer_cache_.end())
-            return;
-        auto &[ilevel, iqty] = icache->second;
-        auto &detail         = ilevel->second;
-        if (iqty->qty -= tick.qty == 0)
-        {
-            detail.orders.erase(iqty);
-            offer_cache_.erase(tick.order_id);
-            if (detail.orders.empty())
-                offers_.erase(ilevel->first);
-        }
-        aggregate_bids_ -= tick.qty;
-    }
+        apply(offers_, offer_cache_, aggregate_offers_);
 
     last_update_ = std::max(tick.timestamp, last_update_);
 }
@@ -189,6 +377,23 @@ order_book::reset()
     offers_.clear();
     offer_cache_.clear();
     aggregate_offers_ = 0;
+    bid_profile_.clear();
+    offer_profile_.clear();
+
+    // every node has been returned to the arena: hand its chunks back in one go
+    arena_->release();
+}
+
+void
+order_book::load(tick_record::snapshot const &snap)
+{
+    reset();
+    aggregate_bids_   = load_side(bids_, bid_cache_, snap.bids);
+    aggregate_offers_ = load_side(offers_, offer_cache_, snap.offers);
+    rebuild_profiles();
+    for (auto const *side : { &snap.bids, &snap.offers })
+        for (auto &o : *side)
+            last_update_ = std::max(last_update_, o.timestamp);
 }
 
 std::string
@@ -12,18 +12,52 @@
 
 #include "config/wise_enum.hpp"
 #include "power_trade/tick_record.hpp"
+#include "trading/depth_profile.hpp"
 #include "trading/types.hpp"
 
 #include <chrono>
 #include <list>
 #include <map>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 
 namespace arby::power_trade
 {
+// The book's containers are allocator-aware so that every node of a book, down to the order ids, comes from the
+// book's own arena. The allocator-extended constructors below are what std::pmr uses to propagate it.
+
 struct order_qty
 {
-    std::string       orderid;
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    order_qty(std::string_view orderid, trading::qty_type qty, allocator_type alloc = {})
+    : orderid(orderid, alloc)
+    , qty(std::move(qty))
+    {
+    }
+
+    order_qty(order_qty const &other, allocator_type alloc = {})
+    : orderid(other.orderid, alloc)
+    , qty(other.qty)
+    {
+    }
+
+    order_qty(order_qty &&other, allocator_type alloc)
+    : orderid(std::move(other.orderid), alloc)
+    , qty(std::move(other.qty))
+    {
+    }
+
+    order_qty(order_qty &&) = default;
+
+    order_qty &
+    operator=(order_qty const &) = default;
+    order_qty &
+    operator=(order_qty &&) = default;
+
+    std::pmr::string  orderid;
     trading::qty_type qty;
 
     friend bool
@@ -35,7 +69,34 @@ struct order_qty
 
 struct level_data
 {
-    using qty_list = std::list< order_qty >;
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+    using qty_list       = std::pmr::list< order_qty >;
+
+    level_data() = default;
+
+    explicit level_data(allocator_type alloc)
+    : orders(alloc)
+    {
+    }
+
+    level_data(level_data const &other, allocator_type alloc = {})
+    : aggregate_depth(other.aggregate_depth)
+    , orders(other.orders, alloc)
+    {
+    }
+
+    level_data(level_data &&other, allocator_type alloc)
+    : aggregate_depth(std::move(other.aggregate_depth))
+    , orders(std::move(other.orders), alloc)
+    {
+    }
+
+    level_data(level_data &&) = default;
+
+    level_data &
+    operator=(level_data const &) = default;
+    level_data &
+    operator=(level_data &&) = default;
 
     trading::qty_type aggregate_depth { 0 };
     qty_list          orders {};
@@ -47,8 +108,32 @@ struct level_data
     }
 };
 
+/// @brief A level 3 order book.
+///
+/// Each book owns a pool arena from which all of its nodes are allocated, so that the tick path neither contends
+/// with other threads in malloc nor fragments the heap. Copying a book into another reuses the target's nodes and
+/// arena, which is how pooled snapshots are refreshed. reset() releases the arena wholesale.
+///
+/// The book keeps a depth_profile of the best levels of each side up to date as levels change, so that the cost of a
+/// sweep can be asked of any book at any time.
+/// @note Not thread-safe. The arena is unsynchronised.
 struct order_book
 {
+    order_book();
+
+    /// The copy has an arena of its own.
+    order_book(order_book const &other);
+
+    order_book &
+    operator=(order_book const &r);
+
+    /// The book takes the arena along with the nodes in it, so nothing is copied. A moved-from book may only be
+    /// destroyed or moved into.
+    order_book(order_book &&other) noexcept;
+
+    order_book &
+    operator=(order_book &&r) noexcept;
+
     std::string
     top_bid_str() const;
     std::string
@@ -66,17 +151,56 @@ struct order_book
     void
     reset();
 
+    /// @brief Replace the contents of the book with an exchange snapshot.
+    ///
+    /// Equivalent to reset() followed by add() for each bid and offer, but each ladder and order index is built in
+    /// one ordered pass of hinted inserts at the end, rather than a tree search per order.
+    void
+    load(tick_record::snapshot const &snap);
+
+    trading::depth_profile const &
+    bid_profile() const
+    {
+        return bid_profile_;
+    }
+
+    trading::depth_profile const &
+    offer_profile() const
+    {
+        return offer_profile_;
+    }
+
+    /// The profiles follow from the ladders, and take no part in the comparison.
     friend bool
     operator==(order_book const &l, order_book const &r);
 
     friend std::ostream &
     operator<<(std::ostream &os, order_book const &book);
 
-    using offer_ladder      = std::map< trading::price_type, level_data, std::less<> >;
-    using offer_order_cache = std::map< std::string, std::tuple< offer_ladder::iterator, level_data::qty_list ::iterator > >;
+    using arena_type = std::pmr::unsynchronized_pool_resource;
 
-    using bid_ladder      = std::map< trading::price_type, level_data, std::greater<> >;
-    using bid_order_cache = std::map< std::string, std::tuple< bid_ladder::iterator, level_data::qty_list ::iterator > >;
+    /// Lets the caches be searched with any string type without building a key in the arena.
+    struct order_id_less
+    {
+        using is_transparent = void;
+
+        bool
+        operator()(std::string_view l, std::string_view r) const
+        {
+            return l < r;
+        }
+    };
+
+    using offer_ladder      = std::pmr::map< trading::price_type, level_data, std::less<> >;
+    using offer_order_cache =
+        std::pmr::map< std::pmr::string, std::tuple< offer_ladder::iterator, level_data::qty_list ::iterator >, order_id_less >;
+
+    using bid_ladder      = std::pmr::map< trading::price_type, level_data, std::greater<> >;
+    using bid_order_cache =
+        std::pmr::map< std::pmr::string, std::tuple< bid_ladder::iterator, level_data::qty_list ::iterator >, order_id_less >;
+
+    // declared first: the containers below allocate from it
+    std::unique_ptr< arena_type > arena_;
 
     std::chrono::system_clock::time_point last_update_;
 
@@ -88,39 +212,19 @@ struct order_book
     bid_order_cache   bid_cache_;
     trading::qty_type aggregate_bids_;
 
-    order_book &
-    operator=(order_book const &r)
-    {
-        offers_           = r.offers_;
-        aggregate_offers_ = r.aggregate_offers_;
-        bids_             = r.bids_;
-        aggregate_bids_   = r.aggregate_bids_;
-        last_update_      = r.last_update_;
-
-        // now rebuild the indexes
+  private:
+    void
+    rebuild_caches();
 
-        for (auto iladder = bids_.begin(); iladder != bids_.end(); ++iladder)
-        {
-            auto &[price, detail] = *iladder;
-            for (auto iqty = detail.orders.begin(); iqty != detail.orders.end(); ++iqty)
-            {
-                auto &[orderid, qty] = *iqty;
-                bid_cache_.emplace(orderid, std::make_tuple(iladder, iqty));
-            }
-        }
+    /// Bring a profile into line with the new depth at a price, which is 0 if the level has gone.
+    void
+    update_profile(trading::side_type side, trading::price_type const &price, trading::qty_type const &depth);
 
-        for (auto iladder = offers_.begin(); iladder != offers_.end(); ++iladder)
-        {
-            auto &[price, detail] = *iladder;
-            for (auto iqty = detail.orders.begin(); iqty != detail.orders.end(); ++iqty)
-            {
-                auto &[orderid, qty] = *iqty;
-                offer_cache_.emplace(orderid, std::make_tuple(iladder, iqty));
-            }
-        }
+    void
+    rebuild_profiles();
 
-        return *this;
-    }
+    trading::depth_profile bid_profile_ { trading::buy };
+    trading::depth_profile offer_profile_ { trading::sell };
 };
 
 }   // namespace arby::power_trade
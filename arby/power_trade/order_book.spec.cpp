@@ -0,0 +1,257 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+#include "power_trade/order_book.hpp"
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+
+using namespace arby;
+
+namespace
+{
+power_trade::tick_record::add
+make_add(std::string orderid, trading::side_type side, int price)
+{
+    return power_trade::tick_record::add { .order_id = std::move(orderid),
+                                           .price    = trading::price_type(price),
+                                           .qty      = trading::qty_type(1),
+                                           .side     = side };
+}
+
+// long enough not to fit in a string's inline buffer
+std::string
+long_id(int i)
+{
+    return "order-" + std::to_string(i) + "-with-an-id-longer-than-sso";
+}
+
+power_trade::order_book
+make_book(int orders)
+{
+    auto book = power_trade::order_book();
+    for (int i = 0; i < orders; ++i)
+        book.add(make_add(long_id(i), i % 2 ? trading::buy : trading::sell, i % 2 ? 100 - i % 5 : 101 + i % 5));
+    return book;
+}
+
+/// A snapshot with levels in exchange order and several orders per level.
+power_trade::tick_record::snapshot
+make_snapshot(int orders_per_side)
+{
+    auto snap = power_trade::tick_record::snapshot();
+    auto ts   = std::chrono::system_clock::time_point();
+    for (int i = 0; i < orders_per_side; ++i)
+    {
+        auto bid      = make_add(long_id(2 * i), trading::buy, 10000 - i / 4);
+        bid.timestamp = ts + std::chrono::microseconds(i);
+        snap.bids.push_back(bid);
+        auto offer      = make_add(long_id(2 * i + 1), trading::sell, 10001 + i / 4);
+        offer.timestamp = ts + std::chrono::microseconds(i);
+        snap.offers.push_back(offer);
+    }
+    return snap;
+}
+
+power_trade::order_book
+add_each(power_trade::tick_record::snapshot const &snap)
+{
+    auto book = power_trade::order_book();
+    for (auto &o : snap.bids)
+        book.add(o);
+    for (auto &o : snap.offers)
+        book.add(o);
+    return book;
+}
+
+/// Whether a profile holds the best levels of a ladder.
+template < class Ladder >
+bool
+profiles(trading::depth_profile const &profile, Ladder const &ladder)
+{
+    auto expected = std::min(ladder.size(), profile.max_levels());
+    if (profile.levels() != expected)
+        return false;
+    auto ilevel = ladder.begin();
+    for (std::size_t i = 0; i < expected; ++i, ++ilevel)
+        if (profile.price(i) != trading::to_double(ilevel->first) ||
+            profile.qty(i) != trading::to_double(ilevel->second.aggregate_depth))
+            return false;
+    return true;
+}
+}   // namespace
+
+TEST_SUITE("power_trade")
+{
+    TEST_CASE("order_book allocates from its own arena")
+    {
+        auto book  = make_book(20);
+        auto arena = book.arena_.get();
+
+        REQUIRE(!book.offers_.empty());
+        auto &level = book.offers_.begin()->second;
+        CHECK(book.offers_.get_allocator().resource() == arena);
+        CHECK(book.bid_cache_.get_allocator().resource() == arena);
+        CHECK(level.orders.get_allocator().resource() == arena);
+        CHECK(level.orders.front().orderid.get_allocator().resource() == arena);
+
+        auto copy = book;
+        CHECK(copy == book);
+        CHECK(copy.arena_.get() != arena);
+        CHECK(copy.offers_.begin()->second.orders.front().orderid.get_allocator().resource() == copy.arena_.get());
+    }
+
+    TEST_CASE("order_book assignment rebuilds the order caches")
+    {
+        auto book = make_book(20);
+        auto snap = make_book(6);
+        snap      = book;
+        CHECK(snap == book);
+        CHECK(snap.bid_cache_.size() == book.bid_cache_.size());
+        CHECK(snap.offer_cache_.size() == book.offer_cache_.size());
+
+        // the cache must refer to the target's own ladder
+        snap.remove(power_trade::tick_record::remove { .order_id = long_id(1), .side = trading::buy });
+        CHECK(snap.bid_cache_.size() == book.bid_cache_.size() - 1);
+        CHECK(snap != book);
+
+        snap.reset();
+        CHECK(snap.bids_.empty());
+        CHECK(snap.bid_cache_.empty());
+        snap = book;
+        CHECK(snap == book);
+    }
+
+    TEST_CASE("order_book moves its arena rather than copying")
+    {
+        auto book  = make_book(20);
+        auto copy  = book;
+        auto arena = book.arena_.get();
+
+        auto moved = std::move(book);
+        CHECK(moved.arena_.get() == arena);
+        CHECK(moved.bids_.get_allocator().resource() == arena);
+        CHECK(moved == copy);
+
+        auto target = make_book(6);
+        target      = std::move(moved);
+        CHECK(target.arena_.get() == arena);
+        CHECK(target.bid_cache_.get_allocator().resource() == arena);
+        CHECK(target == copy);
+
+        // the caches still refer to the ladders they came with
+        target.remove(power_trade::tick_record::remove { .order_id = long_id(1), .side = trading::buy });
+        CHECK(target.bid_cache_.size() == copy.bid_cache_.size() - 1);
+        CHECK(target != copy);
+
+        book = std::move(target);
+        CHECK(book.arena_.get() == arena);
+        CHECK(book.bid_cache_.size() == copy.bid_cache_.size() - 1);
+    }
+
+    TEST_CASE("order_book load")
+    {
+        auto snap = make_snapshot(200);
+        // a repeated id, which add() resolves in favour of the later order
+        snap.bids.push_back(make_add(long_id(0), trading::buy, 9990));
+
+        auto loaded = power_trade::order_book();
+        loaded.load(snap);
+        CHECK(loaded == add_each(snap));
+        CHECK(loaded.bid_cache_.size() == 200);
+        CHECK(std::get< 0 >(loaded.bid_cache_.find(long_id(0))->second)->first == trading::price_type(9990));
+
+        // out of order levels give the same book
+        auto rng = std::mt19937(42);
+        std::shuffle(snap.bids.begin(), snap.bids.end(), rng);
+        std::shuffle(snap.offers.begin(), snap.offers.end(), rng);
+        auto reloaded = power_trade::order_book();
+        reloaded.load(snap);
+        CHECK(reloaded == add_each(snap));
+
+        // replacing a book which already has orders
+        reloaded.load(make_snapshot(3));
+        CHECK(reloaded == add_each(make_snapshot(3)));
+    }
+
+    TEST_CASE("order_book execute")
+    {
+        auto book  = power_trade::order_book();
+        auto order = make_add("a", trading::sell, 101);
+        order.qty  = trading::qty_type(3);
+        book.add(order);
+        book.add(make_add("b", trading::sell, 101));
+        book.add(make_add("c", trading::sell, 102));
+
+        auto exec = [&](std::string id, int qty)
+        {
+            book.execute(power_trade::tick_record::execute {
+                .order_id = std::move(id), .qty = trading::qty_type(qty), .side = trading::sell });
+        };
+
+        exec("a", 2);
+        CHECK(book.offer_cache_.size() == 3);
+        CHECK(book.offers_.begin()->second.aggregate_depth == 2);
+        CHECK(book.aggregate_offers_ == 3);
+        CHECK(book.aggregate_bids_ == 0);
+
+        exec("a", 1);
+        CHECK(book.offer_cache_.size() == 2);
+        CHECK(book.offers_.begin()->second.orders.size() == 1);
+        CHECK(book.offers_.begin()->second.aggregate_depth == 1);
+
+        exec("b", 1);
+        CHECK(book.offers_.size() == 1);
+        CHECK(book.offers_.begin()->first == 102);
+        CHECK(book.aggregate_offers_ == 1);
+        CHECK(profiles(book.offer_profile(), book.offers_));
+    }
+
+    TEST_CASE("order_book keeps its depth profiles in line with its ladders")
+    {
+        // more levels than a profile holds, so that removals near the top pull levels in from below
+        auto book = make_book(0);
+        auto rng  = std::mt19937(7);
+        auto ids  = std::vector< std::string >();
+        for (int i = 0; i < 2000; ++i)
+        {
+            if (ids.empty() || rng() % 3)
+            {
+                auto side  = rng() % 2 ? trading::buy : trading::sell;
+                auto level = int(rng() % 48);
+                ids.push_back(long_id(i));
+                book.add(make_add(ids.back(), side, side == trading::buy ? 1000 - level : 1001 + level));
+            }
+            else
+            {
+                auto pick = rng() % ids.size();
+                std::swap(ids[pick], ids.back());
+                auto side = book.bid_cache_.count(ids.back()) ? trading::buy : trading::sell;
+                book.remove(power_trade::tick_record::remove { .order_id = ids.back(), .side = side });
+                ids.pop_back();
+            }
+            REQUIRE(profiles(book.bid_profile(), book.bids_));
+            REQUIRE(profiles(book.offer_profile(), book.offers_));
+        }
+
+        auto copy = power_trade::order_book();
+        copy      = book;
+        CHECK(profiles(copy.bid_profile(), copy.bids_));
+
+        copy.load(make_snapshot(200));
+        CHECK(profiles(copy.bid_profile(), copy.bids_));
+        CHECK(profiles(copy.offer_profile(), copy.offers_));
+
+        copy.reset();
+        CHECK(copy.bid_profile().levels() == 0);
+    }
+}
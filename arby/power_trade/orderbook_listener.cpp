@@ -9,9 +9,82 @@
 
 #include "orderbook_listener.hpp"
 
+#include <mutex>
+
 namespace arby
 {
 namespace power_trade
 {
+namespace
+{
+    /// Listeners which may be idling without a handle, so that renewed demand within the idle period finds the
+    /// existing book rather than subscribing a second one.
+    struct listener_registry
+    {
+        std::mutex                                                            m;
+        trading::instrument_table< std::weak_ptr< orderbook_listener_impl > > listeners;
+
+        static listener_registry &
+        get()
+        {
+            static listener_registry r;
+            return r;
+        }
+    };
+}   // namespace
+
+std::shared_ptr< orderbook_listener >
+orderbook_listener::require(asio::any_io_executor        exec,
+                            std::shared_ptr< connector > connector,
+                            trading::market_key          market,
+                            std::chrono::milliseconds    idle_after)
+{
+    auto &inst = trading::instrument_registry::instance()[require_listing(market).id];
+    auto  key  = entity::entity_key();
+    key.set("class", classname);
+    key.set("market", inst.name);
+    key.lock();
+
+    auto svc = entity::entity_service();
+    return svc.require< orderbook_listener >(
+        key,
+        [&]
+        {
+            auto &reg  = listener_registry::get();
+            auto  lock = std::unique_lock(reg.m);
+            auto &weak = reg.listeners[inst.id];
+            auto  impl = weak.lock();
+            if (!impl)
+            {
+                impl = orderbook_listener_impl::create_on_demand(
+                    std::move(exec), { std::move(connector) }, std::move(market), idle_after);
+                weak = impl;
+            }
+            return std::make_shared< orderbook_listener >(std::move(impl));
+        });
+}
+
+orderbook_listener::orderbook_listener(impl_type impl)
+: impl_(std::move(impl))
+{
+    // posted rather than dispatched in both directions, so that release can never overtake acquire
+    asio::post(impl_->get_executor(), [impl = impl_] { impl->acquire(); });
+}
+
+orderbook_listener::~orderbook_listener()
+{
+    auto exec = impl_->get_executor();
+    asio::post(exec, [impl = std::move(impl_)] { impl->release(); });
+}
+
+asio::awaitable< std::string >
+orderbook_listener::summary() const
+{
+    co_return co_await asio::co_spawn(
+        impl_->get_executor(),
+        [impl = impl_]() -> asio::awaitable< std::string > { co_return impl->summary(); },
+        asio::use_awaitable);
+}
+
 }   // namespace power_trade
-}   // namespace arby
\ No newline at end of file
+}   // namespace arby
@@ -10,6 +10,7 @@
 #ifndef ARBY_ARBY_POWER_TRADE_ORDERBOOK_LISTENER_HPP
 #define ARBY_ARBY_POWER_TRADE_ORDERBOOK_LISTENER_HPP
 
+#include "entity/entity_base.hpp"
 #include "power_trade/orderbook_listener_impl.hpp"
 #include "trading/market_key.hpp"
 
@@ -18,22 +19,77 @@ namespace arby
 namespace power_trade
 {
 
-    struct orderbook_listener
+/// @brief A subscriber's share of an on-demand orderbook_listener_impl.
+///
+/// Handles are obtained through require(), which returns the handle already held by other subscribers to the same
+/// market, if there is one. Each handle registers demand for the book while it lives: the venue subscription is
+/// sent when the first handle is created and withdrawn once no handle has existed for the idle period.
+struct orderbook_listener : entity::entity_handle_base
+{
+    using impl_class     = orderbook_listener_impl;
+    using impl_type      = std::shared_ptr< impl_class >;
+    using executor_type  = impl_class::executor_type;
+    using snapshot_class = impl_class::snapshot_class;
+    using snapshot_type  = impl_class::snapshot_type;
+    static constexpr char classname[] = "power_trade::orderbook_listener";
+
+    /// @brief Locate the listener for a market, creating it if necessary.
+    /// @param exec is the executor of a listener which has to be created
+    /// @param idle_after is the idle period of a listener which has to be created
+    /// @note thread-safe
+    static std::shared_ptr< orderbook_listener >
+    require(asio::any_io_executor        exec,
+            std::shared_ptr< connector > connector,
+            trading::market_key          market,
+            std::chrono::milliseconds    idle_after = impl_class::default_idle_after);
+
+    explicit orderbook_listener(impl_type impl);
+
+    orderbook_listener(orderbook_listener const &) = delete;
+    orderbook_listener &
+    operator=(orderbook_listener const &) = delete;
+
+    ~orderbook_listener();
+
+    asio::any_io_executor
+    get_executor() const override
     {
-        using impl_class = orderbook_listener_impl;
-        using impl_type = std::shared_ptr<impl_class>;
-        using executor_type = impl_class::executor_type;
-        using snapshot_class = impl_class::snapshot_class;
-        using snapshot_type = impl_class::snapshot_type;
-        static constexpr char classname[] = "power_trade::orderbook_listener";
+        return impl_->get_executor();
+    }
 
-        orderbook_listener(asio::any_io_executor exec, std::shared_ptr<connector> connector, trading::market_key market);
+    asio::awaitable< std::string >
+    summary() const override;
 
-        executor_type const& get_executor() const { return impl_->get_executor(); }
+    /// @see orderbook_listener_impl::subscribe
+    util::delivery_subscription< snapshot_type >
+    subscribe(asio::any_io_executor exec, util::delivery_policy policy, impl_class::slot_type slot)
+    {
+        return impl_->subscribe(std::move(exec), policy, std::move(slot));
+    }
+
+    /// @see orderbook_listener_impl::checkpoint
+    void
+    checkpoint(std::filesystem::path path, std::chrono::milliseconds interval, asio::any_io_executor io)
+    {
+        impl_->checkpoint(std::move(path), interval, std::move(io));
+    }
+
+    /// @see orderbook_listener_impl::record
+    void
+    record(std::filesystem::path root, asio::any_io_executor io)
+    {
+        impl_->record(std::move(root), std::move(io));
+    }
+
+    impl_type const &
+    get_implementation() const
+    {
+        return impl_;
+    }
 
-      private:
-        impl_type impl_;
-    };
+  private:
+    impl_type impl_;
+};
 
 }   // namespace power_trade
 }   // namespace arby
@@ -11,12 +11,15 @@
 
 #include "asioex/helpers.hpp"
 #include "util/monitor.hpp"
+#include "util/recycling_allocator.hpp"
 
+#include <fmt/chrono.h>
 #include <fmt/ostream.h>
 #include <spdlog/spdlog.h>
 #include <util/truncate.hpp>
 
 #include <functional>
+#include <iterator>
 
 namespace arby
 {
@@ -26,45 +29,284 @@ namespace power_trade
 using namespace std::literals;
 
 void
-orderbook_listener_impl::on_connection_state(connection_state cstate)
+orderbook_listener_impl::on_connection_state(std::size_t leg, connection_state cstate)
 {
-    connstate_ = cstate;
-    spdlog::info("{}::{} {}", this->source_id_, __func__, cstate);
-    if (connstate_.down())
+    auto &l     = legs_[leg];
+    l.connstate = cstate;
+    arbiter_.leg_state(leg, cstate.up());
+    spdlog::info("{}::{} leg {} {}", this->source_id_, __func__, leg, cstate);
+    if (cstate.down())
     {
-        connection_condition_.reset(trading::feed_state::stale);
-        connection_condition_.errors.push_back("connection dropped");
-        book_condition_.merge(trading::feed_state::stale);
+        if (arbiter_.any_up())
+        {
+            spdlog::info("{}::{} continuing on remaining legs", this->source_id_, __func__);
+        }
+        else
+        {
+            connection_condition_.reset(trading::feed_state::stale);
+            connection_condition_.errors.push_back("connection dropped");
+            book_condition_.merge(trading::feed_state::stale);
+            awaiting_snapshot_ = true;
+            recovering_        = false;
+            watchdog_.cancel();
+        }
     }
     else
     {
         connection_condition_.reset(trading::feed_state::good);
-        auto req = json::value({ { "subscribe",
-                                   { { "market_id", "0" },
-                                     { "symbol", native_symbol(symbol_) },
-                                     { "type", "snap_full_updates" },
-                                     { "interval", "0" },
-                                     { "user_tag", my_subscribe_id_ } } } });
-        connector_->send(json::serialize(req));
+        if (wanted_)
+            send_subscribe(l);
+    }
+    report_book_state();
+    update();
+}
+
+void
+orderbook_listener_impl::send_subscribe(feed_leg &l)
+{
+    auto req = json::value({ { "subscribe",
+                               { { "market_id", "0" },
+                                 { "symbol", json::string_view(listing_.native_symbol) },
+                                 { "type", "snap_full_updates" },
+                                 { "interval", "0" },
+                                 { "user_tag", my_subscribe_id_ } } } });
+    l.source->send(json::serialize(req));
+}
+
+void
+orderbook_listener_impl::send_unsubscribe(feed_leg &l)
+{
+    auto req = json::value({ { "unsubscribe",
+                               { { "market_id", "0" },
+                                 { "symbol", json::string_view(listing_.native_symbol) },
+                                 { "type", "snap_full_updates" },
+                                 { "user_tag", my_subscribe_id_ } } } });
+    l.source->send(json::serialize(req));
+}
+
+void
+orderbook_listener_impl::acquire()
+{
+    assert(asioex::on_correct_thread(get_executor()));
+    ++demand_;
+    idle_timer_.cancel();
+    lingering_.reset();
+    if (std::exchange(wanted_, true))
+        return;
+
+    spdlog::info("{}::{} subscribing on demand", source_id_, __func__);
+    book_condition_.reset(trading::not_ready);
+    book_condition_.errors.push_back("subscribing");
+    for (auto &l : legs_)
+    {
+        l.source->add_book(this);
+        if (l.connstate.up())
+            send_subscribe(l);
+    }
+    restore_checkpoint();
+    update();
+}
+
+void
+orderbook_listener_impl::release()
+{
+    assert(asioex::on_correct_thread(get_executor()));
+    assert(demand_ > 0);
+    if (--demand_ != 0 || !idle_after_)
+        return;
+
+    lingering_ = shared_from_this();
+    idle_timer_.expires_after(*idle_after_);
+}
+
+void
+orderbook_listener_impl::on_idle()
+{
+    if (demand_ != 0)
+        return;
+
+    spdlog::info("{}::{} no demand for {}, unsubscribing", source_id_, __func__, *idle_after_);
+    wanted_            = false;
+    awaiting_snapshot_ = true;
+    warm_              = false;
+    recovering_        = false;
+    watchdog_.cancel();
+    for (auto &l : legs_)
+    {
+        if (l.connstate.up())
+            send_unsubscribe(l);
+        l.source->remove_book(this);
+        l.reported_good = false;
     }
+    snapshot_service_.clear();
+    book_condition_.reset(trading::not_ready);
+    book_condition_.errors.push_back("idle");
     update();
+
+    // the wheel is still running this timer: let go of ourselves once it has returned
+    asio::post(get_executor(), [self = std::move(lingering_)] {});
+}
+
+void
+orderbook_listener_impl::checkpoint(std::filesystem::path path, std::chrono::milliseconds interval, asio::any_io_executor io)
+{
+    asio::dispatch(asio::bind_executor(get_executor(),
+                                       [self = shared_from_this(), path = std::move(path), interval, io = std::move(io)]
+                                       {
+                                           self->checkpoint_path_     = path;
+                                           self->checkpoint_interval_ = interval;
+                                           self->checkpoint_io_       = io;
+                                           self->restore_checkpoint();
+                                           self->update();
+                                           self->checkpoint_timer_.expires_after(interval);
+                                       }));
+}
+
+void
+orderbook_listener_impl::record(std::filesystem::path root, asio::any_io_executor io)
+{
+    asio::dispatch(asio::bind_executor(
+        get_executor(),
+        [self = shared_from_this(), root = std::move(root), io = std::move(io)]
+        {
+            if (self->recorder_)
+                asio::post(self->recorder_strand_, [recorder = std::move(self->recorder_)] {});
+            try
+            {
+                self->recorder_        = std::make_shared< tick_store_writer >(root, self->instrument_.name);
+                self->recorder_strand_ = asio::make_strand(io);
+            }
+            catch (std::exception &e)
+            {
+                spdlog::error("{}::record {}", self->source_id_, e.what());
+            }
+        }));
+}
+
+void
+orderbook_listener_impl::restore_checkpoint()
+{
+    if (checkpoint_path_.empty() || !wanted_ || !awaiting_snapshot_ || warm_)
+        return;
+
+    auto &book = snapshot_service_.orderbook();
+    if (!book.bids_.empty() || !book.offers_.empty())
+        return;
+
+    try
+    {
+        auto cp = mapped_checkpoint::open(checkpoint_path_);
+        if (!cp)
+            return;
+        if (cp->market() != instrument_.name)
+        {
+            spdlog::warn("{}::{} {} holds {}, ignoring", source_id_, __func__, checkpoint_path_.string(), cp->market());
+            return;
+        }
+
+        recycle_snapshots();
+        snapshot_ = std::shared_ptr< orderbook_snapshot >(
+            snapshot_service_.process_tick(tick_record(cp->to_snapshot())).release(),
+            snapshot_pool::deleter { released_snapshots_ });
+        warm_ = true;
+        spdlog::info("{}::{} restored {} bids and {} offers as of {}",
+                     source_id_,
+                     __func__,
+                     cp->bids().size(),
+                     cp->offers().size(),
+                     cp->upstream_time());
+
+        // the book is usable, but only as a guide until the live snapshot confirms it
+        book_condition_.reset(trading::stale);
+        book_condition_.errors.push_back("restored from checkpoint");
+        if (connection_condition_.state == trading::not_ready)
+            connection_condition_.state = trading::stale;
+    }
+    catch (std::exception &e)
+    {
+        spdlog::warn("{}::{} {}", source_id_, __func__, e.what());
+    }
+}
+
+void
+orderbook_listener_impl::on_checkpoint_timer()
+{
+    checkpoint_timer_.expires_after(checkpoint_interval_);
+    if (!wanted_ || awaiting_snapshot_ || book_condition_.state != trading::good)
+        return;
+
+    auto written = std::make_tuple(snapshot_->generation, snapshot_->sequence);
+    if (written == checkpoint_written_ || checkpoint_busy_->exchange(true))
+        return;
+    checkpoint_written_ = written;
+
+    // a published snapshot is immutable, so it can be encoded on the io executor while the book moves on
+    asio::post(checkpoint_io_,
+               [snap = snapshot_type(snapshot_), path = checkpoint_path_, busy = checkpoint_busy_, market = instrument_.name]
+               {
+                   try
+                   {
+                       write_file_atomically(path, encode_checkpoint(market, snap->book, snap->generation, snap->sequence));
+                   }
+                   catch (std::exception &e)
+                   {
+                       spdlog::error("{}::checkpoint {}: {}", classname, market, e.what());
+                   }
+                   busy->store(false);
+               });
 }
 
 std::shared_ptr< orderbook_listener_impl >
 orderbook_listener_impl::create(asio::any_io_executor exec, std::shared_ptr< connector > connector, trading::market_key symbol)
 {
-    auto impl = std::make_shared< orderbook_listener_impl >(std::move(exec), std::move(connector), std::move(symbol));
+    auto legs = std::vector< std::shared_ptr< power_trade::connector > > { std::move(connector) };
+    return create(std::move(exec), std::move(legs), std::move(symbol));
+}
+
+std::shared_ptr< orderbook_listener_impl >
+orderbook_listener_impl::create(asio::any_io_executor                       exec,
+                                std::vector< std::shared_ptr< connector > > legs,
+                                trading::market_key                         symbol,
+                                std::optional< asioex::timer_wheel >        watchdogs)
+{
+    auto impl = std::make_shared< orderbook_listener_impl >(
+        std::move(exec), std::move(legs), std::move(symbol), std::move(watchdogs));
+    impl->start();
+    return impl;
+}
+
+std::shared_ptr< orderbook_listener_impl >
+orderbook_listener_impl::create_on_demand(asio::any_io_executor                       exec,
+                                          std::vector< std::shared_ptr< connector > > legs,
+                                          trading::market_key                         symbol,
+                                          std::chrono::milliseconds                   idle_after,
+                                          std::optional< asioex::timer_wheel >        timers)
+{
+    auto impl = std::make_shared< orderbook_listener_impl >(
+        std::move(exec), std::move(legs), std::move(symbol), std::move(timers));
+    impl->idle_after_ = idle_after;
+    impl->wanted_     = false;
     impl->start();
     return impl;
 }
 
-orderbook_listener_impl::orderbook_listener_impl(asio::any_io_executor        exec,
-                                                 std::shared_ptr< connector > connector,
-                                                 trading::market_key          symbol)
+orderbook_listener_impl::orderbook_listener_impl(asio::any_io_executor                       exec,
+                                                 std::vector< std::shared_ptr< connector > > legs,
+                                                 trading::market_key                         symbol,
+                                                 std::optional< asioex::timer_wheel >        watchdogs)
 : util::has_executor_base(std::move(exec))
-, connector_(std::move(connector))
 , symbol_(std::move(symbol))
+, arbiter_(legs.size())
+, timers_(watchdogs ? *watchdogs : asioex::timer_wheel(get_executor(), 100ms))
+, watchdog_(timers_, [this] { on_stale(); })
+, idle_timer_(timers_, [this] { on_idle(); })
+, checkpoint_timer_(timers_, [this] { on_checkpoint_timer(); })
 {
+    assert(!legs.empty());
+    legs_.reserve(legs.size());
+    for (auto &c : legs)
+        legs_.push_back(feed_leg { .source = std::move(c) });
+
     connection_condition_.state = trading::feed_state::not_ready;
     connection_condition_.errors.push_back("connection state unknown");
     book_condition_.state = trading::feed_state::not_ready;
@@ -76,83 +318,116 @@ orderbook_listener_impl::orderbook_listener_impl(asio::any_io_executor        ex
     snapshot_->source = source_id_;
 }
 
+orderbook_listener_impl::~orderbook_listener_impl()
+{
+    for (auto &l : legs_)
+        l.source->remove_book(this);
+
+    // the writer flushes as it is destroyed, which is disk work
+    if (recorder_)
+        asio::post(recorder_strand_, [recorder = std::move(recorder_)] {});
+}
+
 void
 orderbook_listener_impl::start()
 {
+    wait_ticks();
     asio::co_spawn(get_executor(), run(shared_from_this()), asio::detached);
 }
 
-namespace
+void
+orderbook_listener_impl::wait_ticks()
 {
-template < class F, class Filter >
-struct filter_message
+    ticks_.async_wait(asio::bind_executor(get_executor(),
+                                          util::bind_recycling_allocator(
+                                              [weak = weak_from_this()](error_code ec)
+                                              {
+                                                  if (ec)
+                                                      return;
+                                                  if (auto self = weak.lock())
+                                                      self->drain_ticks();
+                                              })));
+}
+
+void
+orderbook_listener_impl::drain_ticks()
 {
-    filter_message(F next, Filter filters)
-    : next(std::move(next))
-    , filters(std::move(filters))
-    {
-    }
+    // batches are bounded so that one busy book does not starve the others on the executor
+    ticks_.try_receive_n(std::back_inserter(tick_batch_), max_tick_batch);
 
-    void
-    operator()(std::shared_ptr< connector::inbound_message const > payload) const
+    if (auto rejected = ticks_.rejected(); rejected != ticks_rejected_)
     {
-        for (auto &[k, v] : filters)
-        {
-            auto pv = payload->object().if_contains(k);
-            if (!pv)
-                return;
-            auto ps = pv->if_string();
-            if (!ps)
-                return;
-            if (*ps != v)
-                return;
-        }
-        next(payload);
+        ticks_rejected_ = rejected;
+        tick_batch_.clear();
+        on_tick_overflow();
     }
-    Filter filters;
-    F      next;
-};
-
-}   // namespace
-
-asio::awaitable< void >
-orderbook_listener_impl::run(std::shared_ptr< orderbook_listener_impl > self)
-{
-    auto [conn, connstate] = co_await connector_->watch_connection_state(connector::connection_state_slot(
-        [weak = weak_from_this()](connection_state state)
-        {
-            if (auto self = weak.lock())
-                asio::post(asio::bind_executor(self->get_executor(), [self, state] { self->on_connection_state(state); }));
-        }));
 
-    cmd_response_conn_ = co_await connector_->watch_messages(
-        "command_response", std::bind(&orderbook_listener_impl::_handle_command_response, weak_from_this(), std::placeholders::_1));
+    for (auto &queued : tick_batch_)
+        on_tick(queued.leg, std::move(queued.tick));
+    tick_batch_.clear();
 
-    tick_con_[0] = co_await connector_->watch_messages(
-        "snapshot",
-        filter_message(
-            std::bind(&orderbook_listener_impl::_handle_tick, weak_from_this(), std::placeholders::_1, tick_code::snapshot),
-            make_message_filter()));
+    wait_ticks();
+}
 
-    tick_con_[1] = co_await connector_->watch_messages(
-        "order_added",
-        filter_message(std::bind(&orderbook_listener_impl::_handle_tick, weak_from_this(), std::placeholders::_1, tick_code::add),
-                       make_message_filter()));
+void
+orderbook_listener_impl::on_tick_overflow()
+{
+    spdlog::error("{}::{} tick queue overflow, {} ticks lost in total", source_id_, __func__, ticks_rejected_);
+    book_condition_.reset(trading::stale);
+    book_condition_.errors.push_back("tick queue overflow");
+    awaiting_snapshot_ = true;
+    recovering_        = true;
+    watchdog_.cancel();
+
+    // only this book has lost ticks, so only this book is resubscribed. The connectors' other books are unaffected.
+    if (wanted_)
+        for (auto &l : legs_)
+            if (l.connstate.up())
+            {
+                send_unsubscribe(l);
+                send_subscribe(l);
+            }
+    report_book_state();
+    update();
+}
 
-    tick_con_[2] = co_await connector_->watch_messages(
-        "order_deleted",
-        filter_message(
-            std::bind(&orderbook_listener_impl::_handle_tick, weak_from_this(), std::placeholders::_1, tick_code::remove),
-            make_message_filter()));
+void
+orderbook_listener_impl::recycle_snapshots()
+{
+    released_snapshots_->reclaim([this](std::unique_ptr< orderbook_snapshot > snap)
+                                 { snapshot_service_.deallocate_snapshot(std::move(snap)); });
+}
 
-    tick_con_[3] = co_await connector_->watch_messages(
-        "order_executed",
-        filter_message(
-            std::bind(&orderbook_listener_impl::_handle_tick, weak_from_this(), std::placeholders::_1, tick_code::execute),
-            make_message_filter()));
+asio::awaitable< void >
+orderbook_listener_impl::run(std::shared_ptr< orderbook_listener_impl > self)
+{
+    using std::placeholders::_1;
+    using std::placeholders::_2;
 
-    connection_state_conn_ = std::move(conn);
-    on_connection_state(connstate);
+    for (std::size_t i = 0; i < legs_.size(); ++i)
+    {
+        auto &l = legs_[i];
+        if (wanted_)
+            l.source->add_book(this);
+
+        auto [conn, connstate] = co_await l.source->watch_connection_state(connector::connection_state_slot(
+            [weak = weak_from_this(), i](connection_state state)
+            {
+                if (auto self = weak.lock())
+                    asio::post(asio::bind_executor(self->get_executor(),
+                                                   [self, i, state] { self->on_connection_state(i, state); }));
+            }));
+
+        l.cmd_response_conn = co_await l.source->watch_messages(
+            "command_response", std::bind(&orderbook_listener_impl::_handle_command_response, weak_from_this(), _1));
+
+        // the connector routes the book's messages to it by instrument id
+        l.book_conn = co_await l.source->watch_book(
+            listing_, std::bind(&orderbook_listener_impl::_handle_tick, weak_from_this(), _1, _2, i));
+
+        l.connection_state_conn = std::move(conn);
+        on_connection_state(i, connstate);
+    }
 }
 
 void
@@ -168,7 +443,8 @@ orderbook_listener_impl::_handle_command_response(std::weak_ptr< orderbook_liste
     {
         if (payload->object().at("user_tag").as_string() != self->my_subscribe_id_)
             return;
-        asio::dispatch(asio::bind_executor(self->get_executor(), [self, payload] { self->on_command_response(payload); }));
+        asio::dispatch(asio::bind_executor(
+            self->get_executor(), util::bind_recycling_allocator([self, payload] { self->on_command_response(payload); })));
     }
     catch (std::exception &e)
     {
@@ -179,7 +455,7 @@ orderbook_listener_impl::_handle_command_response(std::weak_ptr< orderbook_liste
 json::string
 orderbook_listener_impl::build_subscribe_id() const
 {
-    auto result = "order_book:"s + to_string(symbol_);
+    auto result = "order_book:"s + instrument_.name;
     return json::string(result);
 }
 
@@ -188,9 +464,16 @@ orderbook_listener_impl::on_command_response(std::shared_ptr< connector::inbound
 {
     spdlog::trace("{}::{}({})", classname, __func__, util::truncate(payload->view()));
 
+    // a leg which resubscribes while another keeps the book good does not change the book's condition, and the
+    // response to an unsubscribe carries the same tag
+    if (!awaiting_snapshot_ || !wanted_)
+        return;
+
     if (auto &code = payload->object().at("error_code"); code == "0")
     {
-        book_condition_.reset(trading::not_ready);
+        // a book restored from a checkpoint, or being recovered after an overflow, remains usable, if stale, until
+        // the live snapshot arrives
+        book_condition_.reset(warm_ || recovering_ ? trading::stale : trading::not_ready);
         book_condition_.errors.push_back("subscribed");
     }
     else
@@ -204,7 +487,8 @@ orderbook_listener_impl::on_command_response(std::shared_ptr< connector::inbound
 void
 orderbook_listener_impl::_handle_tick(std::weak_ptr< orderbook_listener_impl >            weak,
                                       std::shared_ptr< const connector::inbound_message > payload,
-                                      tick_code                                           code)
+                                      tick_code                                           code,
+                                      std::size_t                                         leg)
 {
     auto self = weak.lock();
     if (!self)
@@ -216,10 +500,9 @@ orderbook_listener_impl::_handle_tick(std::weak_ptr< orderbook_listener_impl >
 
     try
     {
-        asio::dispatch(asio::bind_executor(
-            self->get_executor(),
-            [self, tick = tick_record { code, std::shared_ptr< json::object const >(payload, &payload->object()) }]() mutable
-            { self->on_tick(std::move(tick)); }));
+        // a rejected tick is noticed by the listener when it next drains the queue
+        auto tick = tick_record(code, std::shared_ptr< json::object const >(payload, &payload->object()));
+        self->ticks_.try_send(queued_tick { .leg = leg, .tick = std::move(tick) });
     }
     catch (std::exception &e)
     {
@@ -227,39 +510,135 @@ orderbook_listener_impl::_handle_tick(std::weak_ptr< orderbook_listener_impl >
     }
 }
 void
-orderbook_listener_impl::on_tick(tick_record tick)
+orderbook_listener_impl::on_tick(std::size_t leg, tick_record tick)
 {
-    auto deleter = [weak = weak_from_this()](orderbook_snapshot *psnap) noexcept
+    if (!wanted_)
+    {
+        spdlog::trace("{}::{} unsubscribed, dropping {}", source_id_, __func__, tick.code());
+        return;
+    }
+
+    if (tick.code() == tick_code::snapshot)
     {
-        auto up = std::unique_ptr< orderbook_snapshot >(psnap);
-        if (auto self = weak.lock())
+        // with redundant legs, a leg which reconnects sends a snapshot of a book which the other legs have kept good
+        if (!awaiting_snapshot_ && arbiter_.legs() > 1)
         {
-            asio::dispatch(asio::bind_executor(self->get_executor(),
-                                               [self, up = std::move(up)]() mutable
-                                               { self->snapshot_service_.deallocate_snapshot(std::move(up)); }));
+            spdlog::trace("{}::{} book is good, ignoring snapshot from leg {}", source_id_, __func__, leg);
+            return;
         }
-    };
-    snapshot_ = std::shared_ptr< orderbook_snapshot >(snapshot_service_.process_tick(std::move(tick)).release(), deleter);
+        awaiting_snapshot_ = false;
+        recovering_        = false;
+        arbiter_.restart(leg, get< tick_record::snapshot >(tick.as_variant()));
+    }
+    else if (awaiting_snapshot_)
+    {
+        spdlog::trace("{}::{} awaiting snapshot, dropping {}", source_id_, __func__, tick.code());
+        return;
+    }
+    else if (!arbiter_.accept(leg, tick))
+        return;
+
+    // a book restored from a checkpoint is reconciled with the first live snapshot rather than replaced, so that
+    // subscribers are brought up to date incrementally
+    auto policy = std::exchange(warm_, false) ? resync_policy::diff : snapshot_service_.resync_;
+
+    if (recorder_)
+        asio::post(recorder_strand_,
+                   util::bind_recycling_allocator(
+                       [recorder = recorder_, tick, market = std::string_view(instrument_.name)]
+                       {
+                           try
+                           {
+                               recorder->append(tick);
+                           }
+                           catch (std::exception &e)
+                           {
+                               spdlog::error("{}::record {}: {}", classname, market, e.what());
+                           }
+                       }));
+
+    // subscribers may release snapshots on any thread
+    recycle_snapshots();
+    snapshot_ = std::shared_ptr< orderbook_snapshot >(snapshot_service_.process_tick(std::move(tick), policy).release(),
+                                                      snapshot_pool::deleter { released_snapshots_ });
 
     book_condition_.reset(trading::good);
+    watchdog_.expires_after(stale_after_);
+    publish();
+    report_book_state();
+}
+
+void
+orderbook_listener_impl::on_stale()
+{
+    if (awaiting_snapshot_ || !arbiter_.any_up())
+        return;
+
+    spdlog::warn("{}::{} no update for {}", source_id_, __func__, stale_after_);
+    book_condition_.reset(trading::stale);
+    book_condition_.errors.push_back(fmt::format("no update for {}", stale_after_));
     update();
 }
 
+void
+orderbook_listener_impl::report_book_state()
+{
+    for (auto &l : legs_)
+    {
+        auto good = !awaiting_snapshot_ && l.connstate.up();
+        if (std::exchange(l.reported_good, good) != good)
+            l.source->report_book_state(this, good);
+    }
+}
+
+std::string
+orderbook_listener_impl::summary() const
+{
+    assert(asioex::on_correct_thread(get_executor()));
+    return fmt::format("{}: {}", source_id_, arbiter_.summary());
+}
+
 auto
-orderbook_listener_impl::subscribe(slot_type slot) -> std::tuple< sigs::connection, snapshot_type >
+orderbook_listener_impl::subscribe(slot_type slot) -> std::tuple< util::connection, snapshot_type >
 {
     assert(asioex::on_correct_thread(get_executor()));
     return std::make_tuple(signal_.connect(std::move(slot)), snapshot_);
 }
+
+auto
+orderbook_listener_impl::subscribe(asio::any_io_executor exec, util::delivery_policy policy, slot_type slot)
+    -> util::delivery_subscription< snapshot_type >
+{
+    auto queue = std::make_shared< util::delivery_queue< snapshot_type > >(std::move(exec), policy, std::move(slot));
+    asio::dispatch(asio::bind_executor(get_executor(),
+                                       [self = shared_from_this(), queue]
+                                       {
+                                           queue->attach(self->signal_);
+                                           queue->publish(self->snapshot_);
+                                       }));
+    return util::delivery_subscription< snapshot_type >(std::move(queue));
+}
+
 std::string
 orderbook_listener_impl::build_source_id() const
 {
-    return fmt::format("{}[{}]", classname, symbol_);
+    return fmt::format("{}[{}]", classname, instrument_.name);
 }
 
 void
 orderbook_listener_impl::update()
 {
+    // subscribers on other executors may be reading the published snapshot, so the condition is changed in a copy
+    recycle_snapshots();
+    snapshot_ = std::shared_ptr< orderbook_snapshot >(snapshot_service_.make_snapshot().release(),
+                                                      snapshot_pool::deleter { released_snapshots_ });
+    publish();
+}
+
+void
+orderbook_listener_impl::publish()
+{
+    snapshot_->source = source_id_;
     snapshot_->condition.reset(trading::good);
     snapshot_->condition.merge(connection_condition_);
     snapshot_->condition.merge(book_condition_);
@@ -10,17 +10,29 @@
 #ifndef ARBY_ARBY_POWER_TRADE_ORDERBOOK_LISTENER_IMPL_HPP
 #define ARBY_ARBY_POWER_TRADE_ORDERBOOK_LISTENER_IMPL_HPP
 
-#include "config/signals.hpp"
+#include "asioex/timer_wheel.hpp"
+#include "power_trade/book_checkpoint.hpp"
 #include "power_trade/connector.hpp"
+#include "power_trade/feed_arbiter.hpp"
 #include "power_trade/native_symbol.hpp"
 #include "power_trade/order_book.hpp"
 #include "power_trade/orderbook_snapshot_service.hpp"
 #include "power_trade/tick_history.hpp"
+#include "power_trade/tick_store.hpp"
 #include "trading/aggregate_book_feed.hpp"
 #include "trading/market_key.hpp"
+#include "util/free_list.hpp"
+#include "util/delivery_queue.hpp"
+#include "util/lockfree_channel.hpp"
+#include "util/signal.hpp"
 
 #include <boost/variant2.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <optional>
+
 namespace arby
 {
 namespace power_trade
@@ -31,12 +43,26 @@ namespace power_trade
 /// This class maintains the power-trade-specific representation of an order
 /// book and delivers generic snapshots to interested observers. It is an
 /// implementation of a generic orderbook_feed. Upon reconnect, the listener
-/// will rebuild the entire order book via a snapshot request. It will not
-/// seek to persist data to local storage.
+/// will rebuild the entire order book via a snapshot request. It persists
+/// the book to local storage only if asked to, by checkpoint().
+///
+/// The listener may be given more than one connector, each subscribing to
+/// the same book on its own socket. Each tick is then taken from whichever
+/// connector delivers it first (see feed_arbiter). While at least one leg is
+/// up and the book is good, a leg which drops and reconnects does not reset
+/// the book, and its fresh snapshot is ignored.
+///
+/// A book which receives no update for stale_after() while connected is
+/// marked stale until the next update.
+///
+/// Ticks are handed from the connectors' threads to the listener through a
+/// lock-free queue which the listener drains in batches. Should the queue
+/// ever overflow, the book is marked stale and resubscribed on each leg, so
+/// that it is rebuilt from a fresh snapshot. The connectors are left alone.
 ///
 /// @note This class maintains its own executor, which may not be the same
-/// executor as the Power Trade connector it holds. Therefore, any events
-/// emitted from the connector must be marshalled onto our own executor via
+/// executor as the Power Trade connectors it holds. Therefore, any events
+/// emitted from a connector must be marshalled onto our own executor via
 /// POST. This also separates the processing of our data from the io loop.
 struct orderbook_listener_impl
 : util::has_executor_base
@@ -48,13 +74,43 @@ struct orderbook_listener_impl
     using snapshot_class = orderbook_snapshot;
     using snapshot_type  = std::shared_ptr< snapshot_class const >;
 
-    using signal_type = typename sigs::signal_type< void(snapshot_type), sigs::keywords::mutex_type< sigs::dummy_mutex > >::type;
+    using signal_type = util::signal< void(snapshot_type) >;
     using slot_type   = signal_type::slot_type;
 
+    static constexpr std::chrono::milliseconds default_stale_after { 10000 };
+    static constexpr std::chrono::milliseconds default_idle_after { 60000 };
+    static constexpr std::size_t               tick_queue_capacity = 16384;
+    static constexpr std::size_t               max_tick_batch      = 256;
+
     static std::shared_ptr< orderbook_listener_impl >
     create(asio::any_io_executor exec, std::shared_ptr< connector > connector, trading::market_key symbol);
 
-    orderbook_listener_impl(asio::any_io_executor exec, std::shared_ptr< connector > connector, trading::market_key symbol);
+    /// @brief Create a listener which arbitrates between redundant connectors.
+    /// @param watchdogs is the wheel which runs the staleness watchdog. It should be shared by all listeners on the
+    /// same executor. If not given, the listener creates its own.
+    static std::shared_ptr< orderbook_listener_impl >
+    create(asio::any_io_executor                       exec,
+           std::vector< std::shared_ptr< connector > > legs,
+           trading::market_key                         symbol,
+           std::optional< asioex::timer_wheel >        watchdogs = std::nullopt);
+
+    /// @brief Create a listener which only subscribes to the venue while it has demand.
+    ///
+    /// The venue subscription is sent when acquire() is first called, and an unsubscribe is sent once the listener has
+    /// been without demand for idle_after. The book is discarded while unsubscribed.
+    static std::shared_ptr< orderbook_listener_impl >
+    create_on_demand(asio::any_io_executor                       exec,
+                     std::vector< std::shared_ptr< connector > > legs,
+                     trading::market_key                         symbol,
+                     std::chrono::milliseconds                   idle_after,
+                     std::optional< asioex::timer_wheel >        timers = std::nullopt);
+
+    orderbook_listener_impl(asio::any_io_executor                       exec,
+                            std::vector< std::shared_ptr< connector > > legs,
+                            trading::market_key                         symbol,
+                            std::optional< asioex::timer_wheel >        watchdogs = std::nullopt);
+
+    ~orderbook_listener_impl();
 
     void
     start();
@@ -62,19 +118,144 @@ struct orderbook_listener_impl
     void
     stop();
 
-    std::tuple< sigs::connection, snapshot_type >
+    std::tuple< util::connection, snapshot_type >
     subscribe(slot_type slot);
 
+    /// @brief Subscribe for delivery on the subscriber's own executor. Thread-safe.
+    ///
+    /// The book only publishes into the subscriber's queue, so a slow subscriber cannot stall book maintenance. The
+    /// current snapshot is delivered first. Delivery stops when the subscription is cancelled or destroyed.
+    util::delivery_subscription< snapshot_type >
+    subscribe(asio::any_io_executor exec, util::delivery_policy policy, slot_type slot);
+
+    /// @brief Register demand for the book. The first demand subscribes to the venue.
+    /// @note must be called on the listener's executor
+    void
+    acquire();
+
+    /// @brief Withdraw demand registered by acquire(). Once there has been no demand for idle_after, the venue is
+    /// unsubscribed. Until then the listener keeps itself alive, so that renewed demand finds the book intact.
+    /// @note must be called on the listener's executor
+    void
+    release();
+
+    /// @brief Keep a checkpoint of the book in a file, from which to warm-start.
+    ///
+    /// If the book has not been built, an existing checkpoint is loaded at once and published as stale. The first
+    /// live exchange snapshot is then applied to it as a difference. While the book is good, it is written to the file
+    /// every interval. Encoding and writing take place on io, so that disk latency does not stall the book.
+    /// @note thread-safe
+    void
+    checkpoint(std::filesystem::path path, std::chrono::milliseconds interval, asio::any_io_executor io);
+
+    /// @brief Record every tick applied to the book in a tick store under root.
+    ///
+    /// Ticks are appended on a strand of io, so that disk latency does not stall the book.
+    /// @note thread-safe
+    void
+    record(std::filesystem::path root, asio::any_io_executor io);
+
+    /// @brief Per-leg win rate and lag.
+    std::string
+    summary() const;
+
+    trading::instrument const &
+    instrument() const
+    {
+        return instrument_;
+    }
+
+    std::chrono::milliseconds
+    stale_after() const
+    {
+        return stale_after_;
+    }
+
+    void
+    stale_after(std::chrono::milliseconds value)
+    {
+        stale_after_ = value;
+    }
+
+    /// @brief The idle period after which an on-demand listener unsubscribes, or nothing if it subscribes forever.
+    std::optional< std::chrono::milliseconds >
+    idle_after() const
+    {
+        return idle_after_;
+    }
+
+    void
+    idle_after(std::chrono::milliseconds value)
+    {
+        assert(idle_after_);
+        idle_after_ = value;
+    }
+
+    /// @brief How an exchange snapshot received after a resubscription is applied to the book.
+    void
+    resync(resync_policy value)
+    {
+        snapshot_service_.resync_ = value;
+    }
+
   private:
+    struct feed_leg
+    {
+        std::shared_ptr< connector >    source;
+        connection_state                connstate;
+        bool                            reported_good = false;
+        util::cross_executor_connection connection_state_conn;
+        util::cross_executor_connection cmd_response_conn;
+        util::cross_executor_connection book_conn;
+    };
+
+    struct queued_tick
+    {
+        std::size_t leg;
+        tick_record tick;
+    };
+
     asio::awaitable< void >
     run(std::shared_ptr< orderbook_listener_impl > self);
 
+    /// Park until ticks are queued, then drain them.
+    void
+    wait_ticks();
+
+    void
+    drain_ticks();
+
+    /// The tick queue overflowed, so ticks have been lost. Resubscribe to rebuild the book from a fresh snapshot.
+    void
+    on_tick_overflow();
+
+    /// Reclaim the snapshots which subscribers have released.
+    void
+    recycle_snapshots();
+
     void
-    on_connection_state(connection_state cstate);
+    on_connection_state(std::size_t leg, connection_state cstate);
 
     void
     on_command_response(std::shared_ptr< connector::inbound_message const > payload);
 
+    void
+    send_subscribe(feed_leg &l);
+
+    void
+    send_unsubscribe(feed_leg &l);
+
+    /// The idle timer expired: nothing has acquired the book for idle_after_.
+    void
+    on_idle();
+
+    /// Load the checkpoint into a book which has not yet been built.
+    void
+    restore_checkpoint();
+
+    void
+    on_checkpoint_timer();
+
     json::string
     build_subscribe_id() const;
 
@@ -97,45 +278,89 @@ struct orderbook_listener_impl
     static void
     _handle_tick(std::weak_ptr< orderbook_listener_impl >            weak,
                  std::shared_ptr< connector::inbound_message const > payload,
-                 tick_code                                           code);
+                 tick_code                                           code,
+                 std::size_t                                         leg);
 
     void
-    on_tick(tick_record tick);
+    on_tick(std::size_t leg, tick_record tick);
 
+    /// Publish the book's current condition in a new snapshot. A published snapshot is never changed.
     void
     update();
 
-    std::array< std::tuple< json::string, json::string >, 2 >
-    make_message_filter() const
-    {
-        auto result = std::array< std::tuple< json::string, json::string >, 2 > { { { "symbol", native_symbol(symbol_) },
-                                                                                    { "market_id", "0" } } };
-        return result;
-    }
+    /// Set the condition of snapshot_, which has not yet been published, and publish it.
+    void
+    publish();
+
+    /// The watchdog expired: nothing has been heard for stale_after_.
+    void
+    on_stale();
+
+    /// Tell each connector whether this book is good through it, for its recovery time metric. The book is good
+    /// through a leg which is up once the book has a snapshot. Only changes are reported.
+    void
+    report_book_state();
 
     std::string
     build_source_id() const;
 
-    trading::market_key const symbol_;
-    json::string const        my_subscribe_id_ = build_subscribe_id();
-    std::string const         source_id_       = build_source_id();
+    trading::market_key const     symbol_;
+    trading::venue_listing const &listing_         = require_listing(symbol_);
+    trading::instrument const    &instrument_      = trading::instrument_registry::instance()[listing_.id];
+    json::string const            my_subscribe_id_ = build_subscribe_id();
+    std::string const             source_id_       = build_source_id();
+
+    std::vector< feed_leg >    legs_;
+    feed_arbiter               arbiter_;
+    asioex::timer_wheel        timers_;
+    asioex::timer_wheel::timer watchdog_;
+    std::chrono::milliseconds  stale_after_ = default_stale_after;
+
+    // demand. A listener without an idle period is always wanted.
+    std::optional< std::chrono::milliseconds > idle_after_;
+    bool                                       wanted_ = true;
+    std::size_t                                demand_ = 0;
+    asioex::timer_wheel::timer                 idle_timer_;
+    std::shared_ptr< orderbook_listener_impl > lingering_;
+
+    // checkpointing. A write which is still in progress when the next falls due causes that one to be skipped.
+    std::filesystem::path                      checkpoint_path_;
+    std::chrono::milliseconds                  checkpoint_interval_ { 0 };
+    asio::any_io_executor                      checkpoint_io_;
+    asioex::timer_wheel::timer                 checkpoint_timer_;
+    std::shared_ptr< std::atomic< bool > >     checkpoint_busy_ = std::make_shared< std::atomic< bool > >(false);
+    std::tuple< std::uint64_t, std::uint64_t > checkpoint_written_ { 0, 0 };
+
+    // the tick store writer, used only on its strand
+    std::shared_ptr< tick_store_writer > recorder_;
+    asio::any_io_executor                recorder_strand_;
 
-    std::shared_ptr< connector > connector_;
-    connection_state             connstate_;
+    asio::cancellation_signal stop_monitoring_books_;
 
-    util::cross_executor_connection connection_state_conn_;
-    util::cross_executor_connection cmd_response_conn_;
-    util::cross_executor_connection tick_con_[4];
+    util::mpsc_channel< queued_tick > ticks_ { tick_queue_capacity };
+    std::vector< queued_tick >        tick_batch_;
+    std::uint64_t                     ticks_rejected_ = 0;
 
-    asio::cancellation_signal stop_monitoring_books_;
+    using snapshot_pool = util::free_list< orderbook_snapshot >;
 
     orderbook_snapshot_service        snapshot_service_;
+    std::shared_ptr< snapshot_pool >  released_snapshots_ = std::make_shared< snapshot_pool >();
     std::shared_ptr< snapshot_class > snapshot_;
     signal_type                       signal_;
 
     // data for building the snapshot
     trading::feed_condition connection_condition_;
     trading::feed_condition book_condition_;
+
+    // after a reconnect, incremental ticks are discarded until the fresh exchange snapshot arrives. Until then the
+    // last snapshot of the previous generation continues to be served, marked stale.
+    bool awaiting_snapshot_ = true;
+
+    // the book was restored from a checkpoint and awaits reconciliation with the first live snapshot
+    bool warm_ = false;
+
+    // the book lost ticks to a queue overflow and awaits the snapshot of its resubscription
+    bool recovering_ = false;
 };
 
 }   // namespace power_trade
@@ -0,0 +1,241 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "power_trade/orderbook_listener_impl.hpp"
+#include "testing/power_trade_acceptor.hpp"
+#include "util/recycling_allocator.hpp"
+
+#include <doctest/doctest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+std::atomic< std::uint64_t > heap_allocations { 0 };
+}
+
+// count every global allocation made by the test executable
+void *
+operator new(std::size_t bytes)
+{
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto p = std::malloc(bytes ? bytes : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void
+operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+using namespace arby;
+using namespace std::literals;
+
+namespace
+{
+/// Wait up to 10 seconds for pred to be satisfied.
+asio::awaitable< bool >
+wait_for(std::function< bool() > pred)
+{
+    auto timer = asio::steady_timer(co_await asio::this_coro::executor);
+    for (int i = 0; i < 1000; ++i)
+    {
+        if (pred())
+            co_return true;
+        timer.expires_after(10ms);
+        co_await timer.async_wait(asio::use_awaitable);
+    }
+    co_return false;
+}
+}   // namespace
+
+TEST_SUITE("power_trade")
+{
+    // Run under ThreadSanitizer (the tsan preset) to catch a snapshot changed after it has been published
+    TEST_CASE("orderbook_listener_impl publishes each change of condition in a new snapshot")
+    {
+        using snapshot_type = power_trade::orderbook_listener_impl::snapshot_type;
+
+        auto ioc    = asio::io_context();
+        auto sslctx = ssl::context(ssl::context::tls_client);
+        auto venue  = testing::power_trade_acceptor::create(ioc.get_executor());
+        auto native = power_trade::require_listing(trading::spot_key("usd/jpy")).native_symbol;
+        venue->add(native, "1", trading::buy, "110.00", "5");
+
+        // the subscriber reads each snapshot on its own thread while the listener's watchdog marks the book stale
+        auto subscriber_ioc = asio::io_context();
+        auto work           = asio::make_work_guard(subscriber_ioc);
+        auto subscriber     = std::thread([&] { subscriber_ioc.run(); });
+
+        auto delivered = std::atomic< int >(0);
+        auto good      = std::atomic< int >(0);
+        auto stale     = std::atomic< int >(0);
+        auto changed   = std::atomic< int >(0);
+
+        // used only on the subscriber's thread
+        auto previous  = snapshot_type();
+        auto condition = trading::feed_condition();
+
+        asio::co_spawn(
+            ioc,
+            [&]() -> asio::awaitable< void >
+            {
+                auto exec      = co_await asio::this_coro::executor;
+                auto connector = std::make_shared< power_trade::connector >(exec, sslctx, venue->endpoint());
+                auto listener  = power_trade::orderbook_listener_impl::create(
+                    exec, { connector }, trading::spot_key("usd/jpy"), asioex::timer_wheel(exec, 1ms));
+                listener->stale_after(5ms);
+
+                auto sub = listener->subscribe(subscriber_ioc.get_executor(),
+                                               util::delivery_policy::latest_only,
+                                               [&](snapshot_type snap)
+                                               {
+                                                   if (previous && (previous->condition.state != condition.state ||
+                                                                    previous->condition.errors != condition.errors))
+                                                       ++changed;
+
+                                                   auto os = std::ostringstream();
+                                                   os << snap;
+                                                   good += snap->condition.state == trading::feed_state::good;
+                                                   stale += snap->condition.state == trading::feed_state::stale;
+                                                   ++delivered;
+
+                                                   condition = snap->condition;
+                                                   previous  = std::move(snap);
+                                               });
+
+                REQUIRE(co_await wait_for([&] { return good > 0; }));
+
+                // each order makes the book good, and the watchdog marks it stale again 5ms later
+                auto timer = asio::steady_timer(exec);
+                for (int i = 0; i < 50; ++i)
+                {
+                    venue->add(native, std::to_string(i + 2), trading::buy, "109.00", "1");
+                    timer.expires_after(15ms);
+                    co_await timer.async_wait(asio::use_awaitable);
+                }
+
+                sub.cancel();
+                listener->stop();
+                connector.reset();
+                venue->stop();
+            },
+            [](std::exception_ptr ep)
+            {
+                if (ep)
+                    std::rethrow_exception(ep);
+            });
+        ioc.run();
+
+        work.reset();
+        subscriber.join();
+
+        MESSAGE("delivered " << delivered << " snapshots, " << good << " good and " << stale << " stale");
+        CHECK(stale > 0);
+        CHECK(good > 1);
+        CHECK(changed == 0);
+    }
+
+    TEST_CASE("orderbook_listener_impl heap allocations per tick")
+    {
+        using snapshot_type = power_trade::orderbook_listener_impl::snapshot_type;
+
+        auto ioc    = asio::io_context();
+        auto sslctx = ssl::context(ssl::context::tls_client);
+        auto venue  = testing::power_trade_acceptor::create(ioc.get_executor());
+        auto native = power_trade::require_listing(trading::spot_key("usd/chf")).native_symbol;
+        for (int i = 0; i < 20; ++i)
+        {
+            venue->add(native, "b" + std::to_string(i), trading::buy, std::to_string(90 - i), "5");
+            venue->add(native, "s" + std::to_string(i), trading::sell, std::to_string(110 + i), "5");
+        }
+
+        // snapshots are delivered to a subscriber on another thread, so each tick's delivery is posted across threads
+        auto subscriber_ioc = asio::io_context();
+        auto work           = asio::make_work_guard(subscriber_ioc);
+        auto subscriber     = std::thread([&] { subscriber_ioc.run(); });
+        auto delivered      = std::atomic< int >(0);
+        auto good           = std::atomic< bool >(false);
+
+        auto connector = std::make_shared< power_trade::connector >(ioc.get_executor(), sslctx, venue->endpoint());
+        auto listener =
+            power_trade::orderbook_listener_impl::create(ioc.get_executor(), connector, trading::spot_key("usd/chf"));
+        auto sub = listener->subscribe(subscriber_ioc.get_executor(),
+                                       util::delivery_policy::every,
+                                       [&](snapshot_type snap)
+                                       {
+                                           good = snap->condition.state == trading::feed_state::good;
+                                           delivered.fetch_add(1, std::memory_order_release);
+                                       });
+
+        auto deadline  = std::chrono::steady_clock::now() + 10s;
+        auto run_until = [&](auto pred)
+        {
+            while (!pred() && std::chrono::steady_clock::now() < deadline)
+                ioc.run_one_for(1ms);
+            return pred();
+        };
+        REQUIRE(run_until([&] { return good.load(); }));
+
+        // each tick adds or removes the same order, so the book keeps its size
+        auto tick = [&](int i)
+        {
+            auto seen = delivered.load(std::memory_order_acquire);
+            if (i % 2)
+                venue->remove(native, "t");
+            else
+                venue->add(native, "t", trading::buy, "95", "1");
+            return run_until([&] { return delivered.load(std::memory_order_acquire) != seen; });
+        };
+
+        for (int i = 0; i < 200; ++i)
+            REQUIRE(tick(i));
+
+        constexpr int ticks  = 1000;
+        auto          before = util::recycling_allocator_stats();
+        auto          heap   = heap_allocations.load();
+        for (int i = 0; i < ticks; ++i)
+            REQUIRE(tick(i));
+        auto after = util::recycling_allocator_stats();
+        heap       = heap_allocations.load() - heap;
+
+        // the count includes the venue's encoding of each tick and the connector's parsing of it
+        MESSAGE("heap allocations per tick: " << double(heap) / ticks << ", of which recycling allocator "
+                                              << double(after.allocated - before.allocated) / ticks);
+
+        // the handlers posted to the subscriber's thread come back to this one to be used again
+        CHECK(after.allocated - before.allocated < ticks / 20);
+        CHECK(after.recycled - before.recycled >= ticks);
+
+        sub.cancel();
+        listener->stop();
+        listener.reset();
+        connector.reset();
+        venue->stop();
+        ioc.run_for(100ms);
+
+        work.reset();
+        subscriber.join();
+    }
+}
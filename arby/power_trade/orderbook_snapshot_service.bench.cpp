@@ -0,0 +1,69 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "bench/bench.hpp"
+#include "power_trade/orderbook_snapshot_service.hpp"
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace arby;
+
+namespace
+{
+constexpr int book_depth = 1000;
+constexpr int ring_size  = 1024;
+
+power_trade::tick_record::add
+make_add(int i, trading::side_type side, int level)
+{
+    auto base = trading::price_type("39628.50");
+    auto p    = side == trading::buy ? trading::price_type(base - level) : trading::price_type(base + 1 + level);
+    return { .order_id = std::to_string(1651234567000000000 + i), .price = p, .qty = trading::qty_type("0.25"), .side = side };
+}
+}   // namespace
+
+// one tick with the given number of snapshots still held by subscribers, the oldest being released each tick
+ARBY_BENCHMARK("orderbook_snapshot_service/process_tick", 1, 4, 16)
+{
+    auto svc  = power_trade::orderbook_snapshot_service();
+    auto snap = power_trade::tick_record::snapshot();
+    for (int i = 0; i < book_depth; ++i)
+    {
+        snap.bids.push_back(make_add(2 * i, trading::buy, i / 4));
+        snap.offers.push_back(make_add(2 * i + 1, trading::sell, i / 4));
+    }
+
+    auto held = std::deque< std::unique_ptr< power_trade::orderbook_snapshot > >();
+    held.push_back(svc.process_tick(power_trade::tick_record(std::move(snap))));
+
+    // alternately add and remove an order, so that the book stays the same size
+    auto ticks = std::vector< power_trade::tick_record >();
+    for (int i = 0; i < ring_size / 2; ++i)
+    {
+        auto side = i % 2 ? trading::buy : trading::sell;
+        auto add  = make_add(10 * book_depth + i, side, i % 50);
+        ticks.emplace_back(add);
+        ticks.emplace_back(power_trade::tick_record::remove { .order_id = add.order_id, .side = side });
+    }
+
+    std::size_t i = 0;
+    for (auto _ : state)
+    {
+        if (held.size() >= std::size_t(state.arg()))
+        {
+            svc.deallocate_snapshot(std::move(held.front()));
+            held.pop_front();
+        }
+        held.push_back(svc.process_tick(ticks[i]));
+        i = (i + 1) % ticks.size();
+    }
+}
@@ -12,6 +12,11 @@
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <string_view>
+
 namespace arby
 {
 namespace power_trade
@@ -31,41 +36,141 @@ void
 orderbook_snapshot_service::replay_tick(order_book &book, const tick_record &tick)
 {
     auto visitor = overloaded {
-        [&book](tick_record::snapshot const &snap)
-        {
-            book.reset();
-            for (auto &bid : snap.bids)
-                book.add(bid);
-            for (auto &offer : snap.offers)
-                book.add(offer);
-        },
+        [&book](tick_record::snapshot const &snap) { book.load(snap); },
         [&book](tick_record::add const &a) { book.add(a); },
         [&book](tick_record::remove const &r) { book.remove(r); },
         [&book](tick_record::execute const &e) { book.execute(e); },
     };
 
     boost::variant2::visit(visitor, tick.as_variant());
-    fmt::print("{}\n", book);
+}
+
+std::optional< std::vector< tick_record > >
+orderbook_snapshot_service::diff(order_book const &book, tick_record::snapshot const &snap)
+{
+    // an order whose id was repeated is in its level without being indexed, so no tick can remove it
+    auto indexed = [](auto const &ladder, auto const &cache)
+    {
+        auto orders = std::size_t(0);
+        for (auto &[price, level] : ladder)
+            orders += level.orders.size();
+        return orders == cache.size();
+    };
+    if (!indexed(book.bids_, book.bid_cache_) || !indexed(book.offers_, book.offer_cache_))
+        return std::nullopt;
+
+    auto result = std::vector< tick_record >();
+    auto adds   = std::vector< tick_record::add const * >();
+
+    auto diff_side = [&](auto const &cache, std::vector< tick_record::add > const &target, trading::side_type side)
+    {
+        auto wanted = std::vector< tick_record::add const * >();
+        wanted.reserve(target.size());
+        for (auto &o : target)
+            wanted.push_back(&o);
+        std::stable_sort(wanted.begin(), wanted.end(), [](auto *l, auto *r) { return l->order_id < r->order_id; });
+
+        auto remove = [&](std::string_view orderid)
+        {
+            result.emplace_back(
+                tick_record::remove { .order_id = std::string(orderid), .timestamp = book.last_update_, .side = side });
+        };
+
+        auto icache = cache.begin();
+        for (auto iwant = wanted.begin(); iwant != wanted.end();)
+        {
+            auto &want  = **iwant;
+            auto  last  = std::find_if(iwant, wanted.end(), [&](auto *o) { return o->order_id != want.order_id; });
+            auto  count = std::distance(iwant, last);
+
+            for (; icache != cache.end() && std::string_view(icache->first) < want.order_id; ++icache)
+                remove(icache->first);
+
+            if (icache != cache.end() && std::string_view(icache->first) == want.order_id)
+            {
+                auto &[ilevel, iqty] = icache->second;
+                ++icache;
+                if (count == 1 && ilevel->first == want.price)
+                {
+                    if (iqty->qty == want.qty)
+                    {
+                        ++iwant;
+                        continue;
+                    }
+                    // a smaller order keeps its place in the queue, as it would after a partial fill
+                    if (want.qty < iqty->qty)
+                    {
+                        result.emplace_back(tick_record::execute { .order_id  = want.order_id,
+                                                                   .price     = want.price,
+                                                                   .qty       = iqty->qty - want.qty,
+                                                                   .timestamp = book.last_update_,
+                                                                   .side      = side });
+                        ++iwant;
+                        continue;
+                    }
+                }
+                remove(want.order_id);
+            }
+
+            // as load() does, every copy of a repeated id is added, and the last is the one indexed
+            for (; iwant != last; ++iwant)
+                adds.push_back(*iwant);
+        }
+        for (; icache != cache.end(); ++icache)
+            remove(icache->first);
+    };
+
+    diff_side(book.bid_cache_, snap.bids, trading::buy);
+    diff_side(book.offer_cache_, snap.offers, trading::sell);
+
+    // removals first, so that an order which changed is re-added. Additions go in the order the snapshot lists them,
+    // which preserves time priority within each level.
+    std::sort(adds.begin(),
+              adds.end(),
+              [](auto *l, auto *r) { return l->side != r->side ? l->side < r->side : std::less<>()(l, r); });
+    for (auto *a : adds)
+        result.emplace_back(*a);
+
+    return result;
 }
 
 std::unique_ptr< orderbook_snapshot >
 orderbook_snapshot_service::process_tick(tick_record tick)
 {
-    auto visitor = overloaded { [&](tick_record::snapshot const &snap)
-                                {
-                                    tick_history_.reset();
-                                    current_generation_ += 1;
-                                } };
+    return process_tick(std::move(tick), resync_);
+}
 
-    if (holds_alternative< tick_record::snapshot >(tick.as_variant()))
+std::unique_ptr< orderbook_snapshot >
+orderbook_snapshot_service::process_tick(tick_record tick, resync_policy policy)
+{
+    if (auto snap = boost::variant2::get_if< tick_record::snapshot >(&tick.as_variant()))
     {
+        if (policy == resync_policy::diff && current_generation_ != 0)
+        {
+            auto ticks = diff(order_book_, *snap);
+            if (ticks && ticks->size() <= snap->bids.size() + snap->offers.size())
+            {
+                for (auto &t : *ticks)
+                {
+                    replay_tick(order_book_, t);
+                    tick_history_.add_tick(std::move(t));
+                }
+                return make_snapshot();
+            }
+        }
+
         tick_history_.reset();
         current_generation_ += 1;
     }
 
     tick_history_.add_tick(tick);
     replay_tick(order_book_, tick);
+    return make_snapshot();
+}
 
+std::unique_ptr< orderbook_snapshot >
+orderbook_snapshot_service::make_snapshot()
+{
     auto new_snap = allocate_snapshot();
     if (new_snap->generation == current_generation_)
     {
@@ -89,7 +194,7 @@ orderbook_snapshot_service::process_tick(tick_record tick)
 
     new_snap->generation    = current_generation_;
     new_snap->sequence      = tick_history_.highest_sequence();
-    new_snap->timestamp     = std::chrono::system_clock::now();
+    new_snap->timestamp     = trading::fast_clock::now();
     new_snap->upstream_time = order_book_.last_update_;
 
     tick_history_.add_watermark(new_snap->sequence);
@@ -117,6 +222,15 @@ orderbook_snapshot_service::deallocate_snapshot(std::unique_ptr< orderbook_snaps
     free_snaps_.push_back(std::move(snap));
 }
 
+void
+orderbook_snapshot_service::clear()
+{
+    tick_history_.reset();
+    order_book_.reset();
+    free_snaps_.clear();
+    current_generation_ += 1;
+}
+
 void
 orderbook_snapshot::print_impl(std::ostream &os) const
 {
@@ -14,6 +14,10 @@
 #include "power_trade/tick_history.hpp"
 #include "trading/feed_snapshot.hpp"
 
+#include <memory>
+#include <optional>
+#include <vector>
+
 namespace arby
 {
 namespace power_trade
@@ -31,25 +35,62 @@ struct orderbook_snapshot : trading::feed_snapshot
     print_impl(std::ostream &os) const override;
 };
 
+/// @brief How an exchange snapshot which arrives once the book is established is applied.
+enum class resync_policy
+{
+    /// start a new generation. Outstanding snapshots are rebuilt by full copy.
+    reset,
+
+    /// apply the difference as synthetic ticks within the current generation, so that outstanding snapshots are
+    /// brought up to date incrementally. A difference larger than the snapshot itself, or one which ticks cannot
+    /// express, falls back to reset.
+    diff
+};
+
 struct orderbook_snapshot_service
 {
     tick_history                                         tick_history_       = {};
     std::uint64_t                                        current_generation_ = 0;
     order_book                                           order_book_         = {};
     std::vector< std::unique_ptr< orderbook_snapshot > > free_snaps_         = {};
+    resync_policy                                        resync_             = resync_policy::reset;
 
     std::unique_ptr< orderbook_snapshot >
     process_tick(tick_record tick);
 
+    /// @brief Process a tick, applying an exchange snapshot by the given policy rather than resync_.
+    std::unique_ptr< orderbook_snapshot >
+    process_tick(tick_record tick, resync_policy policy);
+
     static void
     replay_tick(order_book &book, tick_record const &tick);
 
+    /// @brief The ticks which take a book to the state of an exchange snapshot.
+    ///
+    /// Orders which are gone are removed and new orders are added in the sequence in which the snapshot lists them.
+    /// An order whose quantity has fallen is executed by the difference, keeping its place in the queue. One whose
+    /// price has changed or whose quantity has grown is removed and added again, at the back of its level. An id
+    /// which the snapshot repeats is replaced by every copy, as order_book::load() would hold them.
+    /// @return the ticks, or nothing if the book holds orders of a repeated id, which no tick can remove
+    static std::optional< std::vector< tick_record > >
+    diff(order_book const &book, tick_record::snapshot const &snap);
+
+    /// @brief A snapshot of the book as it stands, e.g. to publish a change of condition without a tick.
+    std::unique_ptr< orderbook_snapshot >
+    make_snapshot();
+
     std::unique_ptr< orderbook_snapshot >
     allocate_snapshot();
 
     void
     deallocate_snapshot(std::unique_ptr< orderbook_snapshot > snap);
 
+    /// @brief Discard the book, its history and the spare snapshots, e.g. when the venue subscription lapses.
+    ///
+    /// Starts a new generation, so that snapshots still held by subscribers are rebuilt by full copy when recycled.
+    void
+    clear();
+
     order_book const &
     orderbook() const
     {
@@ -48,6 +48,21 @@ make_add(json::string              orderid,
                                                          { "quantity", to_string(qty) },
                                                          { "utc_timestamp", std::to_string(ts.count()) } })) };
 }
+
+power_trade::tick_record::add
+make_order(std::string orderid, trading::side_type side, int price, int qty)
+{
+    return power_trade::tick_record::add {
+        .order_id = std::move(orderid), .price = trading::price_type(price), .qty = trading::qty_type(qty), .side = side
+    };
+}
+
+power_trade::tick_record
+make_snapshot(std::vector< power_trade::tick_record::add > bids, std::vector< power_trade::tick_record::add > offers)
+{
+    return power_trade::tick_record(
+        power_trade::tick_record::snapshot { .bids = std::move(bids), .offers = std::move(offers) });
+}
 }   // namespace
 
 TEST_SUITE("power_trade")
@@ -68,4 +83,124 @@ TEST_SUITE("power_trade")
         CHECK(snap1->book != snap2->book);
         CHECK(snap1->book == svc.orderbook());
     }
+    TEST_CASE("orderbook_snapshot_service diff")
+    {
+        using trading::buy;
+        using trading::sell;
+
+        auto book = power_trade::order_book();
+        book.load(boost::variant2::get< power_trade::tick_record::snapshot >(
+            make_snapshot({ make_order("b1", buy, 100, 1), make_order("b2", buy, 100, 2), make_order("b3", buy, 99, 1) },
+                          { make_order("o1", sell, 101, 1), make_order("o2", sell, 102, 1) })
+                .as_variant()));
+
+        // b2 is gone, b3 has changed size, b4 and o3 are new
+        auto target = make_snapshot(
+            { make_order("b1", buy, 100, 1), make_order("b4", buy, 100, 5), make_order("b3", buy, 99, 3) },
+            { make_order("o1", sell, 101, 1), make_order("o2", sell, 102, 1), make_order("o3", sell, 102, 2) });
+        auto &want = boost::variant2::get< power_trade::tick_record::snapshot >(target.as_variant());
+
+        auto ticks = power_trade::orderbook_snapshot_service::diff(book, want);
+        REQUIRE(ticks);
+        CHECK(ticks->size() == 5);
+        for (auto &t : *ticks)
+            power_trade::orderbook_snapshot_service::replay_tick(book, t);
+
+        auto expected = power_trade::order_book();
+        expected.load(want);
+        CHECK(book.bids_ == expected.bids_);
+        CHECK(book.offers_ == expected.offers_);
+        CHECK(book.bid_cache_.size() == 3);
+
+        auto again = power_trade::orderbook_snapshot_service::diff(book, want);
+        REQUIRE(again);
+        CHECK(again->empty());
+    }
+
+    TEST_CASE("orderbook_snapshot_service diff keeps queue position")
+    {
+        using trading::buy;
+        using trading::sell;
+
+        auto book = power_trade::order_book();
+        book.load(boost::variant2::get< power_trade::tick_record::snapshot >(
+            make_snapshot({ make_order("b1", buy, 100, 3), make_order("b2", buy, 100, 1) }, {}).as_variant()));
+
+        // b1 has been partly filled, and still stands ahead of b2
+        auto target = make_snapshot({ make_order("b1", buy, 100, 1), make_order("b2", buy, 100, 1) }, {});
+        auto &want  = boost::variant2::get< power_trade::tick_record::snapshot >(target.as_variant());
+
+        auto ticks = power_trade::orderbook_snapshot_service::diff(book, want);
+        REQUIRE(ticks);
+        REQUIRE(ticks->size() == 1);
+        auto *exec = boost::variant2::get_if< power_trade::tick_record::execute >(&(*ticks)[0].as_variant());
+        REQUIRE(exec);
+        CHECK(exec->order_id == "b1");
+        CHECK(exec->qty == trading::qty_type(2));
+
+        power_trade::orderbook_snapshot_service::replay_tick(book, (*ticks)[0]);
+        auto expected = power_trade::order_book();
+        expected.load(want);
+        CHECK(book.bids_ == expected.bids_);
+        CHECK(book.bids_.begin()->second.orders.front().orderid == "b1");
+    }
+
+    TEST_CASE("orderbook_snapshot_service diff repeated ids")
+    {
+        using trading::buy;
+        using trading::sell;
+
+        auto book = power_trade::order_book();
+        book.load(boost::variant2::get< power_trade::tick_record::snapshot >(
+            make_snapshot({ make_order("b1", buy, 100, 1), make_order("b2", buy, 100, 2) }, {}).as_variant()));
+
+        // the snapshot repeats b2, so the diff must build the same two orders that load() keeps
+        auto target = make_snapshot(
+            { make_order("b1", buy, 100, 1), make_order("b2", buy, 100, 2), make_order("b2", buy, 99, 4) }, {});
+        auto &want = boost::variant2::get< power_trade::tick_record::snapshot >(target.as_variant());
+
+        auto ticks = power_trade::orderbook_snapshot_service::diff(book, want);
+        REQUIRE(ticks);
+        for (auto &t : *ticks)
+            power_trade::orderbook_snapshot_service::replay_tick(book, t);
+
+        auto expected = power_trade::order_book();
+        expected.load(want);
+        CHECK(book.bids_ == expected.bids_);
+        CHECK(book.bid_cache_.size() == expected.bid_cache_.size());
+        CHECK(std::get< 0 >(book.bid_cache_.find("b2")->second)->first == trading::price_type(99));
+
+        // once the book holds an order no id reaches, only a reset can bring it to a snapshot
+        CHECK(!power_trade::orderbook_snapshot_service::diff(book, want));
+    }
+
+    TEST_CASE("orderbook_snapshot_service resync by diff")
+    {
+        using trading::buy;
+        using trading::sell;
+
+        auto svc    = power_trade::orderbook_snapshot_service();
+        svc.resync_ = power_trade::resync_policy::diff;
+
+        auto snap1 = svc.process_tick(make_snapshot({ make_order("b1", buy, 100, 1), make_order("b2", buy, 99, 1) },
+                                                    { make_order("o1", sell, 101, 1) }));
+        auto snap2 = svc.process_tick(power_trade::tick_record(make_order("o2", sell, 102, 1)));
+        CHECK(snap2->generation == snap1->generation);
+
+        // a resync which keeps most of the book stays in the same generation
+        svc.deallocate_snapshot(std::move(snap1));
+        auto snap3 = svc.process_tick(make_snapshot({ make_order("b1", buy, 100, 1), make_order("b3", buy, 99, 2) },
+                                                    { make_order("o1", sell, 101, 1), make_order("o2", sell, 102, 1) }));
+        CHECK(snap3->generation == snap2->generation);
+        CHECK(snap3->sequence > snap2->sequence);
+        CHECK(snap3->book == svc.orderbook());
+        CHECK(snap3->book.bid_cache_.count("b3") == 1);
+        CHECK(snap3->book.bid_cache_.count("b2") == 0);
+
+        // one which replaces everything starts a new generation
+        svc.deallocate_snapshot(std::move(snap2));
+        auto snap4 = svc.process_tick(make_snapshot({ make_order("b9", buy, 90, 1) }, { make_order("o9", sell, 110, 1) }));
+        CHECK(snap4->generation == snap3->generation + 1);
+        CHECK(snap4->book == svc.orderbook());
+    }
 }
@@ -0,0 +1,81 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "power_trade/recovery_tracker.hpp"
+
+#include <algorithm>
+
+namespace arby::power_trade
+{
+recovery_tracker::recovery_tracker(clock::time_point now)
+: recovery_start_(now)
+{
+}
+
+void
+recovery_tracker::add_book(void const *book)
+{
+    books_.emplace(book, false);
+}
+
+void
+recovery_tracker::remove_book(void const *book, clock::time_point now)
+{
+    if (auto i = books_.find(book); i != books_.end())
+    {
+        if (i->second)
+            --good_;
+        books_.erase(i);
+        check_complete(now);
+    }
+}
+
+bool
+recovery_tracker::book_state(void const *book, bool good, clock::time_point now)
+{
+    auto i = books_.find(book);
+    if (i == books_.end() || i->second == good)
+        return false;
+
+    i->second = good;
+    if (good)
+    {
+        ++good_;
+        return check_complete(now);
+    }
+
+    --good_;
+    return false;
+}
+
+void
+recovery_tracker::connection_lost(clock::time_point now)
+{
+    for (auto &[book, good] : books_)
+        good = false;
+    good_ = 0;
+    if (!recovery_start_)
+        recovery_start_ = now;
+}
+
+bool
+recovery_tracker::check_complete(clock::time_point now)
+{
+    if (!recovery_start_ || books_.empty() || good_ != books_.size())
+        return false;
+
+    auto elapsed = now - *recovery_start_;
+    recovery_start_.reset();
+    last_  = elapsed;
+    worst_ = std::max(worst_, elapsed);
+    ++count_;
+    return true;
+}
+
+}   // namespace arby::power_trade
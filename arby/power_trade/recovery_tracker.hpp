@@ -0,0 +1,86 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_ARBY_POWER_TRADE_RECOVERY_TRACKER_HPP
+#define ARBY_ARBY_POWER_TRADE_RECOVERY_TRACKER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <unordered_map>
+
+namespace arby::power_trade
+{
+/// @brief Measures the time from a connection being lost to every registered book being good again.
+///
+/// Books are identified by an opaque pointer, usually the address of the listener which maintains the book.
+/// A recovery starts when the connection is lost (or at construction, so that the first measurement is the time to
+/// first good books) and completes when every registered book has reported good.
+/// @note not thread-safe. Use only on the owning connector's executor.
+struct recovery_tracker
+{
+    using clock = std::chrono::steady_clock;
+
+    recovery_tracker(clock::time_point now = clock::now());
+
+    void
+    add_book(void const *book);
+
+    void
+    remove_book(void const *book, clock::time_point now = clock::now());
+
+    /// @brief Record that a book has become good or not good.
+    /// @return true if this report completed a recovery
+    bool
+    book_state(void const *book, bool good, clock::time_point now = clock::now());
+
+    /// @brief Start a new recovery. All books are marked not good.
+    void
+    connection_lost(clock::time_point now = clock::now());
+
+    bool
+    recovering() const
+    {
+        return recovery_start_.has_value();
+    }
+
+    /// The duration of the most recently completed recovery, if any
+    std::optional< clock::duration >
+    last_recovery() const
+    {
+        return last_;
+    }
+
+    clock::duration
+    worst_recovery() const
+    {
+        return worst_;
+    }
+
+    std::size_t
+    recoveries() const
+    {
+        return count_;
+    }
+
+  private:
+    bool
+    check_complete(clock::time_point now);
+
+    std::unordered_map< void const *, bool > books_;
+    std::size_t                              good_ = 0;
+    std::optional< clock::time_point >       recovery_start_;
+    std::optional< clock::duration >         last_;
+    clock::duration                          worst_ = clock::duration::zero();
+    std::size_t                              count_ = 0;
+};
+
+}   // namespace arby::power_trade
+
+#endif   // ARBY_ARBY_POWER_TRADE_RECOVERY_TRACKER_HPP
@@ -0,0 +1,139 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "config/asio.hpp"
+#include "power_trade/connector.hpp"
+#include "power_trade/native_symbol.hpp"
+#include "power_trade/orderbook_listener_impl.hpp"
+#include "power_trade/recovery_tracker.hpp"
+#include "testing/power_trade_acceptor.hpp"
+
+#include <doctest/doctest.h>
+
+#include <exception>
+#include <functional>
+#include <memory>
+#include <vector>
+
+using namespace arby;
+using namespace std::literals;
+
+namespace
+{
+/// Wait up to 10 seconds for pred to be satisfied.
+asio::awaitable< bool >
+wait_for(std::function< bool() > pred)
+{
+    auto timer = asio::steady_timer(co_await asio::this_coro::executor);
+    for (int i = 0; i < 1000; ++i)
+    {
+        if (pred())
+            co_return true;
+        timer.expires_after(10ms);
+        co_await timer.async_wait(asio::use_awaitable);
+    }
+    co_return false;
+}
+}   // namespace
+
+TEST_SUITE("power_trade")
+{
+    TEST_CASE("recovery_tracker")
+    {
+        using clock = power_trade::recovery_tracker::clock;
+
+        auto t0      = clock::time_point();
+        auto tracker = power_trade::recovery_tracker(t0);
+        int  a, b;
+        tracker.add_book(&a);
+        tracker.add_book(&b);
+
+        CHECK(tracker.recovering());
+        CHECK_FALSE(tracker.book_state(&a, true, t0 + 10ms));
+        CHECK(tracker.book_state(&b, true, t0 + 20ms));
+        CHECK_FALSE(tracker.recovering());
+        REQUIRE(tracker.last_recovery());
+        CHECK(*tracker.last_recovery() == 20ms);
+
+        tracker.connection_lost(t0 + 100ms);
+        CHECK(tracker.recovering());
+        CHECK_FALSE(tracker.book_state(&a, true, t0 + 150ms));
+
+        // removing the last outstanding book completes the recovery
+        tracker.remove_book(&b, t0 + 160ms);
+        CHECK_FALSE(tracker.recovering());
+        CHECK(*tracker.last_recovery() == 60ms);
+        CHECK(tracker.worst_recovery() == 60ms);
+        CHECK(tracker.recoveries() == 2);
+    }
+
+    TEST_CASE("time from disconnect to all books good is bounded")
+    {
+        auto ioc    = asio::io_context();
+        auto sslctx = ssl::context(ssl::context::tls_client);
+        auto venue  = testing::power_trade_acceptor::create(ioc.get_executor());
+
+        static constexpr char const *symbols[] = { "usd/jpy", "usd/chf", "eur/usd", "gbp/usd", "aud/usd" };
+        for (auto sym : symbols)
+        {
+            auto native = power_trade::require_listing(trading::spot_key(sym)).native_symbol;
+            venue->add(native, "1", trading::buy, "1.0000", "5");
+            venue->add(native, "2", trading::sell, "1.0002", "3");
+        }
+
+        asio::co_spawn(
+            ioc,
+            [&]() -> asio::awaitable< void >
+            {
+                auto exec      = co_await asio::this_coro::executor;
+                auto connector = std::make_shared< power_trade::connector >(exec, sslctx, venue->endpoint());
+                auto listeners = std::vector< std::shared_ptr< power_trade::orderbook_listener_impl > >();
+                for (auto sym : symbols)
+                    listeners.push_back(power_trade::orderbook_listener_impl::create(exec, connector, trading::spot_key(sym)));
+
+                auto &tracker   = connector->get_implementation()->recovery();
+                auto  recovered = [&](std::size_t n)
+                { return [&, n] { return tracker.recoveries() == n && !tracker.recovering(); }; };
+
+                // first connection: every book subscribed and good
+                REQUIRE(co_await wait_for([&] { return venue->subscriptions() == std::size(symbols); }));
+                REQUIRE(co_await wait_for(recovered(1)));
+
+                // the venue drops the connection, then refuses three reconnects before accepting
+                venue->refuse(3);
+                venue->drop();
+                REQUIRE(co_await wait_for(recovered(2)));
+
+                // the recovery went through the connector's own reconnect loop
+                CHECK(venue->connections() >= 5);
+                CHECK(venue->subscriptions() == 2 * std::size(symbols));
+
+                REQUIRE(tracker.last_recovery());
+                MESSAGE("time to all books good: "
+                        << std::chrono::duration_cast< std::chrono::milliseconds >(*tracker.last_recovery()).count()
+                        << "ms");
+
+                // three refused attempts with backoff from 25ms wait at most 25 + 50 + 100 + 200ms. The old fixed 2s
+                // reconnect delay would take over 6s.
+                CHECK(*tracker.last_recovery() < 2s);
+
+                for (auto &l : listeners)
+                    l->stop();
+                listeners.clear();
+                connector.reset();
+                venue->stop();
+            },
+            [](std::exception_ptr ep)
+            {
+                if (ep)
+                    std::rethrow_exception(ep);
+            });
+        ioc.run();
+    }
+}
@@ -0,0 +1,35 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "bench/bench.hpp"
+#include "power_trade/tick_history.hpp"
+
+#include <deque>
+
+using namespace arby;
+
+// a tick added and watermarked, and the oldest of the given number of outstanding watermarks removed
+ARBY_BENCHMARK("tick_history/watermark_churn", 1, 16, 256)
+{
+    auto history = power_trade::tick_history();
+    auto tick    = power_trade::tick_record(power_trade::tick_record::remove { .order_id = "1", .side = trading::buy });
+    auto marks   = std::deque< std::uint64_t >();
+    for (auto _ : state)
+    {
+        history.add_tick(tick);
+        history.add_watermark(history.highest_sequence());
+        marks.push_back(history.highest_sequence());
+        if (marks.size() > std::size_t(state.arg()))
+        {
+            history.remove_watermark(marks.front());
+            marks.pop_front();
+        }
+    }
+    bench::do_not_optimize(history.history.size());
+}
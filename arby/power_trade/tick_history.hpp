@@ -57,7 +57,9 @@ struct tick_history
     void
     remove_watermark(std::uint64_t wm)
     {
-        watermarks.erase(wm);
+        // several snapshots may share a sequence, so only one of them is let go
+        if (auto i = watermarks.find(wm); i != watermarks.end())
+            watermarks.erase(i);
 
         if (watermarks.empty())
         {
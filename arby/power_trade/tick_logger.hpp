@@ -12,9 +12,9 @@
 
 #include "config/filesystem.hpp"
 #include "config/json.hpp"
-#include "config/signals.hpp"
 #include "logging/data_log.hpp"
 #include "power_trade/connector.hpp"
+#include "util/signal.hpp"
 
 namespace arby
 {
@@ -60,7 +60,7 @@ struct tick_logger
 
       private:
         std::shared_ptr< connector >           connector_;
-        std::vector< sigs::scoped_connection > persistent_connections_;
+        std::vector< util::scoped_connection > persistent_connections_;
         std::string                            symbol_;
         logging::data_log                      logger_;
     };
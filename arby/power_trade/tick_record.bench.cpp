@@ -0,0 +1,56 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "bench/bench.hpp"
+#include "config/json.hpp"
+#include "power_trade/tick_record.hpp"
+
+#include <memory>
+#include <string>
+
+using namespace arby;
+
+namespace
+{
+json::object
+order_json(int i, char const *id_field)
+{
+    return json::object({ { id_field, std::to_string(1651234567000000000 + i) },
+                          { "side", i % 2 ? "buy" : "sell" },
+                          { "price", "39628.50" },
+                          { "quantity", "0.00250000" },
+                          { "utc_timestamp", "1651234567123456789" } });
+}
+}   // namespace
+
+ARBY_BENCHMARK("tick_record/add")
+{
+    auto payload = std::make_shared< json::object const >(order_json(0, "order_id"));
+    for (auto _ : state)
+        bench::do_not_optimize(power_trade::tick_record(power_trade::tick_code::add, payload));
+}
+
+ARBY_BENCHMARK("tick_record/snapshot", 100, 1000)
+{
+    auto buy  = json::array();
+    auto sell = json::array();
+    for (int i = 0; i < state.arg(); ++i)
+    {
+        buy.push_back(order_json(2 * i, "orderid"));
+        sell.push_back(order_json(2 * i + 1, "orderid"));
+    }
+    auto payload = std::make_shared< json::object const >(json::object({ { "server_utc_timestamp", "1651234567123456789" },
+                                                                         { "market_id", "0" },
+                                                                         { "symbol", "BTC-USD" },
+                                                                         { "buy", std::move(buy) },
+                                                                         { "sell", std::move(sell) } }));
+    state.set_items_per_iteration(2.0 * state.arg());
+    for (auto _ : state)
+        bench::do_not_optimize(power_trade::tick_record(power_trade::tick_code::snapshot, payload));
+}
@@ -100,4 +100,23 @@ tick_record::tick_record(tick_code code, std::shared_ptr< json::object const > p
 {
 }
 
+tick_record::tick_record(impl_var tick)
+: impl_(std::make_shared< impl_var const >(std::move(tick)))
+, code_(boost::variant2::visit(
+      [](auto const &t)
+      {
+          using type = std::decay_t< decltype(t) >;
+          if constexpr (std::is_same_v< type, add >)
+              return tick_code::add;
+          else if constexpr (std::is_same_v< type, remove >)
+              return tick_code::remove;
+          else if constexpr (std::is_same_v< type, execute >)
+              return tick_code::execute;
+          else
+              return tick_code::snapshot;
+      },
+      *impl_))
+{
+}
+
 }   // namespace arby::power_trade
\ No newline at end of file
@@ -69,12 +69,21 @@ struct tick_record
 
     using impl_var = boost::variant2::variant< add, remove, execute, snapshot >;
 
+    /// @brief A tick synthesised locally rather than decoded from the exchange.
+    explicit tick_record(impl_var tick);
+
     impl_var const &
     as_variant() const
     {
         return *impl_;
     }
 
+    tick_code
+    code() const
+    {
+        return code_;
+    }
+
   private:
     using implementation_type = std::shared_ptr< impl_var const >;
 
@@ -0,0 +1,89 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "bench/bench.hpp"
+#include "power_trade/tick_store.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+
+using namespace arby;
+using namespace std::literals;
+
+namespace
+{
+auto const t0 = trading::timestamp_type(1650376740s);
+
+power_trade::tick_record
+make_tick(int i)
+{
+    auto ts = t0 + std::chrono::milliseconds(i);
+    if (i % 3 == 0)
+        return power_trade::tick_record(power_trade::tick_record::remove {
+            .order_id = "order-" + std::to_string(i - 2), .timestamp = ts, .side = trading::buy });
+    return power_trade::tick_record(power_trade::tick_record::add { .order_id  = "order-" + std::to_string(i),
+                                                                    .price     = trading::price_type(2990 - i % 50),
+                                                                    .qty       = trading::qty_type(i % 11 + 1),
+                                                                    .timestamp = ts,
+                                                                    .side      = trading::buy });
+}
+
+/// 100k ticks over 100 seconds, written once.
+std::filesystem::path const &
+sample_store()
+{
+    static auto const root = []
+    {
+        auto path = std::filesystem::temp_directory_path() / "arby-tick-store-bench";
+        std::filesystem::remove_all(path);
+        auto writer = power_trade::tick_store_writer(path, "eth/usd");
+        for (int i = 1; i <= 100000; ++i)
+            writer.append(make_tick(i));
+        return path;
+    }();
+    return root;
+}
+}   // namespace
+
+// includes making the tick, since a tick may not be replayed into the writer's book twice
+ARBY_BENCHMARK("tick_store/append")
+{
+    auto path = std::filesystem::temp_directory_path() / "arby-tick-store-bench-append";
+    {
+        auto writer = power_trade::tick_store_writer(path, "eth/usd");
+        auto i      = 0;
+        for (auto _ : state)
+            writer.append(make_tick(++i));
+    }
+    std::filesystem::remove_all(path);
+}
+
+// decoding every column of 100k rows
+ARBY_BENCHMARK("tick_store/scan_100k")
+{
+    auto store = power_trade::tick_store(sample_store());
+    for (auto _ : state)
+        bench::do_not_optimize(store.scan("eth/usd", t0, t0 + 1h, [](power_trade::tick_row const &) {}));
+}
+
+// a one-second window, which skips all but one or two blocks
+ARBY_BENCHMARK("tick_store/scan_1s")
+{
+    auto store = power_trade::tick_store(sample_store());
+    for (auto _ : state)
+        bench::do_not_optimize(store.scan("eth/usd", t0 + 50s, t0 + 51s, [](power_trade::tick_row const &) {}));
+}
+
+ARBY_BENCHMARK("tick_store/book_as_of")
+{
+    auto store = power_trade::tick_store(sample_store());
+    for (auto _ : state)
+        bench::do_not_optimize(store.book_as_of("eth/usd", t0 + 50s));
+}
@@ -0,0 +1,698 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "tick_store.hpp"
+
+#include <fmt/chrono.h>
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+
+namespace arby::power_trade
+{
+namespace
+{
+    template < class... Ts >
+    struct overloaded : Ts...
+    {
+        using Ts::operator()...;
+    };
+    template < class... Ts >
+    overloaded(Ts...) -> overloaded< Ts... >;
+
+    constexpr std::int64_t ns_per_hour = std::int64_t(3600) * 1'000'000'000;
+
+    enum column : std::size_t
+    {
+        time_column,
+        kind_column,
+        price_column,
+        price_exponent_column,
+        qty_column,
+        qty_exponent_column,
+        order_id_column,
+        column_count
+    };
+
+    /// The start of each block of a partition. The columns follow, in column order.
+    struct block_header
+    {
+        static constexpr char          expected_magic[8] = { 'A', 'R', 'B', 'Y', 'T', 'I', 'C', 'K' };
+        static constexpr std::uint32_t current_version   = 1;
+
+        char          magic[8];
+        std::uint32_t version;
+        std::uint32_t rows;
+        std::int64_t  base_ns;
+        std::int64_t  min_ns;
+        std::int64_t  max_ns;
+        std::uint32_t column_bytes[column_count];
+        std::uint32_t reserved;
+        std::uint64_t checksum;
+    };
+
+    static_assert(std::is_trivially_copyable_v< block_header >);
+
+    std::int64_t
+    to_ns(trading::timestamp_type t)
+    {
+        return std::chrono::duration_cast< std::chrono::nanoseconds >(t.time_since_epoch()).count();
+    }
+
+    trading::timestamp_type
+    from_ns(std::int64_t ns)
+    {
+        return trading::timestamp_type(
+            std::chrono::duration_cast< trading::timestamp_type::duration >(std::chrono::nanoseconds(ns)));
+    }
+
+    std::int64_t
+    hour_of(std::int64_t ns)
+    {
+        return ns >= 0 ? ns / ns_per_hour : (ns - ns_per_hour + 1) / ns_per_hour;
+    }
+
+    std::string
+    partition_stem(std::int64_t hour)
+    {
+        return fmt::format("{:%Y%m%dT%H}", fmt::gmtime(std::time_t(hour * 3600)));
+    }
+
+    std::optional< std::int64_t >
+    parse_partition_stem(std::string const &stem)
+    {
+        auto tm = std::tm();
+        auto n  = 0;
+        if (std::sscanf(stem.c_str(), "%4d%2d%2dT%2d%n", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &n) != 4 ||
+            std::size_t(n) != stem.size())
+            return std::nullopt;
+        tm.tm_year -= 1900;
+        tm.tm_mon -= 1;
+        return std::int64_t(::timegm(&tm)) / 3600;
+    }
+
+    std::uint64_t
+    zigzag(std::int64_t n)
+    {
+        return (std::uint64_t(n) << 1) ^ std::uint64_t(n >> 63);
+    }
+
+    std::int64_t
+    unzigzag(std::uint64_t n)
+    {
+        return std::int64_t(n >> 1) ^ -std::int64_t(n & 1);
+    }
+
+    void
+    put_varint(std::vector< std::uint8_t > &out, std::uint64_t n)
+    {
+        while (n >= 0x80)
+        {
+            out.push_back(std::uint8_t(n) | 0x80);
+            n >>= 7;
+        }
+        out.push_back(std::uint8_t(n));
+    }
+
+    /// FNV-1a
+    std::uint64_t
+    checksum(void const *data, std::size_t size, std::uint64_t h = 0xcbf29ce484222325ull)
+    {
+        auto p = static_cast< std::uint8_t const * >(data);
+        for (auto last = p + size; p != last; ++p)
+        {
+            h ^= *p;
+            h *= 0x100000001b3ull;
+        }
+        return h;
+    }
+
+    [[noreturn]] void
+    throw_errno(std::string const &what)
+    {
+        throw std::system_error(errno, std::system_category(), what);
+    }
+
+    /// Reads one column of a block.
+    struct column_reader
+    {
+        std::uint8_t const *pos;
+        std::uint8_t const *end;
+
+        std::uint64_t
+        varint()
+        {
+            auto result = std::uint64_t(0);
+            for (int shift = 0; pos != end && shift < 64; shift += 7)
+            {
+                auto b = *pos++;
+                result |= std::uint64_t(b & 0x7f) << shift;
+                if (!(b & 0x80))
+                    return result;
+            }
+            throw std::runtime_error("tick_store: malformed varint");
+        }
+
+        std::int64_t
+        signed_varint()
+        {
+            return unzigzag(varint());
+        }
+
+        std::uint8_t
+        byte()
+        {
+            if (pos == end)
+                throw std::runtime_error("tick_store: column overrun");
+            return *pos++;
+        }
+
+        std::string_view
+        string()
+        {
+            auto n = varint();
+            if (std::size_t(end - pos) < n)
+                throw std::runtime_error("tick_store: column overrun");
+            auto result = std::string_view(reinterpret_cast< char const * >(pos), n);
+            pos += n;
+            return result;
+        }
+    };
+
+    /// A whole file, mapped read-only.
+    struct mapped_file
+    {
+        explicit mapped_file(std::filesystem::path const &path)
+        {
+            auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+                throw_errno(fmt::format("open {}", path.string()));
+            struct stat st;
+            if (::fstat(fd, &st) < 0)
+            {
+                auto ec = errno;
+                ::close(fd);
+                errno = ec;
+                throw_errno(fmt::format("stat {}", path.string()));
+            }
+            size = std::size_t(st.st_size);
+            if (size)
+            {
+                auto p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p == MAP_FAILED)
+                {
+                    auto ec = errno;
+                    ::close(fd);
+                    errno = ec;
+                    throw_errno(fmt::format("mmap {}", path.string()));
+                }
+                ::madvise(p, size, MADV_SEQUENTIAL);
+                data = static_cast< std::uint8_t const * >(p);
+            }
+            ::close(fd);
+        }
+
+        mapped_file(mapped_file const &) = delete;
+        mapped_file &
+        operator=(mapped_file const &) = delete;
+
+        ~mapped_file()
+        {
+            if (data)
+                ::munmap(const_cast< std::uint8_t * >(data), size);
+        }
+
+        std::uint8_t const *data = nullptr;
+        std::size_t         size = 0;
+    };
+
+    /// Visit the rows of one partition whose time is in [from, to).
+    std::size_t
+    scan_partition(std::filesystem::path const                    &path,
+                   std::int64_t                                    from,
+                   std::int64_t                                    to,
+                   std::function< void(tick_row const &) > const &f)
+    {
+        auto file    = mapped_file(path);
+        auto visited = std::size_t(0);
+        auto pos     = std::size_t(0);
+        while (file.size - pos >= sizeof(block_header))
+        {
+            auto h = block_header();
+            std::memcpy(&h, file.data + pos, sizeof(h));
+            if (std::memcmp(h.magic, block_header::expected_magic, sizeof(h.magic)) != 0 ||
+                h.version != block_header::current_version)
+                throw std::runtime_error(fmt::format("tick_store: {} is corrupt at offset {}", path.string(), pos));
+
+            auto body = std::size_t(0);
+            for (auto n : h.column_bytes)
+                body += n;
+            if (file.size - pos - sizeof(h) < body)
+            {
+                // the writer stopped part way through a block
+                spdlog::warn("tick_store: {} ends with a partial block", path.string());
+                break;
+            }
+
+            auto first = file.data + pos + sizeof(h);
+            pos += sizeof(h) + body;
+            if (h.max_ns < from || h.min_ns >= to)
+                continue;
+
+            auto check = h;
+            check.checksum = 0;
+            if (checksum(first, body, checksum(&check, sizeof(check))) != h.checksum)
+                throw std::runtime_error(fmt::format("tick_store: {} fails its checksum at offset {}", path.string(), pos));
+
+            column_reader cols[column_count];
+            for (std::size_t i = 0; i < column_count; ++i)
+            {
+                cols[i] = column_reader { first, first + h.column_bytes[i] };
+                first += h.column_bytes[i];
+            }
+
+            auto time  = h.base_ns;
+            auto price = std::int64_t(0);
+            auto row   = tick_row();
+            for (std::uint32_t i = 0; i < h.rows; ++i)
+            {
+                time += cols[time_column].signed_varint();
+                auto ks = cols[kind_column].byte();
+                price += cols[price_column].signed_varint();
+
+                row.time           = from_ns(time);
+                row.kind           = tick_row_kind(ks >> 1);
+                row.side           = (ks & 1) ? trading::sell : trading::buy;
+                row.price.mantissa = price;
+                row.price.exponent = std::int32_t(cols[price_exponent_column].signed_varint());
+                row.qty.mantissa   = cols[qty_column].signed_varint();
+                row.qty.exponent   = std::int32_t(cols[qty_exponent_column].signed_varint());
+                row.order_id       = cols[order_id_column].string();
+
+                if (time >= from && time < to)
+                {
+                    f(row);
+                    ++visited;
+                }
+            }
+        }
+        return visited;
+    }
+}   // namespace
+
+void
+apply_row(order_book &book, tick_row const &row)
+{
+    switch (row.kind)
+    {
+    case tick_row_kind::snapshot:
+        book.reset();
+        break;
+    case tick_row_kind::snapshot_order:
+    case tick_row_kind::add:
+        book.add(tick_record::add { .order_id  = std::string(row.order_id),
+                                    .price     = from_checkpoint_decimal(row.price),
+                                    .qty       = from_checkpoint_decimal(row.qty),
+                                    .timestamp = row.time,
+                                    .side      = row.side });
+        break;
+    case tick_row_kind::remove:
+        book.remove(tick_record::remove { .order_id = std::string(row.order_id), .timestamp = row.time, .side = row.side });
+        break;
+    case tick_row_kind::execute:
+        book.execute(tick_record::execute { .order_id  = std::string(row.order_id),
+                                            .price     = from_checkpoint_decimal(row.price),
+                                            .qty       = from_checkpoint_decimal(row.qty),
+                                            .timestamp = row.time,
+                                            .side      = row.side });
+        break;
+    }
+}
+
+// writer
+
+tick_store_writer::tick_store_writer(std::filesystem::path root, std::string market)
+: directory_(tick_store(std::move(root)).directory(market))
+, market_(std::move(market))
+{
+    std::filesystem::create_directories(directory_);
+}
+
+tick_store_writer::~tick_store_writer()
+{
+    try
+    {
+        flush();
+    }
+    catch (std::exception &e)
+    {
+        spdlog::error("tick_store_writer[{}]: {}", market_, e.what());
+    }
+    close_partition();
+}
+
+std::int64_t
+tick_store_writer::row_time(trading::timestamp_type t) const
+{
+    auto ns = to_ns(t);
+    return ns > 0 ? ns : last_ns_;
+}
+
+void
+tick_store_writer::roll(std::int64_t time_ns)
+{
+    last_ns_  = std::max(last_ns_, time_ns);
+    auto hour = hour_of(last_ns_);
+    if (!hour_ || hour > *hour_)
+        open_partition(hour);
+}
+
+void
+tick_store_writer::append(tick_record const &tick)
+{
+    static constexpr auto none = checkpoint_decimal { 0, 0, 0 };
+
+    // each tick is recorded in the partition current before it is applied, so that the checkpoint taken on opening
+    // a partition is the book as it stood before the partition's first row
+    auto visitor = overloaded {
+        [&](tick_record::snapshot const &s)
+        {
+            auto ns = std::int64_t(0);
+            for (auto *side : { &s.bids, &s.offers })
+                for (auto &a : *side)
+                    ns = std::max(ns, to_ns(a.timestamp));
+            ns = row_time(from_ns(ns));
+            roll(ns);
+            add_row(ns, tick_row_kind::snapshot, trading::buy, {}, none, none);
+            for (auto *side : { &s.bids, &s.offers })
+                for (auto &a : *side)
+                    add_row(ns,
+                            tick_row_kind::snapshot_order,
+                            a.side,
+                            a.order_id,
+                            to_checkpoint_decimal(a.price),
+                            to_checkpoint_decimal(a.qty));
+            book_.load(s);
+        },
+        [&](tick_record::add const &a)
+        {
+            auto ns = row_time(a.timestamp);
+            roll(ns);
+            add_row(ns, tick_row_kind::add, a.side, a.order_id, to_checkpoint_decimal(a.price), to_checkpoint_decimal(a.qty));
+            book_.add(a);
+        },
+        [&](tick_record::remove const &r)
+        {
+            auto ns = row_time(r.timestamp);
+            roll(ns);
+            add_row(ns, tick_row_kind::remove, r.side, r.order_id, none, none);
+            book_.remove(r);
+        },
+        [&](tick_record::execute const &e)
+        {
+            auto ns = row_time(e.timestamp);
+            roll(ns);
+            add_row(
+                ns, tick_row_kind::execute, e.side, e.order_id, to_checkpoint_decimal(e.price), to_checkpoint_decimal(e.qty));
+            book_.execute(e);
+        },
+    };
+    boost::variant2::visit(visitor, tick.as_variant());
+
+    if (rows_ >= block_rows_ || std::chrono::nanoseconds(max_ns_ - base_ns_) >= flush_after_)
+        flush();
+}
+
+void
+tick_store_writer::add_row(std::int64_t              time_ns,
+                           tick_row_kind             kind,
+                           trading::side_type        side,
+                           std::string_view          order_id,
+                           checkpoint_decimal const &price,
+                           checkpoint_decimal const &qty)
+{
+    if (rows_ == 0)
+    {
+        base_ns_    = time_ns;
+        min_ns_     = time_ns;
+        max_ns_     = time_ns;
+        prev_ns_    = time_ns;
+        prev_price_ = 0;
+    }
+
+    put_varint(columns_[time_column], zigzag(time_ns - prev_ns_));
+    columns_[kind_column].push_back(std::uint8_t(std::uint8_t(kind) << 1 | (side == trading::sell ? 1 : 0)));
+    put_varint(columns_[price_column], zigzag(price.mantissa - prev_price_));
+    put_varint(columns_[price_exponent_column], zigzag(price.exponent));
+    put_varint(columns_[qty_column], zigzag(qty.mantissa));
+    put_varint(columns_[qty_exponent_column], zigzag(qty.exponent));
+    put_varint(columns_[order_id_column], order_id.size());
+    columns_[order_id_column].insert(columns_[order_id_column].end(), order_id.begin(), order_id.end());
+
+    prev_ns_    = time_ns;
+    prev_price_ = price.mantissa;
+    min_ns_     = std::min(min_ns_, time_ns);
+    max_ns_     = std::max(max_ns_, time_ns);
+    ++rows_;
+}
+
+void
+tick_store_writer::flush()
+{
+    if (rows_ == 0)
+        return;
+
+    auto h = block_header();
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, block_header::expected_magic, sizeof(h.magic));
+    h.version = block_header::current_version;
+    h.rows    = std::uint32_t(rows_);
+    h.base_ns = base_ns_;
+    h.min_ns  = min_ns_;
+    h.max_ns  = max_ns_;
+
+    auto body = std::size_t(0);
+    for (std::size_t i = 0; i < column_count; ++i)
+    {
+        h.column_bytes[i] = std::uint32_t(columns_[i].size());
+        body += columns_[i].size();
+    }
+
+    auto out = std::vector< std::uint8_t >();
+    out.reserve(sizeof(h) + body);
+    out.resize(sizeof(h));
+    for (auto &c : columns_)
+        out.insert(out.end(), c.begin(), c.end());
+    h.checksum = checksum(out.data() + sizeof(h), body, checksum(&h, sizeof(h)));
+    std::memcpy(out.data(), &h, sizeof(h));
+
+    // a block is written whole or, should the process die part way, is recognised as partial by the reader
+    auto data = std::span< std::uint8_t const >(out);
+    while (!data.empty())
+    {
+        auto n = ::write(fd_, data.data(), data.size());
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw_errno(fmt::format("tick_store_writer[{}]: write", market_));
+        }
+        data = data.subspan(std::size_t(n));
+    }
+
+    for (auto &c : columns_)
+        c.clear();
+    rows_ = 0;
+}
+
+void
+tick_store_writer::open_partition(std::int64_t hour)
+{
+    flush();
+    close_partition();
+
+    auto stem = partition_stem(hour);
+
+    // a partition which already exists was begun by an earlier run, whose checkpoint stands
+    auto book_path = directory_ / (stem + ".book");
+    if (!std::filesystem::exists(book_path))
+        write_file_atomically(book_path, encode_checkpoint(market_, book_, 0, 0));
+
+    auto path = directory_ / (stem + ".ticks");
+    fd_       = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd_ < 0)
+        throw_errno(fmt::format("open {}", path.string()));
+    hour_ = hour;
+}
+
+void
+tick_store_writer::close_partition()
+{
+    if (fd_ < 0)
+        return;
+    ::fdatasync(fd_);
+    ::close(fd_);
+    fd_ = -1;
+}
+
+// reader
+
+tick_store::tick_store(std::filesystem::path root)
+: root_(std::move(root))
+{
+}
+
+std::filesystem::path
+tick_store::directory(std::string_view market) const
+{
+    auto name = std::string(market);
+    for (auto &c : name)
+        if (!std::isalnum(static_cast< unsigned char >(c)))
+            c = '-';
+    return root_ / name;
+}
+
+std::vector< trading::timestamp_type >
+tick_store::partitions(std::string_view market) const
+{
+    auto result = std::vector< trading::timestamp_type >();
+    auto dir    = directory(market);
+    auto ec     = std::error_code();
+    for (auto it = std::filesystem::directory_iterator(dir, ec); !ec && it != std::filesystem::directory_iterator();
+         it.increment(ec))
+    {
+        auto &path = it->path();
+        if (path.extension() != ".ticks")
+            continue;
+        if (auto hour = parse_partition_stem(path.stem().string()))
+            result.push_back(from_ns(*hour * ns_per_hour));
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+std::size_t
+tick_store::scan(std::string_view                               market,
+                 trading::timestamp_type                        from,
+                 trading::timestamp_type                        to,
+                 std::function< void(tick_row const &) > const &f) const
+{
+    auto dir     = directory(market);
+    auto lo      = to_ns(from);
+    auto hi      = to_ns(to);
+    auto visited = std::size_t(0);
+    for (auto start : partitions(market))
+    {
+        auto hour = hour_of(to_ns(start));
+        if ((hour + 1) * ns_per_hour <= lo || hour * ns_per_hour >= hi)
+            continue;
+        visited += scan_partition(dir / (partition_stem(hour) + ".ticks"), lo, hi, f);
+    }
+    return visited;
+}
+
+std::vector< tick_record >
+tick_store::query(std::string_view market, trading::timestamp_type from, trading::timestamp_type to) const
+{
+    auto result = std::vector< tick_record >();
+    auto snap   = std::optional< tick_record::snapshot >();
+    auto finish = [&]
+    {
+        if (snap)
+        {
+            result.emplace_back(std::move(*snap));
+            snap.reset();
+        }
+    };
+
+    scan(market,
+         from,
+         to,
+         [&](tick_row const &row)
+         {
+             auto make_add = [&]
+             {
+                 return tick_record::add { .order_id  = std::string(row.order_id),
+                                           .price     = from_checkpoint_decimal(row.price),
+                                           .qty       = from_checkpoint_decimal(row.qty),
+                                           .timestamp = row.time,
+                                           .side      = row.side };
+             };
+
+             switch (row.kind)
+             {
+             case tick_row_kind::snapshot:
+                 finish();
+                 snap.emplace();
+                 break;
+             case tick_row_kind::snapshot_order:
+                 // a range which begins part way through a snapshot cannot, since all its rows share a time
+                 if (snap)
+                     (row.side == trading::buy ? snap->bids : snap->offers).push_back(make_add());
+                 break;
+             case tick_row_kind::add:
+                 finish();
+                 result.emplace_back(make_add());
+                 break;
+             case tick_row_kind::remove:
+                 finish();
+                 result.emplace_back(
+                     tick_record::remove { .order_id = std::string(row.order_id), .timestamp = row.time, .side = row.side });
+                 break;
+             case tick_row_kind::execute:
+                 finish();
+                 result.emplace_back(tick_record::execute { .order_id  = std::string(row.order_id),
+                                                            .price     = from_checkpoint_decimal(row.price),
+                                                            .qty       = from_checkpoint_decimal(row.qty),
+                                                            .timestamp = row.time,
+                                                            .side      = row.side });
+                 break;
+             }
+         });
+    finish();
+    return result;
+}
+
+order_book
+tick_store::book_as_of(std::string_view market, trading::timestamp_type t) const
+{
+    auto book  = order_book();
+    auto parts = partitions(market);
+    auto it    = std::upper_bound(parts.begin(), parts.end(), t);
+    if (it == parts.begin())
+        return book;
+
+    auto stem = partition_stem(hour_of(to_ns(*std::prev(it))));
+    auto dir  = directory(market);
+    if (auto cp = mapped_checkpoint::open(dir / (stem + ".book")))
+        book.load(cp->to_snapshot());
+
+    scan_partition(dir / (stem + ".ticks"),
+                   std::numeric_limits< std::int64_t >::min(),
+                   to_ns(t) + 1,
+                   [&](tick_row const &row) { apply_row(book, row); });
+    return book;
+}
+
+}   // namespace arby::power_trade
@@ -0,0 +1,202 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_ARBY_POWER_TRADE_TICK_STORE_HPP
+#define ARBY_ARBY_POWER_TRADE_TICK_STORE_HPP
+
+#include "power_trade/book_checkpoint.hpp"
+#include "power_trade/order_book.hpp"
+#include "power_trade/tick_record.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace arby::power_trade
+{
+
+/// @brief What a stored row records. An exchange snapshot is stored as a snapshot row, which clears the book, followed
+/// by one snapshot_order row per order.
+enum class tick_row_kind : std::uint8_t
+{
+    snapshot,
+    snapshot_order,
+    add,
+    remove,
+    execute
+};
+
+/// @brief One decoded row of the tick store. The order id refers into the mapped partition.
+///
+/// Prices and quantities are left in stored form, since most scans look at few of them. A remove has neither.
+struct tick_row
+{
+    trading::timestamp_type time;
+    tick_row_kind           kind;
+    trading::side_type      side;
+    std::string_view        order_id;
+    checkpoint_decimal      price;
+    checkpoint_decimal      qty;
+};
+
+/// @brief Apply a row to a book, as replay_tick applies a tick.
+void
+apply_row(order_book &book, tick_row const &row);
+
+/// @brief Appends the ticks of one market to a tick store.
+///
+/// The store holds a directory per market and a partition file per hour, named for the hour in UTC, e.g.
+/// 20220419T13.ticks. A partition is a sequence of independently readable blocks of up to block_rows rows. Within
+/// a block each field is held in a column of its own: times and prices as zig-zag varint deltas from the previous
+/// row, quantities and exponents as zig-zag varints, and order ids as length-prefixed strings.
+///
+/// Alongside each partition the writer leaves a checkpoint of the book as it stood at the start of the hour, from
+/// which any time within the hour can be reached by replay.
+///
+/// A row is written to the partition of the latest exchange timestamp seen so far. Should the exchange's timestamps
+/// step back across an hour boundary, the row is written to the later partition rather than reopening the earlier.
+/// @note not thread-safe
+struct tick_store_writer
+{
+    static constexpr std::size_t          default_block_rows = 4096;
+    static constexpr std::chrono::seconds default_flush_after { 5 };
+
+    tick_store_writer(std::filesystem::path root, std::string market);
+
+    tick_store_writer(tick_store_writer const &) = delete;
+    tick_store_writer &
+    operator=(tick_store_writer const &) = delete;
+
+    /// @brief Flushes what remains. Errors are logged.
+    ~tick_store_writer();
+
+    /// @brief Record a tick. The current block is written out once it holds block_rows rows or spans flush_after.
+    /// @throws std::system_error if a write fails
+    void
+    append(tick_record const &tick);
+
+    /// @brief Write out the current block.
+    /// @throws std::system_error if the write fails
+    void
+    flush();
+
+    void
+    block_rows(std::size_t n)
+    {
+        block_rows_ = n;
+    }
+
+    void
+    flush_after(std::chrono::milliseconds d)
+    {
+        flush_after_ = d;
+    }
+
+    std::filesystem::path const &
+    directory() const
+    {
+        return directory_;
+    }
+
+  private:
+    static constexpr std::size_t column_count = 7;
+
+    /// The time to record for a tick: its exchange time, or the latest time seen if it has none.
+    std::int64_t
+    row_time(trading::timestamp_type t) const;
+
+    /// Move to the partition for a time, if it is later than the current one.
+    void
+    roll(std::int64_t time_ns);
+
+    void
+    add_row(std::int64_t              time_ns,
+            tick_row_kind             kind,
+            trading::side_type        side,
+            std::string_view          order_id,
+            checkpoint_decimal const &price,
+            checkpoint_decimal const &qty);
+
+    void
+    open_partition(std::int64_t hour);
+
+    void
+    close_partition();
+
+    std::filesystem::path    directory_;
+    std::string              market_;
+    std::size_t              block_rows_  = default_block_rows;
+    std::chrono::nanoseconds flush_after_ = default_flush_after;
+
+    // the open partition, and the latest time seen, which decides the partition
+    std::optional< std::int64_t > hour_;
+    int                           fd_      = -1;
+    std::int64_t                  last_ns_ = 0;
+
+    // the book, for the checkpoint at the start of each partition
+    order_book book_;
+
+    // the block being built
+    std::array< std::vector< std::uint8_t >, column_count > columns_;
+    std::size_t                                              rows_       = 0;
+    std::int64_t                                             base_ns_    = 0;
+    std::int64_t                                             min_ns_     = 0;
+    std::int64_t                                             max_ns_     = 0;
+    std::int64_t                                             prev_ns_    = 0;
+    std::int64_t                                             prev_price_ = 0;
+};
+
+/// @brief Reads the tick store written by tick_store_writer. Partitions are memory-mapped while they are read.
+/// @note thread-safe. Each call maps the partitions it needs.
+struct tick_store
+{
+    explicit tick_store(std::filesystem::path root);
+
+    /// @brief The hours for which a market has a partition, in order.
+    std::vector< trading::timestamp_type >
+    partitions(std::string_view market) const;
+
+    /// @brief Visit, in stored order, the rows of a market whose time is in [from, to).
+    ///
+    /// Partitions and blocks which lie outside the range are skipped without being decoded. A row stored in a partition
+    /// later than its own hour (see tick_store_writer) is visited only if the range reaches that partition.
+    /// @return the number of rows visited
+    std::size_t
+    scan(std::string_view                               market,
+         trading::timestamp_type                        from,
+         trading::timestamp_type                        to,
+         std::function< void(tick_row const &) > const &f) const;
+
+    /// @brief The ticks of a market in [from, to), with each exchange snapshot reassembled.
+    std::vector< tick_record >
+    query(std::string_view market, trading::timestamp_type from, trading::timestamp_type to) const;
+
+    /// @brief The book as it stood after every tick up to and including time t.
+    ///
+    /// Starts from the checkpoint of the latest partition at or before t and replays forward.
+    order_book
+    book_as_of(std::string_view market, trading::timestamp_type t) const;
+
+    /// @brief The directory which holds a market's partitions. The market name is made safe for the filesystem.
+    std::filesystem::path
+    directory(std::string_view market) const;
+
+  private:
+    std::filesystem::path root_;
+};
+
+}   // namespace arby::power_trade
+
+#endif   // ARBY_ARBY_POWER_TRADE_TICK_STORE_HPP
@@ -0,0 +1,138 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+#include "power_trade/orderbook_snapshot_service.hpp"
+#include "power_trade/tick_store.hpp"
+
+#include <doctest/doctest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace arby;
+using namespace std::literals;
+
+namespace
+{
+// 2022-04-19T13:59:00Z
+auto const t0 = trading::timestamp_type(1650376740s);
+
+power_trade::tick_record::add
+make_add(std::string             orderid,
+         trading::side_type      side,
+         std::string const      &price,
+         std::string const      &qty,
+         trading::timestamp_type ts)
+{
+    return power_trade::tick_record::add { .order_id  = std::move(orderid),
+                                           .price     = trading::price_type(price),
+                                           .qty       = trading::qty_type(qty),
+                                           .timestamp = ts,
+                                           .side      = side };
+}
+
+/// A snapshot, then adds and removes at one second intervals, crossing into the next hour.
+std::vector< power_trade::tick_record >
+make_ticks()
+{
+    auto result = std::vector< power_trade::tick_record >();
+    auto snap   = power_trade::tick_record::snapshot();
+    snap.bids.push_back(make_add("b0", trading::buy, "2999.5", "1.5", t0));
+    snap.offers.push_back(make_add("o0", trading::sell, "3000.25", "0.01", t0));
+    result.emplace_back(snap);
+    for (int i = 1; i <= 120; ++i)
+    {
+        auto ts = t0 + std::chrono::seconds(i);
+        if (i % 3 == 0)
+            result.emplace_back(power_trade::tick_record::remove {
+                .order_id = "b" + std::to_string(i - 2), .timestamp = ts, .side = trading::buy });
+        else
+            result.emplace_back(make_add(
+                "b" + std::to_string(i), trading::buy, std::to_string(2990 - i % 7) + ".5", "0.00" + std::to_string(i), ts));
+    }
+    return result;
+}
+
+power_trade::order_book
+replay_until(std::vector< power_trade::tick_record > const &ticks, std::size_t n)
+{
+    auto book = power_trade::order_book();
+    for (std::size_t i = 0; i < n; ++i)
+        power_trade::orderbook_snapshot_service::replay_tick(book, ticks[i]);
+    return book;
+}
+
+struct temp_dir
+{
+    temp_dir()
+    : path(std::filesystem::temp_directory_path() /
+           ("arby-tick-store-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count())))
+    {
+    }
+
+    ~temp_dir()
+    {
+        std::filesystem::remove_all(path);
+    }
+
+    std::filesystem::path path;
+};
+}   // namespace
+
+TEST_CASE("power_trade::tick_store")
+{
+    auto dir   = temp_dir();
+    auto ticks = make_ticks();
+    {
+        auto writer = power_trade::tick_store_writer(dir.path, "eth/usd");
+        writer.block_rows(16);
+        for (auto &t : ticks)
+            writer.append(t);
+    }
+
+    auto store = power_trade::tick_store(dir.path);
+    REQUIRE(store.partitions("eth/usd").size() == 2);
+    CHECK(store.partitions("eth/usd")[0] == trading::timestamp_type(1650373200s));
+    CHECK(store.partitions("btc/usd").empty());
+
+    SUBCASE("range query")
+    {
+        auto got = store.query("eth/usd", t0, t0 + 61s);
+        REQUIRE(got.size() == 61);
+        CHECK(got[0].code() == power_trade::tick_code::snapshot);
+        CHECK(get< power_trade::tick_record::snapshot >(got[0].as_variant()).bids.size() == 1);
+
+        // across the hour boundary
+        auto rows = store.scan("eth/usd", t0 + 50s, t0 + 70s, [](power_trade::tick_row const &) {});
+        CHECK(rows == 20);
+        auto later = store.query("eth/usd", t0 + 50s, t0 + 70s);
+        REQUIRE(later.size() == 20);
+        auto &first = get< power_trade::tick_record::add >(later[0].as_variant());
+        CHECK(first.order_id == "b50");
+        CHECK(first.qty == trading::qty_type("0.0050"));
+    }
+
+    SUBCASE("book as of")
+    {
+        for (auto i : { 0, 1, 59, 60, 61, 119, 120 })
+            CHECK(store.book_as_of("eth/usd", t0 + std::chrono::seconds(i)) == replay_until(ticks, std::size_t(i) + 1));
+        CHECK(store.book_as_of("eth/usd", t0 - 2h) == power_trade::order_book());
+    }
+
+    SUBCASE("a partial block at the end is ignored")
+    {
+        auto path = store.directory("eth/usd") / "20220419T14.ticks";
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3);
+        // a snapshot row, an order row per order, and a row per tick
+        auto rows = store.scan("eth/usd", t0, t0 + 1h, [](power_trade::tick_row const &) {});
+        CHECK(rows > 60);
+        CHECK(rows < 123);
+    }
+}
@@ -0,0 +1,48 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "reactive/fix_book_feed.hpp"
+
+namespace arby::reactive
+{
+namespace
+{
+    template < class Ladder, class Levels >
+    void
+    copy_side(Levels const &levels, Ladder &ladder)
+    {
+        ladder.clear();
+        for (auto &[price, qty] : levels)
+            ladder.push_back({ .price = price, .depth = qty });
+    }
+}   // namespace
+
+fix_book_feed::fix_book_feed(asio::any_io_executor exec, std::string source_id, trading::market_key market)
+: util::has_executor_base(std::move(exec))
+, source_id_(std::move(source_id))
+, market_(std::move(market))
+{
+}
+
+void
+fix_book_feed::publish(fix_book const &book)
+{
+    auto snap            = new_aggregate_book_snapshot();
+    snap->source         = source_id_;
+    snap->timestamp      = trading::fast_clock::now();
+    snap->condition      = book.condition;
+    snap->upstream_time  = book.updated;
+    snap->book.market    = market_;
+    snap->book.timestamp = book.updated;
+    copy_side(book.bids, snap->book.bids);
+    copy_side(book.offers, snap->book.offers);
+    update_snapshot(std::move(snap));
+}
+
+}   // namespace arby::reactive
@@ -0,0 +1,49 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_ARBY_REACTIVE_FIX_BOOK_FEED_HPP
+#define ARBY_ARBY_REACTIVE_FIX_BOOK_FEED_HPP
+
+#include "reactive/fix_session.hpp"
+#include "trading/aggregate_book_feed.hpp"
+#include "trading/market_key.hpp"
+#include "util/cross_executor_connection.hpp"
+
+#include <memory>
+#include <string>
+
+namespace arby::reactive
+{
+
+/// @brief The aggregate book of one instrument of a FIX market data session.
+///
+/// The book is maintained by the fix_session of a fix_connector, which publishes it here whenever it changes.
+/// @note lives on the executor of the connector
+struct fix_book_feed
+: util::has_executor_base
+, std::enable_shared_from_this< fix_book_feed >
+, trading::implement_aggregate_book_feed< fix_book_feed >
+{
+    static constexpr char classname[] = "reactive::fix_book_feed";
+
+    fix_book_feed(asio::any_io_executor exec, std::string source_id, trading::market_key market);
+
+    /// @brief Publish a snapshot of the book.
+    /// @note must be called on the feed's executor
+    void
+    publish(fix_book const &book);
+
+  private:
+    std::string const         source_id_;
+    trading::market_key const market_;
+};
+
+}   // namespace arby::reactive
+
+#endif   // ARBY_ARBY_REACTIVE_FIX_BOOK_FEED_HPP
@@ -0,0 +1,74 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "bench/bench.hpp"
+#include "reactive/fix_connector.hpp"
+#include "testing/fix_acceptor.hpp"
+
+#include <memory>
+#include <optional>
+#include <string>
+
+using namespace arby;
+
+// one incremental refresh through the loopback interface: from the venue's write to the published snapshot
+ARBY_BENCHMARK("fix_connector/loopback_refresh")
+{
+    auto ioc    = asio::io_context();
+    auto sslctx = ssl::context(ssl::context::tls_client);
+    auto venue  = testing::fix_acceptor::create(ioc.get_executor());
+    for (int level = 0; level < 20; ++level)
+    {
+        venue->update("EUR/USD", trading::buy, std::to_string(10999 - level), "1000000");
+        venue->update("EUR/USD", trading::sell, std::to_string(11001 + level), "1000000");
+    }
+
+    auto connector = std::optional< reactive::fix_connector >();
+    connector.emplace(ioc.get_executor(),
+                      sslctx,
+                      reactive::fix_connector_args { .sender_comp_id      = "ME",
+                                                     .target_comp_id      = "VENUE",
+                                                     .socket_connect_host = "127.0.0.1",
+                                                     .socket_connect_port = venue->port(),
+                                                     .use_ssl             = false });
+
+    auto published  = std::size_t(0);
+    auto good       = false;
+    auto connection = util::cross_executor_connection();
+    asio::co_spawn(
+        ioc,
+        [&]() -> asio::awaitable< void >
+        {
+            auto feed = co_await connector->market_data("EUR/USD", trading::spot_key("eur/usd"));
+            auto [snap, con] =
+                co_await feed->subscribe([&](std::shared_ptr< trading::aggregate_book_snapshot const > s)
+                                         {
+                                             ++published;
+                                             good = s->condition.state == trading::feed_state::good;
+                                         });
+            connection = std::move(con);
+        },
+        asio::detached);
+    while (!good)
+        ioc.run_one();
+
+    auto i = 0;
+    for (auto _ : state)
+    {
+        venue->update("EUR/USD", trading::buy, "10999", ++i % 2 ? "2000000" : "1000000");
+        venue->flush();
+        for (auto seen = published; published == seen;)
+            ioc.run_one();
+    }
+
+    connection.disconnect();
+    connector.reset();
+    venue->stop();
+    ioc.run();
+}
@@ -13,5 +13,19 @@ namespace arby
 {
 namespace reactive
 {
+asio::awaitable< std::shared_ptr< trading::aggregate_book_feed_iface > >
+fix_connector::market_data(std::string symbol, trading::market_key market) const
+{
+    using asio::co_spawn;
+    using asio::use_awaitable;
+
+    auto impl = get_implementation();
+    co_return co_await co_spawn(
+        impl->get_executor(),
+        [impl, symbol = std::move(symbol), market = std::move(market)]()
+            -> asio::awaitable< std::shared_ptr< trading::aggregate_book_feed_iface > >
+        { co_return impl->market_data(symbol, market); },
+        use_awaitable);
+}
 }   // namespace reactive
 }   // namespace arby
\ No newline at end of file
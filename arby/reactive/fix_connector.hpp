@@ -31,6 +31,12 @@ struct fix_connector : entity::entity_handle< fix_connector_impl >
     : entity::entity_handle< fix_connector_impl >(exec, sslctx, args)
     {
     }
+
+    /// @brief The aggregate book of a symbol, which is requested of the venue if it has not been already.
+    /// @param symbol is the venue's name for the instrument
+    /// @param market is the market which the book is published as
+    asio::awaitable< std::shared_ptr< trading::aggregate_book_feed_iface > >
+    market_data(std::string symbol, trading::market_key market) const;
 };
 
 }   // namespace reactive
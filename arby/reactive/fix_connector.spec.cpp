@@ -0,0 +1,112 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+#include "reactive/fix_connector.hpp"
+#include "testing/fix_acceptor.hpp"
+
+#include <doctest/doctest.h>
+
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <memory>
+
+using namespace arby;
+using namespace std::literals;
+
+namespace
+{
+using snapshot_ptr = std::shared_ptr< trading::aggregate_book_snapshot const >;
+
+/// Wait up to 5 seconds for the last snapshot to satisfy pred.
+asio::awaitable< bool >
+wait_for(snapshot_ptr const &last, std::function< bool(trading::aggregate_book_snapshot const &) > pred)
+{
+    auto timer = asio::steady_timer(co_await asio::this_coro::executor);
+    for (int i = 0; i < 500; ++i)
+    {
+        if (last && pred(*last))
+            co_return true;
+        timer.expires_after(10ms);
+        co_await timer.async_wait(asio::use_awaitable);
+    }
+    co_return false;
+}
+
+bool
+good(trading::aggregate_book_snapshot const &snap)
+{
+    return snap.condition.state == trading::feed_state::good;
+}
+}   // namespace
+
+TEST_CASE("reactive::fix_connector")
+{
+    auto ioc    = asio::io_context();
+    auto sslctx = ssl::context(ssl::context::tls_client);
+    auto venue  = testing::fix_acceptor::create(ioc.get_executor());
+    venue->update("EUR/USD", trading::buy, "1.1000", "5");
+    venue->update("EUR/USD", trading::sell, "1.1002", "3");
+
+    asio::co_spawn(
+        ioc,
+        [&]() -> asio::awaitable< void >
+        {
+            auto connector = reactive::fix_connector(co_await asio::this_coro::executor,
+                                                     sslctx,
+                                                     reactive::fix_connector_args { .sender_comp_id      = "ME",
+                                                                                    .target_comp_id      = "VENUE",
+                                                                                    .socket_connect_host = "127.0.0.1",
+                                                                                    .socket_connect_port = venue->port(),
+                                                                                    .use_ssl             = false });
+
+            auto feed         = co_await connector.market_data("EUR/USD", trading::spot_key("eur/usd"));
+            auto last         = snapshot_ptr();
+            auto stale        = 0;
+            auto [first, con] = co_await feed->subscribe(
+                [&](snapshot_ptr snap)
+                {
+                    stale += snap->condition.state == trading::feed_state::stale;
+                    last = std::move(snap);
+                });
+            // the book is published as soon as it is requested, before the venue has answered
+            REQUIRE(first);
+            last = first;
+
+            // logon, request and full refresh
+            REQUIRE(co_await wait_for(last, good));
+            REQUIRE(last->book.bids.size() == 1);
+            CHECK(last->book.bids.front().price == trading::price_type("1.1"));
+            CHECK(last->book.bids.front().depth == 5);
+            REQUIRE(last->book.offers.size() == 1);
+            CHECK(last->book.offers.front().price == trading::price_type("1.1002"));
+
+            // incremental refresh
+            venue->update("EUR/USD", trading::buy, "1.1001", "2");
+            venue->update("EUR/USD", trading::sell, "1.1002", "0");
+            venue->flush();
+            REQUIRE(co_await wait_for(last, [](auto &snap) { return snap.book.bids.size() == 2; }));
+            CHECK(last->book.bids.front().price == trading::price_type("1.1001"));
+            CHECK(last->book.offers.empty());
+
+            // the book is stale while the connection is down, and rebuilt once it is remade
+            venue->drop();
+            REQUIRE(co_await wait_for(last, [&](auto &snap) { return stale > 0 && good(snap); }));
+            CHECK(venue->logons() == 2);
+            CHECK(last->book.bids.size() == 2);
+
+            con.disconnect();
+            venue->stop();
+        },
+        [](std::exception_ptr ep)
+        {
+            if (ep)
+                std::rethrow_exception(ep);
+        });
+    ioc.run();
+}
@@ -0,0 +1,63 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "bench/bench.hpp"
+#include "reactive/fix_parser.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace arby;
+
+namespace
+{
+/// A refresh of n price levels, in the layout of a MarketDataIncrementalRefresh.
+std::string
+refresh(int n)
+{
+    auto builder = reactive::fix_message_builder();
+    builder.start("X")
+        .field(49, "VENUE")
+        .field(56, "ME")
+        .field(34, std::int64_t(123456))
+        .field(52, "20220518-09:30:00.250")
+        .field(268, std::int64_t(n));
+    for (int i = 0; i < n; ++i)
+        builder.field(279, "1")
+            .field(269, i % 2 ? "1" : "0")
+            .field(55, "EUR/USD")
+            .field(270, std::to_string(1.1 + (i % 2 ? 1 : -1) * 0.0001 * (i / 2 + 1)))
+            .field(271, std::to_string(1000000 * (i + 1)));
+    return std::string(builder.finish());
+}
+}   // namespace
+
+// one message, split into its fields and checksummed
+ARBY_BENCHMARK("fix_parser/parse_refresh", 1, 4, 32)
+{
+    auto msg    = refresh(int(state.arg()));
+    auto fields = std::vector< reactive::fix_field >();
+    for (auto _ : state)
+    {
+        auto r = reactive::parse_fix_message(msg, fields);
+        bench::do_not_optimize(r);
+        bench::do_not_optimize(fields.data());
+    }
+}
+
+ARBY_BENCHMARK("fix_parser/build_heartbeat")
+{
+    auto builder = reactive::fix_message_builder();
+    auto seq     = std::int64_t(0);
+    for (auto _ : state)
+    {
+        builder.start("0").field(49, "ME").field(56, "VENUE").field(34, ++seq).field(52, "20220518-09:30:00.250");
+        bench::do_not_optimize(builder.finish());
+    }
+}
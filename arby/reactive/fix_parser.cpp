@@ -0,0 +1,221 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "reactive/fix_parser.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace arby::reactive
+{
+namespace
+{
+    constexpr std::size_t max_begin_string = 16;
+    constexpr std::size_t max_body_length  = 7;
+
+    // "10=ddd" and its delimiter
+    constexpr std::size_t trailer_size = 7;
+
+    bool
+    is_digit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    std::uint32_t
+    byte_sum(char const *first, char const *last)
+    {
+        auto sum = std::uint32_t(0);
+        for (; first != last; ++first)
+            sum += static_cast< unsigned char >(*first);
+        return sum;
+    }
+
+    fix_parse_result
+    malformed(char const *error)
+    {
+        return { .status = fix_parse_status::malformed, .size = 0, .error = error };
+    }
+
+    constexpr auto incomplete = fix_parse_result { .status = fix_parse_status::incomplete };
+}   // namespace
+
+fix_parse_result
+parse_fix_message(std::string_view buffer, std::vector< fix_field > &fields)
+{
+    fields.clear();
+
+    // 8=<begin string>
+    auto prefix = std::string_view("8=").substr(0, std::min< std::size_t >(buffer.size(), 2));
+    if (buffer.substr(0, prefix.size()) != prefix)
+        return malformed("message does not begin with BeginString");
+    auto begin_end = buffer.find(fix_soh, 2);
+    if (begin_end == std::string_view::npos)
+        return buffer.size() > max_begin_string ? malformed("BeginString too long") : incomplete;
+
+    // 9=<body length>
+    auto pos = begin_end + 1;
+    if (buffer.size() < pos + 2)
+        return incomplete;
+    if (buffer.compare(pos, 2, "9=") != 0)
+        return malformed("BodyLength is not the second field");
+    pos += 2;
+    auto body_length = std::size_t(0);
+    auto digits      = std::size_t(0);
+    for (; pos < buffer.size() && is_digit(buffer[pos]); ++pos, ++digits)
+        body_length = body_length * 10 + std::size_t(buffer[pos] - '0');
+    if (pos == buffer.size())
+        return digits > max_body_length ? malformed("BodyLength too long") : incomplete;
+    if (digits == 0 || digits > max_body_length || buffer[pos] != fix_soh)
+        return malformed("bad BodyLength");
+
+    auto const body_begin = pos + 1;
+    auto const body_end   = body_begin + body_length;
+    auto const size       = body_end + trailer_size;
+    if (buffer.size() < size)
+        return incomplete;
+
+    auto const *data = buffer.data();
+    if (body_length == 0 || data[body_end - 1] != fix_soh)
+        return malformed("BodyLength does not end on a field");
+    if (buffer.compare(body_end, 3, "10=") != 0 || !is_digit(data[body_end + 3]) || !is_digit(data[body_end + 4]) ||
+        !is_digit(data[body_end + 5]) || data[size - 1] != fix_soh)
+        return malformed("bad CheckSum field");
+    auto const expected_sum = (data[body_end + 3] - '0') * 100 + (data[body_end + 4] - '0') * 10 + (data[body_end + 5] - '0');
+
+    // the body: split at each delimiter, while summing the bytes
+    auto field_begin = body_begin;
+    auto add_field   = [&](std::size_t delimiter)
+    {
+        auto tag = 0;
+        auto i   = field_begin;
+        for (; i < delimiter && i - field_begin < 9 && is_digit(data[i]); ++i)
+            tag = tag * 10 + (data[i] - '0');
+        if (i == field_begin || i == delimiter || data[i] != '=')
+            return false;
+        fields.push_back({ .tag = tag, .value = std::string_view(data + i + 1, delimiter - i - 1) });
+        field_begin = delimiter + 1;
+        return true;
+    };
+
+    auto sum = byte_sum(data, data + body_begin);
+    auto i   = body_begin;
+#ifdef __SSE2__
+    auto const delimiters = _mm_set1_epi8(fix_soh);
+    auto const zero       = _mm_setzero_si128();
+    auto       sums       = _mm_setzero_si128();
+    for (; i + 16 <= body_end; i += 16)
+    {
+        auto chunk = _mm_loadu_si128(reinterpret_cast< __m128i const * >(data + i));
+        sums       = _mm_add_epi64(sums, _mm_sad_epu8(chunk, zero));
+        for (auto mask = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, delimiters))); mask; mask &= mask - 1)
+            if (!add_field(i + std::size_t(std::countr_zero(mask))))
+                return malformed("bad field");
+    }
+    sum += std::uint32_t(_mm_cvtsi128_si32(sums)) + std::uint32_t(_mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+#endif
+    for (; i < body_end; ++i)
+    {
+        sum += static_cast< unsigned char >(data[i]);
+        if (data[i] == fix_soh && !add_field(i))
+            return malformed("bad field");
+    }
+
+    if (int(sum % 256) != expected_sum)
+        return malformed("CheckSum mismatch");
+    if (fields.front().tag != 35)
+        return malformed("MsgType is not the third field");
+
+    return { .status = fix_parse_status::complete, .size = size };
+}
+
+std::string_view
+find_field(std::span< fix_field const > fields, int tag)
+{
+    auto i = std::find_if(fields.begin(), fields.end(), [tag](fix_field const &f) { return f.tag == tag; });
+    return i == fields.end() ? std::string_view() : i->value;
+}
+
+std::int64_t
+field_to_int(std::string_view value)
+{
+    if (value.empty() || value.size() > 18)
+        return -1;
+    auto result = std::int64_t(0);
+    for (auto c : value)
+    {
+        if (!is_digit(c))
+            return -1;
+        result = result * 10 + (c - '0');
+    }
+    return result;
+}
+
+fix_message_builder::fix_message_builder(std::string_view begin_string)
+: begin_string_(begin_string)
+{
+}
+
+fix_message_builder &
+fix_message_builder::start(std::string_view msg_type)
+{
+    body_.clear();
+    return field(35, msg_type);
+}
+
+fix_message_builder &
+fix_message_builder::field(int tag, std::string_view value)
+{
+    char buf[16];
+    auto end = std::to_chars(buf, buf + sizeof(buf), tag).ptr;
+    body_.append(buf, end);
+    body_ += '=';
+    body_ += value;
+    body_ += fix_soh;
+    return *this;
+}
+
+fix_message_builder &
+fix_message_builder::field(int tag, std::int64_t value)
+{
+    char buf[24];
+    auto end = std::to_chars(buf, buf + sizeof(buf), value).ptr;
+    return field(tag, std::string_view(buf, end));
+}
+
+std::string_view
+fix_message_builder::finish()
+{
+    char buf[24];
+    auto end = std::to_chars(buf, buf + sizeof(buf), body_.size()).ptr;
+
+    message_.clear();
+    message_ += "8=";
+    message_ += begin_string_;
+    message_ += fix_soh;
+    message_ += "9=";
+    message_.append(buf, end);
+    message_ += fix_soh;
+    message_ += body_;
+
+    auto sum = byte_sum(message_.data(), message_.data() + message_.size()) % 256;
+    message_ += "10=";
+    message_ += char('0' + sum / 100);
+    message_ += char('0' + sum / 10 % 10);
+    message_ += char('0' + sum % 10);
+    message_ += fix_soh;
+    return message_;
+}
+
+}   // namespace arby::reactive
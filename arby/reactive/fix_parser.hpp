@@ -0,0 +1,102 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_ARBY_REACTIVE_FIX_PARSER_HPP
+#define ARBY_ARBY_REACTIVE_FIX_PARSER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace arby::reactive
+{
+
+constexpr char fix_soh = '\x01';
+
+/// @brief One tag=value field of a FIX message. The value refers into the buffer which was parsed.
+struct fix_field
+{
+    int              tag;
+    std::string_view value;
+};
+
+enum class fix_parse_status
+{
+    complete,
+    incomplete,
+    malformed
+};
+
+struct fix_parse_result
+{
+    fix_parse_status status;
+
+    /// the length of the message at the front of the buffer, when complete
+    std::size_t size = 0;
+
+    /// a description of the fault, when malformed
+    char const *error = nullptr;
+};
+
+/// @brief Split the FIX message at the front of buffer into its fields, without copying.
+///
+/// The message must begin with BeginString (8) and BodyLength (9), and end with CheckSum (10) at the offset which
+/// BodyLength gives. The body is scanned once, 16 bytes at a time where SSE2 is available, both for the field
+/// delimiters and for the byte sum from which the checksum is verified.
+///
+/// @param fields is cleared, then receives the fields of the body: from MsgType (35) up to, but not including, the
+/// CheckSum. Its capacity is reused, so that parsing a stream of messages does not allocate.
+/// @return incomplete if the buffer holds only the start of a message, in which case more data should be read and the
+/// parse repeated.
+fix_parse_result
+parse_fix_message(std::string_view buffer, std::vector< fix_field > &fields);
+
+/// @brief The value of the first field with the tag, or an empty view.
+std::string_view
+find_field(std::span< fix_field const > fields, int tag);
+
+/// @brief Parse an unsigned decimal field value.
+/// @return -1 if the value is empty, is not a number or does not fit.
+std::int64_t
+field_to_int(std::string_view value);
+
+/// @brief Builds outbound FIX messages into reused buffers.
+///
+/// BeginString, BodyLength and CheckSum are supplied by finish(). The caller supplies every other field, in order.
+struct fix_message_builder
+{
+    explicit fix_message_builder(std::string_view begin_string = "FIX.4.4");
+
+    /// @brief Begin a message of the given MsgType, discarding any unfinished one.
+    fix_message_builder &
+    start(std::string_view msg_type);
+
+    fix_message_builder &
+    field(int tag, std::string_view value);
+
+    fix_message_builder &
+    field(int tag, std::int64_t value);
+
+    /// @brief Complete the message.
+    /// @return the encoded message, which is valid until the next call to start()
+    std::string_view
+    finish();
+
+  private:
+    std::string begin_string_;
+    std::string body_;
+    std::string message_;
+};
+
+}   // namespace arby::reactive
+
+#endif   // ARBY_ARBY_REACTIVE_FIX_PARSER_HPP
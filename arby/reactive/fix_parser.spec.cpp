@@ -0,0 +1,105 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+#include "reactive/fix_parser.hpp"
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace arby;
+
+namespace
+{
+/// A message written with | for the delimiter.
+std::string
+soh(std::string s)
+{
+    std::replace(s.begin(), s.end(), '|', reactive::fix_soh);
+    return s;
+}
+}   // namespace
+
+TEST_CASE("reactive::parse_fix_message")
+{
+    auto fields = std::vector< reactive::fix_field >();
+
+    // a heartbeat answering a test request
+    auto heartbeat = soh("8=FIX.4.4|9=65|35=0|49=SENDER|56=TARGET|34=12|52=20220518-09:30:00.000|112=test|10=019|");
+
+    SUBCASE("fields are split without copying")
+    {
+        auto r = reactive::parse_fix_message(heartbeat, fields);
+        REQUIRE(r.status == reactive::fix_parse_status::complete);
+        CHECK(r.size == heartbeat.size());
+        REQUIRE(fields.size() == 6);
+        CHECK(fields[0].tag == 35);
+        CHECK(fields[0].value == "0");
+        CHECK(fields[5].tag == 112);
+        CHECK(fields[5].value == "test");
+        CHECK(fields[5].value.data() == heartbeat.data() + heartbeat.find("test"));
+        CHECK(reactive::find_field(fields, 34) == "12");
+        CHECK(reactive::field_to_int(reactive::find_field(fields, 34)) == 12);
+        CHECK(reactive::find_field(fields, 58).empty());
+    }
+
+    SUBCASE("every truncation is incomplete")
+    {
+        for (std::size_t n = 0; n < heartbeat.size(); ++n)
+        {
+            auto r = reactive::parse_fix_message(std::string_view(heartbeat).substr(0, n), fields);
+            REQUIRE(r.status == reactive::fix_parse_status::incomplete);
+        }
+    }
+
+    SUBCASE("a message followed by the next is parsed alone")
+    {
+        auto two = heartbeat + heartbeat;
+        auto r   = reactive::parse_fix_message(two, fields);
+        REQUIRE(r.status == reactive::fix_parse_status::complete);
+        CHECK(r.size == heartbeat.size());
+    }
+
+    SUBCASE("faults are detected")
+    {
+        auto corrupt = heartbeat;
+        corrupt[corrupt.find("test")] = 'T';
+        CHECK(reactive::parse_fix_message(corrupt, fields).status == reactive::fix_parse_status::malformed);
+
+        auto long_body = soh("8=FIX.4.4|9=66|35=0|49=SENDER|56=TARGET|34=12|52=20220518-09:30:00.000|112=test|10=019|x");
+        CHECK(reactive::parse_fix_message(long_body, fields).status == reactive::fix_parse_status::malformed);
+
+        auto bad_tag = soh("8=FIX.4.4|9=9|35=0|x=1|10=142|");
+        CHECK(reactive::parse_fix_message(bad_tag, fields).status == reactive::fix_parse_status::malformed);
+
+        CHECK(reactive::parse_fix_message(soh("9=5|8=FIX.4.4|"), fields).status == reactive::fix_parse_status::malformed);
+    }
+
+    SUBCASE("built messages parse")
+    {
+        auto builder = reactive::fix_message_builder();
+        for (int round = 0; round < 2; ++round)
+        {
+            // long enough for the vectorised scan, with delimiters at every offset within a block
+            builder.start("W").field(49, "SENDER").field(56, "TARGET").field(34, std::int64_t(round + 1));
+            for (int i = 0; i < 20; ++i)
+                builder.field(270, std::string(std::size_t(i), '7'));
+            auto msg = std::string(builder.finish());
+
+            auto r = reactive::parse_fix_message(msg, fields);
+            REQUIRE(r.status == reactive::fix_parse_status::complete);
+            CHECK(r.size == msg.size());
+            REQUIRE(fields.size() == 24);
+            CHECK(fields[0].value == "W");
+            CHECK(fields[3].value == std::to_string(round + 1));
+            CHECK(fields[23].value == std::string(19, '7'));
+        }
+    }
+}
@@ -0,0 +1,102 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "bench/bench.hpp"
+#include "reactive/fix_session.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace arby;
+
+namespace
+{
+constexpr int messages = 4096;
+
+/// A session logged on with a book of 20 levels a side, and the incremental refreshes which follow: each a change of
+/// the quantity at one level of each side.
+struct fixture
+{
+    fixture()
+    {
+        session.subscribe("EUR/USD");
+        logon();
+
+        auto rng = std::mt19937(3);
+        for (int i = 0; i < messages; ++i)
+        {
+            start("X", i + 3).field(268, std::int64_t(2));
+            for (auto side : { "0", "1" })
+                builder.field(279, "1")
+                    .field(269, side)
+                    .field(55, "EUR/USD")
+                    .field(270, price(side, int(rng() % 20)))
+                    .field(271, std::to_string(1000000 * (1 + rng() % 50)));
+            offsets.push_back(stream.size());
+            stream += builder.finish();
+        }
+        offsets.push_back(stream.size());
+    }
+
+    static std::string
+    price(std::string_view side, int level)
+    {
+        return std::to_string((side == "0" ? 10999 - level : 11001 + level) / 10000.0).substr(0, 6);
+    }
+
+    reactive::fix_message_builder &
+    start(std::string_view type, std::int64_t seq)
+    {
+        return builder.start(type).field(49, "VENUE").field(56, "ME").field(34, seq).field(52, "20220518-09:30:00.250");
+    }
+
+    /// Begin the session again, so that the refreshes can be replayed.
+    void
+    logon()
+    {
+        session.connect({});
+        start("A", 1).field(98, "0").field(108, std::int64_t(30));
+        session.receive(builder.finish(), {});
+        start("W", 2).field(55, "EUR/USD").field(268, std::int64_t(40));
+        for (auto side : { "0", "1" })
+            for (int level = 0; level < 20; ++level)
+                builder.field(269, side).field(270, price(side, level)).field(271, "1000000");
+        session.receive(builder.finish(), {});
+        session.outbound().clear();
+        session.clear_changed();
+    }
+
+    reactive::fix_session         session { { .sender_comp_id = "ME", .target_comp_id = "VENUE" } };
+    reactive::fix_message_builder builder;
+    std::string                   stream;
+    std::vector< std::size_t >    offsets;
+};
+}   // namespace
+
+// one incremental refresh of two levels, from the bytes to the updated book
+ARBY_BENCHMARK("fix_session/incremental_refresh")
+{
+    auto f = fixture();
+    auto i = 0;
+    for (auto _ : state)
+    {
+        if (i == messages)
+        {
+            state.pause_timing();
+            f.logon();
+            i = 0;
+            state.resume_timing();
+        }
+        auto msg = std::string_view(f.stream).substr(f.offsets[i], f.offsets[i + 1] - f.offsets[i]);
+        bench::do_not_optimize(f.session.receive(msg, {}));
+        f.session.clear_changed();
+        ++i;
+    }
+}
@@ -0,0 +1,576 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "reactive/fix_session.hpp"
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace arby::reactive
+{
+namespace
+{
+    /// One entry of the repeating group of a market data message.
+    struct md_entry
+    {
+        std::string_view action;
+        std::string_view type;
+        std::string_view symbol;
+        std::string_view price;
+        std::string_view size;
+    };
+
+    /// Call f with each entry of the NoMDEntries (268) group, where each entry begins with first_tag.
+    template < class F >
+    void
+    for_each_entry(std::span< fix_field const > fields, int first_tag, F f)
+    {
+        auto is_first = [first_tag](fix_field const &field) { return field.tag == first_tag; };
+
+        auto count = std::int64_t(0);
+        auto i     = std::find_if(fields.begin(), fields.end(), is_first);
+        while (i != fields.end())
+        {
+            auto next  = std::find_if(i + 1, fields.end(), is_first);
+            auto entry = md_entry();
+            for (auto j = i; j != next; ++j)
+                switch (j->tag)
+                {
+                case 279:
+                    entry.action = j->value;
+                    break;
+                case 269:
+                    entry.type = j->value;
+                    break;
+                case 55:
+                    entry.symbol = j->value;
+                    break;
+                case 270:
+                    entry.price = j->value;
+                    break;
+                case 271:
+                    entry.size = j->value;
+                    break;
+                }
+            f(entry);
+            ++count;
+            i = next;
+        }
+
+        if (count != field_to_int(find_field(fields, 268)))
+            throw std::runtime_error(fmt::format("NoMDEntries is {}, but there are {} entries", find_field(fields, 268), count));
+    }
+
+    /// The decimal value of a field. cpp_dec_float only parses null-terminated strings.
+    trading::price_type
+    to_decimal(std::string_view value)
+    {
+        char buf[64];
+        if (value.empty() || value.size() >= sizeof(buf))
+            throw std::runtime_error(fmt::format("bad decimal: '{}'", value));
+        std::memcpy(buf, value.data(), value.size());
+        buf[value.size()] = 0;
+        return trading::price_type(buf);
+    }
+
+    /// Apply a price level entry to the side of the book it is for. Entries for other than bids and offers are ignored.
+    void
+    apply_level(fix_book &book, md_entry const &entry, bool remove)
+    {
+        auto apply = [&](auto &side)
+        {
+            if (entry.price.empty())
+                throw std::runtime_error(fmt::format("{} entry without MDEntryPx", book.symbol));
+            auto price = to_decimal(entry.price);
+            auto qty   = remove ? trading::qty_type(0) : to_decimal(entry.size);
+            if (qty > 0)
+                side.insert_or_assign(std::move(price), std::move(qty));
+            else
+                side.erase(price);
+        };
+
+        if (entry.type == "0")
+            apply(book.bids);
+        else if (entry.type == "1")
+            apply(book.offers);
+    }
+
+    /// UTCTimestamp: YYYYMMDD-HH:MM:SS with optional fractional seconds. An unreadable time is the epoch.
+    trading::timestamp_type
+    parse_utc_timestamp(std::string_view s)
+    {
+        using namespace std::chrono;
+
+        if (s.size() < 17 || s[8] != '-' || s[11] != ':' || s[14] != ':')
+            return {};
+        auto number = [&](std::size_t pos, std::size_t n) { return field_to_int(s.substr(pos, n)); };
+        auto hh     = number(9, 2);
+        auto mm     = number(12, 2);
+        auto ss     = number(15, 2);
+        auto ymd    = year(int(number(0, 4))) / month(unsigned(number(4, 2))) / day(unsigned(number(6, 2)));
+        if (!ymd.ok() || hh < 0 || mm < 0 || ss < 0)
+            return {};
+
+        auto result = sys_days(ymd) + hours(hh) + minutes(mm) + seconds(ss);
+        auto ns     = nanoseconds(0);
+        if (s.size() > 18 && s[17] == '.')
+        {
+            auto frac = s.substr(18, 9);
+            auto n    = field_to_int(frac);
+            if (n >= 0)
+            {
+                for (auto i = frac.size(); i < 9; ++i)
+                    n *= 10;
+                ns = nanoseconds(n);
+            }
+        }
+        return time_point_cast< system_clock::duration >(result + ns);
+    }
+
+    /// Write the UTCTimestamp of t, to the millisecond, into buf.
+    std::string_view
+    format_utc_timestamp(trading::timestamp_type t, char (&buf)[32])
+    {
+        using namespace std::chrono;
+
+        auto days = floor< std::chrono::days >(t);
+        auto ymd  = year_month_day(days);
+        auto time = hh_mm_ss(floor< milliseconds >(t - days));
+        auto r    = fmt::format_to_n(buf,
+                                  sizeof(buf),
+                                  "{:04}{:02}{:02}-{:02}:{:02}:{:02}.{:03}",
+                                  int(ymd.year()),
+                                  unsigned(ymd.month()),
+                                  unsigned(ymd.day()),
+                                  time.hours().count(),
+                                  time.minutes().count(),
+                                  time.seconds().count(),
+                                  time.subseconds().count());
+        return std::string_view(buf, r.size);
+    }
+}   // namespace
+
+fix_session::fix_session(config conf)
+: config_(std::move(conf))
+, heartbeat_interval_(config_.heartbeat_interval)
+{
+}
+
+void
+fix_session::connect(clock::time_point now)
+{
+    now_           = now;
+    connected_at_  = now;
+    last_received_ = now;
+    state_         = connection_unauthenticated;
+    next_inbound_  = 1;
+    next_outbound_ = 1;
+    resend_until_.reset();
+    test_request_.reset();
+    heartbeat_interval_ = config_.heartbeat_interval;
+    outbound_.clear();
+
+    begin("A").field(98, "0").field(108, std::int64_t(heartbeat_interval_.count())).field(141, "Y");
+    send();
+}
+
+void
+fix_session::disconnect(std::string_view reason)
+{
+    state_ = connection_down;
+    resend_until_.reset();
+    test_request_.reset();
+    for (auto &[symbol, book] : books_)
+        if (book.condition.state == trading::feed_state::good)
+        {
+            book.condition.reset(trading::feed_state::stale);
+            book.condition.errors.emplace_back(reason);
+            mark_changed(book);
+        }
+}
+
+fix_book const &
+fix_session::subscribe(std::string const &symbol)
+{
+    auto [i, inserted] = books_.try_emplace(symbol);
+    auto &book         = i->second;
+    if (inserted)
+    {
+        book.symbol = symbol;
+        book.condition.reset(trading::feed_state::not_ready);
+        book.condition.errors.push_back("subscribing");
+        if (state_ == connection_up)
+            send_market_data_request(book);
+    }
+    return book;
+}
+
+std::size_t
+fix_session::receive(std::string_view data, clock::time_point now)
+{
+    now_          = now;
+    auto consumed = std::size_t(0);
+    while (state_ != connection_down)
+    {
+        auto r = parse_fix_message(data.substr(consumed), fields_);
+        if (r.status == fix_parse_status::incomplete)
+            break;
+        if (r.status == fix_parse_status::malformed)
+            throw std::runtime_error(fmt::format("malformed message: {}", r.error));
+
+        // any traffic shows that the counterparty is alive
+        last_received_ = now;
+        test_request_.reset();
+
+        process(fields_);
+        consumed += r.size;
+    }
+    return consumed;
+}
+
+bool
+fix_session::poll(clock::time_point now)
+{
+    now_ = now;
+    if (state_ == connection_down)
+        return true;
+    if (state_ == connection_unauthenticated)
+        return now - connected_at_ < heartbeat_interval_;
+
+    auto silence = now - last_received_;
+    if (test_request_)
+    {
+        if (silence >= 2 * heartbeat_interval_)
+            return false;
+    }
+    else if (silence >= std::chrono::milliseconds(heartbeat_interval_) * 6 / 5)
+    {
+        test_request_ = fmt::format("TEST{}", ++test_requests_);
+        begin("1").field(112, *test_request_);
+        send();
+    }
+
+    if (now - last_sent_ >= heartbeat_interval_)
+    {
+        begin("0");
+        send();
+    }
+    return true;
+}
+
+void
+fix_session::clear_changed()
+{
+    changed_.clear();
+}
+
+void
+fix_session::process(std::span< fix_field const > fields)
+{
+    auto type = fields.front().value;
+    auto seq  = field_to_int(find_field(fields, 34));
+    if (seq < 0)
+        throw std::runtime_error(fmt::format("{} message without MsgSeqNum", type));
+    if (find_field(fields, 49) != config_.target_comp_id || find_field(fields, 56) != config_.sender_comp_id)
+        throw std::runtime_error(fmt::format("{} message from {} to {}", type, find_field(fields, 49), find_field(fields, 56)));
+    if (state_ == connection_unauthenticated && type != "A" && type != "5")
+        throw std::runtime_error(fmt::format("{} message before Logon", type));
+
+    // SequenceReset moves the expected number on. In Reset mode its own number is ignored, but in GapFill mode it
+    // stands in for the messages it skips and is sequenced like them.
+    auto gap_fill = type == "4" && find_field(fields, 123) == "Y";
+    if (type == "4" && !gap_fill)
+    {
+        auto next = field_to_int(find_field(fields, 36));
+        if (next < next_inbound_)
+            throw std::runtime_error(fmt::format("SequenceReset to {}, expecting {}", next, next_inbound_));
+        if (next > next_inbound_ && !resend_until_)
+        {
+            mark_books_stale(fmt::format("SequenceReset skipped {} to {}", next_inbound_, next - 1));
+            request_snapshots();
+        }
+        advance(next);
+        return;
+    }
+
+    if (seq < next_inbound_)
+    {
+        if (find_field(fields, 43) == "Y")
+            return;
+        throw std::runtime_error(fmt::format("MsgSeqNum too low: expected {}, received {}", next_inbound_, seq));
+    }
+
+    if (seq > next_inbound_)
+    {
+        on_gap(seq);
+
+        // the session messages are acted upon now, since they are not resent
+        if (type == "A")
+            on_logon(fields);
+        else if (type == "1")
+        {
+            begin("0").field(112, find_field(fields, 112));
+            send();
+        }
+        else if (type == "5")
+            on_logout(fields);
+        return;
+    }
+
+    if (gap_fill)
+    {
+        auto next = field_to_int(find_field(fields, 36));
+        if (next <= next_inbound_)
+            throw std::runtime_error(fmt::format("SequenceReset-GapFill to {}, expecting {}", next, next_inbound_));
+        advance(next);
+        return;
+    }
+
+    advance(next_inbound_ + 1);
+
+    switch (type.size() == 1 ? type.front() : 0)
+    {
+    case 'X':
+        on_incremental_refresh(fields);
+        break;
+    case 'W':
+        on_full_refresh(fields);
+        break;
+    case '0':
+        // a Heartbeat only shows that the counterparty is alive
+        break;
+    case '1':
+        begin("0").field(112, find_field(fields, 112));
+        send();
+        break;
+    case '2':
+    {
+        // nothing we send is worth resending: a MarketDataRequest would duplicate the subscription
+        auto from = field_to_int(find_field(fields, 7));
+        builder_.start("4")
+            .field(49, config_.sender_comp_id)
+            .field(56, config_.target_comp_id)
+            .field(34, from)
+            .field(43, "Y")
+            .field(123, "Y")
+            .field(36, next_outbound_);
+        outbound_ += builder_.finish();
+        last_sent_ = now_;
+        break;
+    }
+    case '3':
+        spdlog::warn("fix_session::{} : Reject of {}: {}", __func__, find_field(fields, 45), find_field(fields, 58));
+        break;
+    case 'A':
+        on_logon(fields);
+        break;
+    case '5':
+        on_logout(fields);
+        break;
+    case 'Y':
+        on_request_reject(fields);
+        break;
+    default:
+        spdlog::debug("fix_session::{} : ignoring {} message", __func__, type);
+    }
+}
+
+void
+fix_session::on_gap(std::int64_t seq)
+{
+    if (!resend_until_)
+    {
+        spdlog::warn("fix_session::{} : gap, expected {}, received {}", __func__, next_inbound_, seq);
+        begin("2").field(7, next_inbound_).field(16, std::int64_t(0));
+        send();
+
+        // the venue may fill the gap with a SequenceReset rather than resend the refreshes
+        mark_books_stale(fmt::format("sequence gap at {}", next_inbound_));
+    }
+    resend_until_ = std::max(resend_until_.value_or(0), seq);
+}
+
+void
+fix_session::advance(std::int64_t next)
+{
+    next_inbound_ = next;
+    if (resend_until_ && next_inbound_ > *resend_until_)
+    {
+        // snapshots are requested only now, so that the replies are not dropped beyond the gap
+        resend_until_.reset();
+        request_snapshots();
+    }
+}
+
+void
+fix_session::mark_books_stale(std::string_view reason)
+{
+    for (auto &[symbol, book] : books_)
+        if (book.condition.state == trading::feed_state::good)
+        {
+            book.condition.reset(trading::feed_state::stale);
+            book.condition.errors.emplace_back(reason);
+            mark_changed(book);
+        }
+}
+
+void
+fix_session::request_snapshots()
+{
+    // a book still awaiting its first full refresh asks again too, in case that refresh was lost. Before Logon, the
+    // subscriptions which follow it bring full refreshes anyway.
+    if (state_ != connection_up)
+        return;
+    for (auto &[symbol, book] : books_)
+        if (book.condition.state != trading::feed_state::good && book.condition.state != trading::feed_state::error)
+            send_market_data_request(book, true);
+}
+
+void
+fix_session::on_logon(std::span< fix_field const > fields)
+{
+    if (state_ != connection_unauthenticated)
+        throw std::runtime_error("unexpected Logon");
+    state_ = connection_up;
+
+    auto interval = field_to_int(find_field(fields, 108));
+    if (interval > 0)
+        heartbeat_interval_ = std::chrono::seconds(interval);
+
+    for (auto &[symbol, book] : books_)
+        send_market_data_request(book);
+}
+
+void
+fix_session::on_logout(std::span< fix_field const > fields)
+{
+    auto text = find_field(fields, 58);
+    spdlog::info("fix_session::{} : {}", __func__, text);
+    disconnect(fmt::format("logged out: {}", text));
+}
+
+void
+fix_session::on_full_refresh(std::span< fix_field const > fields)
+{
+    auto book = find_book(find_field(fields, 55));
+    if (!book)
+        return;
+
+    book->bids.clear();
+    book->offers.clear();
+    for_each_entry(fields, 269, [&](md_entry const &entry) { apply_level(*book, entry, false); });
+    book->condition.reset(trading::feed_state::good);
+    book->updated = parse_utc_timestamp(find_field(fields, 52));
+    mark_changed(*book);
+}
+
+void
+fix_session::on_incremental_refresh(std::span< fix_field const > fields)
+{
+    auto updated = parse_utc_timestamp(find_field(fields, 52));
+
+    // the symbol is carried from one entry to the next if it is not repeated
+    auto symbol = std::string_view();
+    auto book   = static_cast< fix_book * >(nullptr);
+    for_each_entry(fields,
+                   279,
+                   [&](md_entry const &entry)
+                   {
+                       if (!entry.symbol.empty() && entry.symbol != symbol)
+                       {
+                           symbol = entry.symbol;
+                           book   = find_book(symbol);
+                       }
+                       // until the full refresh arrives, there is nothing to apply the change to
+                       if (!book || book->condition.state != trading::feed_state::good)
+                           return;
+
+                       if (entry.action == "0" || entry.action == "1")
+                           apply_level(*book, entry, false);
+                       else if (entry.action == "2")
+                           apply_level(*book, entry, true);
+                       else
+                           throw std::runtime_error(fmt::format("{}: bad MDUpdateAction '{}'", symbol, entry.action));
+                       book->updated = updated;
+                       mark_changed(*book);
+                   });
+}
+
+void
+fix_session::on_request_reject(std::span< fix_field const > fields)
+{
+    auto req_id = find_field(fields, 262);
+    if (req_id.starts_with(snapshot_req_prefix))
+        req_id.remove_prefix(snapshot_req_prefix.size());
+    auto book = find_book(req_id);
+    if (!book)
+        return;
+    book->condition.reset(trading::feed_state::error);
+    book->condition.errors.push_back(fmt::format("MarketDataRequest rejected: {}", find_field(fields, 58)));
+    mark_changed(*book);
+}
+
+fix_book *
+fix_session::find_book(std::string_view symbol)
+{
+    auto i = books_.find(symbol);
+    return i == books_.end() ? nullptr : &i->second;
+}
+
+void
+fix_session::mark_changed(fix_book &book)
+{
+    if (std::find(changed_.begin(), changed_.end(), &book) == changed_.end())
+        changed_.push_back(&book);
+}
+
+fix_message_builder &
+fix_session::begin(std::string_view msg_type)
+{
+    char buf[32];
+    return builder_.start(msg_type)
+        .field(49, config_.sender_comp_id)
+        .field(56, config_.target_comp_id)
+        .field(34, next_outbound_++)
+        .field(52, format_utc_timestamp(std::chrono::system_clock::now(), buf));
+}
+
+void
+fix_session::send()
+{
+    outbound_ += builder_.finish();
+    last_sent_ = now_;
+}
+
+void
+fix_session::send_market_data_request(fix_book const &book, bool snapshot_only)
+{
+    // the whole book, as a snapshot followed by incremental refreshes, or as a snapshot alone
+    if (snapshot_only)
+        req_id_.assign(snapshot_req_prefix).append(book.symbol);
+    else
+        req_id_.assign(book.symbol);
+    begin("V")
+        .field(262, req_id_)
+        .field(263, snapshot_only ? "0" : "1")
+        .field(264, std::int64_t(0))
+        .field(265, "1")
+        .field(267, std::int64_t(2))
+        .field(269, "0")
+        .field(269, "1")
+        .field(146, std::int64_t(1))
+        .field(55, book.symbol);
+    send();
+}
+
+}   // namespace arby::reactive
@@ -0,0 +1,230 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_ARBY_REACTIVE_FIX_SESSION_HPP
+#define ARBY_ARBY_REACTIVE_FIX_SESSION_HPP
+
+#include "connection_state.hpp"
+#include "reactive/fix_parser.hpp"
+#include "trading/feed_condition.hpp"
+#include "trading/types.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace arby::reactive
+{
+
+/// @brief The price levels of one instrument, as maintained from market data refreshes.
+struct fix_book
+{
+    std::string symbol;
+
+    std::map< trading::price_type, trading::qty_type, std::greater<> > bids;
+    std::map< trading::price_type, trading::qty_type >                 offers;
+
+    /// not_ready until the first full refresh, stale while the session is down or refreshes may have been lost, and
+    /// error if the request was rejected
+    trading::feed_condition condition;
+
+    /// the SendingTime of the last refresh applied
+    trading::timestamp_type updated = {};
+};
+
+/// @brief The initiator side of a FIX 4.4 market data session, independent of the transport.
+///
+/// The owner passes the bytes it reads to receive(), calls poll() about once a second, and writes whatever the session
+/// appends to outbound(). Each connection begins with connect(), which resets the sequence numbers on both sides by
+/// sending Logon with ResetSeqNumFlag.
+///
+/// A gap in the inbound sequence is answered by one ResendRequest for everything after the last message received.
+/// Application messages which arrive beyond the gap are dropped until the gap is filled, so that no refresh is ever
+/// applied out of order. Since the venue may fill the gap with a SequenceReset rather than resend the refreshes, the
+/// books are also marked stale, and a snapshot of each is requested once the gap is closed. A SequenceReset which skips
+/// messages outside a resend does the same.
+///
+/// Each subscribed symbol has a MarketDataRequest for the full book with incremental refresh. The books are rebuilt by
+/// each MarketDataSnapshotFullRefresh (W) and maintained by MarketDataIncrementalRefresh (X).
+/// @note not thread-safe
+struct fix_session
+{
+    using clock = std::chrono::steady_clock;
+
+    struct config
+    {
+        std::string          sender_comp_id;
+        std::string          target_comp_id;
+        std::chrono::seconds heartbeat_interval = std::chrono::seconds(30);
+    };
+
+    explicit fix_session(config conf);
+
+    /// @brief Begin a session on a new connection, queueing a Logon.
+    void
+    connect(clock::time_point now);
+
+    /// @brief The connection has been lost. Every book which was good is marked stale.
+    void
+    disconnect(std::string_view reason);
+
+    /// @brief Request market data for symbol: at once if logged on, otherwise upon logon.
+    /// @return the book, which lives as long as the session
+    fix_book const &
+    subscribe(std::string const &symbol);
+
+    /// @brief Process each complete message at the front of data.
+    /// @return the number of bytes consumed. Any remainder is the start of a message which is yet to be completed.
+    /// @throws std::runtime_error if the data is malformed or the counterparty breaks the protocol, in which case the
+    /// connection should be dropped.
+    std::size_t
+    receive(std::string_view data, clock::time_point now);
+
+    /// @brief Send a Heartbeat when we have been quiet for the heartbeat interval, and a TestRequest when the
+    /// counterparty has.
+    /// @return false if the counterparty has not answered the TestRequest, or the Logon, in time. The connection should
+    /// then be dropped.
+    bool
+    poll(clock::time_point now);
+
+    /// @brief The messages waiting to be sent. The owner clears the buffer once they are written.
+    std::string &
+    outbound()
+    {
+        return outbound_;
+    }
+
+    /// @brief The books changed since the last call to clear_changed(), each listed once.
+    std::vector< fix_book * > const &
+    changed() const
+    {
+        return changed_;
+    }
+
+    void
+    clear_changed();
+
+    /// @brief connection_unauthenticated between connect() and the Logon reply.
+    connection_state
+    state() const
+    {
+        return state_;
+    }
+
+    std::chrono::seconds
+    heartbeat_interval() const
+    {
+        return heartbeat_interval_;
+    }
+
+    /// @brief The MsgSeqNum expected of the next inbound message.
+    std::int64_t
+    next_inbound() const
+    {
+        return next_inbound_;
+    }
+
+    std::int64_t
+    next_outbound() const
+    {
+        return next_outbound_;
+    }
+
+  private:
+    void
+    process(std::span< fix_field const > fields);
+
+    /// @brief A message numbered seq has arrived beyond the next expected.
+    void
+    on_gap(std::int64_t seq);
+
+    /// @brief Expect next as the next inbound MsgSeqNum, closing any gap which this fills.
+    void
+    advance(std::int64_t next);
+
+    /// @brief Refreshes may have been lost, so no good book can be trusted.
+    void
+    mark_books_stale(std::string_view reason);
+
+    /// @brief Request a full refresh of each book which is neither good nor in error.
+    void
+    request_snapshots();
+
+    void
+    on_logon(std::span< fix_field const > fields);
+
+    void
+    on_logout(std::span< fix_field const > fields);
+
+    void
+    on_full_refresh(std::span< fix_field const > fields);
+
+    void
+    on_incremental_refresh(std::span< fix_field const > fields);
+
+    void
+    on_request_reject(std::span< fix_field const > fields);
+
+    fix_book *
+    find_book(std::string_view symbol);
+
+    void
+    mark_changed(fix_book &book);
+
+    /// @brief Start an outbound message with the standard header.
+    fix_message_builder &
+    begin(std::string_view msg_type);
+
+    /// @brief Queue the message started with begin().
+    void
+    send();
+
+    /// @param snapshot_only requests a full refresh of a book already subscribed, under snapshot_req_prefix
+    void
+    send_market_data_request(fix_book const &book, bool snapshot_only = false);
+
+    /// the MDReqID of a snapshot request is the symbol with this prefix
+    static constexpr std::string_view snapshot_req_prefix = "SNAP:";
+
+    config const         config_;
+    std::chrono::seconds heartbeat_interval_;
+    connection_state     state_         = connection_down;
+    std::int64_t         next_inbound_  = 1;
+    std::int64_t         next_outbound_ = 1;
+    std::uint64_t        test_requests_ = 0;
+
+    // the highest sequence number seen beyond a gap, while a resend is outstanding
+    std::optional< std::int64_t > resend_until_;
+
+    // the TestReqID awaiting a Heartbeat
+    std::optional< std::string > test_request_;
+
+    clock::time_point now_;
+    clock::time_point connected_at_;
+    clock::time_point last_sent_;
+    clock::time_point last_received_;
+
+    std::map< std::string, fix_book, std::less<> > books_;
+    std::vector< fix_book * >                      changed_;
+
+    fix_message_builder      builder_;
+    std::string              outbound_;
+    std::string              req_id_;
+    std::vector< fix_field > fields_;
+};
+
+}   // namespace arby::reactive
+
+#endif   // ARBY_ARBY_REACTIVE_FIX_SESSION_HPP
@@ -0,0 +1,393 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+#include "reactive/fix_session.hpp"
+
+#include <doctest/doctest.h>
+
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace arby;
+using namespace std::literals;
+
+namespace
+{
+/// The fields of a message, by tag. A repeated tag keeps its last value.
+using message = std::map< int, std::string >;
+
+/// Take the messages the session has queued.
+std::vector< message >
+sent(reactive::fix_session &session)
+{
+    auto result = std::vector< message >();
+    auto fields = std::vector< reactive::fix_field >();
+    auto data   = std::string_view(session.outbound());
+    while (!data.empty())
+    {
+        auto r = reactive::parse_fix_message(data, fields);
+        REQUIRE(r.status == reactive::fix_parse_status::complete);
+        auto &m = result.emplace_back();
+        for (auto &f : fields)
+            m[f.tag] = std::string(f.value);
+        data.remove_prefix(r.size);
+    }
+    session.outbound().clear();
+    return result;
+}
+
+/// The venue's side of the session.
+struct counterparty
+{
+    reactive::fix_message_builder &
+    start(std::string_view type, std::int64_t seq)
+    {
+        return builder.start(type).field(49, "VENUE").field(56, "ME").field(34, seq).field(52, "20220518-09:30:00.250");
+    }
+
+    reactive::fix_message_builder &
+    start(std::string_view type)
+    {
+        return start(type, next++);
+    }
+
+    /// Deliver the message started, in two pieces to show that a partial message is held back.
+    void
+    deliver(reactive::fix_session &session)
+    {
+        auto msg      = std::string(builder.finish());
+        auto consumed = session.receive(std::string_view(msg).substr(0, msg.size() / 2), now);
+        CHECK(consumed == 0);
+        CHECK(session.receive(msg, now) == msg.size());
+    }
+
+    void
+    logon(reactive::fix_session &session)
+    {
+        start("A").field(98, "0").field(108, std::int64_t(30));
+        deliver(session);
+    }
+
+    reactive::fix_message_builder       builder;
+    std::int64_t                        next = 1;
+    reactive::fix_session::clock::time_point now;
+};
+
+reactive::fix_session
+make_session()
+{
+    return reactive::fix_session({ .sender_comp_id = "ME", .target_comp_id = "VENUE", .heartbeat_interval = 30s });
+}
+
+trading::qty_type
+level(auto const &side, int price)
+{
+    auto i = side.find(trading::price_type(price));
+    return i == side.end() ? trading::qty_type(0) : i->second;
+}
+}   // namespace
+
+TEST_CASE("reactive::fix_session")
+{
+    SUBCASE("logon and market data")
+    {
+        auto session = make_session();
+        auto venue   = counterparty();
+        auto &book   = session.subscribe("EUR/USD");
+
+        session.connect(venue.now);
+        CHECK(session.state() == connection_unauthenticated);
+        auto out = sent(session);
+        REQUIRE(out.size() == 1);
+        CHECK(out[0][35] == "A");
+        CHECK(out[0][34] == "1");
+        CHECK(out[0][108] == "30");
+        CHECK(out[0][141] == "Y");
+
+        // the subscription is sent upon logon
+        venue.logon(session);
+        CHECK(session.state() == connection_up);
+        out = sent(session);
+        REQUIRE(out.size() == 1);
+        CHECK(out[0][35] == "V");
+        CHECK(out[0][34] == "2");
+        CHECK(out[0][55] == "EUR/USD");
+        CHECK(out[0][263] == "1");
+
+        // an incremental refresh before the snapshot has nothing to apply to
+        venue.start("X").field(268, std::int64_t(1)).field(279, "0").field(269, "0").field(55, "EUR/USD").field(270, "100").field(271, "5");
+        venue.deliver(session);
+        CHECK(book.bids.empty());
+        CHECK(session.changed().empty());
+
+        venue.start("W")
+            .field(55, "EUR/USD")
+            .field(268, std::int64_t(3))
+            .field(269, "0")
+            .field(270, "100")
+            .field(271, "1.5")
+            .field(269, "0")
+            .field(270, "99")
+            .field(271, "2")
+            .field(269, "1")
+            .field(270, "101")
+            .field(271, "3");
+        venue.deliver(session);
+        CHECK(book.condition.state == trading::feed_state::good);
+        CHECK(book.bids.size() == 2);
+        CHECK(level(book.bids, 100) == trading::qty_type("1.5"));
+        CHECK(book.bids.begin()->first == 100);
+        CHECK(level(book.offers, 101) == 3);
+        REQUIRE(session.changed().size() == 1);
+        CHECK(session.changed().front() == &book);
+        session.clear_changed();
+
+        // a change, a new level and a deletion, with the symbol carried between entries
+        venue.start("X")
+            .field(268, std::int64_t(3))
+            .field(279, "1")
+            .field(269, "0")
+            .field(55, "EUR/USD")
+            .field(270, "100")
+            .field(271, "4")
+            .field(279, "0")
+            .field(269, "1")
+            .field(270, "102")
+            .field(271, "1")
+            .field(279, "2")
+            .field(269, "0")
+            .field(270, "99");
+        venue.deliver(session);
+        CHECK(level(book.bids, 100) == 4);
+        CHECK(book.bids.size() == 1);
+        CHECK(level(book.offers, 102) == 1);
+        CHECK(book.offers.begin()->first == 101);
+        CHECK(session.changed().size() == 1);
+        CHECK(book.updated == trading::timestamp_type(std::chrono::sys_days(2022y / 5 / 18) + 9h + 30min + 250ms));
+
+        // a subscription made while logged on is sent at once
+        session.subscribe("GBP/USD");
+        out = sent(session);
+        REQUIRE(out.size() == 1);
+        CHECK(out[0][55] == "GBP/USD");
+
+        venue.start("Y").field(262, "GBP/USD").field(58, "unknown symbol");
+        venue.deliver(session);
+        CHECK(session.changed().back()->symbol == "GBP/USD");
+        CHECK(session.changed().back()->condition.state == trading::feed_state::error);
+
+        venue.start("5").field(58, "maintenance");
+        venue.deliver(session);
+        CHECK(session.state() == connection_down);
+        CHECK(book.condition.state == trading::feed_state::stale);
+    }
+
+    SUBCASE("a gap is filled by resending")
+    {
+        auto session = make_session();
+        auto venue   = counterparty();
+        auto &book   = session.subscribe("EUR/USD");
+        session.connect(venue.now);
+        venue.logon(session);
+        venue.start("W").field(55, "EUR/USD").field(268, std::int64_t(1)).field(269, "0").field(270, "100").field(271, "1");
+        venue.deliver(session);
+        sent(session);
+        session.clear_changed();
+
+        // message 3 is lost
+        auto x = [&](std::int64_t seq, char const *qty)
+        {
+            venue.start("X", seq).field(268, std::int64_t(1)).field(279, "1").field(269, "0").field(55, "EUR/USD").field(270, "100").field(271, qty);
+        };
+        x(4, "4");
+        venue.deliver(session);
+        x(5, "5");
+        venue.deliver(session);
+        CHECK(level(book.bids, 100) == 1);
+        CHECK(book.condition.state == trading::feed_state::stale);
+        CHECK(session.changed().size() == 1);
+        auto out = sent(session);
+        REQUIRE(out.size() == 1);
+        CHECK(out[0][35] == "2");
+        CHECK(out[0][7] == "3");
+        CHECK(out[0][16] == "0");
+
+        // a duplicate already seen is dropped
+        venue.start("W", 2).field(43, "Y").field(55, "EUR/USD").field(268, std::int64_t(0));
+        venue.deliver(session);
+        CHECK(book.bids.size() == 1);
+
+        // the resent refreshes are in order, but the book waits for a snapshot before taking any more
+        x(3, "3");
+        venue.deliver(session);
+        CHECK(session.next_inbound() == 4);
+        x(4, "4");
+        venue.deliver(session);
+        CHECK(sent(session).empty());
+        x(5, "5");
+        venue.deliver(session);
+        CHECK(level(book.bids, 100) == 1);
+        CHECK(session.next_inbound() == 6);
+
+        // with the gap closed, a snapshot is requested
+        out = sent(session);
+        REQUIRE(out.size() == 1);
+        CHECK(out[0][35] == "V");
+        CHECK(out[0][263] == "0");
+        CHECK(out[0][262] == "SNAP:EUR/USD");
+        CHECK(out[0][55] == "EUR/USD");
+
+        venue.start("W", 6).field(55, "EUR/USD").field(268, std::int64_t(1)).field(269, "0").field(270, "100").field(271, "5");
+        venue.deliver(session);
+        CHECK(book.condition.state == trading::feed_state::good);
+        x(7, "7");
+        venue.deliver(session);
+        CHECK(level(book.bids, 100) == 7);
+        CHECK(session.next_inbound() == 8);
+        CHECK(sent(session).empty());
+
+        // a message numbered too low which is not a resend breaks the session
+        x(2, "2");
+        auto msg = std::string(venue.builder.finish());
+        CHECK_THROWS_AS(session.receive(msg, venue.now), std::runtime_error);
+    }
+
+    SUBCASE("a gap filled by SequenceReset rebuilds the books")
+    {
+        auto session = make_session();
+        auto venue   = counterparty();
+        auto &book   = session.subscribe("EUR/USD");
+        session.connect(venue.now);
+        venue.logon(session);
+        venue.start("W").field(55, "EUR/USD").field(268, std::int64_t(1)).field(269, "0").field(270, "100").field(271, "1");
+        venue.deliver(session);
+        sent(session);
+
+        // refreshes 3 and 4 are lost, and the venue will not resend them
+        venue.start("X", 5).field(268, std::int64_t(1)).field(279, "1").field(269, "0").field(55, "EUR/USD").field(270, "100").field(271, "5");
+        venue.deliver(session);
+        CHECK(book.condition.state == trading::feed_state::stale);
+        auto out = sent(session);
+        REQUIRE(out.size() == 1);
+        CHECK(out[0][35] == "2");
+
+        venue.start("4", 3).field(43, "Y").field(123, "Y").field(36, std::int64_t(5));
+        venue.deliver(session);
+        CHECK(session.next_inbound() == 5);
+        CHECK(sent(session).empty());
+
+        // the resent refresh closes the gap, but the book has missed 3 and 4, so a snapshot is requested
+        venue.start("X", 5).field(43, "Y").field(268, std::int64_t(1)).field(279, "1").field(269, "0").field(55, "EUR/USD").field(270, "100").field(271, "5");
+        venue.deliver(session);
+        CHECK(session.next_inbound() == 6);
+        CHECK(book.condition.state == trading::feed_state::stale);
+        CHECK(level(book.bids, 100) == 1);
+        out = sent(session);
+        REQUIRE(out.size() == 1);
+        CHECK(out[0][35] == "V");
+        CHECK(out[0][263] == "0");
+
+        venue.start("W", 6).field(55, "EUR/USD").field(268, std::int64_t(1)).field(269, "0").field(270, "100").field(271, "6");
+        venue.deliver(session);
+        CHECK(book.condition.state == trading::feed_state::good);
+        CHECK(level(book.bids, 100) == 6);
+        CHECK(session.next_inbound() == 7);
+
+        // a GapFill numbered beyond the next expected leaves a gap of its own
+        venue.start("4", 9).field(123, "Y").field(36, std::int64_t(10));
+        venue.deliver(session);
+        CHECK(session.next_inbound() == 7);
+        CHECK(book.condition.state == trading::feed_state::stale);
+        out = sent(session);
+        REQUIRE(out.size() == 1);
+        CHECK(out[0][35] == "2");
+        CHECK(out[0][7] == "7");
+
+        // a Reset skipping ahead closes the gap, and a snapshot is requested
+        venue.start("4", 1).field(36, std::int64_t(20));
+        venue.deliver(session);
+        CHECK(session.next_inbound() == 20);
+        out = sent(session);
+        REQUIRE(out.size() == 1);
+        CHECK(out[0][35] == "V");
+
+        // so does one outside a resend, which loses whatever it skips
+        venue.start("W", 20).field(55, "EUR/USD").field(268, std::int64_t(0));
+        venue.deliver(session);
+        CHECK(book.condition.state == trading::feed_state::good);
+        venue.start("4", 1).field(36, std::int64_t(30));
+        venue.deliver(session);
+        CHECK(book.condition.state == trading::feed_state::stale);
+        out = sent(session);
+        REQUIRE(out.size() == 1);
+        CHECK(out[0][35] == "V");
+
+        // a rejected snapshot request is an error in its book
+        venue.start("Y", 30).field(262, "SNAP:EUR/USD").field(58, "no");
+        venue.deliver(session);
+        CHECK(book.condition.state == trading::feed_state::error);
+    }
+
+    SUBCASE("heartbeats and test requests")
+    {
+        auto session = make_session();
+        auto venue   = counterparty();
+        auto t0      = venue.now;
+        session.connect(t0);
+        CHECK(session.poll(t0 + 29s));
+        CHECK_FALSE(session.poll(t0 + 30s));
+
+        session.connect(t0);
+        venue.logon(session);
+        sent(session);
+
+        venue.start("1").field(112, "ping");
+        venue.deliver(session);
+        auto out = sent(session);
+        REQUIRE(out.size() == 1);
+        CHECK(out[0][35] == "0");
+        CHECK(out[0][112] == "ping");
+
+        // quiet for the interval: a heartbeat
+        CHECK(session.poll(t0 + 30s));
+        out = sent(session);
+        REQUIRE(out.size() == 1);
+        CHECK(out[0][35] == "0");
+
+        // the venue quiet for a little longer: a test request, then a timeout
+        CHECK(session.poll(t0 + 36s));
+        out = sent(session);
+        REQUIRE(out.size() == 1);
+        CHECK(out[0][35] == "1");
+        CHECK(session.poll(t0 + 59s));
+        CHECK_FALSE(session.poll(t0 + 60s));
+
+        // unless it answers
+        venue.now = t0 + 40s;
+        venue.start("0").field(112, out[0][112]);
+        venue.deliver(session);
+        CHECK(session.poll(t0 + 60s));
+    }
+
+    SUBCASE("faults break the session")
+    {
+        auto session = make_session();
+        auto venue   = counterparty();
+        session.connect(venue.now);
+
+        venue.start("W").field(55, "EUR/USD").field(268, std::int64_t(0));
+        auto msg = std::string(venue.builder.finish());
+        CHECK_THROWS_AS(session.receive(msg, venue.now), std::runtime_error);
+
+        session.connect(venue.now);
+        msg[msg.size() - 2] ^= 1;
+        CHECK_THROWS_AS(session.receive(msg, venue.now), std::runtime_error);
+    }
+}
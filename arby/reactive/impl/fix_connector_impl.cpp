@@ -9,10 +9,25 @@
 
 #include "fix_connector_impl.hpp"
 
+#include "asioex/scoped_interrupt.hpp"
+#include "network/backoff.hpp"
+#include "network/connect_ssl.hpp"
+
+#include <fmt/chrono.h>
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
 namespace arby
 {
 namespace reactive
 {
+using namespace std::literals;
+
 std::string_view
 fix_connector_impl::classname() const
 {
@@ -22,22 +37,229 @@ fix_connector_impl::classname() const
 void
 fix_connector_impl::extend_summary(std::string &buffer) const
 {
+    fmt::format_to(std::back_inserter(buffer),
+                   "{}:{} {} {} -> {} : {} : in {} out {} : {} books",
+                   args_.socket_connect_host,
+                   args_.socket_connect_port,
+                   args_.use_ssl ? "tls" : "tcp",
+                   args_.sender_comp_id,
+                   args_.target_comp_id,
+                   wise_enum::to_string(connstate_),
+                   session_.next_inbound(),
+                   session_.next_outbound(),
+                   feeds_.size());
 }
 
 void
 fix_connector_impl::handle_start()
 {
-
+    auto self = std::static_pointer_cast< fix_connector_impl >(shared_from_this());
+    asio::co_spawn(get_executor(), run(self), asio::bind_cancellation_slot(stop_.slot(), asio::detached));
 }
+
 void
 fix_connector_impl::handle_stop()
 {
+    stopped_ = true;
+    asioex::terminate(stop_);
 }
+
 fix_connector_impl::fix_connector_impl(asio::any_io_executor exec, ssl::context &sslctx, fix_connector_args args)
     : entity::entity_base(exec)
     , sslctx_(sslctx)
     , args_(std::move(args))
+    , session_({ .sender_comp_id = args_.sender_comp_id, .target_comp_id = args_.target_comp_id })
+{
+}
+
+std::shared_ptr< trading::aggregate_book_feed_iface >
+fix_connector_impl::market_data(std::string const &symbol, trading::market_key const &market)
+{
+    assert(asioex::on_correct_thread(get_executor()));
+
+    auto &feed = feeds_[symbol];
+    if (!feed)
+    {
+        feed = std::make_shared< fix_book_feed >(
+            get_executor(), fmt::format("{}[{}:{}]", classname(), args_.target_comp_id, symbol), market);
+        feed->publish(session_.subscribe(symbol));
+        wake_writer();
+    }
+    return feed;
+}
+
+asio::awaitable< void >
+fix_connector_impl::run(std::shared_ptr< fix_connector_impl > self)
+{
+    using asio::use_awaitable;
+
+    auto delay = network::backoff();
+    while (!stopped_)
+    {
+        try
+        {
+            co_await run_connection();
+        }
+        catch (std::exception &e)
+        {
+            if (!stopped_)
+                spdlog::error("{}::{} : {}", classname(), __func__, e.what());
+        }
+        session_.disconnect("connection down");
+        update_connection_state();
+        publish_changes();
+        if (stopped_)
+            break;
+
+        // as for the power trade connector, a session which stayed up for a while reconnects quickly
+        if (up_since_ && clock::now() - *up_since_ > 1s)
+            delay.reset();
+        up_since_.reset();
+
+        auto wait = delay.next();
+        spdlog::info("{}::{} : reconnect attempt {} in {}", classname(), __func__, delay.attempts(), wait);
+        auto t = asio::steady_timer(get_executor(), wait);
+        co_await t.async_wait(use_awaitable);
+    }
+}
+
+asio::awaitable< void >
+fix_connector_impl::run_connection()
+{
+    spdlog::info("{}::{} : connecting to {}:{}", classname(), __func__, args_.socket_connect_host, args_.socket_connect_port);
+    if (args_.use_ssl)
+    {
+        auto stream = ssl::stream< tcp::socket >(get_executor(), sslctx_);
+        co_await network::connect(stream, args_.socket_connect_host, args_.socket_connect_port);
+        co_await run_session(stream);
+    }
+    else
+    {
+        auto sock = tcp::socket(get_executor());
+        co_await network::connect(sock, args_.socket_connect_host, args_.socket_connect_port);
+        co_await run_session(sock);
+    }
+}
+
+template < class Stream >
+asio::awaitable< void >
+fix_connector_impl::run_session(Stream &stream)
+{
+    using namespace asio::experimental::awaitable_operators;
+
+    stream.lowest_layer().set_option(tcp::no_delay(true));
+    session_.connect(clock::now());
+    update_connection_state();
+
+    // whichever finishes first, by error or logout, ends the session
+    co_await (read_loop(stream) || write_loop(stream) || heartbeat_loop());
+}
+
+template < class Stream >
+asio::awaitable< void >
+fix_connector_impl::read_loop(Stream &stream)
+{
+    using asio::use_awaitable;
+
+    // the bytes received but not yet parsed
+    auto begin = std::size_t(0);
+    auto end   = std::size_t(0);
+    for (;;)
+    {
+        if (end == rxbuf_.size())
+        {
+            if (begin > 0)
+            {
+                std::memmove(rxbuf_.data(), rxbuf_.data() + begin, end - begin);
+                end -= begin;
+                begin = 0;
+            }
+            else if (rxbuf_.size() < max_message_size)
+                rxbuf_.resize(rxbuf_.size() * 2);
+            else
+                throw std::runtime_error("message too large");
+        }
+
+        end += co_await stream.async_read_some(asio::buffer(rxbuf_.data() + end, rxbuf_.size() - end), use_awaitable);
+        begin += session_.receive(std::string_view(rxbuf_.data() + begin, end - begin), clock::now());
+        if (begin == end)
+            begin = end = 0;
+
+        update_connection_state();
+        publish_changes();
+        wake_writer();
+        if (session_.state() == connection_down)
+            co_return;
+    }
+}
+
+template < class Stream >
+asio::awaitable< void >
+fix_connector_impl::write_loop(Stream &stream)
+{
+    using asio::redirect_error;
+    using asio::use_awaitable;
+
+    for (;;)
+    {
+        while (session_.outbound().empty())
+        {
+            error_code ec;
+            send_cv_.expires_at(asio::steady_timer::time_point::max());
+            co_await send_cv_.async_wait(redirect_error(use_awaitable, ec));
+            if ((co_await asio::this_coro::cancellation_state).cancelled() != asio::cancellation_type::none)
+                co_return;
+        }
+
+        // the buffers are exchanged so that the session may queue more while this is written
+        txbuf_.clear();
+        txbuf_.swap(session_.outbound());
+        co_await asio::async_write(stream, asio::buffer(txbuf_), use_awaitable);
+    }
+}
+
+asio::awaitable< void >
+fix_connector_impl::heartbeat_loop()
+{
+    using asio::use_awaitable;
+
+    auto timer = asio::steady_timer(get_executor());
+    for (;;)
+    {
+        timer.expires_after(1s);
+        co_await timer.async_wait(use_awaitable);
+        if (!session_.poll(clock::now()))
+            throw std::runtime_error(session_.state() == connection_unauthenticated ? "logon timed out" : "heartbeat timed out");
+        wake_writer();
+    }
+}
+
+void
+fix_connector_impl::update_connection_state()
+{
+    auto state = session_.state();
+    if (state == connstate_)
+        return;
+    spdlog::info("{}::{} : {} -> {}", classname(), __func__, wise_enum::to_string(connstate_), wise_enum::to_string(state));
+    connstate_ = state;
+    if (state == connection_up)
+        up_since_ = clock::now();
+}
+
+void
+fix_connector_impl::publish_changes()
+{
+    for (auto book : session_.changed())
+        if (auto i = feeds_.find(book->symbol); i != feeds_.end())
+            i->second->publish(*book);
+    session_.clear_changed();
+}
+
+void
+fix_connector_impl::wake_writer()
 {
+    if (!session_.outbound().empty())
+        send_cv_.cancel();
 }
 
 entity::entity_key
@@ -58,4 +280,4 @@ merge(entity::entity_key &target, const fix_connector_args &args)
     target.merge(entity::entity_key(args.to_key()));
 }
 }   // namespace reactive
-}   // namespace arby
\ No newline at end of file
+}   // namespace arby
@@ -14,8 +14,16 @@
 #include "connection_state.hpp"
 #include "entity/entity_base.hpp"
 #include "entity/entity_key.hpp"
-
+#include "reactive/fix_book_feed.hpp"
+#include "reactive/fix_session.hpp"
+#include "trading/market_key.hpp"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
 #include <string>
+#include <vector>
 
 namespace arby
 {
@@ -37,33 +45,94 @@ struct fix_connector_args
 void
 merge(entity::entity_key &target, fix_connector_args const &args);
 
+/// @brief A FIX 4.4 market data session with a venue, such as Reactive Markets, which maintains the books of the symbols
+/// requested of it.
+///
+/// The connection is made over TCP, with TLS if args.use_ssl, and remade with backoff whenever it drops. Each book is
+/// marked stale while the connection is down, and rebuilt from the full refresh which follows each logon.
+///
+/// The protocol itself is in fix_session. This class reads into a buffer which fix_session parses in place, writes
+/// what it queues, and polls it for heartbeats once a second.
 struct fix_connector_impl : entity::entity_base
 {
+    using clock = fix_session::clock;
+
+    /// the largest message which may be received
+    static constexpr std::size_t max_message_size = 1 << 20;
+
     fix_connector_impl(asio::any_io_executor exec, ssl::context &sslctx, fix_connector_args args);
 
     std::string_view
     classname() const override;
 
+    /// @brief The book of a symbol, which is requested of the venue if it has not been already.
+    /// @param symbol is the venue's name for the instrument
+    /// @param market is the market which the book is published as
+    /// @note must be called on the connector's executor
+    std::shared_ptr< trading::aggregate_book_feed_iface >
+    market_data(std::string const &symbol, trading::market_key const &market);
+
   private:
     void
     extend_summary(std::string &buffer) const override;
 
-    static asio::awaitable< void >
-    run(std::shared_ptr< fix_connector_impl > self)
-    {
-        co_await asioex::spin();
-    }
     void
     handle_start() override;
+
     void
     handle_stop() override;
 
+    asio::awaitable< void >
+    run(std::shared_ptr< fix_connector_impl > self);
+
+    asio::awaitable< void >
+    run_connection();
+
+    template < class Stream >
+    asio::awaitable< void >
+    run_session(Stream &stream);
+
+    template < class Stream >
+    asio::awaitable< void >
+    read_loop(Stream &stream);
+
+    template < class Stream >
+    asio::awaitable< void >
+    write_loop(Stream &stream);
+
+    asio::awaitable< void >
+    heartbeat_loop();
+
+    /// @brief Note a change of the session state.
+    void
+    update_connection_state();
+
+    /// @brief Publish each book which the session has changed.
+    void
+    publish_changes();
+
+    /// @brief Wake the writer if the session has queued anything.
+    void
+    wake_writer();
+
   public:
     ssl::context &sslctx_;
 
     fix_connector_args args_;
 
     connection_state connstate_ = connection_down;
+
+  private:
+    fix_session                                                            session_;
+    std::map< std::string, std::shared_ptr< fix_book_feed >, std::less<> > feeds_;
+
+    std::vector< char > rxbuf_ = std::vector< char >(65536);
+    std::string         txbuf_;
+
+    std::optional< clock::time_point > up_since_;
+    asio::steady_timer                 send_cv_ { get_executor() };
+    asio::cancellation_signal          stop_;
+    bool                               stopped_ = false;
 };
 
 }   // namespace reactive
@@ -11,6 +11,7 @@
 #define ARBY_ARBY_SSL_CONTEXT_HPP
 
 #include "config/asio.hpp"
+#include "network/tls_session_cache.hpp"
 
 namespace arby
 {
@@ -26,6 +27,13 @@ struct ssl_context
 
     ssl::context& to_context() const { return *impl_; }
 
+    /// TLS sessions issued to clients using this context, by host:port
+    network::tls_session_cache &
+    session_cache() const
+    {
+        return network::tls_session_cache::of(*impl_);
+    }
+
   private:
     ssl::context *impl_;
 };
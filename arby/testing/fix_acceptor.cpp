@@ -0,0 +1,254 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "testing/fix_acceptor.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace arby
+{
+namespace testing
+{
+std::shared_ptr< fix_acceptor >
+fix_acceptor::create(asio::any_io_executor exec, std::string comp_id)
+{
+    auto impl = std::make_shared< fix_acceptor >(std::move(exec), std::move(comp_id));
+    impl->start();
+    return impl;
+}
+
+fix_acceptor::fix_acceptor(asio::any_io_executor exec, std::string comp_id)
+: comp_id_(std::move(comp_id))
+, acceptor_(exec, tcp::endpoint(ip::make_address("127.0.0.1"), 0))
+, send_cv_(exec)
+{
+}
+
+void
+fix_acceptor::start()
+{
+    asio::co_spawn(acceptor_.get_executor(), accept_loop(shared_from_this()), asio::detached);
+}
+
+void
+fix_acceptor::stop()
+{
+    stopped_ = true;
+    error_code ec;
+    acceptor_.close(ec);
+    drop();
+}
+
+std::string
+fix_acceptor::port() const
+{
+    return std::to_string(acceptor_.local_endpoint().port());
+}
+
+void
+fix_acceptor::update(std::string const &symbol, trading::side_type side, std::string const &price, std::string const &qty)
+{
+    auto &b      = books_[symbol];
+    auto &levels = side == trading::buy ? b.bids : b.offers;
+    auto  action = std::string_view();
+    if (qty == "0")
+    {
+        if (!levels.erase(price))
+            return;
+        action = "2";
+    }
+    else
+    {
+        auto [i, inserted] = levels.insert_or_assign(price, qty);
+        action             = inserted ? "0" : "1";
+    }
+
+    if (socket_ && requested_.contains(symbol))
+        pending_.push_back({ .action = std::string(action), .symbol = symbol, .side = side, .price = price, .qty = qty });
+}
+
+void
+fix_acceptor::flush()
+{
+    if (pending_.empty())
+        return;
+
+    auto &msg = begin("X").field(268, std::int64_t(pending_.size()));
+    for (auto &e : pending_)
+    {
+        msg.field(279, e.action).field(269, e.side == trading::buy ? "0" : "1").field(55, e.symbol).field(270, e.price);
+        if (e.action != "2")
+            msg.field(271, e.qty);
+    }
+    pending_.clear();
+    send();
+}
+
+void
+fix_acceptor::drop()
+{
+    if (socket_)
+    {
+        error_code ec;
+        socket_->close(ec);
+    }
+}
+
+asio::awaitable< void >
+fix_acceptor::accept_loop(std::shared_ptr< fix_acceptor > self)
+{
+    using namespace asio::experimental::awaitable_operators;
+    using asio::use_awaitable;
+
+    while (!stopped_)
+    {
+        try
+        {
+            socket_.emplace(co_await acceptor_.async_accept(use_awaitable));
+            socket_->set_option(tcp::no_delay(true));
+        }
+        catch (std::exception &)
+        {
+            break;
+        }
+
+        requested_.clear();
+        pending_.clear();
+        outbound_.clear();
+        try
+        {
+            co_await (read_loop() || write_loop());
+        }
+        catch (std::exception &e)
+        {
+            spdlog::debug("fix_acceptor::{} : session ended : {}", __func__, e.what());
+        }
+        socket_.reset();
+    }
+}
+
+asio::awaitable< void >
+fix_acceptor::read_loop()
+{
+    using asio::use_awaitable;
+
+    auto buffer = std::vector< char >(65536);
+    auto fields = std::vector< reactive::fix_field >();
+    auto end    = std::size_t(0);
+    for (;;)
+    {
+        if (end == buffer.size())
+            throw std::runtime_error("message too large");
+        end += co_await socket_->async_read_some(asio::buffer(buffer.data() + end, buffer.size() - end), use_awaitable);
+
+        auto begin = std::size_t(0);
+        for (;;)
+        {
+            auto r = reactive::parse_fix_message(std::string_view(buffer.data() + begin, end - begin), fields);
+            if (r.status == reactive::fix_parse_status::incomplete)
+                break;
+            if (r.status == reactive::fix_parse_status::malformed)
+                throw std::runtime_error(r.error);
+            ++messages_received_;
+            handle(fields);
+            begin += r.size;
+        }
+        std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+        end -= begin;
+    }
+}
+
+asio::awaitable< void >
+fix_acceptor::write_loop()
+{
+    using asio::redirect_error;
+    using asio::use_awaitable;
+
+    for (;;)
+    {
+        while (outbound_.empty())
+        {
+            error_code ec;
+            send_cv_.expires_at(asio::steady_timer::time_point::max());
+            co_await send_cv_.async_wait(redirect_error(use_awaitable, ec));
+            if ((co_await asio::this_coro::cancellation_state).cancelled() != asio::cancellation_type::none)
+                co_return;
+        }
+        txbuf_.clear();
+        txbuf_.swap(outbound_);
+        co_await asio::async_write(*socket_, asio::buffer(txbuf_), use_awaitable);
+    }
+}
+
+void
+fix_acceptor::handle(std::span< reactive::fix_field const > fields)
+{
+    auto type = fields.front().value;
+    if (type == "A")
+    {
+        // the initiator resets the sequence numbers
+        peer_comp_id_  = std::string(reactive::find_field(fields, 49));
+        next_outbound_ = 1;
+        ++logons_;
+        begin("A").field(98, "0").field(108, reactive::find_field(fields, 108));
+        send();
+    }
+    else if (type == "1")
+    {
+        begin("0").field(112, reactive::find_field(fields, 112));
+        send();
+    }
+    else if (type == "V")
+    {
+        auto symbol = std::string(reactive::find_field(fields, 55));
+        requested_.insert(symbol);
+        send_full_refresh(symbol);
+    }
+    else if (type == "5")
+    {
+        begin("5");
+        send();
+    }
+}
+
+void
+fix_acceptor::send_full_refresh(std::string const &symbol)
+{
+    auto &b   = books_[symbol];
+    auto &msg = begin("W").field(55, symbol).field(268, std::int64_t(b.bids.size() + b.offers.size()));
+    for (auto &[price, qty] : b.bids)
+        msg.field(269, "0").field(270, price).field(271, qty);
+    for (auto &[price, qty] : b.offers)
+        msg.field(269, "1").field(270, price).field(271, qty);
+    send();
+}
+
+reactive::fix_message_builder &
+fix_acceptor::begin(std::string_view msg_type)
+{
+    // a constant SendingTime will do for a stand-in
+    return builder_.start(msg_type)
+        .field(49, comp_id_)
+        .field(56, peer_comp_id_)
+        .field(34, next_outbound_++)
+        .field(52, "20220518-09:30:00.000");
+}
+
+void
+fix_acceptor::send()
+{
+    outbound_ += builder_.finish();
+    send_cv_.cancel();
+}
+
+}   // namespace testing
+}   // namespace arby
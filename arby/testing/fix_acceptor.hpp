@@ -0,0 +1,143 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_ARBY_TESTING_FIX_ACCEPTOR_HPP
+#define ARBY_ARBY_TESTING_FIX_ACCEPTOR_HPP
+
+#include "config/asio.hpp"
+#include "reactive/fix_parser.hpp"
+#include "trading/types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace arby
+{
+namespace testing
+{
+
+/// @brief A stand-in for a FIX 4.4 market data venue, on the loopback interface, for testing and benchmarking the
+/// reactive::fix_connector.
+///
+/// One session is served at a time. Logon, TestRequest and Logout are answered, and each MarketDataRequest is
+/// answered with a full refresh of the book held for its symbol. Changes made by update() are queued as entries of an
+/// incremental refresh, which flush() sends to the session if it has requested the symbol.
+/// @note not thread-safe. Must be used on its executor.
+struct fix_acceptor : std::enable_shared_from_this< fix_acceptor >
+{
+    static std::shared_ptr< fix_acceptor >
+    create(asio::any_io_executor exec, std::string comp_id = "VENUE");
+
+    fix_acceptor(asio::any_io_executor exec, std::string comp_id);
+
+    void
+    start();
+
+    void
+    stop();
+
+    /// @brief The port on which the acceptor listens.
+    std::string
+    port() const;
+
+    /// @brief Set a level of the book of symbol. A quantity of "0" removes the level.
+    void
+    update(std::string const &symbol, trading::side_type side, std::string const &price, std::string const &qty);
+
+    /// @brief Send the updates made since the last flush as one incremental refresh.
+    void
+    flush();
+
+    /// @brief Close the connection of the current session.
+    void
+    drop();
+
+    /// @brief The number of sessions which have logged on.
+    std::size_t
+    logons() const
+    {
+        return logons_;
+    }
+
+    /// @brief The number of messages received in all sessions.
+    std::size_t
+    messages_received() const
+    {
+        return messages_received_;
+    }
+
+  private:
+    struct book
+    {
+        std::map< std::string, std::string > bids;
+        std::map< std::string, std::string > offers;
+    };
+
+    struct entry
+    {
+        std::string        action;
+        std::string        symbol;
+        trading::side_type side;
+        std::string        price;
+        std::string        qty;
+    };
+
+    asio::awaitable< void >
+    accept_loop(std::shared_ptr< fix_acceptor > self);
+
+    asio::awaitable< void >
+    read_loop();
+
+    asio::awaitable< void >
+    write_loop();
+
+    void
+    handle(std::span< reactive::fix_field const > fields);
+
+    void
+    send_full_refresh(std::string const &symbol);
+
+    reactive::fix_message_builder &
+    begin(std::string_view msg_type);
+
+    void
+    send();
+
+    std::string const comp_id_;
+    std::string       peer_comp_id_;
+
+    tcp::acceptor                acceptor_;
+    std::optional< tcp::socket > socket_;
+    asio::steady_timer           send_cv_;
+    bool                         stopped_ = false;
+
+    std::map< std::string, book > books_;
+    std::set< std::string >       requested_;
+    std::vector< entry >          pending_;
+
+    std::int64_t                  next_outbound_ = 1;
+    reactive::fix_message_builder builder_;
+    std::string                   outbound_;
+    std::string                   txbuf_;
+
+    std::size_t logons_            = 0;
+    std::size_t messages_received_ = 0;
+};
+
+}   // namespace testing
+}   // namespace arby
+
+#endif   // ARBY_ARBY_TESTING_FIX_ACCEPTOR_HPP
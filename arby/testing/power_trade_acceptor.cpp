@@ -0,0 +1,284 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "testing/power_trade_acceptor.hpp"
+
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+#include <spdlog/spdlog.h>
+
+#include <stdexcept>
+
+namespace arby
+{
+namespace testing
+{
+namespace
+{
+/// A throwaway certificate for CN=localhost. The connector does not verify its peer.
+void
+use_self_signed_certificate(ssl::context &ctx)
+{
+    auto fail = [](char const *what) { throw std::runtime_error(fmt::format("power_trade_acceptor: {} failed", what)); };
+
+    EVP_PKEY *pkey = nullptr;
+    auto     *kctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+    auto      ok   = kctx && EVP_PKEY_keygen_init(kctx) == 1 &&
+              EVP_PKEY_CTX_set_ec_paramgen_curve_nid(kctx, NID_X9_62_prime256v1) == 1 && EVP_PKEY_keygen(kctx, &pkey) == 1;
+    EVP_PKEY_CTX_free(kctx);
+    if (!ok)
+        fail("key generation");
+
+    auto *cert = X509_new();
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+    X509_set_pubkey(cert, pkey);
+    auto *name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast< unsigned char const * >("localhost"), -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+    ok = X509_sign(cert, pkey, EVP_sha256()) > 0 && SSL_CTX_use_certificate(ctx.native_handle(), cert) == 1 &&
+         SSL_CTX_use_PrivateKey(ctx.native_handle(), pkey) == 1;
+    X509_free(cert);
+    EVP_PKEY_free(pkey);
+    if (!ok)
+        fail("certificate");
+}
+}   // namespace
+
+std::shared_ptr< power_trade_acceptor >
+power_trade_acceptor::create(asio::any_io_executor exec)
+{
+    auto impl = std::make_shared< power_trade_acceptor >(std::move(exec));
+    impl->start();
+    return impl;
+}
+
+power_trade_acceptor::power_trade_acceptor(asio::any_io_executor exec)
+: ssl_ctx_(ssl::context::tls_server)
+, acceptor_(exec, tcp::endpoint(ip::make_address("127.0.0.1"), 0))
+, send_cv_(exec)
+{
+    use_self_signed_certificate(ssl_ctx_);
+}
+
+void
+power_trade_acceptor::start()
+{
+    asio::co_spawn(acceptor_.get_executor(), accept_loop(shared_from_this()), asio::detached);
+}
+
+void
+power_trade_acceptor::stop()
+{
+    stopped_ = true;
+    error_code ec;
+    acceptor_.close(ec);
+    drop();
+}
+
+power_trade::connector::endpoint
+power_trade_acceptor::endpoint() const
+{
+    return power_trade::connector::endpoint { .host = "127.0.0.1",
+                                              .port = std::to_string(acceptor_.local_endpoint().port()),
+                                              .path = "/" };
+}
+
+void
+power_trade_acceptor::add(std::string const &symbol,
+                          std::string const &order_id,
+                          trading::side_type side,
+                          std::string const &price,
+                          std::string const &qty)
+{
+    auto &o = books_[symbol][order_id];
+    o       = order { .side = side, .price = price, .qty = qty, .timestamp = next_timestamp() };
+    if (ws_ && subscribed_.contains(symbol))
+        send(json::value({ { "order_added",
+                             { { "market_id", "0" },
+                               { "symbol", symbol },
+                               { "order_id", order_id },
+                               { "side", wise_enum::to_string(side) },
+                               { "price", price },
+                               { "quantity", qty },
+                               { "utc_timestamp", o.timestamp } } } }));
+}
+
+void
+power_trade_acceptor::remove(std::string const &symbol, std::string const &order_id)
+{
+    auto &b = books_[symbol];
+    auto  i = b.find(order_id);
+    if (i == b.end())
+        return;
+    auto side = i->second.side;
+    b.erase(i);
+    if (ws_ && subscribed_.contains(symbol))
+        send(json::value({ { "order_deleted",
+                             { { "market_id", "0" },
+                               { "symbol", symbol },
+                               { "order_id", order_id },
+                               { "side", wise_enum::to_string(side) },
+                               { "utc_timestamp", next_timestamp() } } } }));
+}
+
+void
+power_trade_acceptor::drop()
+{
+    if (ws_)
+    {
+        error_code ec;
+        beast::get_lowest_layer(*ws_).close(ec);
+    }
+}
+
+asio::awaitable< void >
+power_trade_acceptor::accept_loop(std::shared_ptr< power_trade_acceptor > self)
+{
+    using namespace asio::experimental::awaitable_operators;
+    using asio::use_awaitable;
+
+    while (!stopped_)
+    {
+        auto sock = tcp::socket(acceptor_.get_executor());
+        try
+        {
+            sock = co_await acceptor_.async_accept(use_awaitable);
+        }
+        catch (std::exception &)
+        {
+            break;
+        }
+
+        ++connections_;
+        if (refuse_)
+        {
+            --refuse_;
+            continue;
+        }
+
+        subscribed_.clear();
+        outbound_.clear();
+        try
+        {
+            sock.set_option(tcp::no_delay(true));
+            ws_.emplace(std::move(sock), ssl_ctx_);
+            co_await ws_->next_layer().async_handshake(ssl::stream_base::server, use_awaitable);
+            co_await ws_->async_accept(use_awaitable);
+            ws_->text(true);
+            co_await (read_loop() || write_loop());
+        }
+        catch (std::exception &e)
+        {
+            spdlog::debug("power_trade_acceptor::{} : connection ended : {}", __func__, e.what());
+        }
+        ws_.reset();
+    }
+}
+
+asio::awaitable< void >
+power_trade_acceptor::read_loop()
+{
+    using asio::use_awaitable;
+
+    auto buffer = beast::flat_buffer();
+    for (;;)
+    {
+        buffer.clear();
+        co_await ws_->async_read(buffer, use_awaitable);
+        auto message = json::parse(beast::buffers_to_string(buffer.data()));
+        if (auto *o = message.if_object())
+            handle(*o);
+    }
+}
+
+asio::awaitable< void >
+power_trade_acceptor::write_loop()
+{
+    using asio::redirect_error;
+    using asio::use_awaitable;
+
+    for (;;)
+    {
+        while (outbound_.empty())
+        {
+            error_code ec;
+            send_cv_.expires_at(asio::steady_timer::time_point::max());
+            co_await send_cv_.async_wait(redirect_error(use_awaitable, ec));
+            if ((co_await asio::this_coro::cancellation_state).cancelled() != asio::cancellation_type::none)
+                co_return;
+        }
+        auto frame = std::move(outbound_.front());
+        outbound_.pop_front();
+        co_await ws_->async_write(asio::buffer(frame), use_awaitable);
+    }
+}
+
+void
+power_trade_acceptor::handle(json::object const &message)
+{
+    auto reply = [&](json::object const &request)
+    {
+        send(json::value(
+            { { "command_response", { { "user_tag", request.at("user_tag") }, { "error_code", "0" }, { "error_text", "" } } } }));
+    };
+
+    if (auto *sub = message.if_contains("subscribe"))
+    {
+        auto &request = sub->as_object();
+        auto  symbol  = json::value_to< std::string >(request.at("symbol"));
+        ++subscriptions_;
+        subscribed_.insert(symbol);
+        reply(request);
+        send_snapshot(symbol);
+    }
+    else if (auto *unsub = message.if_contains("unsubscribe"))
+    {
+        auto &request = unsub->as_object();
+        subscribed_.erase(json::value_to< std::string >(request.at("symbol")));
+        reply(request);
+    }
+}
+
+void
+power_trade_acceptor::send_snapshot(std::string const &symbol)
+{
+    auto buy  = json::array();
+    auto sell = json::array();
+    for (auto &[id, o] : books_[symbol])
+        (o.side == trading::buy ? buy : sell)
+            .push_back(json::object(
+                { { "orderid", id }, { "price", o.price }, { "quantity", o.qty }, { "utc_timestamp", o.timestamp } }));
+
+    send(json::value({ { "snapshot",
+                         { { "server_utc_timestamp", next_timestamp() },
+                           { "market_id", "0" },
+                           { "symbol", symbol },
+                           { "buy", std::move(buy) },
+                           { "sell", std::move(sell) } } } }));
+}
+
+void
+power_trade_acceptor::send(json::value const &message)
+{
+    outbound_.push_back(json::serialize(message));
+    send_cv_.cancel();
+}
+
+std::string
+power_trade_acceptor::next_timestamp()
+{
+    return std::to_string(++clock_);
+}
+
+}   // namespace testing
+}   // namespace arby
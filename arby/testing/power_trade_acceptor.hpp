@@ -0,0 +1,149 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_ARBY_TESTING_POWER_TRADE_ACCEPTOR_HPP
+#define ARBY_ARBY_TESTING_POWER_TRADE_ACCEPTOR_HPP
+
+#include "config/json.hpp"
+#include "config/websocket.hpp"
+#include "power_trade/connector.hpp"
+#include "trading/types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+
+namespace arby
+{
+namespace testing
+{
+
+/// @brief A stand-in for the Power Trade websocket venue, over TLS on the loopback interface, for testing the
+/// power_trade::connector and the order book listeners built on it.
+///
+/// One connection is served at a time. Each subscribe request is answered with a command_response and a snapshot of
+/// the book held for its symbol. add() and remove() change a book, and send the change as an order event if the
+/// connection has subscribed to the symbol. refuse() closes the next connections as soon as they are accepted, as a
+/// venue which is down would.
+/// @note not thread-safe. Must be used on its executor.
+struct power_trade_acceptor : std::enable_shared_from_this< power_trade_acceptor >
+{
+    static std::shared_ptr< power_trade_acceptor >
+    create(asio::any_io_executor exec);
+
+    explicit power_trade_acceptor(asio::any_io_executor exec);
+
+    void
+    start();
+
+    void
+    stop();
+
+    /// @brief The endpoint at which a connector reaches the acceptor.
+    power_trade::connector::endpoint
+    endpoint() const;
+
+    /// @brief Add an order to the book of a native symbol such as "BTC-USD".
+    void
+    add(std::string const &symbol,
+        std::string const &order_id,
+        trading::side_type side,
+        std::string const &price,
+        std::string const &qty);
+
+    /// @brief Remove an order from the book of a native symbol.
+    void
+    remove(std::string const &symbol, std::string const &order_id);
+
+    /// @brief Close the current connection.
+    void
+    drop();
+
+    /// @brief Close the next n connections as soon as they are accepted.
+    void
+    refuse(std::size_t n)
+    {
+        refuse_ = n;
+    }
+
+    /// @brief The number of connections accepted, including those refused.
+    std::size_t
+    connections() const
+    {
+        return connections_;
+    }
+
+    /// @brief The number of subscribe requests received in all connections.
+    std::size_t
+    subscriptions() const
+    {
+        return subscriptions_;
+    }
+
+  private:
+    using ws_stream = websocket::stream< ssl::stream< tcp::socket > >;
+
+    struct order
+    {
+        trading::side_type side;
+        std::string        price;
+        std::string        qty;
+        std::string        timestamp;
+    };
+
+    // orders by id
+    using book = std::map< std::string, order >;
+
+    asio::awaitable< void >
+    accept_loop(std::shared_ptr< power_trade_acceptor > self);
+
+    asio::awaitable< void >
+    read_loop();
+
+    asio::awaitable< void >
+    write_loop();
+
+    void
+    handle(json::object const &message);
+
+    void
+    send_snapshot(std::string const &symbol);
+
+    void
+    send(json::value const &message);
+
+    /// Each event is stamped a nanosecond after the last.
+    std::string
+    next_timestamp();
+
+    ssl::context               ssl_ctx_;
+    tcp::acceptor              acceptor_;
+    std::optional< ws_stream > ws_;
+    asio::steady_timer         send_cv_;
+    bool                       stopped_ = false;
+
+    std::map< std::string, book > books_;
+    std::set< std::string >       subscribed_;
+    std::deque< std::string >     outbound_;
+    std::int64_t                  clock_ = 1'000'000'000;
+
+    std::size_t refuse_        = 0;
+    std::size_t connections_   = 0;
+    std::size_t subscriptions_ = 0;
+};
+
+}   // namespace testing
+}   // namespace arby
+
+#endif   // ARBY_ARBY_TESTING_POWER_TRADE_ACCEPTOR_HPP
@@ -10,9 +10,10 @@
 #ifndef ARBY_ARBY_TRADING_AGGREGATE_BOOK_FEED_HPP
 #define ARBY_ARBY_TRADING_AGGREGATE_BOOK_FEED_HPP
 
-#include "config/signals.hpp"
 #include "trading/aggregate_book_snapshot.hpp"
 #include "util/cross_executor_connection.hpp"
+#include "util/free_list.hpp"
+#include "util/signal.hpp"
 
 #include <vector>
 
@@ -23,8 +24,7 @@ namespace trading
 
 class aggregate_book_feed_iface
 {
-    using snapshot_signal = typename sigs::signal_type< void(std::shared_ptr< aggregate_book_snapshot const >),
-                                                        sigs::keywords::mutex_type< sigs::dummy_mutex > >::type;
+    using snapshot_signal = util::signal< void(std::shared_ptr< aggregate_book_snapshot const >) >;
 
   public:
     using snapshot_slot = snapshot_signal::slot_type;
@@ -94,18 +94,12 @@ struct implement_aggregate_book_feed : aggregate_book_feed_iface
     std::shared_ptr< aggregate_book_snapshot >
     new_aggregate_book_snapshot()
     {
-        auto derived = static_cast< Derived * >(this);
-        auto deleter = [weak = derived->weak_from_this(), exec = derived->get_executor()](aggregate_book_snapshot *snap)
-        {
-            if (auto self = weak.lock())
-                asio::dispatch(asio::bind_executor(
-                    exec, [self, snap] { self->snapshot_buffer_.push_back(std::unique_ptr< aggregate_book_snapshot >(snap)); }));
-            else
-                delete snap;
-        };
-
+        // subscribers may release snapshots on any thread
         auto pop_or_create = [&]
         {
+            if (snapshot_buffer_.empty())
+                released_snapshots_->reclaim([this](std::unique_ptr< aggregate_book_snapshot > snap)
+                                             { snapshot_buffer_.push_back(std::move(snap)); });
             if (snapshot_buffer_.empty())
                 return std::make_unique< aggregate_book_snapshot >();
             else
@@ -116,11 +110,15 @@ struct implement_aggregate_book_feed : aggregate_book_feed_iface
             }
         };
 
-        return std::shared_ptr< aggregate_book_snapshot >(pop_or_create(), deleter);
+        auto deleter = snapshot_pool::deleter { released_snapshots_ };
+        return std::shared_ptr< aggregate_book_snapshot >(pop_or_create().release(), std::move(deleter));
     }
 
   private:
+    using snapshot_pool = util::free_list< aggregate_book_snapshot >;
+
     std::vector< std::unique_ptr< aggregate_book_snapshot > > snapshot_buffer_;
+    std::shared_ptr< snapshot_pool >                          released_snapshots_ = std::make_shared< snapshot_pool >();
 };
 
 
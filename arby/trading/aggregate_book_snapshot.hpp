@@ -13,14 +13,29 @@
 #include "trading/aggregate_book.hpp"
 #include "trading/feed_snapshot.hpp"
 
+#include <cstddef>
+#include <vector>
+
 namespace arby
 {
 namespace trading
 {
 
+/// @brief The part of a level's depth contributed by one venue.
+struct venue_depth
+{
+    std::size_t venue;
+    qty_type    depth;
+};
+
 struct aggregate_book_snapshot : feed_snapshot
 {
     aggregate_book book;
+
+    /// @brief For a book consolidated from several feeds, the contributions to each level of the ladders, in the same
+    /// order. Each venue is an index into parents_. Empty for the book of a single venue.
+    std::vector< std::vector< venue_depth > > bid_venues;
+    std::vector< std::vector< venue_depth > > offer_venues;
 };
 
 }   // namespace trading
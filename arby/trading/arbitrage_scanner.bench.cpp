@@ -0,0 +1,83 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "bench/bench.hpp"
+#include "trading/arbitrage_scanner.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace arby;
+
+namespace
+{
+/// 50 coins, each quoted in usd, usdt and btc, with the crosses among the quote currencies, on two venues: 306 books.
+struct universe
+{
+    universe()
+    {
+        auto rng   = std::mt19937(5);
+        auto value = std::vector< std::pair< std::string, double > > { { "usd", 1 }, { "usdt", 1.0002 }, { "btc", 40000 } };
+        auto coins = std::vector< std::pair< std::string, double > >();
+        for (int i = 0; i < 50; ++i)
+            coins.emplace_back("coin" + std::to_string(i), 0.1 + double(rng() % 100000) / 10);
+
+        auto add = [&](std::string const &base, double base_value, std::string const &term, double term_value)
+        {
+            for (auto venue : { "a", "b" })
+            {
+                scanner.add_book(venue, trading::spot_key(base + "/" + term), 0.001);
+                mids.push_back(base_value / term_value);
+            }
+        };
+        for (auto &[coin, v] : coins)
+            for (auto &[quote, qv] : value)
+                add(coin, v, quote, qv);
+        add("btc", 40000, "usd", 1);
+        add("btc", 40000, "usdt", 1.0002);
+        add("usdt", 1.0002, "usd", 1);
+
+        // the stream of quotes: each book's spread moved by up to a few basis points either side of its mid
+        for (int i = 0; i < 1 << 16; ++i)
+        {
+            auto book   = std::size_t(rng() % mids.size());
+            auto mid    = mids[book] * (1 + (int(rng() % 11) - 5) * 1e-4);
+            auto spread = mid * 5e-4;
+            quotes.emplace_back(book,
+                                trading::top_of_book { .bid       = mid - spread,
+                                                       .bid_qty   = 1 + double(rng() % 100),
+                                                       .offer     = mid + spread,
+                                                       .offer_qty = 1 + double(rng() % 100) });
+        }
+    }
+
+    trading::arbitrage_scanner                                   scanner { 0.0001 };
+    std::vector< double >                                        mids;
+    std::vector< std::pair< std::size_t, trading::top_of_book > > quotes;
+};
+}   // namespace
+
+// one top of book update, evaluating every cycle through the book
+ARBY_BENCHMARK("arbitrage_scanner/update_306_books")
+{
+    auto u     = universe();
+    auto found = std::size_t(0);
+    auto con   = u.scanner.connect([&](trading::arbitrage_opportunity const &op) { found += op.legs.size(); });
+    for (auto &[book, top] : u.quotes)
+        u.scanner.update(book, top);
+
+    auto i = std::size_t(0);
+    for (auto _ : state)
+    {
+        auto &[book, top] = u.quotes[i++ & (u.quotes.size() - 1)];
+        bench::do_not_optimize(u.scanner.update(book, top));
+    }
+    bench::do_not_optimize(found);
+}
@@ -0,0 +1,305 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "trading/arbitrage_scanner.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace arby::trading
+{
+namespace
+{
+    constexpr auto no_rate = -std::numeric_limits< double >::infinity();
+
+    bool
+    is_sale(std::uint32_t edge)
+    {
+        return edge % 2 == 0;
+    }
+}   // namespace
+
+arbitrage_scanner::arbitrage_scanner(double min_return, std::size_t max_cycle)
+: log_threshold_(std::log1p(min_return))
+, max_cycle_(max_cycle)
+{
+}
+
+std::size_t
+arbitrage_scanner::add_book(std::string venue, spot_market_key const &market, double fee)
+{
+    auto base = currency_node(market.base);
+    auto term = currency_node(market.term);
+    books_.push_back(book_info {
+        .venue = std::move(venue), .market = market, .base = base, .term = term, .fee_factor = 1 - fee });
+    price_.insert(price_.end(), 2, 0);
+    weight_.insert(weight_.end(), 2, no_rate);
+    capacity_.insert(capacity_.end(), 2, 0);
+    indexed_ = false;
+    return books_.size() - 1;
+}
+
+std::uint32_t
+arbitrage_scanner::currency_node(std::string const &name)
+{
+    auto [i, inserted] = currency_index_.try_emplace(name, std::uint32_t(currencies_.size()));
+    if (inserted)
+        currencies_.push_back(name);
+    return i->second;
+}
+
+std::size_t
+arbitrage_scanner::cycles()
+{
+    if (!indexed_)
+        build_index();
+    return cycle_begin_.size() - 1;
+}
+
+void
+arbitrage_scanner::build_index()
+{
+    auto source = [&](std::uint32_t e)
+    {
+        auto &b = books_[e / 2];
+        return is_sale(e) ? b.base : b.term;
+    };
+    auto target = [&](std::uint32_t e)
+    {
+        auto &b = books_[e / 2];
+        return is_sale(e) ? b.term : b.base;
+    };
+
+    auto out_edges = std::vector< std::vector< std::uint32_t > >(currencies_.size());
+    for (std::uint32_t e = 0; e < weight_.size(); ++e)
+        out_edges[source(e)].push_back(e);
+
+    cycle_edges_.clear();
+    cycle_begin_.assign(1, 0);
+
+    // each directed cycle is found once, from its lowest numbered currency
+    auto path    = std::vector< std::uint32_t >();
+    auto visited = std::vector< bool >(currencies_.size());
+    auto start   = std::uint32_t(0);
+    auto search  = [&](auto &self, std::uint32_t node) -> void
+    {
+        for (auto e : out_edges[node])
+        {
+            auto t = target(e);
+            if (t == start)
+            {
+                // buying and selling on the same book is a certain loss
+                if (path.size() == 1 && path.front() / 2 == e / 2)
+                    continue;
+                cycle_edges_.insert(cycle_edges_.end(), path.begin(), path.end());
+                cycle_edges_.push_back(e);
+                cycle_begin_.push_back(std::uint32_t(cycle_edges_.size()));
+            }
+            else if (t > start && !visited[t] && path.size() + 1 < max_cycle_)
+            {
+                visited[t] = true;
+                path.push_back(e);
+                self(self, t);
+                path.pop_back();
+                visited[t] = false;
+            }
+        }
+    };
+    for (start = 0; start < currencies_.size(); ++start)
+        search(search, start);
+
+    // invert into the cycles through each edge
+    edge_cycle_begin_.assign(weight_.size() + 1, 0);
+    for (auto e : cycle_edges_)
+        ++edge_cycle_begin_[e + 1];
+    for (std::size_t e = 0; e < weight_.size(); ++e)
+        edge_cycle_begin_[e + 1] += edge_cycle_begin_[e];
+    edge_cycles_.resize(cycle_edges_.size());
+    auto fill = std::vector< std::uint32_t >(edge_cycle_begin_.begin(), edge_cycle_begin_.end() - 1);
+    for (std::uint32_t c = 0; c + 1 < cycle_begin_.size(); ++c)
+        for (auto i = cycle_begin_[c]; i < cycle_begin_[c + 1]; ++i)
+            edge_cycles_[fill[cycle_edges_[i]]++] = c;
+
+    indexed_ = true;
+    spdlog::debug("arbitrage_scanner: {} currencies, {} books, {} cycles", currencies_.size(), books_.size(), cycles());
+}
+
+std::size_t
+arbitrage_scanner::update(std::size_t book, top_of_book const &top)
+{
+    assert(book < books_.size());
+    if (!indexed_)
+        build_index();
+
+    auto &b        = books_[book];
+    auto  sale     = std::uint32_t(2 * book);
+    auto  purchase = sale + 1;
+
+    // the sale takes base, and the purchase takes term
+    auto has_bid   = top.bid > 0 && top.bid_qty > 0;
+    auto has_offer = top.offer > 0 && top.offer_qty > 0;
+
+    price_[sale]        = top.bid;
+    weight_[sale]       = has_bid ? std::log(top.bid * b.fee_factor) : no_rate;
+    capacity_[sale]     = has_bid ? top.bid_qty : 0;
+    price_[purchase]    = top.offer;
+    weight_[purchase]   = has_offer ? std::log(b.fee_factor / top.offer) : no_rate;
+    capacity_[purchase] = has_offer ? top.offer_qty * top.offer : 0;
+
+    // no cycle uses both edges of one book
+    auto found = std::size_t(0);
+    for (auto e : { sale, purchase })
+        for (auto i = edge_cycle_begin_[e]; i < edge_cycle_begin_[e + 1]; ++i)
+            found += evaluate(edge_cycles_[i]);
+    return found;
+}
+
+bool
+arbitrage_scanner::evaluate(std::uint32_t cycle)
+{
+    auto const first = cycle_begin_[cycle];
+    auto const last  = cycle_begin_[cycle + 1];
+
+    auto sum = 0.0;
+    for (auto i = first; i < last; ++i)
+        sum += weight_[cycle_edges_[i]];
+    // false for an edge without a rate, whose weight is -inf
+    if (!(sum > log_threshold_))
+        return false;
+
+    // the most which can be put in is limited by the leg with the least capacity, scaled back to the start currency
+    auto size    = std::numeric_limits< double >::infinity();
+    auto carried = 1.0;
+    for (auto i = first; i < last; ++i)
+    {
+        auto e  = cycle_edges_[i];
+        size    = std::min(size, capacity_[e] / carried);
+        carried = carried * std::exp(weight_[e]);
+    }
+
+    auto &op = opportunity_;
+    op.legs.clear();
+    auto amount = size;
+    for (auto i = first; i < last; ++i)
+    {
+        auto e     = cycle_edges_[i];
+        auto price = price_[e];
+        if (is_sale(e))
+            op.legs.push_back({ .book = e / 2, .side = sell, .price = price, .qty = amount });
+        else
+            op.legs.push_back({ .book = e / 2, .side = buy, .price = price, .qty = amount / price });
+        amount *= std::exp(weight_[e]);
+    }
+
+    auto &start = books_[cycle_edges_[first] / 2];
+    op.currency = &currencies_[is_sale(cycle_edges_[first]) ? start.base : start.term];
+    op.rate     = carried;
+    op.size     = size;
+    op.profit   = size * (carried - 1);
+    signal_(op);
+    return true;
+}
+
+arbitrage_engine::arbitrage_engine(asio::any_io_executor exec, double min_return)
+: util::has_executor_base(std::move(exec))
+, scanner_(min_return)
+{
+}
+
+void
+arbitrage_engine::add_source(std::string                                  venue,
+                             spot_market_key const                       &market,
+                             double                                       fee,
+                             std::shared_ptr< aggregate_book_feed_iface > source)
+{
+    auto book = scanner_.add_book(std::move(venue), market, fee);
+    sources_.push_back(source_state { .book = book, .feed = std::move(source), .connection = {}, .last_timestamp = {} });
+}
+
+void
+arbitrage_engine::start()
+{
+    asio::co_spawn(get_executor(), run(shared_from_this()), asio::detached);
+}
+
+void
+arbitrage_engine::stop()
+{
+    stopped_ = true;
+    for (auto &s : sources_)
+        s.connection.disconnect();
+}
+
+asio::awaitable< void >
+arbitrage_engine::run(std::shared_ptr< arbitrage_engine > self)
+{
+    for (std::size_t index = 0; index < sources_.size() && !stopped_; ++index)
+    {
+        // a source signals on its own executor
+        auto slot = [weak = weak_from_this(), exec = get_executor(), index](std::shared_ptr< aggregate_book_snapshot const > snap)
+        {
+            asio::post(exec,
+                       [weak, index, snap = std::move(snap)]
+                       {
+                           if (auto self = weak.lock())
+                               self->on_snapshot(index, snap);
+                       });
+        };
+
+        auto &source = sources_[index];
+        try
+        {
+            auto [snap, connection] = co_await source.feed->subscribe(std::move(slot));
+            if (stopped_)
+                break;
+            source.connection = std::move(connection);
+            if (snap)
+                on_snapshot(index, snap);
+        }
+        catch (std::exception &e)
+        {
+            spdlog::error("{}::{} {}: {}", classname, __func__, to_string(scanner_.market(source.book)), e.what());
+        }
+    }
+}
+
+void
+arbitrage_engine::on_snapshot(std::size_t index, std::shared_ptr< aggregate_book_snapshot const > const &snap)
+{
+    auto &source = sources_[index];
+
+    // the snapshot returned by subscribe may arrive after one which was signalled later
+    if (stopped_ || snap->timestamp < source.last_timestamp)
+        return;
+    source.last_timestamp = snap->timestamp;
+
+    auto top = top_of_book();
+    if (snap->condition.state == feed_state::good)
+    {
+        auto &bids   = snap->book.bids;
+        auto &offers = snap->book.offers;
+        if (!bids.empty())
+        {
+            top.bid     = to_double(bids.front().price);
+            top.bid_qty = to_double(bids.front().depth);
+        }
+        if (!offers.empty())
+        {
+            top.offer     = to_double(offers.front().price);
+            top.offer_qty = to_double(offers.front().depth);
+        }
+    }
+    scanner_.update(source.book, top);
+}
+
+}   // namespace arby::trading
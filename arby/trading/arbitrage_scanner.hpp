@@ -0,0 +1,232 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_ARBY_TRADING_ARBITRAGE_SCANNER_HPP
+#define ARBY_ARBY_TRADING_ARBITRAGE_SCANNER_HPP
+
+#include "trading/aggregate_book_feed.hpp"
+#include "trading/spot_market_key.hpp"
+#include "trading/types.hpp"
+#include "util/cross_executor_connection.hpp"
+#include "util/signal.hpp"
+
+#include <boost/container/small_vector.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace arby::trading
+{
+
+/// @brief The best bid and offer of a book, for analytics. A side without orders has a quantity of 0.
+struct top_of_book
+{
+    double bid       = 0;
+    double bid_qty   = 0;
+    double offer     = 0;
+    double offer_qty = 0;
+};
+
+/// @brief One trade of an arbitrage cycle.
+struct arbitrage_leg
+{
+    /// the book traded, as returned by arbitrage_scanner::add_book
+    std::size_t book;
+
+    /// buy base for term at the offer, or sell base for term at the bid
+    side_type side;
+
+    double price;
+
+    /// the base quantity traded when the cycle is run at its executable size
+    double qty;
+};
+
+/// @brief A cycle of trades which ends with more of a currency than it started with.
+struct arbitrage_opportunity
+{
+    /// the currency in which the cycle starts and ends
+    std::string const *currency;
+
+    /// the amount of the currency returned for each unit put in, net of fees
+    double rate;
+
+    /// the amount of the currency which can be put through the cycle at the quoted depth
+    double size;
+
+    /// size * (rate - 1)
+    double profit;
+
+    boost::container::small_vector< arbitrage_leg, 4 > legs;
+};
+
+/// @brief Finds triangular and cross-venue arbitrage among the top of book of many spot markets.
+///
+/// Each currency is a node of a graph. Each book contributes two edges: base to term at the bid, and term to base at
+/// the offer. An edge is weighted by the log of its rate net of fees, so that a cycle is profitable when its weights
+/// sum to more than 0. Two books for the same market on different venues give a cycle of length 2, which is
+/// cross-venue arbitrage; three markets give a triangle.
+///
+/// Every cycle of up to max_cycle edges is enumerated once, when the first update arrives after books have been added,
+/// and indexed by the edges it uses. An update of one book then evaluates only the cycles through its two edges.
+/// @note not thread-safe
+struct arbitrage_scanner
+{
+    static constexpr std::size_t default_max_cycle = 3;
+
+    using signal_type = util::signal< void(arbitrage_opportunity const &) >;
+
+    /// @param min_return is the least return, net of fees, for which an opportunity is reported
+    explicit arbitrage_scanner(double min_return = 0, std::size_t max_cycle = default_max_cycle);
+
+    /// @brief Add a market on a venue.
+    /// @param fee is the proportional fee charged on each trade
+    /// @return the book's index, by which it is updated
+    std::size_t
+    add_book(std::string venue, spot_market_key const &market, double fee = 0);
+
+    /// @brief Set the top of a book, and evaluate every cycle which trades in it. Each profitable cycle is signalled.
+    /// @return the number of profitable cycles
+    std::size_t
+    update(std::size_t book, top_of_book const &top);
+
+    /// @brief Connect a slot to receive each opportunity. The opportunity is valid only for the duration of the call.
+    util::connection
+    connect(signal_type::slot_type slot)
+    {
+        return signal_.connect(std::move(slot));
+    }
+
+    std::size_t
+    books() const
+    {
+        return books_.size();
+    }
+
+    std::string const &
+    venue(std::size_t book) const
+    {
+        return books_[book].venue;
+    }
+
+    spot_market_key const &
+    market(std::size_t book) const
+    {
+        return books_[book].market;
+    }
+
+    /// @brief The number of cycles indexed. Builds the index if need be.
+    std::size_t
+    cycles();
+
+  private:
+    struct book_info
+    {
+        std::string     venue;
+        spot_market_key market;
+        std::uint32_t   base;
+        std::uint32_t   term;
+        double          fee_factor;
+    };
+
+    std::uint32_t
+    currency_node(std::string const &name);
+
+    void
+    build_index();
+
+    bool
+    evaluate(std::uint32_t cycle);
+
+    double      log_threshold_;
+    std::size_t max_cycle_;
+
+    std::vector< book_info >                         books_;
+    std::vector< std::string >                       currencies_;
+    std::unordered_map< std::string, std::uint32_t > currency_index_;
+
+    // per edge, 2 * book for the sale of base at the bid and 2 * book + 1 for the purchase of base at the offer: the
+    // quoted price, the log of the rate net of fees, and the most of the edge's source currency it can take
+    std::vector< double > price_;
+    std::vector< double > weight_;
+    std::vector< double > capacity_;
+
+    // the cycles, as runs of edges, and the cycles through each edge
+    bool                         indexed_ = false;
+    std::vector< std::uint32_t > cycle_edges_;
+    std::vector< std::uint32_t > cycle_begin_;
+    std::vector< std::uint32_t > edge_cycles_;
+    std::vector< std::uint32_t > edge_cycle_begin_;
+
+    arbitrage_opportunity opportunity_;
+    signal_type           signal_;
+};
+
+/// @brief Runs an arbitrage_scanner over the top of book of a set of aggregate book feeds.
+///
+/// Snapshots from the sources are marshalled onto the engine's executor by POST. A source whose book is not good is
+/// treated as empty until it recovers.
+struct arbitrage_engine
+: util::has_executor_base
+, std::enable_shared_from_this< arbitrage_engine >
+{
+    static constexpr char classname[] = "arbitrage_engine";
+
+    arbitrage_engine(asio::any_io_executor exec, double min_return = 0);
+
+    /// @brief Add a market on a venue, whose book is taken from source.
+    /// @note must be called before start()
+    void
+    add_source(std::string                                  venue,
+               spot_market_key const                       &market,
+               double                                       fee,
+               std::shared_ptr< aggregate_book_feed_iface > source);
+
+    void
+    start();
+
+    /// @note must be called on the engine's executor
+    void
+    stop();
+
+    /// @brief The scanner, to which opportunities may be subscribed.
+    /// @note must be used on the engine's executor
+    arbitrage_scanner &
+    scanner()
+    {
+        return scanner_;
+    }
+
+  private:
+    struct source_state
+    {
+        std::size_t                                  book;
+        std::shared_ptr< aggregate_book_feed_iface > feed;
+        util::cross_executor_connection              connection;
+        fast_clock::time_point                       last_timestamp;
+    };
+
+    asio::awaitable< void >
+    run(std::shared_ptr< arbitrage_engine > self);
+
+    void
+    on_snapshot(std::size_t index, std::shared_ptr< aggregate_book_snapshot const > const &snap);
+
+    arbitrage_scanner           scanner_;
+    std::vector< source_state > sources_;
+    bool                        stopped_ = false;
+};
+
+}   // namespace arby::trading
+
+#endif   // ARBY_ARBY_TRADING_ARBITRAGE_SCANNER_HPP
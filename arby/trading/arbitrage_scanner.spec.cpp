@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+#include "trading/arbitrage_scanner.hpp"
+
+#include <doctest/doctest.h>
+
+#include <vector>
+
+using namespace arby;
+
+TEST_CASE("trading::arbitrage_scanner")
+{
+    SUBCASE("cross-venue")
+    {
+        auto scanner = trading::arbitrage_scanner();
+        auto a       = scanner.add_book("a", trading::spot_key("eth/usd"));
+        auto b       = scanner.add_book("b", trading::spot_key("eth/usd"));
+        CHECK(scanner.cycles() == 2);
+
+        auto found = std::vector< trading::arbitrage_opportunity >();
+        auto con   = scanner.connect([&](trading::arbitrage_opportunity const &op) { found.push_back(op); });
+
+        CHECK(scanner.update(a, { .bid = 99, .bid_qty = 1, .offer = 100, .offer_qty = 2 }) == 0);
+        CHECK(scanner.update(b, { .bid = 99.5, .bid_qty = 1, .offer = 100.5, .offer_qty = 1 }) == 0);
+
+        // b's bid crosses a's offer
+        CHECK(scanner.update(b, { .bid = 101, .bid_qty = 1.5, .offer = 102, .offer_qty = 1 }) == 1);
+        REQUIRE(found.size() == 1);
+        auto &op = found.front();
+        CHECK(*op.currency == "eth");
+        CHECK(op.rate == doctest::Approx(1.01));
+        CHECK(op.size == doctest::Approx(1.5));
+        CHECK(op.profit == doctest::Approx(0.015));
+        REQUIRE(op.legs.size() == 2);
+        CHECK(op.legs[0].book == b);
+        CHECK(op.legs[0].side == trading::sell);
+        CHECK(op.legs[0].price == 101);
+        CHECK(op.legs[1].book == a);
+        CHECK(op.legs[1].side == trading::buy);
+        CHECK(op.legs[1].qty == doctest::Approx(1.515));
+
+        // the offer runs out before the bid: 150 usd buys 1.5 eth, which needs 150 / 101 eth to be sold first
+        found.clear();
+        scanner.update(a, { .bid = 99, .bid_qty = 1, .offer = 100, .offer_qty = 1.5 });
+        REQUIRE(found.size() == 1);
+        CHECK(found.front().size == doctest::Approx(150.0 / 101));
+
+        // an empty side trades nothing
+        found.clear();
+        CHECK(scanner.update(a, { .bid = 99, .bid_qty = 1 }) == 0);
+        CHECK(found.empty());
+    }
+
+    SUBCASE("triangular, net of fees")
+    {
+        auto scanner = trading::arbitrage_scanner(0.001);
+        auto ethusd  = scanner.add_book("a", trading::spot_key("eth/usd"), 0.001);
+        auto btcusd  = scanner.add_book("a", trading::spot_key("btc/usd"), 0.001);
+        auto ethbtc  = scanner.add_book("a", trading::spot_key("eth/btc"), 0.001);
+        // the two directions round the triangle, and nothing more
+        CHECK(scanner.cycles() == 2);
+
+        auto found = std::vector< trading::arbitrage_opportunity >();
+        auto con   = scanner.connect([&](trading::arbitrage_opportunity const &op) { found.push_back(op); });
+
+        scanner.update(btcusd, { .bid = 39990, .bid_qty = 1, .offer = 40000, .offer_qty = 1 });
+        scanner.update(ethbtc, { .bid = 0.0749, .bid_qty = 10, .offer = 0.075, .offer_qty = 10 });
+        // consistent prices: 3000 usd / eth is 0.075 btc / eth
+        CHECK(scanner.update(ethusd, { .bid = 2999, .bid_qty = 10, .offer = 3000, .offer_qty = 10 }) == 0);
+
+        // eth is bid at 3020 in usd: buy btc with usd, buy eth with btc, sell eth for usd. A gain of 0.67% before the
+        // fees of 0.3%.
+        CHECK(scanner.update(ethusd, { .bid = 3020, .bid_qty = 10, .offer = 3021, .offer_qty = 10 }) == 1);
+        REQUIRE(found.size() == 1);
+        auto &op = found.front();
+        CHECK(op.legs.size() == 3);
+        CHECK(op.rate == doctest::Approx(3020.0 / 40000 / 0.075 * 0.999 * 0.999 * 0.999));
+        CHECK(op.profit > 0);
+
+        // too thin a margin to cover the fees
+        found.clear();
+        CHECK(scanner.update(ethusd, { .bid = 3004, .bid_qty = 10, .offer = 3005, .offer_qty = 10 }) == 0);
+    }
+}
@@ -0,0 +1,302 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "trading/consolidated_book.hpp"
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+namespace arby::trading
+{
+namespace
+{
+    bool
+    same(price_depth const &l, price_depth const &r)
+    {
+        return l.price == r.price && l.depth == r.depth;
+    }
+
+    /// Replace one venue's ladder on one side, and merge again the range of prices over which it changed.
+    /// @param better orders prices best first
+    template < class Compare >
+    void
+    merge_side(std::vector< std::vector< price_depth > > &ladders,
+               std::vector< consolidated_level >          &merged,
+               std::size_t                                 venue,
+               std::span< price_depth const >              ladder,
+               Compare                                     better)
+    {
+        auto &old = ladders[venue];
+
+        // the levels which changed lie between the longest common prefix and the longest common suffix
+        auto const m      = old.size();
+        auto const n      = ladder.size();
+        auto       prefix = std::size_t(0);
+        while (prefix < m && prefix < n && same(old[prefix], ladder[prefix]))
+            ++prefix;
+        auto suffix = std::size_t(0);
+        while (suffix < m - prefix && suffix < n - prefix && same(old[m - 1 - suffix], ladder[n - 1 - suffix]))
+            ++suffix;
+        if (prefix + suffix == m && prefix + suffix == n)
+            return;
+
+        // the price range to merge again runs from the best changed level of either ladder to the worst
+        auto best  = price_type();
+        auto worst = price_type();
+        auto any   = false;
+        auto widen = [&](price_type const &p)
+        {
+            if (!any || better(p, best))
+                best = p;
+            if (!any || better(worst, p))
+                worst = p;
+            any = true;
+        };
+        if (prefix < m - suffix)
+        {
+            widen(old[prefix].price);
+            widen(old[m - 1 - suffix].price);
+        }
+        if (prefix < n - suffix)
+        {
+            widen(ladder[prefix].price);
+            widen(ladder[n - 1 - suffix].price);
+        }
+        old.assign(ladder.begin(), ladder.end());
+
+        auto before_range = [&](price_type const &p) { return better(p, best); };
+        auto in_or_before = [&](price_type const &p) { return !better(worst, p); };
+
+        struct cursor
+        {
+            price_depth const *first;
+            price_depth const *last;
+            std::size_t        venue;
+        };
+        auto cursors = boost::container::small_vector< cursor, 8 >();
+        for (std::size_t v = 0; v < ladders.size(); ++v)
+        {
+            auto &l     = ladders[v];
+            auto  first = std::partition_point(l.begin(), l.end(), [&](price_depth const &pd) { return before_range(pd.price); });
+            auto  last  = std::partition_point(first, l.end(), [&](price_depth const &pd) { return in_or_before(pd.price); });
+            if (first != last)
+                cursors.push_back({ .first = std::to_address(first), .last = std::to_address(last), .venue = v });
+        }
+
+        // the k-way merge. There are few venues, so the best of the cursors is found by a scan rather than a heap.
+        auto replacement = std::vector< consolidated_level >();
+        while (!cursors.empty())
+        {
+            auto const *top = &cursors.front().first->price;
+            for (auto &c : cursors)
+                if (better(c.first->price, *top))
+                    top = &c.first->price;
+
+            auto level = consolidated_level { .price = *top, .depth = 0, .venues = {} };
+            for (auto &c : cursors)
+                if (c.first->price == level.price)
+                {
+                    level.depth += c.first->depth;
+                    level.venues.push_back({ .venue = c.venue, .depth = c.first->depth });
+                    ++c.first;
+                }
+            replacement.push_back(std::move(level));
+
+            cursors.erase(std::remove_if(cursors.begin(), cursors.end(), [](cursor const &c) { return c.first == c.last; }),
+                          cursors.end());
+        }
+
+        // splice the replacement over the range, reusing the levels already there
+        auto lo =
+            std::partition_point(merged.begin(), merged.end(), [&](consolidated_level const &l) { return before_range(l.price); });
+        auto hi = std::partition_point(lo, merged.end(), [&](consolidated_level const &l) { return in_or_before(l.price); });
+        auto common = std::min(std::size_t(hi - lo), replacement.size());
+        lo          = std::move(replacement.begin(), replacement.begin() + common, lo);
+        if (common < replacement.size())
+            merged.insert(
+                lo, std::make_move_iterator(replacement.begin() + common), std::make_move_iterator(replacement.end()));
+        else
+            merged.erase(lo, hi);
+    }
+
+    template < class Ladder, class VenueLadder >
+    void
+    copy_side(std::vector< consolidated_level > const &levels,
+              Ladder                                  &ladder,
+              VenueLadder                             &venues,
+              std::vector< std::size_t > const        &parent_of)
+    {
+        ladder.resize(levels.size());
+        venues.resize(levels.size());
+        for (std::size_t i = 0; i < levels.size(); ++i)
+        {
+            ladder[i].price = levels[i].price;
+            ladder[i].depth = levels[i].depth;
+            venues[i].clear();
+            for (auto &vd : levels[i].venues)
+                venues[i].push_back({ .venue = parent_of[vd.venue], .depth = vd.depth });
+        }
+    }
+}   // namespace
+
+book_consolidator::book_consolidator(std::size_t venues)
+: venue_bids_(venues)
+, venue_offers_(venues)
+{
+}
+
+void
+book_consolidator::update(std::size_t venue, std::span< price_depth const > bids, std::span< price_depth const > offers)
+{
+    assert(venue < venues());
+    merge_side(venue_bids_, bids_, venue, bids, std::greater<>());
+    merge_side(venue_offers_, offers_, venue, offers, std::less<>());
+}
+
+std::shared_ptr< consolidated_book_feed >
+consolidated_book_feed::create(asio::any_io_executor exec, market_key market, std::vector< source_ptr > sources)
+{
+    auto impl = std::make_shared< consolidated_book_feed >(std::move(exec), std::move(market), std::move(sources));
+    impl->start();
+    return impl;
+}
+
+consolidated_book_feed::consolidated_book_feed(asio::any_io_executor exec, market_key market, std::vector< source_ptr > sources)
+: util::has_executor_base(std::move(exec))
+, market_(std::move(market))
+, source_id_(fmt::format("{}[{}]", classname, market_))
+, consolidator_(sources.size())
+{
+    sources_.reserve(sources.size());
+    for (auto &s : sources)
+        sources_.push_back(source_state { .feed = std::move(s), .last = {}, .connection = {} });
+}
+
+void
+consolidated_book_feed::start()
+{
+    asio::co_spawn(get_executor(), run(shared_from_this()), asio::detached);
+}
+
+void
+consolidated_book_feed::stop()
+{
+    stopped_ = true;
+    for (auto &s : sources_)
+        s.connection.disconnect();
+}
+
+asio::awaitable< void >
+consolidated_book_feed::run(std::shared_ptr< consolidated_book_feed > self)
+{
+    for (std::size_t venue = 0; venue < sources_.size() && !stopped_; ++venue)
+    {
+        // a source signals on its own executor
+        auto slot = [weak = weak_from_this(), exec = get_executor(), venue](std::shared_ptr< aggregate_book_snapshot const > snap)
+        {
+            asio::post(exec,
+                       [weak, venue, snap = std::move(snap)]() mutable
+                       {
+                           if (auto self = weak.lock())
+                               self->on_snapshot(venue, std::move(snap));
+                       });
+        };
+
+        try
+        {
+            auto [snap, connection] = co_await sources_[venue].feed->subscribe(std::move(slot));
+            if (stopped_)
+                break;
+            sources_[venue].connection = std::move(connection);
+            if (snap)
+                on_snapshot(venue, std::move(snap));
+        }
+        catch (std::exception &e)
+        {
+            spdlog::error("{}::{} venue {}: {}", source_id_, __func__, venue, e.what());
+        }
+    }
+}
+
+void
+consolidated_book_feed::on_snapshot(std::size_t venue, std::shared_ptr< aggregate_book_snapshot const > snap)
+{
+    if (stopped_)
+        return;
+
+    // the snapshot returned by subscribe may arrive after one which was signalled later
+    auto &last = sources_[venue].last;
+    if (last && snap->timestamp < last->timestamp)
+        return;
+    last = std::move(snap);
+
+    if (last->condition.state == feed_state::good)
+        consolidator_.update(venue, last->book.bids, last->book.offers);
+    else
+        consolidator_.withdraw(venue);
+
+    publish();
+}
+
+void
+consolidated_book_feed::publish()
+{
+    auto snap       = new_aggregate_book_snapshot();
+    snap->source    = source_id_;
+    snap->timestamp = fast_clock::now();
+    snap->parents_.clear();
+    snap->upstream_time  = {};
+    snap->book.market    = market_;
+    snap->book.timestamp = {};
+
+    auto good = std::any_of(sources_.begin(),
+                            sources_.end(),
+                            [](source_state const &s) { return s.last && s.last->condition.state == feed_state::good; });
+    snap->condition.reset(good ? feed_state::good : feed_state::not_ready);
+
+    // the parents are the sources which have delivered a snapshot
+    auto parent_of    = std::vector< std::size_t >(sources_.size());
+    auto first_parent = true;
+    for (std::size_t venue = 0; venue < sources_.size(); ++venue)
+    {
+        auto &last = sources_[venue].last;
+        if (!last)
+            continue;
+        parent_of[venue] = snap->parents_.size();
+        snap->parents_.push_back(last);
+        snap->upstream_time  = std::max(snap->upstream_time, last->upstream_time);
+        snap->book.timestamp = std::max(snap->book.timestamp, last->book.timestamp);
+
+        if (good)
+        {
+            if (last->condition.state != feed_state::good)
+                snap->condition.errors.push_back(fmt::format("{} withdrawn: {}", last->source, last->condition));
+        }
+        else
+        {
+            if (std::exchange(first_parent, false))
+                snap->condition.reset(last->condition.state);
+            snap->condition.merge(last->condition);
+        }
+    }
+
+    copy_side(consolidator_.bids(), snap->book.bids, snap->bid_venues, parent_of);
+    copy_side(consolidator_.offers(), snap->book.offers, snap->offer_venues, parent_of);
+
+    update_snapshot(std::move(snap));
+}
+
+}   // namespace arby::trading
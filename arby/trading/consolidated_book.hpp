@@ -0,0 +1,145 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_ARBY_TRADING_CONSOLIDATED_BOOK_HPP
+#define ARBY_ARBY_TRADING_CONSOLIDATED_BOOK_HPP
+
+#include "trading/aggregate_book_feed.hpp"
+#include "trading/aggregate_book_snapshot.hpp"
+#include "trading/market_key.hpp"
+#include "util/cross_executor_connection.hpp"
+
+#include <boost/container/small_vector.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace arby::trading
+{
+
+/// @brief A level of a consolidated ladder, with the depth each venue contributes to it.
+struct consolidated_level
+{
+    price_type                                       price;
+    qty_type                                         depth;
+    boost::container::small_vector< venue_depth, 4 > venues;
+};
+
+/// @brief Merges the ladders of several venues into one ladder per side, keeping each venue's contribution.
+///
+/// When a venue's ladder changes, only the price range between the first and last level which changed is merged
+/// again. The merged levels in that range are replaced by a k-way merge of every venue's levels in the range, each of
+/// which is found by binary search. A change at the top of one venue's book therefore leaves the rest of the
+/// consolidated ladder untouched.
+/// @note not thread-safe
+struct book_consolidator
+{
+    explicit book_consolidator(std::size_t venues);
+
+    std::size_t
+    venues() const
+    {
+        return venue_bids_.size();
+    }
+
+    /// @brief Replace the ladders of one venue. Each ladder is best first.
+    void
+    update(std::size_t venue, std::span< price_depth const > bids, std::span< price_depth const > offers);
+
+    /// @brief Remove the levels of one venue.
+    void
+    withdraw(std::size_t venue)
+    {
+        update(venue, {}, {});
+    }
+
+    std::vector< consolidated_level > const &
+    bids() const
+    {
+        return bids_;
+    }
+
+    std::vector< consolidated_level > const &
+    offers() const
+    {
+        return offers_;
+    }
+
+  private:
+    std::vector< std::vector< price_depth > > venue_bids_;
+    std::vector< std::vector< price_depth > > venue_offers_;
+    std::vector< consolidated_level >         bids_;
+    std::vector< consolidated_level >         offers_;
+};
+
+/// @brief An aggregate book feed which consolidates the books of one market from several venues.
+///
+/// The feed subscribes to each of its sources and publishes a new snapshot whenever one of them does. Each snapshot
+/// names the source snapshots from which it was built in parents_, and attributes the depth of each level to them in
+/// bid_venues and offer_venues.
+///
+/// A source whose book is not good has its levels withdrawn from the consolidated book until it recovers. The
+/// consolidated book is good while any source is good, and lists the sources which are withdrawn among its errors.
+/// Otherwise its condition is the merged condition of its sources.
+///
+/// @note Snapshots from the sources are marshalled onto this feed's executor by POST.
+struct consolidated_book_feed
+: util::has_executor_base
+, std::enable_shared_from_this< consolidated_book_feed >
+, implement_aggregate_book_feed< consolidated_book_feed >
+{
+    static constexpr char classname[] = "consolidated_book_feed";
+
+    using source_ptr = std::shared_ptr< aggregate_book_feed_iface >;
+
+    static std::shared_ptr< consolidated_book_feed >
+    create(asio::any_io_executor exec, market_key market, std::vector< source_ptr > sources);
+
+    consolidated_book_feed(asio::any_io_executor exec, market_key market, std::vector< source_ptr > sources);
+
+    /// @brief Subscribe to the sources.
+    void
+    start();
+
+    /// @brief Unsubscribe from the sources.
+    /// @note must be called on the feed's executor
+    void
+    stop();
+
+  private:
+    struct source_state
+    {
+        source_ptr                                       feed;
+        std::shared_ptr< aggregate_book_snapshot const > last;
+        util::cross_executor_connection                  connection;
+    };
+
+    asio::awaitable< void >
+    run(std::shared_ptr< consolidated_book_feed > self);
+
+    void
+    on_snapshot(std::size_t venue, std::shared_ptr< aggregate_book_snapshot const > snap);
+
+    void
+    publish();
+
+    market_key const  market_;
+    std::string const source_id_;
+
+    std::vector< source_state > sources_;
+    book_consolidator           consolidator_;
+    bool                        stopped_ = false;
+};
+
+}   // namespace arby::trading
+
+#endif   // ARBY_ARBY_TRADING_CONSOLIDATED_BOOK_HPP
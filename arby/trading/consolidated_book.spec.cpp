@@ -0,0 +1,138 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+#include "trading/consolidated_book.hpp"
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace arby;
+
+namespace
+{
+std::vector< trading::price_depth >
+ladder(std::initializer_list< std::pair< int, int > > levels)
+{
+    auto result = std::vector< trading::price_depth >();
+    for (auto [p, q] : levels)
+        result.push_back({ .price = trading::price_type(p), .depth = trading::qty_type(q) });
+    return result;
+}
+
+/// The consolidated ladder, merged from scratch.
+template < class Compare >
+std::vector< trading::consolidated_level >
+merge_all(std::vector< std::vector< trading::price_depth > > const &ladders)
+{
+    auto levels = std::map< trading::price_type, trading::consolidated_level, Compare >();
+    for (std::size_t v = 0; v < ladders.size(); ++v)
+        for (auto &pd : ladders[v])
+        {
+            auto &level = levels[pd.price];
+            level.price = pd.price;
+            level.depth += pd.depth;
+            level.venues.push_back({ .venue = v, .depth = pd.depth });
+        }
+    auto result = std::vector< trading::consolidated_level >();
+    for (auto &[p, level] : levels)
+        result.push_back(level);
+    return result;
+}
+
+bool
+same(std::vector< trading::consolidated_level > const &l, std::vector< trading::consolidated_level > const &r)
+{
+    if (l.size() != r.size())
+        return false;
+    for (std::size_t i = 0; i < l.size(); ++i)
+    {
+        if (l[i].price != r[i].price || l[i].depth != r[i].depth || l[i].venues.size() != r[i].venues.size())
+            return false;
+        for (std::size_t j = 0; j < l[i].venues.size(); ++j)
+            if (l[i].venues[j].venue != r[i].venues[j].venue || l[i].venues[j].depth != r[i].venues[j].depth)
+                return false;
+    }
+    return true;
+}
+}   // namespace
+
+TEST_CASE("trading::book_consolidator")
+{
+    SUBCASE("levels are merged with their venues")
+    {
+        auto book = trading::book_consolidator(3);
+        book.update(0, ladder({ { 100, 1 }, { 99, 2 } }), ladder({ { 101, 1 } }));
+        book.update(1, ladder({ { 100, 3 }, { 98, 1 } }), ladder({ { 102, 5 }, { 103, 1 } }));
+        book.update(2, {}, ladder({ { 101, 2 } }));
+
+        REQUIRE(book.bids().size() == 3);
+        CHECK(book.bids()[0].price == 100);
+        CHECK(book.bids()[0].depth == 4);
+        REQUIRE(book.bids()[0].venues.size() == 2);
+        CHECK(book.bids()[0].venues[1].venue == 1);
+        CHECK(book.bids()[0].venues[1].depth == 3);
+        CHECK(book.bids()[2].price == 98);
+
+        REQUIRE(book.offers().size() == 3);
+        CHECK(book.offers()[0].depth == 3);
+        CHECK(book.offers()[0].venues[1].venue == 2);
+
+        // a change at one price leaves the others as they were
+        book.update(1, ladder({ { 100, 1 }, { 98, 1 } }), ladder({ { 102, 5 }, { 103, 1 } }));
+        CHECK(book.bids()[0].depth == 2);
+        CHECK(book.bids().size() == 3);
+
+        book.withdraw(0);
+        CHECK(book.bids()[0].depth == 1);
+        CHECK(book.bids()[0].venues.size() == 1);
+        CHECK(book.bids().size() == 2);
+        CHECK(book.offers()[0].venues[0].venue == 2);
+    }
+
+    SUBCASE("incremental merges agree with a full merge")
+    {
+        auto book    = trading::book_consolidator(3);
+        auto rng     = std::mt19937(11);
+        auto bids    = std::vector< std::vector< trading::price_depth > >(3);
+        auto offers  = std::vector< std::vector< trading::price_depth > >(3);
+        auto rebuild = [&](std::size_t v, std::map< int, int > const &levels, bool bid)
+        {
+            auto &l = bid ? bids[v] : offers[v];
+            l.clear();
+            for (auto [p, q] : levels)
+                l.push_back({ .price = trading::price_type(p), .depth = trading::qty_type(q) });
+            if (bid)
+                std::reverse(l.begin(), l.end());
+        };
+
+        auto bid_levels   = std::vector< std::map< int, int > >(3);
+        auto offer_levels = std::vector< std::map< int, int > >(3);
+        for (int i = 0; i < 500; ++i)
+        {
+            auto v   = std::size_t(rng() % 3);
+            auto bid = rng() % 2 == 0;
+            auto p   = int(rng() % 20);
+            auto q   = int(rng() % 4);
+            auto &m  = bid ? bid_levels[v] : offer_levels[v];
+            if (q)
+                m[bid ? 100 - p : 101 + p] = q;
+            else
+                m.erase(bid ? 100 - p : 101 + p);
+            rebuild(v, m, bid);
+
+            book.update(v, bids[v], offers[v]);
+            REQUIRE(same(book.bids(), merge_all< std::greater<> >(bids)));
+            REQUIRE(same(book.offers(), merge_all< std::less<> >(offers)));
+        }
+    }
+}
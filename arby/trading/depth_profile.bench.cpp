@@ -0,0 +1,72 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "bench/bench.hpp"
+#include "trading/depth_profile.hpp"
+
+#include <array>
+
+using namespace arby;
+
+namespace
+{
+trading::depth_profile
+make_offers()
+{
+    auto profile = trading::depth_profile(trading::sell);
+    for (int i = 0; i < int(trading::depth_profile::default_levels); ++i)
+        profile.push_back(39629.5 + i * 0.5, 0.25 + (i % 7) * 0.5);
+    return profile;
+}
+}   // namespace
+
+// a change of quantity at a level in the middle of the profile
+ARBY_BENCHMARK("depth_profile/update")
+{
+    auto profile = make_offers();
+    auto i       = 0;
+    for (auto _ : state)
+        bench::do_not_optimize(profile.update(39629.5 + 8, 1 + (++i & 1)));
+}
+
+ARBY_BENCHMARK("depth_profile/cost_to_fill")
+{
+    auto profile = make_offers();
+    auto qty     = 10.0;
+    for (auto _ : state)
+    {
+        bench::do_not_optimize(profile.cost_to_fill(qty));
+        qty = qty < 40 ? qty + 1.5 : 0.5;
+    }
+}
+
+// the sizes a strategy might price on every snapshot
+ARBY_BENCHMARK("depth_profile/cost_to_fill_16_sizes")
+{
+    auto profile = make_offers();
+    auto qtys    = std::array< double, 16 >();
+    for (std::size_t i = 0; i < qtys.size(); ++i)
+        qtys[i] = 0.5 * double(1 << (i / 2));
+    auto out = std::array< trading::fill_estimate, 16 >();
+    for (auto _ : state)
+    {
+        profile.cost_to_fill(qtys, out);
+        bench::do_not_optimize(out);
+    }
+}
+
+// the price of profiling an aggregate_book which does not maintain one
+ARBY_BENCHMARK("depth_profile/from_ladder")
+{
+    auto ladder = trading::offer_ladder();
+    for (int i = 0; i < 100; ++i)
+        ladder.push_back({ .price = trading::price_type(39629 + i), .depth = trading::qty_type("0.25") });
+    for (auto _ : state)
+        bench::do_not_optimize(trading::depth_profile::from_ladder(trading::sell, ladder));
+}
@@ -0,0 +1,171 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "trading/depth_profile.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace arby::trading
+{
+depth_profile::depth_profile(side_type side, std::size_t max_levels)
+: side_(side)
+, max_levels_(max_levels)
+{
+    prices_.reserve(max_levels_);
+    qty_.reserve(max_levels_);
+    cum_qty_.reserve(max_levels_);
+    cum_notional_.reserve(max_levels_);
+}
+
+depth_profile
+depth_profile::from_ladder(side_type side, std::span< price_depth const > ladder, std::size_t max_levels)
+{
+    auto result = depth_profile(side, max_levels);
+    for (auto &level : ladder.first(std::min(ladder.size(), max_levels)))
+        result.push_back(to_double(level.price), to_double(level.depth));
+    return result;
+}
+
+void
+depth_profile::clear()
+{
+    prices_.clear();
+    qty_.clear();
+    cum_qty_.clear();
+    cum_notional_.clear();
+}
+
+void
+depth_profile::push_back(double price, double qty)
+{
+    if (full())
+        return;
+    assert(prices_.empty() || better(prices_.back(), price));
+    prices_.push_back(price);
+    qty_.push_back(qty);
+    cum_qty_.push_back(depth() + qty);
+    cum_notional_.push_back((cum_notional_.empty() ? 0 : cum_notional_.back()) + price * qty);
+}
+
+bool
+depth_profile::update(double price, double qty)
+{
+    auto i = find(price);
+    if (i < prices_.size() && prices_[i] == price)
+    {
+        if (qty > 0)
+        {
+            qty_[i] = qty;
+        }
+        else
+        {
+            auto was_full = full();
+            prices_.erase(prices_.begin() + i);
+            qty_.erase(qty_.begin() + i);
+            cum_qty_.pop_back();
+            cum_notional_.pop_back();
+            resum(i);
+            return !was_full;
+        }
+    }
+    else
+    {
+        // a new level: beyond the last of a full profile, it is of no interest
+        if (qty <= 0 || i == max_levels_)
+            return true;
+        if (full())
+        {
+            prices_.pop_back();
+            qty_.pop_back();
+        }
+        else
+        {
+            cum_qty_.push_back(0);
+            cum_notional_.push_back(0);
+        }
+        prices_.insert(prices_.begin() + i, price);
+        qty_.insert(qty_.begin() + i, qty);
+    }
+    resum(i);
+    return true;
+}
+
+fill_estimate
+depth_profile::cost_to_fill(double qty) const
+{
+    if (qty <= 0 || prices_.empty())
+        return {};
+
+    auto i = search_qty(qty);
+    if (i == prices_.size())
+        return { .qty = cum_qty_.back(), .cost = cum_notional_.back(), .worst_price = prices_.back() };
+
+    // whole levels before i, and part of level i
+    auto before_qty      = i ? cum_qty_[i - 1] : 0;
+    auto before_notional = i ? cum_notional_[i - 1] : 0;
+    return { .qty = qty, .cost = before_notional + (qty - before_qty) * prices_[i], .worst_price = prices_[i] };
+}
+
+void
+depth_profile::cost_to_fill(std::span< double const > qtys, std::span< fill_estimate > out) const
+{
+    assert(out.size() >= qtys.size());
+    for (std::size_t i = 0; i < qtys.size(); ++i)
+        out[i] = cost_to_fill(qtys[i]);
+}
+
+double
+depth_profile::qty_for_price_limit(double limit) const
+{
+    auto n = std::size_t(std::partition_point(prices_.begin(), prices_.end(), [&](double p) { return !better(limit, p); }) -
+                         prices_.begin());
+    return n ? cum_qty_[n - 1] : 0;
+}
+
+std::size_t
+depth_profile::find(double price) const
+{
+    return std::size_t(std::partition_point(prices_.begin(), prices_.end(), [&](double p) { return better(p, price); }) -
+                       prices_.begin());
+}
+
+std::size_t
+depth_profile::search_qty(double qty) const
+{
+    // lower_bound without a data-dependent branch, so that a batch of searches does not stall on mispredictions
+    auto n = cum_qty_.size();
+    if (n == 0)
+        return 0;
+    auto const *first = cum_qty_.data();
+    auto const *base  = first;
+    while (n > 1)
+    {
+        auto half = n / 2;
+        base      = base[half] < qty ? base + half : base;
+        n -= half;
+    }
+    return std::size_t(base - first) + (*base < qty);
+}
+
+void
+depth_profile::resum(std::size_t from)
+{
+    auto q = from ? cum_qty_[from - 1] : 0;
+    auto n = from ? cum_notional_[from - 1] : 0;
+    for (auto i = from; i < prices_.size(); ++i)
+    {
+        q += qty_[i];
+        n += prices_[i] * qty_[i];
+        cum_qty_[i]      = q;
+        cum_notional_[i] = n;
+    }
+}
+
+}   // namespace arby::trading
@@ -0,0 +1,173 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_ARBY_TRADING_DEPTH_PROFILE_HPP
+#define ARBY_ARBY_TRADING_DEPTH_PROFILE_HPP
+
+#include "trading/aggregate_book.hpp"
+#include "trading/types.hpp"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace arby::trading
+{
+
+/// @brief The outcome of sweeping one side of a book for a quantity.
+struct fill_estimate
+{
+    /// the quantity which the profile can fill, which is less than asked if it runs out
+    double qty = 0;
+
+    /// the notional cost of that quantity
+    double cost = 0;
+
+    /// the price of the last level touched, or 0 if nothing was filled
+    double worst_price = 0;
+
+    bool
+    complete(double wanted) const
+    {
+        return qty >= wanted;
+    }
+
+    /// the volume-weighted average price, or 0 if nothing was filled
+    double
+    vwap() const
+    {
+        return qty > 0 ? cost / qty : 0;
+    }
+};
+
+/// @brief Cumulative quantity and notional over the best levels of one side of a book, for sweep queries.
+///
+/// The profile holds up to max_levels levels, best first, with running totals of quantity and notional, so that
+/// cost-to-fill, VWAP and quantity-within-a-price-limit are each a binary search. A level change costs a shift and a
+/// re-summation of the levels behind it. Values are doubles: the profile answers "about how much", and the book
+/// remains the record of exact prices and quantities.
+/// @note not thread-safe
+struct depth_profile
+{
+    static constexpr std::size_t default_levels = 32;
+
+    explicit depth_profile(side_type side, std::size_t max_levels = default_levels);
+
+    /// @brief Build the profile of a ladder, such as one side of an aggregate_book.
+    static depth_profile
+    from_ladder(side_type side, std::span< price_depth const > ladder, std::size_t max_levels = default_levels);
+
+    side_type
+    side() const
+    {
+        return side_;
+    }
+
+    std::size_t
+    max_levels() const
+    {
+        return max_levels_;
+    }
+
+    std::size_t
+    levels() const
+    {
+        return prices_.size();
+    }
+
+    bool
+    full() const
+    {
+        return prices_.size() == max_levels_;
+    }
+
+    /// @brief The total quantity in the profile.
+    double
+    depth() const
+    {
+        return cum_qty_.empty() ? 0 : cum_qty_.back();
+    }
+
+    double
+    price(std::size_t level) const
+    {
+        return prices_[level];
+    }
+
+    double
+    qty(std::size_t level) const
+    {
+        return qty_[level];
+    }
+
+    void
+    clear();
+
+    /// @brief Append a level which is worse than all others. Ignored once the profile is full.
+    void
+    push_back(double price, double qty);
+
+    /// @brief Set the quantity at a price. A quantity of 0 removes the level.
+    ///
+    /// A level worse than the worst held by a full profile is ignored.
+    /// @return false if a level was removed from a full profile, which now lacks its last level. The owner must then
+    /// rebuild it from the book if the book has more levels.
+    bool
+    update(double price, double qty);
+
+    /// @brief The cost of sweeping qty from the best level.
+    fill_estimate
+    cost_to_fill(double qty) const;
+
+    /// @brief cost_to_fill for many quantities at once.
+    void
+    cost_to_fill(std::span< double const > qtys, std::span< fill_estimate > out) const;
+
+    /// @brief The VWAP of sweeping qty, or 0 if the profile is empty.
+    double
+    vwap(double qty) const
+    {
+        return cost_to_fill(qty).vwap();
+    }
+
+    /// @brief The quantity available at prices no worse than a limit: at or above it for bids, at or below for offers.
+    double
+    qty_for_price_limit(double limit) const;
+
+  private:
+    /// whether price a is better than price b on this side
+    bool
+    better(double a, double b) const
+    {
+        return side_ == buy ? a > b : a < b;
+    }
+
+    /// the first level which is not better than price
+    std::size_t
+    find(double price) const;
+
+    /// the first level whose cumulative quantity reaches qty
+    std::size_t
+    search_qty(double qty) const;
+
+    void
+    resum(std::size_t from);
+
+    side_type   side_;
+    std::size_t max_levels_;
+
+    std::vector< double > prices_;
+    std::vector< double > qty_;
+    std::vector< double > cum_qty_;
+    std::vector< double > cum_notional_;
+};
+
+}   // namespace arby::trading
+
+#endif   // ARBY_ARBY_TRADING_DEPTH_PROFILE_HPP
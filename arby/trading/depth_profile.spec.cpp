@@ -0,0 +1,162 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+#include "trading/depth_profile.hpp"
+
+#include <doctest/doctest.h>
+
+#include <array>
+#include <functional>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace arby;
+
+namespace
+{
+/// offers of 1 at 100, 2 at 101 and 3 at 102
+trading::depth_profile
+make_offers(std::size_t max_levels = trading::depth_profile::default_levels)
+{
+    auto profile = trading::depth_profile(trading::sell, max_levels);
+    profile.push_back(100, 1);
+    profile.push_back(101, 2);
+    profile.push_back(102, 3);
+    return profile;
+}
+}   // namespace
+
+TEST_CASE("trading::depth_profile")
+{
+    SUBCASE("cost to fill")
+    {
+        auto profile = make_offers();
+        CHECK(profile.depth() == 6);
+
+        auto part = profile.cost_to_fill(0.5);
+        CHECK(part.qty == 0.5);
+        CHECK(part.cost == 50);
+        CHECK(part.worst_price == 100);
+
+        auto two = profile.cost_to_fill(2);
+        CHECK(two.cost == 201);
+        CHECK(two.worst_price == 101);
+        CHECK(two.vwap() == 100.5);
+
+        // exactly the depth of the first two levels does not touch the third
+        CHECK(profile.cost_to_fill(3).worst_price == 101);
+
+        auto too_much = profile.cost_to_fill(10);
+        CHECK(too_much.qty == 6);
+        CHECK(too_much.cost == 100 + 202 + 306);
+        CHECK(!too_much.complete(10));
+
+        CHECK(profile.cost_to_fill(0).qty == 0);
+        CHECK(trading::depth_profile(trading::buy).cost_to_fill(1).qty == 0);
+    }
+
+    SUBCASE("many sizes at once")
+    {
+        auto profile = make_offers();
+        auto qtys    = std::array< double, 6 > { 0.5, 1, 2.5, 3, 6, 7 };
+        auto out     = std::array< trading::fill_estimate, 6 >();
+        profile.cost_to_fill(qtys, out);
+        for (std::size_t i = 0; i < qtys.size(); ++i)
+        {
+            CHECK(out[i].qty == profile.cost_to_fill(qtys[i]).qty);
+            CHECK(out[i].cost == profile.cost_to_fill(qtys[i]).cost);
+        }
+    }
+
+    SUBCASE("quantity within a price limit")
+    {
+        auto offers = make_offers();
+        CHECK(offers.qty_for_price_limit(99) == 0);
+        CHECK(offers.qty_for_price_limit(101) == 3);
+        CHECK(offers.qty_for_price_limit(101.5) == 3);
+        CHECK(offers.qty_for_price_limit(200) == 6);
+
+        auto bids = trading::depth_profile(trading::buy);
+        bids.push_back(99, 1);
+        bids.push_back(98, 2);
+        CHECK(bids.qty_for_price_limit(99) == 1);
+        CHECK(bids.qty_for_price_limit(97) == 3);
+        CHECK(bids.qty_for_price_limit(100) == 0);
+    }
+
+    SUBCASE("updates")
+    {
+        auto profile = make_offers(3);
+        CHECK(profile.full());
+
+        CHECK(profile.update(101, 5));
+        CHECK(profile.depth() == 9);
+        CHECK(profile.cost_to_fill(6).cost == 100 + 505);
+
+        // a better level pushes the worst out
+        CHECK(profile.update(99.5, 1));
+        CHECK(profile.levels() == 3);
+        CHECK(profile.price(2) == 101);
+        CHECK(profile.depth() == 7);
+
+        // a level beyond the last is ignored
+        CHECK(profile.update(150, 1));
+        CHECK(profile.depth() == 7);
+
+        // removing a level from a full profile asks for a rebuild
+        CHECK(!profile.update(100, 0));
+        CHECK(profile.levels() == 2);
+        CHECK(profile.cost_to_fill(6).cost == 99.5 + 505);
+
+        // which a profile with room does not
+        CHECK(profile.update(99.5, 0));
+        CHECK(profile.update(120, 0));
+        CHECK(profile.levels() == 1);
+    }
+
+    SUBCASE("from a ladder")
+    {
+        auto ladder = trading::bid_ladder();
+        for (int i = 0; i < 40; ++i)
+            ladder.push_back({ .price = trading::price_type(1000 - i), .depth = trading::qty_type("0.5") });
+        auto profile = trading::depth_profile::from_ladder(trading::buy, ladder);
+        CHECK(profile.levels() == trading::depth_profile::default_levels);
+        CHECK(profile.depth() == 16);
+        CHECK(profile.qty_for_price_limit(990) == 5.5);
+    }
+
+    SUBCASE("incremental updates agree with a rebuild")
+    {
+        auto rng     = std::mt19937(3);
+        auto profile = trading::depth_profile(trading::buy, 8);
+        auto ladder  = std::map< double, double, std::greater<> >();
+        for (int i = 0; i < 1000; ++i)
+        {
+            auto price = double(100 - int(rng() % 12));
+            auto qty   = double(rng() % 3);
+            if (qty > 0)
+                ladder[price] = qty;
+            else
+                ladder.erase(price);
+            if (!profile.update(price, qty))
+            {
+                profile.clear();
+                for (auto [p, q] : ladder)
+                    profile.push_back(p, q);
+            }
+
+            auto expected = trading::depth_profile(trading::buy, 8);
+            for (auto [p, q] : ladder)
+                expected.push_back(p, q);
+            REQUIRE(profile.levels() == expected.levels());
+            for (auto q : { 1.0, 2.5, 7.0, 100.0 })
+                REQUIRE(profile.cost_to_fill(q).cost == expected.cost_to_fill(q).cost);
+        }
+    }
+}
@@ -0,0 +1,59 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "bench/bench.hpp"
+#include "trading/fast_clock.hpp"
+
+#include <chrono>
+
+using namespace arby;
+
+ARBY_BENCHMARK("fast_clock/now")
+{
+    for (auto _ : state)
+        bench::do_not_optimize(trading::fast_clock::now());
+}
+
+ARBY_BENCHMARK("fast_clock/to_timestamp")
+{
+    auto tp = trading::fast_clock::now();
+    for (auto _ : state)
+        bench::do_not_optimize(trading::fast_clock::to_timestamp(tp));
+}
+
+ARBY_BENCHMARK("fast_clock/calibrate")
+{
+    for (auto _ : state)
+        trading::fast_clock::calibrate();
+}
+
+// the clocks which fast_clock replaces on the hot path, for comparison
+ARBY_BENCHMARK("fast_clock/system_clock_now")
+{
+    for (auto _ : state)
+        bench::do_not_optimize(std::chrono::system_clock::now());
+}
+
+ARBY_BENCHMARK("fast_clock/steady_clock_now")
+{
+    for (auto _ : state)
+        bench::do_not_optimize(std::chrono::steady_clock::now());
+}
+
+#if defined(__linux__)
+ARBY_BENCHMARK("fast_clock/monotonic_coarse")
+{
+    for (auto _ : state)
+    {
+        auto ts = timespec();
+        ::clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        bench::do_not_optimize(ts);
+    }
+}
+#endif
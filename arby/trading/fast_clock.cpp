@@ -0,0 +1,262 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "fast_clock.hpp"
+
+#include <atomic>
+#include <limits>
+#include <mutex>
+
+#ifdef ARBY_FAST_CLOCK_TSC
+#include <cpuid.h>
+#endif
+
+namespace arby::trading
+{
+namespace
+{
+    using namespace std::literals;
+
+    std::int64_t
+    clock_ns([[maybe_unused]] int id)
+    {
+#if defined(__linux__)
+        auto ts = timespec();
+        ::clock_gettime(id, &ts);
+        return std::int64_t(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+#else
+        return std::chrono::duration_cast< std::chrono::nanoseconds >(std::chrono::system_clock::now().time_since_epoch())
+            .count();
+#endif
+    }
+
+    /// Readings of the fast clock and the system clocks, taken as close together as possible.
+    struct sample
+    {
+        std::uint64_t ticks;
+        std::int64_t  realtime_ns;
+        std::int64_t  monotonic_ns;
+    };
+
+    std::uint64_t
+    ordered_ticks()
+    {
+#ifdef ARBY_FAST_CLOCK_TSC
+        // rdtscp waits for earlier instructions, so the reading cannot drift into the clock_gettime call
+        if (fast_clock::uses_tsc())
+        {
+            unsigned aux;
+            return __rdtscp(&aux);
+        }
+#endif
+        return fast_clock::now().ticks;
+    }
+
+    sample
+    take_sample()
+    {
+        // keep the narrowest of a few attempts: a wide one has been interrupted
+        auto best  = sample {};
+        auto width = std::numeric_limits< std::uint64_t >::max();
+        for (int i = 0; i < 5; ++i)
+        {
+            auto before = ordered_ticks();
+#if defined(__linux__)
+            auto mono = clock_ns(CLOCK_MONOTONIC_RAW);
+            auto real = clock_ns(CLOCK_REALTIME);
+#else
+            auto mono = clock_ns(0);
+            auto real = mono;
+#endif
+            auto after = ordered_ticks();
+            if (after - before < width)
+            {
+                width = after - before;
+                best  = sample { before + (after - before) / 2, real, mono };
+            }
+        }
+        return best;
+    }
+
+    /// The conversion from ticks to wall-clock time. One writer at a time, under the mutex; readers use the seqlock.
+    struct calibration
+    {
+        calibration()
+        : anchor(take_sample())
+        {
+            if (!fast_clock::uses_tsc())
+            {
+                // the coarse clock already counts nanoseconds
+                publish(anchor, 1.0);
+                return;
+            }
+
+            // an initial rate, good enough until the first recalibration
+            auto s = anchor;
+            while (s.monotonic_ns - anchor.monotonic_ns < std::chrono::nanoseconds(2ms).count() || s.ticks == anchor.ticks)
+                s = take_sample();
+            publish(s, rate(s));
+        }
+
+        double
+        rate(sample const &s) const
+        {
+            // measured against the monotonic clock since the anchor, so that steps in the wall clock do not skew it
+            return double(s.monotonic_ns - anchor.monotonic_ns) / double(s.ticks - anchor.ticks);
+        }
+
+        void
+        publish(sample const &s, double ns_per_tick)
+        {
+            auto seq = sequence.load(std::memory_order_relaxed);
+            sequence.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            base_ticks.store(s.ticks, std::memory_order_relaxed);
+            base_ns.store(s.realtime_ns, std::memory_order_relaxed);
+            rate_.store(ns_per_tick, std::memory_order_relaxed);
+            sequence.store(seq + 2, std::memory_order_release);
+        }
+
+        void
+        recalibrate()
+        {
+            auto lock = std::unique_lock(m);
+            auto s    = take_sample();
+            if (!fast_clock::uses_tsc())
+                publish(s, 1.0);
+            else if (s.ticks > anchor.ticks)
+                publish(s, rate(s));
+        }
+
+        struct params
+        {
+            std::uint64_t ticks;
+            std::int64_t  ns;
+            double        ns_per_tick;
+        };
+
+        params
+        read() const
+        {
+            for (;;)
+            {
+                auto seq1 = sequence.load(std::memory_order_acquire);
+                auto p    = params { base_ticks.load(std::memory_order_relaxed),
+                                  base_ns.load(std::memory_order_relaxed),
+                                  rate_.load(std::memory_order_relaxed) };
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (!(seq1 & 1) && sequence.load(std::memory_order_relaxed) == seq1) [[likely]]
+                    return p;
+            }
+        }
+
+        std::mutex m;
+        sample     anchor;
+
+        std::atomic< std::uint32_t > sequence { 0 };
+        std::atomic< std::uint64_t > base_ticks { 0 };
+        std::atomic< std::int64_t >  base_ns { 0 };
+        std::atomic< double >        rate_ { 1.0 };
+    };
+
+    calibration &
+    current()
+    {
+        static calibration c;
+        return c;
+    }
+
+    std::int64_t
+    ticks_to_ns(std::int64_t ticks, double ns_per_tick)
+    {
+        return std::int64_t(double(ticks) * ns_per_tick);
+    }
+}   // namespace
+
+bool
+fast_clock::detect_tsc() noexcept
+{
+#ifdef ARBY_FAST_CLOCK_TSC
+    // invariant TSC: constant rate across frequency changes and deep sleep states
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007)
+        return false;
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+        return false;
+    return (edx & (1u << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+timestamp_type
+fast_clock::to_timestamp(time_point tp) noexcept
+{
+    auto p  = current().read();
+    auto ns = p.ns + ticks_to_ns(std::int64_t(tp.ticks - p.ticks), p.ns_per_tick);
+    return timestamp_type(std::chrono::duration_cast< timestamp_type::duration >(std::chrono::nanoseconds(ns)));
+}
+
+std::chrono::nanoseconds
+fast_clock::between(time_point from, time_point to) noexcept
+{
+    auto p = current().read();
+    return std::chrono::nanoseconds(ticks_to_ns(std::int64_t(to.ticks - from.ticks), p.ns_per_tick));
+}
+
+void
+fast_clock::calibrate()
+{
+    current().recalibrate();
+}
+
+struct fast_clock_calibrator::impl : std::enable_shared_from_this< impl >
+{
+    impl(asio::any_io_executor exec, std::chrono::milliseconds interval)
+    : timer(std::move(exec))
+    , interval(interval)
+    {
+    }
+
+    void
+    arm()
+    {
+        timer.expires_after(interval);
+        timer.async_wait(
+            [weak = weak_from_this()](error_code ec)
+            {
+                if (ec)
+                    return;
+                if (auto self = weak.lock())
+                {
+                    fast_clock::calibrate();
+                    self->arm();
+                }
+            });
+    }
+
+    asio::steady_timer        timer;
+    std::chrono::milliseconds interval;
+};
+
+fast_clock_calibrator::fast_clock_calibrator(asio::any_io_executor exec, std::chrono::milliseconds interval)
+: impl_(std::make_shared< impl >(std::move(exec), interval))
+{
+    // take the first calibration now rather than on the first hot-path conversion
+    fast_clock::calibrate();
+    asio::dispatch(impl_->timer.get_executor(), [impl = impl_] { impl->arm(); });
+}
+
+fast_clock_calibrator::~fast_clock_calibrator()
+{
+    auto exec = impl_->timer.get_executor();
+    asio::dispatch(exec, [impl = std::move(impl_)] { impl->timer.cancel(); });
+}
+
+}   // namespace arby::trading
@@ -0,0 +1,122 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_ARBY_TRADING_FAST_CLOCK_HPP
+#define ARBY_ARBY_TRADING_FAST_CLOCK_HPP
+
+#include "config/asio.hpp"
+#include "trading/types.hpp"
+
+#include <chrono>
+#include <compare>
+#include <cstdint>
+#include <memory>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define ARBY_FAST_CLOCK_TSC 1
+#include <x86intrin.h>
+#endif
+
+#if defined(__linux__)
+#include <time.h>
+#endif
+
+namespace arby::trading
+{
+
+/// @brief A cheap clock for hot-path timestamps.
+///
+/// On x86-64 Linux with an invariant TSC, now() is a single rdtsc. Elsewhere it reads CLOCK_MONOTONIC_COARSE, or the
+/// steady clock where there is no coarse clock. Either way a time_point is a raw counter value, which is converted to
+/// wall-clock time only when it is needed, for display, by to_timestamp().
+///
+/// Conversion uses the latest calibration against CLOCK_REALTIME, which is published through a seqlock so that
+/// conversion never blocks. The first calibration is taken at first use. Keep a fast_clock_calibrator alive to follow
+/// adjustments to the wall clock.
+struct fast_clock
+{
+    struct time_point
+    {
+        std::uint64_t ticks = 0;
+
+        auto
+        operator<=>(time_point const &) const = default;
+    };
+
+    /// @note thread-safe
+    static time_point
+    now() noexcept
+    {
+#ifdef ARBY_FAST_CLOCK_TSC
+        if (uses_tsc()) [[likely]]
+            return time_point { __rdtsc() };
+#endif
+        return time_point { coarse_ticks() };
+    }
+
+    /// @brief Whether time points are TSC readings. Decided once, at first use.
+    static bool
+    uses_tsc() noexcept
+    {
+        static const bool tsc = detect_tsc();
+        return tsc;
+    }
+
+    /// @brief Convert to wall-clock time. Thread-safe and lock-free.
+    static timestamp_type
+    to_timestamp(time_point tp) noexcept;
+
+    /// @brief The time elapsed from one time point to another. Negative if the second is earlier.
+    static std::chrono::nanoseconds
+    between(time_point from, time_point to) noexcept;
+
+    /// @brief Take a fresh calibration against CLOCK_REALTIME and publish it. Thread-safe.
+    static void
+    calibrate();
+
+  private:
+    static bool
+    detect_tsc() noexcept;
+
+    static std::uint64_t
+    coarse_ticks() noexcept
+    {
+#if defined(__linux__)
+        auto ts = timespec();
+        ::clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return std::uint64_t(ts.tv_sec) * 1'000'000'000 + std::uint64_t(ts.tv_nsec);
+#else
+        return std::chrono::duration_cast< std::chrono::nanoseconds >(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+#endif
+    }
+};
+
+/// @brief Recalibrates the fast_clock at intervals, on an executor, until destroyed.
+struct fast_clock_calibrator
+{
+    static constexpr std::chrono::seconds default_interval { 1 };
+
+    explicit fast_clock_calibrator(asio::any_io_executor exec, std::chrono::milliseconds interval = default_interval);
+
+    fast_clock_calibrator(fast_clock_calibrator const &) = delete;
+    fast_clock_calibrator &
+    operator=(fast_clock_calibrator const &) = delete;
+
+    ~fast_clock_calibrator();
+
+  private:
+    struct impl;
+    std::shared_ptr< impl > impl_;
+};
+
+}   // namespace arby::trading
+
+#endif   // ARBY_ARBY_TRADING_FAST_CLOCK_HPP
@@ -0,0 +1,63 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "trading/fast_clock.hpp"
+
+#include <doctest/doctest.h>
+
+#include <thread>
+
+using namespace arby;
+using namespace std::literals;
+
+TEST_SUITE("trading")
+{
+    TEST_CASE("fast_clock")
+    {
+        using trading::fast_clock;
+        MESSAGE("fast_clock uses " << (fast_clock::uses_tsc() ? "the TSC" : "the coarse clock"));
+
+        auto t0 = fast_clock::now();
+        std::this_thread::sleep_for(20ms);
+        auto t1 = fast_clock::now();
+        CHECK(t0 <= t1);
+
+        // the coarse clock may be a few milliseconds behind
+        auto elapsed = fast_clock::between(t0, t1);
+        CHECK(elapsed > 10ms);
+        CHECK(elapsed < 200ms);
+        CHECK(fast_clock::between(t1, t0) == -elapsed);
+
+        auto wall  = std::chrono::system_clock::now();
+        auto fast  = fast_clock::to_timestamp(fast_clock::now());
+        auto error = wall > fast ? wall - fast : fast - wall;
+        CHECK(error < 50ms);
+
+        fast_clock::calibrate();
+        auto recal = fast_clock::to_timestamp(t1);
+        auto drift = recal > fast ? recal - fast : fast - recal;
+        CHECK(drift < 50ms);
+    }
+
+    TEST_CASE("fast_clock_calibrator")
+    {
+        auto ioc = asio::io_context();
+        {
+            auto calibrator = trading::fast_clock_calibrator(ioc.get_executor(), 5ms);
+            ioc.run_for(30ms);
+        }
+        // destroying the calibrator cancels its timer, so the context runs out of work
+        ioc.restart();
+        ioc.run();
+        auto wall  = std::chrono::system_clock::now();
+        auto fast  = trading::fast_clock::to_timestamp(trading::fast_clock::now());
+        auto error = wall > fast ? wall - fast : fast - wall;
+        CHECK(error < 50ms);
+    }
+}
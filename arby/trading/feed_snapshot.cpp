@@ -26,7 +26,7 @@ feed_snapshot::print(std::ostream &os) const
                "[condition {}][source {}][timestamp {}][upstream_time {}]",
                this->condition,
                source,
-               this->timestamp,
+               fast_clock::to_timestamp(this->timestamp),
                this->upstream_time);
     this->print_impl(os);
     fmt::print(os, "[parents {}]", this->parents_);
@@ -10,7 +10,9 @@
 #ifndef ARBY_ARBY_TRADING_FEED_SNAPSHOT_HPP
 #define ARBY_ARBY_TRADING_FEED_SNAPSHOT_HPP
 
+#include "trading/fast_clock.hpp"
 #include "trading/feed_condition.hpp"
+#include "util/free_list.hpp"
 
 #include <memory>
 
@@ -19,7 +21,8 @@ namespace arby
 namespace trading
 {
 
-struct feed_snapshot
+/// @note Snapshots derive from free_list_hook so that their producers can recycle them through a util::free_list.
+struct feed_snapshot : util::free_list_hook
 {
     /// @brief The current condition of the entity producing the snapshot
     feed_condition condition;
@@ -27,11 +30,11 @@ struct feed_snapshot
     /// @brief The identity of the entity producing the snapshot
     std::string source;
 
-    /// @brief The time the snapshot was constructed
-    trading::timestamp_type timestamp = std::chrono::system_clock::now();
+    /// @brief The time the snapshot was constructed. Convert with fast_clock::to_timestamp for display.
+    fast_clock::time_point timestamp = fast_clock::now();
 
     /// @brief The time of construction of the upstream data
-    trading::timestamp_type upstream_time = std::chrono::system_clock::now();
+    trading::timestamp_type upstream_time = {};
 
     /// @brief a collection of snapshots that were used to construct this snapshot
     std::vector< std::shared_ptr< feed_snapshot const > > parents_ = {};
@@ -0,0 +1,136 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "instrument_registry.hpp"
+
+#include <fmt/format.h>
+
+#include <stdexcept>
+
+namespace arby::trading
+{
+
+instrument_registry &
+instrument_registry::instance()
+{
+    static instrument_registry registry;
+    return registry;
+}
+
+instrument_registry::~instrument_registry()
+{
+    for (auto &chunk : chunks_)
+        delete[] chunk.load(std::memory_order_relaxed);
+}
+
+instrument const &
+instrument_registry::add(market_key const &market)
+{
+    auto name = to_string(market);
+    auto lock = std::unique_lock(m_);
+    return add_locked(market, std::move(name));
+}
+
+venue_listing const &
+instrument_registry::list(std::string_view venue, market_key const &market, instrument_spec spec)
+{
+    auto  name = to_string(market);
+    auto  lock = std::unique_lock(m_);
+    auto &inst = add_locked(market, std::move(name));
+    if (spec.native_symbol.empty())
+        spec.native_symbol = inst.name;
+
+    auto key = std::make_tuple(std::string(venue), inst.id);
+    if (auto i = listings_.find(key); i != listings_.end())
+    {
+        if (i->second.native_symbol != spec.native_symbol)
+            throw std::invalid_argument(fmt::format("instrument_registry: {} is listed on {} as {}, not {}",
+                                                    inst.name,
+                                                    venue,
+                                                    i->second.native_symbol,
+                                                    spec.native_symbol));
+        return i->second;
+    }
+
+    auto [owner, inserted] =
+        by_native_symbol_.emplace(std::make_tuple(std::string(venue), spec.native_symbol), inst.id);
+    if (!inserted)
+        throw std::invalid_argument(fmt::format("instrument_registry: {} on {} is already taken by {}",
+                                                spec.native_symbol,
+                                                venue,
+                                                (*this)[owner->second].name));
+
+    auto &listing         = listings_[key];
+    listing.id            = inst.id;
+    listing.venue         = std::string(venue);
+    listing.native_symbol = std::move(spec.native_symbol);
+    listing.tick_size     = std::move(spec.tick_size);
+    listing.lot_size      = std::move(spec.lot_size);
+    return listing;
+}
+
+instrument const &
+instrument_registry::add_locked(market_key const &market, std::string name)
+{
+    if (auto i = by_name_.find(name); i != by_name_.end())
+        return (*this)[i->second];
+
+    auto id = size_.load(std::memory_order_relaxed);
+    if (id == max_instruments)
+        throw std::length_error(fmt::format("instrument_registry: no room for {}", name));
+
+    auto &chunk = chunks_[id / chunk_size];
+    auto *slots = chunk.load(std::memory_order_relaxed);
+    if (!slots)
+    {
+        slots = new instrument[chunk_size];
+        chunk.store(slots, std::memory_order_release);
+    }
+
+    auto &inst  = slots[id % chunk_size];
+    inst.id     = instrument_id(id);
+    inst.market = market;
+    inst.name   = std::move(name);
+
+    by_name_.emplace(inst.name, inst.id);
+    // publishes the instrument to lock-free readers
+    size_.store(id + 1, std::memory_order_release);
+    return inst;
+}
+
+instrument const *
+instrument_registry::find(std::string_view name) const
+{
+    auto lock = std::unique_lock(m_);
+    if (auto i = by_name_.find(std::string(name)); i != by_name_.end())
+        return &(*this)[i->second];
+    return nullptr;
+}
+
+venue_listing const *
+instrument_registry::find_listing(std::string_view venue, instrument_id id) const
+{
+    auto lock = std::unique_lock(m_);
+    if (auto i = listings_.find(std::make_tuple(std::string(venue), id)); i != listings_.end())
+        return &i->second;
+    return nullptr;
+}
+
+std::vector< venue_listing >
+instrument_registry::listings() const
+{
+    auto lock   = std::unique_lock(m_);
+    auto result = std::vector< venue_listing >();
+    result.reserve(listings_.size());
+    for (auto &[key, listing] : listings_)
+        result.push_back(listing);
+    return result;
+}
+
+}   // namespace arby::trading
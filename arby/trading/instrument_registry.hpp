@@ -0,0 +1,213 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_ARBY_TRADING_INSTRUMENT_REGISTRY_HPP
+#define ARBY_ARBY_TRADING_INSTRUMENT_REGISTRY_HPP
+
+#include "trading/market_key.hpp"
+#include "trading/types.hpp"
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace arby::trading
+{
+
+/// @brief A dense index for a market, assigned in order of registration from 0.
+using instrument_id = std::uint32_t;
+
+/// @brief What a venue knows about a market when it lists it.
+struct instrument_spec
+{
+    /// the venue's name for the market. If empty, the market's canonical name is used
+    std::string native_symbol;
+
+    /// the smallest price increment, or 0 if not known
+    price_type tick_size = 0;
+
+    /// the smallest quantity increment, or 0 if not known
+    qty_type lot_size = 0;
+};
+
+/// @brief A registered market, with everything derived from its key computed once.
+struct instrument
+{
+    instrument_id id = 0;
+    market_key    market;
+    std::string   name;
+};
+
+/// @brief A market as listed on one venue.
+struct venue_listing
+{
+    instrument_id id = 0;
+    std::string   venue;
+    std::string   native_symbol;
+    price_type    tick_size = 0;
+    qty_type      lot_size  = 0;
+};
+
+/// @brief Assigns each market a dense instrument_id, for use as an index into per-instrument tables, and keeps each
+/// venue's listing of it.
+///
+/// Registration takes a lock. Lookup by id does not: instruments are stored in fixed chunks which are never moved, so
+/// a reference to an instrument remains valid for the life of the registry. So does a reference to a listing.
+/// @note thread-safe
+struct instrument_registry
+{
+    static constexpr std::size_t chunk_size      = 1024;
+    static constexpr std::size_t max_chunks      = 64;
+    static constexpr std::size_t max_instruments = chunk_size * max_chunks;
+
+    /// @brief The process-wide registry.
+    static instrument_registry &
+    instance();
+
+    instrument_registry() = default;
+
+    instrument_registry(instrument_registry const &) = delete;
+    instrument_registry &
+    operator=(instrument_registry const &) = delete;
+
+    ~instrument_registry();
+
+    /// @brief Register a market, or find its existing registration.
+    /// @throws std::length_error if the registry is full
+    instrument const &
+    add(market_key const &market);
+
+    /// @brief List a market on a venue, registering the market if need be, or find its existing listing.
+    /// @throws std::invalid_argument if the market is already listed on the venue under another native symbol, or if
+    /// the native symbol is already taken on the venue by another market
+    /// @throws std::length_error if the registry is full
+    venue_listing const &
+    list(std::string_view venue, market_key const &market, instrument_spec spec = {});
+
+    /// @brief Find a registered market by its canonical name, as produced by to_string(market_key).
+    /// @return the instrument, or nullptr if the market has not been registered
+    instrument const *
+    find(std::string_view name) const;
+
+    instrument const *
+    find(market_key const &market) const
+    {
+        return find(to_string(market));
+    }
+
+    /// @return the listing of an instrument on a venue, or nullptr if it is not listed there
+    venue_listing const *
+    find_listing(std::string_view venue, instrument_id id) const;
+
+    /// @brief A copy of every listing, ordered by venue and then by id.
+    std::vector< venue_listing >
+    listings() const;
+
+    /// @brief The instrument with an id which has been returned by add().
+    instrument const &
+    operator[](instrument_id id) const
+    {
+        assert(id < size());
+        return chunks_[id / chunk_size].load(std::memory_order_acquire)[id % chunk_size];
+    }
+
+    /// @brief The number of registered instruments. Ids below this are valid.
+    std::size_t
+    size() const
+    {
+        return size_.load(std::memory_order_acquire);
+    }
+
+  private:
+    instrument const &
+    add_locked(market_key const &market, std::string name);
+
+    std::array< std::atomic< instrument * >, max_chunks > chunks_ {};
+    std::atomic< std::size_t >                            size_ { 0 };
+
+    mutable std::mutex                                                  m_;
+    std::unordered_map< std::string, instrument_id >                    by_name_;
+    std::map< std::tuple< std::string, instrument_id >, venue_listing > listings_;
+    std::map< std::tuple< std::string, std::string >, instrument_id >   by_native_symbol_;
+};
+
+/// @brief Per-instrument state held in an array indexed by instrument_id. Grows to fit the ids it is given.
+/// @note not thread-safe. A table is owned by one executor, like the state it holds.
+template < class T >
+struct instrument_table
+{
+    using value_type = T;
+
+    /// @brief The entry for an instrument, default constructed if it has not been touched before.
+    T &
+    operator[](instrument_id id)
+    {
+        if (id >= values_.size())
+            values_.resize(std::size_t(id) + 1);
+        return values_[id];
+    }
+
+    /// @return the entry for an instrument, or nullptr if the table has never held one for it
+    T const *
+    find(instrument_id id) const
+    {
+        return id < values_.size() ? &values_[id] : nullptr;
+    }
+
+    T *
+    find(instrument_id id)
+    {
+        return id < values_.size() ? &values_[id] : nullptr;
+    }
+
+    std::size_t
+    size() const
+    {
+        return values_.size();
+    }
+
+    auto
+    begin()
+    {
+        return values_.begin();
+    }
+
+    auto
+    end()
+    {
+        return values_.end();
+    }
+
+    auto
+    begin() const
+    {
+        return values_.begin();
+    }
+
+    auto
+    end() const
+    {
+        return values_.end();
+    }
+
+  private:
+    std::vector< T > values_;
+};
+
+}   // namespace arby::trading
+
+#endif   // ARBY_ARBY_TRADING_INSTRUMENT_REGISTRY_HPP
@@ -0,0 +1,119 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "trading/instrument_registry.hpp"
+
+#include <doctest/doctest.h>
+
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace arby;
+
+TEST_SUITE("trading")
+{
+    TEST_CASE("instrument_registry")
+    {
+        auto reg = trading::instrument_registry();
+
+        auto &eth = reg.add(trading::spot_key("eth/usd"));
+        auto &btc = reg.add(trading::spot_key("BTC/usd"));
+        CHECK(eth.id == 0);
+        CHECK(btc.id == 1);
+        CHECK(eth.name == "eth/usd");
+
+        // registering again finds the first registration
+        CHECK(&reg.add(trading::spot_key("eth/usd")) == &eth);
+        CHECK(reg.size() == 2);
+
+        CHECK(&reg[1] == &btc);
+        CHECK(reg.find("btc/usd") == &btc);
+        CHECK(reg.find(trading::market_key(trading::spot_key("eth/usd"))) == &eth);
+        CHECK(reg.find("xrp/usd") == nullptr);
+    }
+
+    TEST_CASE("instrument_registry listings")
+    {
+        auto reg = trading::instrument_registry();
+
+        auto &a = reg.list("a",
+                           trading::spot_key("eth/usd"),
+                           trading::instrument_spec { .native_symbol = "ETH-USD",
+                                                      .tick_size     = trading::price_type("0.01"),
+                                                      .lot_size      = trading::qty_type("0.001") });
+        auto &b = reg.list("b", trading::spot_key("eth/usd"), trading::instrument_spec { .native_symbol = "ETH/USD" });
+        auto &c = reg.list("b", trading::spot_key("btc/usd"));
+
+        // each venue keeps its own symbol for the same instrument
+        CHECK(reg.size() == 2);
+        CHECK(a.id == 0);
+        CHECK(b.id == 0);
+        CHECK(a.native_symbol == "ETH-USD");
+        CHECK(a.tick_size == trading::price_type("0.01"));
+        CHECK(b.native_symbol == "ETH/USD");
+        CHECK(b.lot_size == 0);
+        CHECK(c.native_symbol == "btc/usd");
+
+        CHECK(&reg.list("a", trading::spot_key("eth/usd"), trading::instrument_spec { .native_symbol = "ETH-USD" }) == &a);
+        CHECK(reg.find_listing("a", 0) == &a);
+        CHECK(reg.find_listing("a", 1) == nullptr);
+        CHECK(reg.find_listing("c", 0) == nullptr);
+
+        // a venue may not rename a listing, nor give one symbol to two markets
+        CHECK_THROWS_AS(reg.list("a", trading::spot_key("eth/usd"), trading::instrument_spec { .native_symbol = "ETHUSD" }),
+                        std::invalid_argument);
+        CHECK_THROWS_AS(reg.list("a", trading::spot_key("btc/usd"), trading::instrument_spec { .native_symbol = "ETH-USD" }),
+                        std::invalid_argument);
+        CHECK(reg.size() == 2);
+        CHECK(reg.find_listing("a", 1) == nullptr);
+
+        auto all = reg.listings();
+        REQUIRE(all.size() == 3);
+        CHECK(all[0].venue == "a");
+        CHECK(all[1].native_symbol == "ETH/USD");
+        CHECK(all[2].native_symbol == "btc/usd");
+    }
+
+    TEST_CASE("instrument_registry keeps references across chunks")
+    {
+        auto  reg   = trading::instrument_registry();
+        auto &first = reg.add(trading::spot_key("a0/usd"));
+
+        auto writer = std::thread(
+            [&]
+            {
+                for (std::size_t i = 1; i < 3 * trading::instrument_registry::chunk_size; ++i)
+                    reg.add(trading::spot_key("a" + std::to_string(i) + "/usd"));
+            });
+        // lock-free readers see whatever has been published so far
+        for (auto seen = std::size_t(0); seen < 3 * trading::instrument_registry::chunk_size;)
+        {
+            seen = reg.size();
+            if (seen)
+                CHECK(reg[trading::instrument_id(seen - 1)].id == seen - 1);
+        }
+        writer.join();
+
+        CHECK(&reg[0] == &first);
+        CHECK(reg[2500].name == "a2500/usd");
+    }
+
+    TEST_CASE("instrument_table")
+    {
+        auto table = trading::instrument_table< int >();
+        CHECK(table.find(3) == nullptr);
+        table[3] = 7;
+        CHECK(table.size() == 4);
+        CHECK(*table.find(3) == 7);
+        CHECK(*table.find(0) == 0);
+        CHECK(table.find(4) == nullptr);
+    }
+}
@@ -9,6 +9,9 @@
 
 #include "trading/types.hpp"
 
+#include <array>
+#include <cmath>
+
 namespace arby::trading
 {
 std::ostream &
@@ -30,4 +33,29 @@ operator>>(std::istream &is, side_type &side)
     return is;
 }
 
+double
+to_double(price_type const &value)
+{
+    static constexpr int  table_bias = 32;
+    static constexpr auto powers     = []
+    {
+        auto result = std::array< double, 2 * table_bias + 1 >();
+        auto p      = 1.0;
+        for (int i = table_bias; i < int(result.size()); ++i, p *= 10)
+            result[i] = p;
+        p = 1.0;
+        for (int i = table_bias; i >= 0; --i, p *= 10)
+            result[i] = 1 / p;
+        return result;
+    }();
+
+    // a mantissa in [1, 10) and a decimal exponent, read straight from the limbs
+    auto mantissa = 0.0;
+    auto exponent = price_type::backend_type::exponent_type(0);
+    value.backend().extract_parts(mantissa, exponent);
+    if (exponent >= -table_bias && exponent <= table_bias)
+        return mantissa * powers[exponent + table_bias];
+    return mantissa * std::pow(10.0, double(exponent));
+}
+
 }   // namespace arby::trading
\ No newline at end of file
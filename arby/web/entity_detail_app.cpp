@@ -9,7 +9,10 @@
 
 #include "entity_detail_app.hpp"
 
+#include "entity/entity_base.hpp"
+
 #include <boost/algorithm/string.hpp>
+#include <fmt/format.h>
 
 namespace arby
 {
@@ -93,20 +96,29 @@ to_sha1_digest(std::string const &s)
 asio::awaitable< bool >
 entity_detail_app::operator()(tcp::socket &stream, http::request< http::string_body > &request, std::cmatch &match)
 {
-    /*
-    auto candidates = std::vector< std::shared_ptr< entity::entity_base > >();
-    auto sha_key    = match[1].str();
-    boost::algorithm::to_lower(sha_key);
+    using asio::use_awaitable;
+
+    // entities are not versioned yet, so a version suffix in match[2] resolves to the live entity
+    auto handle = std::shared_ptr< entity::entity_handle_base >();
+    if (auto key = entity::entity_key::find(to_sha1_digest(match[1].str())))
+        handle = entity_service_.lookup(*key);
 
-    if (match[2].matched)
+    auto response = http::response< http::string_body >();
+    response.version(request.version());
+    response.keep_alive(request.keep_alive());
+    if (handle)
     {
-        if (auto p = entity_service_.hash_lookup(sha_key, ::atoi(match[2].str().c_str())); p)
-            candidates.push_back(p);
+        response.result(http::status::ok);
+        response.body() = fmt::format("{}\r\n", co_await handle->summary());
     }
     else
-        candidates = entity_service_.hash_lookup(sha_key);
-*/
-    co_return false;
+    {
+        response.result(http::status::not_found);
+        response.body() = fmt::format("entity {} not found\r\n", match[1].str());
+    }
+    response.prepare_payload();
+    co_await http::async_write(stream, response, use_awaitable);
+    co_return !response.need_eof();
 }
 }   // namespace web
-}   // namespace arby
\ No newline at end of file
+}   // namespace arby
@@ -13,6 +13,7 @@
 #include "asioex/scoped_interrupt.hpp"
 #include "config/http.hpp"
 #include "util/monitor.hpp"
+#include "util/recycling_allocator.hpp"
 #include "web/http_app.hpp"
 
 #include <fmt/ostream.h>
@@ -46,7 +47,8 @@ http_server::impl::impl(asio::any_io_executor exec, std::string host, std::strin
 asio::awaitable< void >
 http_server::impl::run()
 {
-    auto sentinel = util::monitor::record(fmt::format("{}::{}()", classname, __func__));
+    static const auto probe    = util::monitor::register_probe("http_server::impl::run");
+    auto              sentinel = util::monitor::record(probe);
 
     auto ex = co_await asio::this_coro::executor;
 
@@ -147,7 +149,8 @@ http_server::impl::serve(tcp::endpoint ep)
     using asio::use_awaitable;
     using asio::this_coro::executor;
 
-    auto sentinel = util::monitor::record(fmt::format("{}::{}({})", classname, __func__, ep));
+    static const auto probe    = util::monitor::register_probe("http_server::impl::serve");
+    auto              sentinel = util::monitor::record(probe);
 
     auto epilog = [this](std::exception_ptr ep)
     {
@@ -170,7 +173,7 @@ http_server::impl::serve(tcp::endpoint ep)
         auto acceptor = tcp::acceptor(co_await executor, ep, true);
         auto sock     = tcp::socket(co_await executor);
         co_await acceptor.async_accept(sock, use_awaitable);
-        co_spawn(co_await executor, run_session(shared_from_this(), std::move(sock)), epilog);
+        co_spawn(co_await executor, run_session(shared_from_this(), std::move(sock)), util::bind_recycling_allocator(epilog));
     }
 }
 
@@ -178,18 +181,20 @@ asio::awaitable< void >
 http_server::impl::session(std::shared_ptr< impl > self, tcp::socket sock)
 {
     using asio::use_awaitable;
-    using namespace asio::experimental::awaitable_operators;
     using namespace std::literals;
 
-    auto sentinel = util::monitor::record(fmt::format("{}::{}({})", classname, __func__, sock.remote_endpoint()));
+    static const auto probe    = util::monitor::register_probe("http_server::impl::session");
+    auto              sentinel = util::monitor::record(probe);
 
-    auto timer   = asio::steady_timer(sock.get_executor());
-    auto timeout = [&timer]() -> asio::awaitable< void >
-    {
-        timer.expires_after(5s);
-        error_code ec;
-        co_await timer.async_wait(asio::redirect_error(use_awaitable, ec));
-    };
+    // a read which does not complete in time is cancelled, failing the read
+    auto timed_out = false;
+    auto timeout   = asioex::timer_wheel::timer(self->session_timeouts,
+                                              [&]
+                                              {
+                                                  timed_out = true;
+                                                  error_code ec;
+                                                  sock.cancel(ec);
+                                              });
 
     auto request = http::request< http::string_body >();
     auto rxbuf   = beast::flat_buffer();
@@ -199,8 +204,14 @@ http_server::impl::session(std::shared_ptr< impl > self, tcp::socket sock)
         request.clear();
         request.body().clear();
 
-        if (auto which = co_await (timeout() || http::async_read(sock, rxbuf, request, use_awaitable)); which.index() == 0)
+        timeout.expires_after(5s);
+        error_code ec;
+        co_await http::async_read(sock, rxbuf, request, asio::redirect_error(use_awaitable, ec));
+        timeout.cancel();
+        if (timed_out)
             break;
+        if (ec)
+            throw system_error(ec);
 
         spdlog::info("{}::{}({}) {} {}", classname, __func__, sock.remote_endpoint(), request.method_string(), request.target());
 
@@ -10,6 +10,7 @@
 #ifndef ARBY_WEB_HTTP_SERVER
 #define ARBY_WEB_HTTP_SERVER
 
+#include "asioex/timer_wheel.hpp"
 #include "config/asio.hpp"
 #include "web/http_app.hpp"
 
@@ -52,6 +53,9 @@ struct http_server
 
         asio::cancellation_signal stop_signal;
 
+        /// read timeouts of all sessions
+        asioex::timer_wheel session_timeouts { exec_, std::chrono::milliseconds(100) };
+
         impl(executor_type exec, std::string host, std::string port, std::shared_ptr< app_store > apps);
 
         executor_type const &
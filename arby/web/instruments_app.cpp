@@ -0,0 +1,58 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+
+#include "instruments_app.hpp"
+
+#include "trading/instrument_registry.hpp"
+#include "util/table.hpp"
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+namespace arby
+{
+namespace web
+{
+
+asio::awaitable< bool >
+instruments_app::operator()(tcp::socket &stream, http::request< http::string_body > &request, std::cmatch &)
+{
+    using asio::use_awaitable;
+
+    auto tab = util::table();
+    auto col = std::size_t(0);
+    for (auto heading : { "id", "market", "venue", "native symbol", "tick size", "lot size" })
+        tab.set(0, col++, heading);
+
+    auto &registry = trading::instrument_registry::instance();
+    auto  row      = std::size_t(0);
+    for (auto &listing : registry.listings())
+    {
+        ++row;
+        tab.set(row, 0, fmt::format("{}", listing.id));
+        tab.set(row, 1, registry[listing.id].name);
+        tab.set(row, 2, listing.venue);
+        tab.set(row, 3, listing.native_symbol);
+        tab.set(row, 4, listing.tick_size == 0 ? std::string("-") : listing.tick_size.str());
+        tab.set(row, 5, listing.lot_size == 0 ? std::string("-") : listing.lot_size.str());
+    }
+
+    auto response = http::response< http::string_body >();
+    response.result(http::status::ok);
+    response.version(request.version());
+    response.keep_alive(request.keep_alive());
+    response.body() = fmt::format("{}\r\n", tab);
+    response.prepare_payload();
+    co_await http::async_write(stream, response, use_awaitable);
+    co_return !response.need_eof();
+}
+
+}   // namespace web
+}   // namespace arby
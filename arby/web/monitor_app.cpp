@@ -0,0 +1,88 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "monitor_app.hpp"
+
+#include "util/monitor.hpp"
+#include "util/table.hpp"
+
+#include <fmt/chrono.h>
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+namespace arby
+{
+namespace web
+{
+namespace
+{
+/// The upper bound of the histogram bucket containing the given quantile of completions.
+std::string
+quantile(util::monitor::probe_report const &r, double q)
+{
+    std::uint64_t total = 0;
+    for (auto n : r.histogram)
+        total += n;
+    if (!total)
+        return "-";
+
+    auto          threshold = static_cast< std::uint64_t >(q * static_cast< double >(total));
+    std::uint64_t seen      = 0;
+    for (std::size_t b = 0; b < r.histogram.size(); ++b)
+    {
+        seen += r.histogram[b];
+        if (seen > threshold)
+        {
+            if (b + 1 == r.histogram.size())
+                return "overflow";
+            return fmt::format("<{}", std::chrono::microseconds(std::uint64_t(1) << b));
+        }
+    }
+    return "overflow";
+}
+}   // namespace
+
+asio::awaitable< bool >
+monitor_app::operator()(tcp::socket &stream, http::request< http::string_body > &request, std::cmatch &)
+{
+    using asio::use_awaitable;
+
+    auto tab = util::table();
+    auto row = std::size_t(0);
+    auto col = std::size_t(0);
+    for (auto heading : { "probe", "live", "oldest", "started", "completed", "failed", "p50", "p99" })
+        tab.set(row, col++, heading);
+
+    for (auto &r : util::monitor::report())
+    {
+        if (!r.started)
+            continue;
+        ++row;
+        tab.set(row, 0, r.name);
+        tab.set(row, 1, fmt::format("{}", r.live));
+        tab.set(row, 2, fmt::format("{}", std::chrono::duration_cast< std::chrono::milliseconds >(r.oldest)));
+        tab.set(row, 3, fmt::format("{}", r.started));
+        tab.set(row, 4, fmt::format("{}", r.completed));
+        tab.set(row, 5, fmt::format("{}", r.failed));
+        tab.set(row, 6, quantile(r, 0.5));
+        tab.set(row, 7, quantile(r, 0.99));
+    }
+
+    auto response = http::response< http::string_body >();
+    response.result(http::status::ok);
+    response.version(request.version());
+    response.keep_alive(request.keep_alive());
+    response.body() = fmt::format("{}\r\n", tab);
+    response.prepare_payload();
+    co_await http::async_write(stream, response, use_awaitable);
+    co_return !response.need_eof();
+}
+
+}   // namespace web
+}   // namespace arby
@@ -0,0 +1,29 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_WEB_MONITOR_APP_HPP
+#define ARBY_WEB_MONITOR_APP_HPP
+
+#include "web/http_app.hpp"
+
+namespace arby
+{
+namespace web
+{
+/// Reports live coroutine counts, ages and completion-time percentiles recorded by util::monitor.
+struct monitor_app : http_app_base
+{
+    virtual asio::awaitable< bool >
+    operator()(tcp::socket &stream, http::request< http::string_body > &request, std::cmatch &match) override;
+};
+
+}   // namespace web
+}   // namespace arby
+
+#endif   // ARBY_WEB_MONITOR_APP_HPP
@@ -0,0 +1,128 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+
+#include "tick_store_app.hpp"
+
+#include "util/table.hpp"
+
+#include <fmt/chrono.h>
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+namespace arby
+{
+namespace web
+{
+namespace
+{
+trading::timestamp_type
+from_ms(std::string const &s)
+{
+    return trading::timestamp_type(std::chrono::milliseconds(std::stoll(s)));
+}
+
+std::string
+to_string(power_trade::tick_row_kind kind)
+{
+    switch (kind)
+    {
+    case power_trade::tick_row_kind::snapshot:
+        return "snapshot";
+    case power_trade::tick_row_kind::snapshot_order:
+        return "snapshot order";
+    case power_trade::tick_row_kind::add:
+        return "add";
+    case power_trade::tick_row_kind::remove:
+        return "remove";
+    case power_trade::tick_row_kind::execute:
+        return "execute";
+    }
+    return "?";
+}
+}   // namespace
+
+tick_store_app::tick_store_app(std::filesystem::path root, asio::any_io_executor work)
+: store_(std::move(root))
+, work_(std::move(work))
+{
+}
+
+asio::awaitable< bool >
+tick_store_app::operator()(tcp::socket &stream, http::request< http::string_body > &request, std::cmatch &match)
+{
+    using asio::use_awaitable;
+
+    auto market = fmt::format("{}/{}", match[1].str(), match[2].str());
+    auto t0     = from_ms(match[3].str());
+    auto t1     = match[4].matched ? std::optional(from_ms(match[4].str())) : std::nullopt;
+
+    auto response = http::response< http::string_body >();
+    response.version(request.version());
+    response.keep_alive(request.keep_alive());
+    try
+    {
+        response.body() = co_await asio::co_spawn(
+            work_,
+            [&]() -> asio::awaitable< std::string > { co_return t1 ? ticks(market, t0, *t1) : book(market, t0); },
+            use_awaitable);
+        response.result(http::status::ok);
+    }
+    catch (std::exception &e)
+    {
+        response.result(http::status::internal_server_error);
+        response.body() = fmt::format("{}\r\n", e.what());
+    }
+    response.prepare_payload();
+    co_await http::async_write(stream, response, use_awaitable);
+    co_return !response.need_eof();
+}
+
+std::string
+tick_store_app::ticks(std::string const &market, trading::timestamp_type from, trading::timestamp_type to) const
+{
+    auto tab = util::table();
+    auto col = std::size_t(0);
+    for (auto heading : { "time", "kind", "side", "order id", "price", "qty" })
+        tab.set(0, col++, heading);
+
+    auto row  = std::size_t(0);
+    auto more = false;
+    store_.scan(market,
+                from,
+                to,
+                [&](power_trade::tick_row const &r)
+                {
+                    if (row == max_rows)
+                    {
+                        more = true;
+                        return;
+                    }
+                    ++row;
+                    auto has_price =
+                        r.kind != power_trade::tick_row_kind::remove && r.kind != power_trade::tick_row_kind::snapshot;
+                    tab.set(row, 0, fmt::format("{}", r.time));
+                    tab.set(row, 1, to_string(r.kind));
+                    tab.set(row, 2, r.kind == power_trade::tick_row_kind::snapshot ? std::string() : fmt::format("{}", r.side));
+                    tab.set(row, 3, std::string(r.order_id));
+                    tab.set(row, 4, has_price ? power_trade::from_checkpoint_decimal(r.price).str() : std::string());
+                    tab.set(row, 5, has_price ? power_trade::from_checkpoint_decimal(r.qty).str() : std::string());
+                });
+
+    return fmt::format("{}\r\n{}", tab, more ? fmt::format("truncated at {} rows\r\n", max_rows) : std::string());
+}
+
+std::string
+tick_store_app::book(std::string const &market, trading::timestamp_type t) const
+{
+    return fmt::format("{} as of {}\r\n{}\r\n", market, t, store_.book_as_of(market, t));
+}
+
+}   // namespace web
+}   // namespace arby
@@ -0,0 +1,51 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+
+#ifndef ARBY_WEB_TICK_STORE_APP_HPP
+#define ARBY_WEB_TICK_STORE_APP_HPP
+
+#include "power_trade/tick_store.hpp"
+#include "web/http_app.hpp"
+
+#include <filesystem>
+
+namespace arby
+{
+namespace web
+{
+/// @brief Queries the tick store.
+///
+/// Expects a match of ^/ticks/([a-z0-9]+)-([a-z0-9]+)/([0-9]+)/(?:([0-9]+)|book)/?$, i.e. /ticks/eth-usd/<from>/<to>
+/// for the ticks in a range, or /ticks/eth-usd/<time>/book for the book at a time. Times are in milliseconds since the
+/// epoch. Queries run on the work executor, so that a long one does not hold up the server.
+struct tick_store_app : http_app_base
+{
+    static constexpr std::size_t max_rows = 10000;
+
+    tick_store_app(std::filesystem::path root, asio::any_io_executor work);
+
+    virtual asio::awaitable< bool >
+    operator()(tcp::socket &stream, http::request< http::string_body > &request, std::cmatch &match) override;
+
+  private:
+    std::string
+    ticks(std::string const &market, trading::timestamp_type from, trading::timestamp_type to) const;
+
+    std::string
+    book(std::string const &market, trading::timestamp_type t) const;
+
+    power_trade::tick_store store_;
+    asio::any_io_executor   work_;
+};
+
+}   // namespace web
+}   // namespace arby
+
+#endif   // ARBY_WEB_TICK_STORE_APP_HPP
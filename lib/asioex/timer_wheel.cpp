@@ -0,0 +1,261 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "timer_wheel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+namespace arby::asioex
+{
+namespace detail
+{
+/// Four levels of 64 slots. A timer is filed in level k if it is due in [64^k, 64^(k+1)) ticks. When the ticks below
+/// level k wrap, the next slot of level k is cascaded: its timers are re-filed into lower levels.
+struct timer_wheel_impl : std::enable_shared_from_this< timer_wheel_impl >
+{
+    using clock = timer_wheel::clock;
+    using timer = timer_wheel::timer;
+
+    static constexpr unsigned      level_bits = 6;
+    static constexpr std::size_t   slots      = std::size_t(1) << level_bits;
+    static constexpr std::size_t   levels     = 4;
+    static constexpr std::uint64_t span       = std::uint64_t(1) << (level_bits * levels);
+
+    timer_wheel_impl(timer_wheel::executor_type exec, clock::duration resolution)
+    : exec(std::move(exec))
+    , resolution(resolution)
+    , origin(clock::now())
+    , ticker(this->exec)
+    {
+        assert(resolution > clock::duration::zero());
+    }
+
+    ~timer_wheel_impl() { assert(armed == 0); }
+
+    /// The first tick at or after the time point
+    std::uint64_t
+    tick_at(clock::time_point t) const
+    {
+        if (t <= origin)
+            return 0;
+        return static_cast< std::uint64_t >((t - origin + resolution - clock::duration(1)) / resolution);
+    }
+
+    /// The last tick at or before the time point
+    std::uint64_t
+    tick_before(clock::time_point t) const
+    {
+        return static_cast< std::uint64_t >((t - origin) / resolution);
+    }
+
+    static void
+    detach(bilist_node *n)
+    {
+        n->unlink();
+        n->next_ = n;
+        n->prev_ = n;
+    }
+
+    /// Move the whole list headed by `from` to the empty list head `to`.
+    static void
+    splice(bilist_node &from, bilist_node &to)
+    {
+        assert(to.next_ == &to);
+        if (from.next_ == &from)
+            return;
+        to.next_        = from.next_;
+        to.prev_        = from.prev_;
+        to.next_->prev_ = &to;
+        to.prev_->next_ = &to;
+        from.next_      = &from;
+        from.prev_      = &from;
+    }
+
+    /// Link the timer into the slot which covers its expiry. Overdue timers go in the slot for the next tick.
+    void
+    file(timer *t)
+    {
+        auto delta = std::min(std::max(t->expiry_, now) - now, span - 1);
+        auto due   = now + delta;
+        auto level = std::size_t(0);
+        while (delta >> (level_bits * (level + 1)))
+            ++level;
+        t->link_before(&wheel[level][(due >> (level_bits * level)) & (slots - 1)]);
+    }
+
+    void
+    arm(timer *t)
+    {
+        if (!running)
+            now = std::max(now, tick_before(clock::now()));
+        file(t);
+        ++armed;
+        if (auto due = next_due(); !running || due < next_wake)
+            schedule(due);
+    }
+
+    void
+    disarm(timer *t)
+    {
+        detach(t);
+        // with nothing armed the pending wait would keep the wheel and the io_context's work alive for nothing.
+        // Nothing is filed either, so a tick being processed may stop here and the next arm() starts afresh.
+        if (--armed == 0 && running)
+        {
+            running = false;
+            ticker.cancel();
+        }
+    }
+
+    void
+    schedule(std::uint64_t tick)
+    {
+        running   = true;
+        next_wake = tick;
+        // re-arming the ticker aborts a pending wait, whose handler then does nothing
+        ticker.expires_at(origin + resolution * tick);
+        ticker.async_wait(
+            [self = shared_from_this()](error_code ec)
+            {
+                if (ec != asio::error::operation_aborted)
+                    self->on_tick();
+            });
+    }
+
+    void
+    on_tick()
+    {
+        auto target = tick_before(clock::now());
+        while (now <= target && armed)
+            process_tick();
+
+        if (!armed)
+        {
+            running = false;
+            return;
+        }
+        schedule(next_due());
+    }
+
+    /// The next tick with work to do: the next occupied level 0 slot, or the next cascade.
+    std::uint64_t
+    next_due() const
+    {
+        if ((now & (slots - 1)) == 0)
+            return now;
+        for (auto t = now; (t & (slots - 1)) != 0; ++t)
+            if (auto &slot = wheel[0][t & (slots - 1)]; slot.next_ != &slot)
+                return t;
+        return (now | (slots - 1)) + 1;
+    }
+
+    void
+    cascade(std::size_t level, std::size_t slot)
+    {
+        auto pending = bilist_node();
+        splice(wheel[level][slot], pending);
+        while (pending.next_ != &pending)
+        {
+            auto *t = static_cast< timer * >(pending.next_);
+            detach(t);
+            file(t);
+        }
+    }
+
+    void
+    process_tick()
+    {
+        for (std::size_t level = 1; level < levels && (now & ((std::uint64_t(1) << (level_bits * level)) - 1)) == 0; ++level)
+            cascade(level, (now >> (level_bits * level)) & (slots - 1));
+
+        auto expired = bilist_node();
+        splice(wheel[0][now & (slots - 1)], expired);
+        ++now;
+
+        // callbacks may arm, disarm or destroy other timers, including those still in the expired list
+        while (expired.next_ != &expired)
+        {
+            auto *t = static_cast< timer * >(expired.next_);
+            disarm(t);
+            t->on_expiry_();
+        }
+    }
+
+    timer_wheel::executor_type                             exec;
+    clock::duration                                        resolution;
+    clock::time_point                                      origin;
+    asio::steady_timer                                     ticker;
+    std::uint64_t                                          now       = 0;   // the next tick to process
+    std::uint64_t                                          next_wake = 0;
+    std::size_t                                            armed     = 0;
+    bool                                                   running   = false;
+    std::array< std::array< bilist_node, slots >, levels > wheel;
+};
+}   // namespace detail
+
+timer_wheel::timer::timer(timer_wheel const &wheel, std::function< void() > on_expiry)
+: wheel_(wheel.impl_)
+, on_expiry_(std::move(on_expiry))
+{
+}
+
+timer_wheel::timer::~timer()
+{
+    cancel();
+}
+
+void
+timer_wheel::timer::expires_after(clock::duration d)
+{
+    expires_at(clock::now() + d);
+}
+
+void
+timer_wheel::timer::expires_at(clock::time_point t)
+{
+    cancel();
+    expiry_ = wheel_->tick_at(t);
+    wheel_->arm(this);
+}
+
+bool
+timer_wheel::timer::cancel()
+{
+    if (!armed())
+        return false;
+    wheel_->disarm(this);
+    return true;
+}
+
+timer_wheel::timer_wheel(executor_type exec, clock::duration resolution)
+: impl_(std::make_shared< detail::timer_wheel_impl >(std::move(exec), resolution))
+{
+}
+
+auto
+timer_wheel::get_executor() const -> executor_type const &
+{
+    return impl_->exec;
+}
+
+auto
+timer_wheel::resolution() const -> clock::duration
+{
+    return impl_->resolution;
+}
+
+std::size_t
+timer_wheel::size() const
+{
+    return impl_->armed;
+}
+
+}   // namespace arby::asioex
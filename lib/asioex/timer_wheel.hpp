@@ -0,0 +1,101 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_LIB_ASIOEX_TIMER_WHEEL_HPP
+#define ARBY_LIB_ASIOEX_TIMER_WHEEL_HPP
+
+#include "asioex/detail/bilist_node.hpp"
+#include "config/asio.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace arby::asioex
+{
+namespace detail
+{
+    struct timer_wheel_impl;
+}
+
+/// @brief A hierarchical timer wheel for large numbers of cheap deadlines on one executor.
+///
+/// Timers are intrusive nodes owned by their users. Arming, re-arming and disarming a timer is O(1) and never
+/// allocates. The wheel is driven by a single steady_timer which only runs while at least one timer is armed.
+///
+/// Deadlines are rounded up to the wheel's resolution, so a timer never fires early but may fire up to one
+/// resolution late. Deadlines further away than 2^24 resolutions are re-filed as they approach.
+///
+/// A timer_wheel is a handle. Copies refer to the same wheel, which lives as long as any handle or timer refers to it.
+/// @note not thread-safe. Timers must be armed, disarmed and destroyed on the wheel's executor, which must be
+/// single-threaded or a strand. Expiry callbacks are invoked on that executor.
+struct timer_wheel
+{
+    using executor_type = asio::any_io_executor;
+    using clock         = std::chrono::steady_clock;
+
+    struct timer : detail::bilist_node
+    {
+        /// @param on_expiry is invoked, on the wheel's executor, each time the timer expires while armed. It may
+        /// re-arm this timer and arm, disarm or destroy others, but must not destroy this one.
+        timer(timer_wheel const &wheel, std::function< void() > on_expiry);
+
+        timer(timer const &) = delete;
+        timer &
+        operator=(timer const &) = delete;
+
+        ~timer();
+
+        /// @brief Arm, or re-arm, the timer to expire after the duration.
+        void
+        expires_after(clock::duration d);
+
+        /// @brief Arm, or re-arm, the timer to expire at the time point.
+        void
+        expires_at(clock::time_point t);
+
+        /// @brief Disarm the timer.
+        /// @return true if the timer was armed
+        bool
+        cancel();
+
+        bool
+        armed() const
+        {
+            return next_ != this;
+        }
+
+      private:
+        friend detail::timer_wheel_impl;
+
+        std::shared_ptr< detail::timer_wheel_impl > wheel_;
+        std::function< void() >                     on_expiry_;
+        std::uint64_t                               expiry_ = 0;   // in ticks of the wheel
+    };
+
+    explicit timer_wheel(executor_type exec, clock::duration resolution = std::chrono::milliseconds(1));
+
+    executor_type const &
+    get_executor() const;
+
+    clock::duration
+    resolution() const;
+
+    /// @brief The number of armed timers.
+    std::size_t
+    size() const;
+
+  private:
+    std::shared_ptr< detail::timer_wheel_impl > impl_;
+};
+
+}   // namespace arby::asioex
+
+#endif   // ARBY_LIB_ASIOEX_TIMER_WHEEL_HPP
@@ -0,0 +1,142 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "asioex/timer_wheel.hpp"
+
+#include <doctest/doctest.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace arby;
+using namespace std::literals;
+
+TEST_SUITE("asioex")
+{
+    TEST_CASE("timer_wheel")
+    {
+        using clock = asioex::timer_wheel::clock;
+
+        auto ioc   = asio::io_context();
+        auto wheel = asioex::timer_wheel(ioc.get_executor(), 1ms);
+        auto start = clock::now();
+
+        auto fired = std::vector< std::pair< int, clock::duration > >();
+        auto t1    = asioex::timer_wheel::timer(wheel, [&] { fired.emplace_back(1, clock::now() - start); });
+        auto t2    = asioex::timer_wheel::timer(wheel, [&] { fired.emplace_back(2, clock::now() - start); });
+        auto t3    = asioex::timer_wheel::timer(wheel, [&] { fired.emplace_back(3, clock::now() - start); });
+
+        t1.expires_after(30ms);
+        t2.expires_after(10ms);
+        t3.expires_after(20ms);
+        CHECK(wheel.size() == 3);
+
+        // disarm and re-arm
+        CHECK(t3.cancel());
+        CHECK_FALSE(t3.cancel());
+        t3.expires_after(100ms);
+        t1.expires_after(5ms);
+
+        ioc.run();
+
+        REQUIRE(fired.size() == 3);
+        CHECK(fired[0].first == 1);
+        CHECK(fired[1].first == 2);
+        CHECK(fired[2].first == 3);
+        CHECK(fired[0].second >= 5ms);
+        CHECK(fired[1].second >= 10ms);
+        CHECK(fired[2].second >= 100ms);
+        CHECK(wheel.size() == 0);
+    }
+
+    TEST_CASE("timer_wheel stops when the last timer is disarmed")
+    {
+        using clock = asioex::timer_wheel::clock;
+
+        auto ioc   = asio::io_context();
+        auto fired = false;
+        {
+            // coarse enough that the wait for the next cascade would take seconds
+            auto wheel = asioex::timer_wheel(ioc.get_executor(), 50ms);
+            auto t     = asioex::timer_wheel::timer(wheel, [&] { fired = true; });
+            t.expires_after(10s);
+            t.cancel();
+
+            // a timer armed afresh after the wheel stopped still fires
+            t.expires_after(2ms);
+            ioc.run();
+            CHECK(fired);
+
+            fired = false;
+            t.expires_after(10s);
+            t.cancel();
+        }
+
+        // neither the wheel nor its work outlives the last armed timer
+        ioc.restart();
+        auto start = clock::now();
+        ioc.run();
+        CHECK(clock::now() - start < 1s);
+        CHECK_FALSE(fired);
+    }
+
+    TEST_CASE("timer_wheel cascades")
+    {
+        using clock = asioex::timer_wheel::clock;
+
+        // 64 ticks of 100us fit in level 0, so these deadlines exercise levels 1 and 2
+        auto ioc   = asio::io_context();
+        auto wheel = asioex::timer_wheel(ioc.get_executor(), 100us);
+        auto start = clock::now();
+        auto early = 0;
+        auto fired = 0;
+
+        auto timers = std::vector< std::unique_ptr< asioex::timer_wheel::timer > >();
+        auto rng    = std::mt19937(7);
+        auto dist   = std::uniform_int_distribution< int >(0, 500);
+        for (int i = 0; i < 1000; ++i)
+        {
+            auto due = start + std::chrono::milliseconds(dist(rng));
+            timers.push_back(std::make_unique< asioex::timer_wheel::timer >(wheel,
+                                                                            [&, due]
+                                                                            {
+                                                                                ++fired;
+                                                                                early += clock::now() < due;
+                                                                            }));
+            timers.back()->expires_at(due);
+        }
+
+        // destroying an armed timer disarms it
+        timers.resize(900);
+
+        ioc.run();
+
+        CHECK(fired == 900);
+        CHECK(early == 0);
+    }
+
+    TEST_CASE("timer_wheel re-arm from callback")
+    {
+        auto ioc   = asio::io_context();
+        auto wheel = asioex::timer_wheel(ioc.get_executor(), 1ms);
+        auto count = 0;
+
+        auto t = std::unique_ptr< asioex::timer_wheel::timer >();
+        t      = std::make_unique< asioex::timer_wheel::timer >(wheel,
+                                                               [&]
+                                                               {
+                                                                   if (++count < 5)
+                                                                       t->expires_after(2ms);
+                                                               });
+        t->expires_after(2ms);
+        ioc.run();
+        CHECK(count == 5);
+    }
+}
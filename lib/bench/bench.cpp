@@ -0,0 +1,344 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "bench/bench.hpp"
+
+#include "config/json.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+namespace arby::bench
+{
+namespace
+{
+    struct bench_case
+    {
+        std::string   name;
+        function_type fn;
+        std::int64_t  arg;
+    };
+
+    std::vector< bench_case > &
+    registry()
+    {
+        static std::vector< bench_case > cases;
+        return cases;
+    }
+
+    struct options
+    {
+        std::regex                   filter { ".*" };
+        std::chrono::milliseconds    min_time { 50 };
+        int                          repetitions = 5;
+        std::optional< std::string > json_path;
+        std::optional< std::string > baseline_path;
+        double                       threshold = 10.0;
+        bool                         list      = false;
+        bool                         smoke     = false;
+        bool                         help      = false;
+    };
+
+    struct result
+    {
+        std::string           name;
+        std::uint64_t         iterations = 0;
+        std::vector< double > ns_per_op;
+        double                items_per_iteration = 0;
+
+        double
+        min() const
+        {
+            return *std::min_element(ns_per_op.begin(), ns_per_op.end());
+        }
+
+        double
+        median() const
+        {
+            auto v = ns_per_op;
+            std::sort(v.begin(), v.end());
+            auto mid = v.size() / 2;
+            return v.size() % 2 ? v[mid] : (v[mid - 1] + v[mid]) / 2;
+        }
+
+        double
+        mean() const
+        {
+            return std::accumulate(ns_per_op.begin(), ns_per_op.end(), 0.0) / ns_per_op.size();
+        }
+    };
+
+    constexpr char usage[] = R"(usage: {} [options]
+  --filter REGEX       run only the cases whose names match
+  --min-time MS        minimum duration of each timed repetition (default 50)
+  --repetitions N      timed repetitions per case (default 5)
+  --json FILE          write the results to FILE as JSON
+  --baseline FILE      compare medians with the results in FILE, written by --json
+  --threshold PERCENT  a slowdown beyond which a case counts as a regression (default 10)
+  --list               list the cases and exit
+  --smoke              run each case for one iteration, untimed, to check that it works
+  --help               show this message
+)";
+
+    options
+    parse_options(int argc, char **argv)
+    {
+        auto opts = options();
+        auto need = [&](int &i) -> std::string
+        {
+            if (i + 1 >= argc)
+                throw std::invalid_argument(fmt::format("{} requires a value", argv[i]));
+            return argv[++i];
+        };
+
+        for (int i = 1; i < argc; ++i)
+        {
+            auto arg = std::string_view(argv[i]);
+            if (arg == "--filter")
+                opts.filter = std::regex(need(i));
+            else if (arg == "--min-time")
+                opts.min_time = std::chrono::milliseconds(std::stol(need(i)));
+            else if (arg == "--repetitions")
+                opts.repetitions = std::max(1, std::stoi(need(i)));
+            else if (arg == "--json")
+                opts.json_path = need(i);
+            else if (arg == "--baseline")
+                opts.baseline_path = need(i);
+            else if (arg == "--threshold")
+                opts.threshold = std::stod(need(i));
+            else if (arg == "--list")
+                opts.list = true;
+            else if (arg == "--smoke")
+                opts.smoke = true;
+            else if (arg == "--help")
+                opts.help = true;
+            else
+                throw std::invalid_argument(fmt::format("unknown option: {}", arg));
+        }
+        return opts;
+    }
+
+    state
+    run_once(bench_case const &c, std::uint64_t iterations)
+    {
+        auto s = state(iterations, c.arg);
+        c.fn(s);
+        return s;
+    }
+
+    /// Find an iteration count for which one repetition takes at least min_time, then time the repetitions.
+    result
+    measure(bench_case const &c, options const &opts)
+    {
+        using namespace std::chrono;
+
+        auto target     = duration_cast< nanoseconds >(opts.min_time);
+        auto iterations = std::uint64_t(1);
+        for (;;)
+        {
+            auto elapsed = duration_cast< nanoseconds >(run_once(c, iterations).elapsed());
+            if (elapsed >= target || iterations >= (std::uint64_t(1) << 40))
+                break;
+            // aim 20% past the target, growing by at least 2x and at most 100x per step
+            auto scale = elapsed.count() ? 1.2 * target.count() / elapsed.count() : 100.0;
+            iterations = std::uint64_t(iterations * std::clamp(scale, 2.0, 100.0));
+        }
+
+        auto r       = result();
+        r.name       = c.name;
+        r.iterations = iterations;
+        for (int rep = 0; rep < opts.repetitions; ++rep)
+        {
+            auto s = run_once(c, iterations);
+            r.ns_per_op.push_back(double(duration_cast< nanoseconds >(s.elapsed()).count()) / iterations);
+            r.items_per_iteration = s.items_per_iteration();
+        }
+        return r;
+    }
+
+    std::string
+    format_ns(double ns)
+    {
+        if (ns < 1e3)
+            return fmt::format("{:.1f}ns", ns);
+        if (ns < 1e6)
+            return fmt::format("{:.2f}us", ns / 1e3);
+        if (ns < 1e9)
+            return fmt::format("{:.2f}ms", ns / 1e6);
+        return fmt::format("{:.2f}s", ns / 1e9);
+    }
+
+    json::value
+    to_json(std::vector< result > const &results)
+    {
+        auto benchmarks = json::array();
+        for (auto &r : results)
+        {
+            auto o                = json::object();
+            o["name"]             = r.name;
+            o["iterations"]       = r.iterations;
+            o["repetitions"]      = r.ns_per_op.size();
+            o["ns_per_op_min"]    = r.min();
+            o["ns_per_op_median"] = r.median();
+            o["ns_per_op_mean"]   = r.mean();
+            if (r.items_per_iteration > 0)
+                o["items_per_second"] = r.items_per_iteration * 1e9 / r.median();
+            benchmarks.push_back(std::move(o));
+        }
+
+        auto context = json::object();
+        context["date"] =
+            std::chrono::duration_cast< std::chrono::seconds >(std::chrono::system_clock::now().time_since_epoch()).count();
+        context["hardware_concurrency"] = std::thread::hardware_concurrency();
+#ifdef NDEBUG
+        context["build"] = "release";
+#else
+        context["build"] = "debug";
+#endif
+        return json::object({ { "context", std::move(context) }, { "benchmarks", std::move(benchmarks) } });
+    }
+
+    std::map< std::string, double >
+    load_baseline(std::string const &path)
+    {
+        auto ifs = std::ifstream(path);
+        if (!ifs)
+            throw std::runtime_error(fmt::format("cannot open baseline {}", path));
+        auto ss = std::stringstream();
+        ss << ifs.rdbuf();
+
+        auto result = std::map< std::string, double >();
+        for (auto &b : json::parse(ss.str()).at("benchmarks").as_array())
+            result[json::value_to< std::string >(b.at("name"))] = b.at("ns_per_op_median").to_number< double >();
+        return result;
+    }
+}   // namespace
+
+registration::registration(char const *name, function_type fn, std::vector< std::int64_t > args)
+{
+    if (args.empty())
+        registry().push_back(bench_case { name, fn, 0 });
+    for (auto a : args)
+        registry().push_back(bench_case { fmt::format("{}/{}", name, a), fn, a });
+}
+
+int
+run(int argc, char **argv)
+{
+    auto opts = options();
+    try
+    {
+        opts = parse_options(argc, argv);
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << e.what() << '\n' << fmt::format(usage, argv[0]);
+        return 2;
+    }
+
+    if (opts.help)
+    {
+        std::cout << fmt::format(usage, argv[0]);
+        return 0;
+    }
+
+    auto cases = std::vector< bench_case const * >();
+    for (auto &c : registry())
+        if (std::regex_search(c.name, opts.filter))
+            cases.push_back(&c);
+
+    if (opts.list)
+    {
+        for (auto *c : cases)
+            std::cout << c->name << '\n';
+        return 0;
+    }
+
+    if (opts.smoke)
+    {
+        for (auto *c : cases)
+            run_once(*c, 1);
+        std::cout << cases.size() << " cases ran\n";
+        return 0;
+    }
+
+    auto baseline = std::map< std::string, double >();
+    try
+    {
+        if (opts.baseline_path)
+            baseline = load_baseline(*opts.baseline_path);
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return 2;
+    }
+
+    auto width = std::size_t(0);
+    for (auto *c : cases)
+        width = std::max(width, c->name.size());
+
+    auto results     = std::vector< result >();
+    auto regressions = 0;
+    for (auto *c : cases)
+    {
+        auto &r    = results.emplace_back(measure(*c, opts));
+        auto  line = fmt::format("{:<{}}  {:>10} {:>10} {:>12}",
+                                r.name,
+                                width,
+                                format_ns(r.median()),
+                                format_ns(r.min()),
+                                fmt::format("x{}", r.iterations));
+        if (r.items_per_iteration > 0)
+            line += fmt::format("  {:.3g} items/s", r.items_per_iteration * 1e9 / r.median());
+        if (auto ib = baseline.find(r.name); ib != baseline.end())
+        {
+            auto change = (r.median() / ib->second - 1) * 100;
+            line += fmt::format("  {:+.1f}%", change);
+            if (change > opts.threshold)
+            {
+                line += " REGRESSION";
+                ++regressions;
+            }
+        }
+        std::cout << line << std::endl;
+    }
+
+    if (opts.json_path)
+    {
+        auto ofs = std::ofstream(*opts.json_path);
+        ofs << json::serialize(to_json(results)) << '\n';
+        if (!ofs)
+        {
+            std::cerr << "failed to write " << *opts.json_path << '\n';
+            return 2;
+        }
+    }
+
+    if (regressions)
+    {
+        std::cout << regressions << " regression(s) beyond " << opts.threshold << "%\n";
+        return 1;
+    }
+    return 0;
+}
+
+}   // namespace arby::bench
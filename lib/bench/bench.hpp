@@ -0,0 +1,191 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_LIB_BENCH_BENCH_HPP
+#define ARBY_LIB_BENCH_BENCH_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace arby::bench
+{
+/// @brief The state of one run of a benchmark case, and its timing loop.
+///
+/// A case does its setup, then runs the code under test in a loop over the state:
+/// @code
+///     ARBY_BENCHMARK("thing/op", 10, 100)
+///     {
+///         auto thing = make_thing(state.arg());
+///         for (auto _ : state)
+///             bench::do_not_optimize(thing.op());
+///     }
+/// @endcode
+/// Only the loop is timed. The runner calls the case repeatedly with different iteration counts.
+struct state
+{
+    using clock_type = std::chrono::steady_clock;
+
+    struct sentinel
+    {
+    };
+
+    struct iterator
+    {
+        struct value_type
+        {
+        };
+
+        value_type
+        operator*() const
+        {
+            return {};
+        }
+
+        iterator &
+        operator++()
+        {
+            --remaining_;
+            return *this;
+        }
+
+        bool
+        operator!=(sentinel) const
+        {
+            if (remaining_ != 0) [[likely]]
+                return true;
+            host_->finish();
+            return false;
+        }
+
+        state        *host_;
+        std::uint64_t remaining_;
+    };
+
+    state(std::uint64_t iterations, std::int64_t arg)
+    : iterations_(iterations)
+    , arg_(arg)
+    {
+    }
+
+    iterator
+    begin()
+    {
+        resume_timing();
+        return iterator { this, iterations_ };
+    }
+
+    sentinel
+    end()
+    {
+        return {};
+    }
+
+    /// @brief The case's argument, or 0 if it was registered without any.
+    std::int64_t
+    arg() const
+    {
+        return arg_;
+    }
+
+    std::uint64_t
+    iterations() const
+    {
+        return iterations_;
+    }
+
+    /// @brief Exclude per-iteration setup from the timing. Expensive: use only where the setup would dominate.
+    void
+    pause_timing()
+    {
+        elapsed_ += clock_type::now() - started_;
+    }
+
+    void
+    resume_timing()
+    {
+        started_ = clock_type::now();
+    }
+
+    /// @brief Report throughput as items per second, e.g. ticks or slots per iteration.
+    void
+    set_items_per_iteration(double items)
+    {
+        items_per_iteration_ = items;
+    }
+
+    clock_type::duration
+    elapsed() const
+    {
+        return elapsed_;
+    }
+
+    double
+    items_per_iteration() const
+    {
+        return items_per_iteration_;
+    }
+
+  private:
+    void
+    finish()
+    {
+        pause_timing();
+    }
+
+    std::uint64_t          iterations_;
+    std::int64_t           arg_;
+    clock_type::time_point started_ {};
+    clock_type::duration   elapsed_ {};
+    double                 items_per_iteration_ = 0;
+};
+
+/// @brief Stop the compiler from optimising away a value or the computation of it.
+template < class T >
+inline void
+do_not_optimize(T const &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/// @brief Force pending writes to memory to be treated as observable.
+inline void
+clobber_memory()
+{
+    asm volatile("" : : : "memory");
+}
+
+using function_type = void (*)(state &);
+
+/// @brief Adds a case to the program's registry at static initialisation. Use ARBY_BENCHMARK.
+struct registration
+{
+    registration(char const *name, function_type fn, std::vector< std::int64_t > args = {});
+};
+
+/// @brief Run the registered cases as directed by the command line. See --help.
+/// @return the process exit code. Non-zero if a case regressed against the baseline beyond the threshold.
+int
+run(int argc, char **argv);
+
+}   // namespace arby::bench
+
+#define ARBY_BENCH_CAT2(a, b) a##b
+#define ARBY_BENCH_CAT(a, b)  ARBY_BENCH_CAT2(a, b)
+
+/// @brief Define a benchmark case. Each argument given produces a case named "name/arg", which reads it with
+/// state.arg(). The body follows the macro and has a `state` in scope.
+#define ARBY_BENCHMARK(name, ...)                                                                                          \
+    static void ARBY_BENCH_CAT(arby_bench_fn_, __LINE__)(::arby::bench::state &);                                         \
+    static ::arby::bench::registration ARBY_BENCH_CAT(arby_bench_reg_, __LINE__)(                                         \
+        name, &ARBY_BENCH_CAT(arby_bench_fn_, __LINE__), { __VA_ARGS__ });                                                  \
+    static void ARBY_BENCH_CAT(arby_bench_fn_, __LINE__)([[maybe_unused]] ::arby::bench::state & state)
+
+#endif   // ARBY_LIB_BENCH_BENCH_HPP
@@ -0,0 +1,42 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "backoff.hpp"
+
+#include <algorithm>
+
+namespace arby::network
+{
+backoff::backoff(duration initial, duration maximum)
+: initial_(initial)
+, maximum_(std::max(initial, maximum))
+, nominal_(initial)
+, rng_(std::random_device()())
+{
+}
+
+auto
+backoff::next() -> duration
+{
+    auto const nominal = nominal_;
+    nominal_           = std::min(nominal_ * 2, maximum_);
+    ++attempts_;
+
+    auto dist = std::uniform_int_distribution< duration::rep >(nominal.count() / 2, nominal.count());
+    return duration(dist(rng_));
+}
+
+void
+backoff::reset()
+{
+    nominal_  = initial_;
+    attempts_ = 0;
+}
+
+}   // namespace arby::network
@@ -0,0 +1,52 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_LIB_NETWORK_BACKOFF_HPP
+#define ARBY_LIB_NETWORK_BACKOFF_HPP
+
+#include <chrono>
+#include <random>
+
+namespace arby::network
+{
+/// @brief Jittered exponential backoff for reconnection attempts.
+///
+/// Each call to next() doubles the nominal delay, up to the maximum, and returns a delay drawn uniformly from the upper
+/// half of the nominal delay so that many clients disconnected at the same moment do not reconnect in lockstep.
+/// Call reset() once a connection has been established.
+struct backoff
+{
+    using duration = std::chrono::milliseconds;
+
+    explicit backoff(duration initial = duration(25), duration maximum = duration(5000));
+
+    duration
+    next();
+
+    void
+    reset();
+
+    /// The number of calls to next() since construction or the last reset
+    unsigned
+    attempts() const
+    {
+        return attempts_;
+    }
+
+  private:
+    duration     initial_;
+    duration     maximum_;
+    duration     nominal_;
+    unsigned     attempts_ = 0;
+    std::mt19937 rng_;
+};
+
+}   // namespace arby::network
+
+#endif   // ARBY_LIB_NETWORK_BACKOFF_HPP
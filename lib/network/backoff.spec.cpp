@@ -0,0 +1,84 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "network/backoff.hpp"
+
+#include <doctest/doctest.h>
+
+#include <set>
+
+using namespace arby;
+using namespace std::literals;
+
+TEST_SUITE("network")
+{
+    TEST_CASE("backoff")
+    {
+        auto delay = network::backoff(25ms, 1000ms);
+
+        SUBCASE("each delay is drawn from the upper half of a doubling nominal delay")
+        {
+            auto nominal = 25ms;
+            for (unsigned attempt = 1; attempt <= 5; ++attempt)
+            {
+                auto d = delay.next();
+                CHECK(d >= nominal / 2);
+                CHECK(d <= nominal);
+                CHECK(delay.attempts() == attempt);
+                nominal *= 2;
+            }
+        }
+
+        SUBCASE("the nominal delay is capped")
+        {
+            for (int i = 0; i < 20; ++i)
+                delay.next();
+            for (int i = 0; i < 100; ++i)
+            {
+                auto d = delay.next();
+                CHECK(d >= 500ms);
+                CHECK(d <= 1000ms);
+            }
+        }
+
+        SUBCASE("delays are jittered")
+        {
+            auto seen = std::set< network::backoff::duration >();
+            for (int i = 0; i < 20; ++i)
+                delay.next();
+            for (int i = 0; i < 100; ++i)
+                seen.insert(delay.next());
+            CHECK(seen.size() > 1);
+        }
+
+        SUBCASE("reset returns to the initial delay")
+        {
+            for (int i = 0; i < 20; ++i)
+                delay.next();
+            delay.reset();
+            CHECK(delay.attempts() == 0);
+            auto d = delay.next();
+            CHECK(d >= 12ms);
+            CHECK(d <= 25ms);
+            CHECK(delay.attempts() == 1);
+        }
+    }
+
+    TEST_CASE("backoff maximum below initial")
+    {
+        // the maximum is never less than the initial delay
+        auto delay = network::backoff(100ms, 10ms);
+        for (int i = 0; i < 10; ++i)
+        {
+            auto d = delay.next();
+            CHECK(d >= 50ms);
+            CHECK(d <= 100ms);
+        }
+    }
+}
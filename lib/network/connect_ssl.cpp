@@ -9,9 +9,16 @@
 
 #include "connect_ssl.hpp"
 
-#include "fmt/format.h"
+#include "asioex/scoped_interrupt.hpp"
+#include "dns_cache.hpp"
+#include "tls_session_cache.hpp"
 #include "util/monitor.hpp"
 
+#include <spdlog/spdlog.h>
+
+#include <optional>
+#include <vector>
+
 namespace arby::network
 {
 asio::awaitable< tcp::resolver ::results_type >
@@ -19,10 +26,111 @@ resolve(std::string const &host, std::string const &service)
 {
     using asio::use_awaitable;
 
-    auto sentinel = util::monitor::record(fmt::format("{}({}:{})", __func__, host, service));
+    static const auto probe    = util::monitor::register_probe("network::resolve");
+    auto              sentinel = util::monitor::record(probe);
+
+    auto &cache = dns_cache::instance();
+    if (auto cached = cache.lookup(host, service))
+        co_return std::move(*cached);
 
     auto resolver = tcp::resolver(co_await asio::this_coro::executor);
-    co_return co_await resolver.async_resolve(host, service, use_awaitable);
+    auto results  = co_await resolver.async_resolve(host, service, use_awaitable);
+    cache.store(host, service, results);
+    co_return results;
+}
+
+asio::awaitable< tcp::endpoint >
+connect_any(tcp::socket &sock, tcp::resolver::results_type const &endpoints, std::chrono::milliseconds stagger)
+{
+    using asio::bind_cancellation_slot;
+    using asio::redirect_error;
+    using asio::use_awaitable;
+
+    static const auto probe    = util::monitor::register_probe("network::connect_any");
+    auto              sentinel = util::monitor::record(probe);
+
+    auto exec = co_await asio::this_coro::executor;
+
+    // state shared by all attempts. It lives in this frame, which is not left until every attempt has completed.
+    auto winner      = std::optional< tcp::socket >();
+    auto winner_ep   = tcp::endpoint();
+    auto last_error  = error_code(asio::error::host_not_found);
+    auto outstanding = std::size_t(0);
+    auto cancels     = std::vector< asio::cancellation_signal >(endpoints.size());
+    auto done        = asio::steady_timer(exec, asio::steady_timer::time_point::max());
+
+    auto cancel_all = [&]
+    {
+        for (auto &c : cancels)
+            asioex::terminate(c);
+    };
+
+    auto attempt = [&](tcp::endpoint ep, std::chrono::milliseconds delay) -> asio::awaitable< void >
+    {
+        error_code ec;
+        if (delay.count())
+        {
+            auto t = asio::steady_timer(exec, delay);
+            co_await t.async_wait(redirect_error(use_awaitable, ec));
+            if (ec || winner)
+                co_return;
+        }
+
+        auto candidate = tcp::socket(exec);
+        co_await candidate.async_connect(ep, redirect_error(use_awaitable, ec));
+        if (ec)
+        {
+            if (ec != asio::error::operation_aborted)
+                last_error = ec;
+        }
+        else if (!winner)
+        {
+            winner.emplace(std::move(candidate));
+            winner_ep = ep;
+            cancel_all();
+        }
+    };
+
+    bool interrupted = false;
+    {
+        auto interrupt = asioex::scoped_interrupt((co_await asio::this_coro::cancellation_state).slot(),
+                                                  [&]
+                                                  {
+                                                      interrupted = true;
+                                                      cancel_all();
+                                                  });
+
+        auto delay = std::chrono::milliseconds(0);
+        auto i     = std::size_t(0);
+        for (auto &entry : endpoints)
+        {
+            ++outstanding;
+            asio::co_spawn(exec,
+                           attempt(entry.endpoint(), delay),
+                           bind_cancellation_slot(cancels[i++].slot(),
+                                                  [&](std::exception_ptr)
+                                                  {
+                                                      if (--outstanding == 0)
+                                                          done.cancel();
+                                                  }));
+            delay += stagger;
+        }
+
+        // the wait must not take over this coroutine's cancellation slot, which is forwarding to the attempts
+        while (outstanding)
+        {
+            error_code ec;
+            co_await done.async_wait(bind_cancellation_slot(asio::cancellation_slot(), redirect_error(use_awaitable, ec)));
+        }
+    }
+
+    if (interrupted)
+        throw system_error(asio::error::operation_aborted, "connect_any");
+    if (!winner)
+        throw system_error(last_error, "connect_any");
+
+    sock = std::move(*winner);
+    co_return winner_ep;
 }
 
 asio::awaitable< tcp::endpoint >
@@ -30,11 +138,21 @@ connect(tcp::socket &sock, std::string const &host, std::string const &service)
 {
     using asio::use_awaitable;
 
-    auto sentinel = util::monitor::record(fmt::format("{}({}:{})", __func__, host, service));
+    static const auto probe    = util::monitor::register_probe("network::connect(tcp)");
+    auto              sentinel = util::monitor::record(probe);
 
     auto endpoints = co_await resolve(host, service);
-    auto ep        = co_await asio::async_connect(sock, endpoints, use_awaitable);
-    co_return ep;
+    try
+    {
+        co_return co_await connect_any(sock, endpoints);
+    }
+    catch (system_error &e)
+    {
+        // the cached addresses may be stale, so resolve afresh next time
+        if (e.code() != asio::error::operation_aborted)
+            dns_cache::instance().invalidate(host, service);
+        throw;
+    }
 }
 
 asio::awaitable< void >
@@ -42,14 +160,25 @@ connect(ssl::stream< tcp::socket > &stream, std::string const &host, std::string
 {
     using asio::use_awaitable;
 
-    auto sentinel = util::monitor::record(fmt::format("{}({}:{})", __func__, host, service));
+    static const auto probe    = util::monitor::register_probe("network::connect(ssl)");
+    auto              sentinel = util::monitor::record(probe);
 
     co_await connect(stream.next_layer(), host, service);
 
     if (!SSL_set_tlsext_host_name(stream.native_handle(), host.c_str()))
         throw sys::system_error(ERR_get_error(), asio::error::get_ssl_category());
 
+    auto &sessions = tls_session_cache::of(SSL_get_SSL_CTX(stream.native_handle()));
+    auto  offered  = sessions.prepare(stream.native_handle(), host, service);
+
     co_await stream.async_handshake(ssl::stream_base::client, use_awaitable);
+
+    // under TLS 1.2 the server's new session is stored during the handshake, so only the declined one is forgotten
+    if (offered && !SSL_session_reused(stream.native_handle()))
+    {
+        spdlog::debug("network::connect: {}:{} declined session resumption", host, service);
+        sessions.erase(host, service, offered);
+    }
 }
 
 asio::awaitable< void >
@@ -60,10 +189,19 @@ connect(websocket::stream< ssl::stream< tcp::socket > > &stream,
 {
     using asio::use_awaitable;
 
-    auto sentinel = util::monitor::record(fmt::format("{}({}:{}{})", __func__, host, service, path));
+    static const auto probe    = util::monitor::register_probe("network::connect(websocket)");
+    auto              sentinel = util::monitor::record(probe);
 
     co_await connect(stream.next_layer(), host, service);
+    co_await upgrade(stream, host, path);
+}
+
+asio::awaitable< void >
+upgrade(websocket::stream< ssl::stream< tcp::socket > > &stream, std::string const &host, std::string const &path)
+{
+    static const auto probe    = util::monitor::register_probe("network::upgrade(websocket)");
+    auto              sentinel = util::monitor::record(probe);
 
-    co_await stream.async_handshake(host, path, use_awaitable);
+    co_await stream.async_handshake(host, path, asio::use_awaitable);
 }
 }   // namespace arby::network
@@ -13,14 +13,33 @@
 #include "config/asio.hpp"
 #include "config/websocket.hpp"
 
+#include <chrono>
+
 namespace arby::network
 {
+/// @brief Resolve host and service, answering from the dns_cache while its entry is fresh.
 asio::awaitable< tcp::resolver ::results_type >
 resolve(std::string const &host, std::string const &service);
 
+/// @brief Connect the socket to the first of the endpoints to accept a connection.
+///
+/// Connection attempts to all endpoints run in parallel, each starting `stagger` after the previous one. When one
+/// attempt succeeds the rest are cancelled. Cancelling this operation cancels all attempts.
+/// @note must be called on a single-threaded executor or strand
+/// @return the connected endpoint
+/// @throws system_error containing the last error seen if no endpoint accepts the connection
+asio::awaitable< tcp::endpoint >
+connect_any(tcp::socket                        &sock,
+            tcp::resolver::results_type const &endpoints,
+            std::chrono::milliseconds           stagger = std::chrono::milliseconds(0));
+
+/// @brief Resolve the host and connect to whichever resolved endpoint accepts first.
+/// @see connect_any
 asio::awaitable< tcp::endpoint >
 connect(tcp::socket &sock, std::string const &host, std::string const &service);
 
+/// @brief Connect and perform the TLS handshake, offering the session cached in the stream's context for host:port.
+/// @see tls_session_cache
 asio::awaitable< void >
 connect(ssl::stream< tcp::socket > &stream, std::string const &host, std::string const &port);
 
@@ -29,5 +48,9 @@ connect(websocket::stream< ssl::stream< tcp::socket > > &stream,
         std::string const                               &host,
         std::string const                               &port,
         std::string const                               &path);
+
+/// @brief Perform the websocket handshake on a stream whose TLS layer is already connected.
+asio::awaitable< void >
+upgrade(websocket::stream< ssl::stream< tcp::socket > > &stream, std::string const &host, std::string const &path);
 }   // namespace arby::network
 #endif   // ARBY_LIB_NETWORK_CONNECT_SSL_HPP
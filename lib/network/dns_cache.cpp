@@ -0,0 +1,105 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "dns_cache.hpp"
+
+namespace arby::network
+{
+namespace
+{
+std::string
+make_key(std::string const &host, std::string const &service)
+{
+    auto key = std::string();
+    key.reserve(host.size() + 1 + service.size());
+    key += host;
+    key += ':';
+    key += service;
+    return key;
+}
+}   // namespace
+
+dns_cache &
+dns_cache::instance()
+{
+    static dns_cache cache;
+    return cache;
+}
+
+std::optional< tcp::resolver::results_type >
+dns_cache::lookup(std::string const &host, std::string const &service, clock::time_point now)
+{
+    auto lock = std::unique_lock(m_);
+    auto i    = entries_.find(make_key(host, service));
+    if (i == entries_.end() || now - i->second.stored >= ttl_)
+    {
+        ++misses_;
+        return std::nullopt;
+    }
+    ++hits_;
+    return i->second.results;
+}
+
+void
+dns_cache::store(std::string const                 &host,
+                 std::string const                 &service,
+                 tcp::resolver::results_type const &results,
+                 clock::time_point                  now)
+{
+    auto lock = std::unique_lock(m_);
+    if (ttl_ == clock::duration::zero() || results.empty())
+        return;
+    entries_.insert_or_assign(make_key(host, service), entry { .results = results, .stored = now });
+}
+
+void
+dns_cache::invalidate(std::string const &host, std::string const &service)
+{
+    auto lock = std::unique_lock(m_);
+    entries_.erase(make_key(host, service));
+}
+
+void
+dns_cache::clear()
+{
+    auto lock = std::unique_lock(m_);
+    entries_.clear();
+}
+
+void
+dns_cache::ttl(clock::duration value)
+{
+    auto lock = std::unique_lock(m_);
+    ttl_      = value;
+    if (ttl_ == clock::duration::zero())
+        entries_.clear();
+}
+
+dns_cache::clock::duration
+dns_cache::ttl() const
+{
+    auto lock = std::unique_lock(m_);
+    return ttl_;
+}
+
+std::uint64_t
+dns_cache::hits() const
+{
+    auto lock = std::unique_lock(m_);
+    return hits_;
+}
+
+std::uint64_t
+dns_cache::misses() const
+{
+    auto lock = std::unique_lock(m_);
+    return misses_;
+}
+
+}   // namespace arby::network
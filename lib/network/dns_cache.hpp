@@ -0,0 +1,81 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_LIB_NETWORK_DNS_CACHE_HPP
+#define ARBY_LIB_NETWORK_DNS_CACHE_HPP
+
+#include "config/asio.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace arby::network
+{
+/// Process-wide cache of resolver results, keyed by host:service.
+///
+/// The system resolver does not report record TTLs, so every entry lives for the same configured time.
+/// @note All members are thread-safe.
+struct dns_cache
+{
+    using clock = std::chrono::steady_clock;
+
+    static dns_cache &
+    instance();
+
+    /// @return the cached results, if present and younger than the ttl
+    std::optional< tcp::resolver::results_type >
+    lookup(std::string const &host, std::string const &service, clock::time_point now = clock::now());
+
+    void
+    store(std::string const                 &host,
+          std::string const                 &service,
+          tcp::resolver::results_type const &results,
+          clock::time_point                  now = clock::now());
+
+    /// Forget the results for host:service, for example because none of the endpoints accepted a connection.
+    void
+    invalidate(std::string const &host, std::string const &service);
+
+    void
+    clear();
+
+    /// Set the lifetime of entries. A zero ttl disables the cache.
+    void
+    ttl(clock::duration value);
+
+    clock::duration
+    ttl() const;
+
+    std::uint64_t
+    hits() const;
+
+    std::uint64_t
+    misses() const;
+
+  private:
+    struct entry
+    {
+        tcp::resolver::results_type results;
+        clock::time_point           stored;
+    };
+
+    mutable std::mutex                        m_;
+    std::unordered_map< std::string, entry > entries_;
+    clock::duration                           ttl_    = std::chrono::seconds(60);
+    std::uint64_t                             hits_   = 0;
+    std::uint64_t                             misses_ = 0;
+};
+
+}   // namespace arby::network
+
+#endif   // ARBY_LIB_NETWORK_DNS_CACHE_HPP
@@ -0,0 +1,176 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "tls_session_cache.hpp"
+
+#include <openssl/ssl.h>
+
+#include <stdexcept>
+
+namespace arby::network
+{
+namespace
+{
+std::string
+make_key(std::string const &host, std::string const &service)
+{
+    auto key = std::string();
+    key.reserve(host.size() + 1 + service.size());
+    key += host;
+    key += ':';
+    key += service;
+    return key;
+}
+
+/// The cache owned by an SSL_CTX, deleted when the context is freed.
+int
+ctx_index()
+{
+    static const int index = SSL_CTX_get_ex_new_index(
+        0,
+        nullptr,
+        nullptr,
+        nullptr,
+        [](void *, void *ptr, CRYPTO_EX_DATA *, int, long, void *) { delete static_cast< tls_session_cache * >(ptr); });
+    if (index < 0)
+        throw std::runtime_error("tls_session_cache: no context ex_data index");
+    return index;
+}
+
+/// The host:port key of an SSL, deleted when the SSL is freed.
+int
+ssl_index()
+{
+    static const int index = SSL_get_ex_new_index(
+        0,
+        nullptr,
+        nullptr,
+        nullptr,
+        [](void *, void *ptr, CRYPTO_EX_DATA *, int, long, void *) { delete static_cast< std::string * >(ptr); });
+    if (index < 0)
+        throw std::runtime_error("tls_session_cache: no ssl ex_data index");
+    return index;
+}
+}   // namespace
+
+tls_session_cache &
+tls_session_cache::of(SSL_CTX *ctx)
+{
+    // serialises attachment so that two first connections cannot attach two caches
+    static std::mutex m;
+    auto              lock = std::unique_lock(m);
+
+    if (auto *existing = SSL_CTX_get_ex_data(ctx, ctx_index()))
+        return *static_cast< tls_session_cache * >(existing);
+
+    auto *cache = new tls_session_cache();
+    SSL_CTX_set_ex_data(ctx, ctx_index(), cache);
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx, &tls_session_cache::on_new_session);
+    return *cache;
+}
+
+tls_session_cache::~tls_session_cache()
+{
+    clear();
+}
+
+SSL_SESSION const *
+tls_session_cache::prepare(SSL *ssl, std::string const &host, std::string const &service)
+{
+    auto key = make_key(host, service);
+
+    delete static_cast< std::string * >(SSL_get_ex_data(ssl, ssl_index()));
+    SSL_set_ex_data(ssl, ssl_index(), new std::string(key));
+
+    auto lock = std::unique_lock(m_);
+    auto i    = sessions_.find(key);
+    if (i == sessions_.end())
+        return nullptr;
+
+    // offer a copy, for the reason given in on_new_session(): a resumed connection which ends without a clean shutdown
+    // marks the session it resumed as not resumable, which would spoil the cached one for the next reconnect
+    auto *copy = SSL_SESSION_dup(i->second);
+    if (!copy)
+        return nullptr;
+    // SSL_set_session takes its own reference
+    auto offered = SSL_set_session(ssl, copy) == 1;
+    SSL_SESSION_free(copy);
+    return offered ? i->second : nullptr;
+}
+
+void
+tls_session_cache::erase(std::string const &host, std::string const &service)
+{
+    auto lock = std::unique_lock(m_);
+    if (auto i = sessions_.find(make_key(host, service)); i != sessions_.end())
+    {
+        SSL_SESSION_free(i->second);
+        sessions_.erase(i);
+    }
+}
+
+void
+tls_session_cache::erase(std::string const &host, std::string const &service, SSL_SESSION const *offered)
+{
+    auto lock = std::unique_lock(m_);
+    if (auto i = sessions_.find(make_key(host, service)); i != sessions_.end() && i->second == offered)
+    {
+        SSL_SESSION_free(i->second);
+        sessions_.erase(i);
+    }
+}
+
+void
+tls_session_cache::clear()
+{
+    auto lock = std::unique_lock(m_);
+    for (auto &[key, session] : sessions_)
+        SSL_SESSION_free(session);
+    sessions_.clear();
+}
+
+std::size_t
+tls_session_cache::size() const
+{
+    auto lock = std::unique_lock(m_);
+    return sessions_.size();
+}
+
+int
+tls_session_cache::on_new_session(SSL *ssl, SSL_SESSION *session)
+{
+    auto *key = static_cast< std::string * >(SSL_get_ex_data(ssl, ssl_index()));
+    if (!key || !SSL_SESSION_is_resumable(session))
+        return 0;
+
+    auto *cache = static_cast< tls_session_cache * >(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), ctx_index()));
+    if (!cache)
+        return 0;
+
+    // keep a copy. OpenSSL marks the connection's own session as not resumable if the connection is freed without a
+    // clean shutdown, which is exactly how the connections we want to resume usually end.
+    if (auto *copy = SSL_SESSION_dup(session))
+        cache->store(*key, copy);
+    return 0;
+}
+
+void
+tls_session_cache::store(std::string const &key, SSL_SESSION *session)
+{
+    auto lock = std::unique_lock(m_);
+    auto [i, inserted] = sessions_.try_emplace(key, session);
+    if (!inserted)
+    {
+        SSL_SESSION_free(i->second);
+        i->second = session;
+    }
+}
+
+}   // namespace arby::network
@@ -0,0 +1,83 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_LIB_NETWORK_TLS_SESSION_CACHE_HPP
+#define ARBY_LIB_NETWORK_TLS_SESSION_CACHE_HPP
+
+#include "config/asio.hpp"
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace arby::network
+{
+/// Client-side cache of TLS sessions, keyed by host:port.
+///
+/// A cache is attached to an SSL_CTX on first use and lives as long as the context. Attaching it enables client-side
+/// session caching on the context, so OpenSSL hands over every session the server issues, including TLS 1.3 tickets
+/// which arrive after the handshake. A stream prepared with the cache offers the last session issued for its
+/// host:port, which lets the server resume it with an abbreviated handshake.
+/// @note All members are thread-safe.
+struct tls_session_cache
+{
+    /// Return the cache attached to the context, attaching a new one if there is none.
+    static tls_session_cache &
+    of(SSL_CTX *ctx);
+
+    static tls_session_cache &
+    of(ssl::context &ctx)
+    {
+        return of(ctx.native_handle());
+    }
+
+    tls_session_cache(tls_session_cache const &) = delete;
+    tls_session_cache &
+    operator=(tls_session_cache const &) = delete;
+
+    ~tls_session_cache();
+
+    /// Prepare an unconnected stream for a handshake with host:port. Offer the cached session if there is one, and
+    /// store any session issued on the stream under the same key.
+    /// @return the session offered, or nullptr if there was none
+    SSL_SESSION const *
+    prepare(SSL *ssl, std::string const &host, std::string const &service);
+
+    /// Forget the session for host:port.
+    void
+    erase(std::string const &host, std::string const &service);
+
+    /// Forget the session for host:port if it is still the one offered, after the server declined it. A session the
+    /// server issued during the same handshake has replaced it, and is kept.
+    void
+    erase(std::string const &host, std::string const &service, SSL_SESSION const *offered);
+
+    void
+    clear();
+
+    std::size_t
+    size() const;
+
+  private:
+    tls_session_cache() = default;
+
+    static int
+    on_new_session(SSL *ssl, SSL_SESSION *session);
+
+    void
+    store(std::string const &key, SSL_SESSION *session);
+
+    mutable std::mutex                               m_;
+    std::unordered_map< std::string, SSL_SESSION * > sessions_;   // each holds one reference
+};
+
+}   // namespace arby::network
+
+#endif   // ARBY_LIB_NETWORK_TLS_SESSION_CACHE_HPP
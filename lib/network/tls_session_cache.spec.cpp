@@ -0,0 +1,223 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "network/connect_ssl.hpp"
+#include "network/dns_cache.hpp"
+#include "network/tls_session_cache.hpp"
+
+#include <doctest/doctest.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace arby;
+
+namespace
+{
+/// Give the server context a throwaway certificate for CN=localhost.
+void
+use_self_signed_certificate(ssl::context &ctx)
+{
+    EVP_PKEY *pkey = nullptr;
+    auto     *kctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+    REQUIRE(EVP_PKEY_keygen_init(kctx) == 1);
+    REQUIRE(EVP_PKEY_CTX_set_ec_paramgen_curve_nid(kctx, NID_X9_62_prime256v1) == 1);
+    REQUIRE(EVP_PKEY_keygen(kctx, &pkey) == 1);
+    EVP_PKEY_CTX_free(kctx);
+
+    auto *cert = X509_new();
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+    X509_set_pubkey(cert, pkey);
+    auto *name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast< unsigned char const * >("localhost"), -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+    REQUIRE(X509_sign(cert, pkey, EVP_sha256()) > 0);
+
+    REQUIRE(SSL_CTX_use_certificate(ctx.native_handle(), cert) == 1);
+    REQUIRE(SSL_CTX_use_PrivateKey(ctx.native_handle(), pkey) == 1);
+    X509_free(cert);
+    EVP_PKEY_free(pkey);
+}
+
+/// A stand-in for the venue. Each connection is handshaken and sent one byte, so that the client reads any session
+/// tickets which follow the handshake, then closed.
+asio::awaitable< void >
+serve(tcp::acceptor &acceptor, ssl::context &ctx, int connections)
+{
+    using asio::redirect_error;
+    using asio::use_awaitable;
+
+    for (int i = 0; i < connections; ++i)
+    {
+        auto stream = ssl::stream< tcp::socket >(co_await acceptor.async_accept(use_awaitable), ctx);
+        co_await stream.async_handshake(ssl::stream_base::server, use_awaitable);
+        co_await asio::async_write(stream, asio::buffer("x", 1), use_awaitable);
+        error_code ec;
+        co_await stream.async_shutdown(redirect_error(use_awaitable, ec));
+    }
+}
+
+struct connect_result
+{
+    std::chrono::steady_clock::duration elapsed;
+    bool                                resumed;
+};
+
+asio::awaitable< connect_result >
+connect_once(ssl::context &ctx, std::string const &port)
+{
+    using asio::use_awaitable;
+
+    auto stream = ssl::stream< tcp::socket >(co_await asio::this_coro::executor, ctx);
+    auto t0     = std::chrono::steady_clock::now();
+    co_await network::connect(stream, "127.0.0.1", port);
+    auto result = connect_result { .elapsed = std::chrono::steady_clock::now() - t0,
+                                   .resumed = SSL_session_reused(stream.native_handle()) == 1 };
+
+    char c;
+    co_await asio::async_read(stream, asio::buffer(&c, 1), use_awaitable);
+    stream.next_layer().close();
+    co_return result;
+}
+
+std::chrono::microseconds
+mean(std::chrono::steady_clock::duration total, int n)
+{
+    return std::chrono::duration_cast< std::chrono::microseconds >(total / n);
+}
+}   // namespace
+
+TEST_SUITE("network")
+{
+    TEST_CASE("dns_cache")
+    {
+        auto cache = network::dns_cache();
+        auto t0    = network::dns_cache::clock::time_point();
+        auto eps   = tcp::resolver::results_type::create(tcp::endpoint(ip::make_address("127.0.0.1"), 443), "h", "443");
+
+        CHECK_FALSE(cache.lookup("h", "443", t0));
+        cache.store("h", "443", eps, t0);
+        REQUIRE(cache.lookup("h", "443", t0 + std::chrono::seconds(1)));
+        CHECK(cache.lookup("h", "443", t0 + std::chrono::seconds(1))->begin()->endpoint().port() == 443);
+        CHECK_FALSE(cache.lookup("h", "443", t0 + cache.ttl()));
+        CHECK(cache.hits() == 2);
+        CHECK(cache.misses() == 2);
+
+        cache.store("h", "443", eps, t0);
+        cache.invalidate("h", "443");
+        CHECK_FALSE(cache.lookup("h", "443", t0));
+    }
+
+    TEST_CASE("tls sessions are resumed on reconnect")
+    {
+        constexpr int rounds = 20;
+
+        auto ioc        = asio::io_context();
+        auto server_ctx = ssl::context(ssl::context::tls_server);
+        use_self_signed_certificate(server_ctx);
+
+        auto acceptor = tcp::acceptor(ioc, tcp::endpoint(ip::make_address("127.0.0.1"), 0));
+        auto port     = std::to_string(acceptor.local_endpoint().port());
+
+        asio::co_spawn(ioc, serve(acceptor, server_ctx, 2 * rounds), asio::detached);
+
+        auto full    = std::chrono::steady_clock::duration::zero();
+        auto resumed = std::chrono::steady_clock::duration::zero();
+        auto reused  = 0;
+
+        asio::co_spawn(
+            ioc,
+            [&]() -> asio::awaitable< void >
+            {
+                // before: a fresh client context for every connection, so every handshake is a full one
+                for (int i = 0; i < rounds; ++i)
+                {
+                    auto ctx = ssl::context(ssl::context::tls_client);
+                    auto r   = co_await connect_once(ctx, port);
+                    CHECK_FALSE(r.resumed);
+                    full += r.elapsed;
+                }
+
+                // after: one context, whose cache offers the previous session on every reconnect
+                auto ctx = ssl::context(ssl::context::tls_client);
+                for (int i = 0; i < rounds; ++i)
+                {
+                    auto r = co_await connect_once(ctx, port);
+                    if (i > 0)
+                    {
+                        reused += r.resumed;
+                        resumed += r.elapsed;
+                    }
+                }
+                CHECK(network::tls_session_cache::of(ctx).size() == 1);
+            },
+            asio::detached);
+
+        ioc.run();
+
+        CHECK(reused == rounds - 1);
+        MESSAGE("mean reconnect latency: full handshake " << mean(full, rounds).count() << "us, resumed "
+                                                          << mean(resumed, rounds - 1).count() << "us");
+    }
+
+    TEST_CASE("tls 1.2 sessions are resumed on every reconnect")
+    {
+        // under TLS 1.2 a session arrives during the handshake rather than after it, and a resumed connection issues
+        // none, so the cached session must survive both the connections which resume it and one which is declined
+        auto ioc        = asio::io_context();
+        auto server_ctx = ssl::context(ssl::context::tls_server);
+        auto restarted  = ssl::context(ssl::context::tls_server);
+        for (auto *ctx : { &server_ctx, &restarted })
+        {
+            use_self_signed_certificate(*ctx);
+            REQUIRE(SSL_CTX_set_max_proto_version(ctx->native_handle(), TLS1_2_VERSION) == 1);
+        }
+
+        auto acceptor = tcp::acceptor(ioc, tcp::endpoint(ip::make_address("127.0.0.1"), 0));
+        auto port     = std::to_string(acceptor.local_endpoint().port());
+
+        // the venue restarts after four connections, and no longer knows the sessions it issued
+        asio::co_spawn(
+            ioc,
+            [&]() -> asio::awaitable< void >
+            {
+                co_await serve(acceptor, server_ctx, 4);
+                co_await serve(acceptor, restarted, 2);
+            },
+            asio::detached);
+
+        auto resumed = std::vector< bool >();
+        asio::co_spawn(
+            ioc,
+            [&]() -> asio::awaitable< void >
+            {
+                auto ctx = ssl::context(ssl::context::tls_client);
+                for (int i = 0; i < 6; ++i)
+                    resumed.push_back((co_await connect_once(ctx, port)).resumed);
+            },
+            asio::detached);
+
+        ioc.run();
+
+        REQUIRE(resumed.size() == 6);
+        CHECK_FALSE(resumed[0]);
+        CHECK(resumed[1]);
+        CHECK(resumed[2]);
+        CHECK(resumed[3]);
+        CHECK_FALSE(resumed[4]);
+        CHECK(resumed[5]);
+    }
+}
@@ -19,6 +19,11 @@ namespace util
     , connection_(std::move(connection))
     {
     }
+    cross_executor_connection::cross_executor_connection(std::shared_ptr< has_executor_base > owner, util::connection connection)
+    : owner_(std::move(owner))
+    , connection_(std::move(connection))
+    {
+    }
     cross_executor_connection::cross_executor_connection(cross_executor_connection &&other)
     : owner_(std::move(other.owner_))
     , connection_(std::move(other.connection_))
@@ -37,7 +42,9 @@ namespace util
     {
         if (owner_)
         {
-            asio::dispatch(owner_->get_executor(), [owner = owner_, connection = connection_] { connection.disconnect(); });
+            asio::dispatch(owner_->get_executor(),
+                           [owner = owner_, connection = connection_]() mutable
+                           { visit([](auto &c) { c.disconnect(); }, connection); });
         }
     }
 }   // namespace util
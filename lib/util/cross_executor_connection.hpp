@@ -11,8 +11,10 @@
 #define ARBY_LIB_UTIL_CROSS_EXECUTOR_CONNECTION_HPP
 
 #include "config/asio.hpp"
+#include "util/signal.hpp"
 
 #include <boost/signals2/connection.hpp>
+#include <boost/variant2/variant.hpp>
 
 namespace arby
 {
@@ -36,10 +38,16 @@ namespace util
         asio::any_io_executor exec_;
     };
 
+    /// @brief A connection to a signal owned by an object on another executor. Disconnection is marshalled onto the
+    /// owner's executor. Either a boost::signals2 or a util::signal connection may be held.
     struct cross_executor_connection
     {
+        using connection_type = boost::variant2::variant< boost::signals2::connection, util::connection >;
+
         cross_executor_connection(std::shared_ptr< has_executor_base > owner = {}, boost::signals2::connection connection = {});
 
+        cross_executor_connection(std::shared_ptr< has_executor_base > owner, util::connection connection);
+
         cross_executor_connection(cross_executor_connection &&other);
 
         cross_executor_connection &
@@ -52,7 +60,7 @@ namespace util
 
       private:
         std::shared_ptr< has_executor_base > owner_;
-        boost::signals2::connection          connection_;
+        connection_type                      connection_;
     };
 
 }   // namespace util
@@ -0,0 +1,300 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_LIB_UTIL_DELIVERY_QUEUE_HPP
+#define ARBY_LIB_UTIL_DELIVERY_QUEUE_HPP
+
+#include "config/asio.hpp"
+#include "util/free_list.hpp"
+#include "util/lockfree_channel.hpp"
+#include "util/recycling_allocator.hpp"
+#include "util/signal.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace arby::util
+{
+enum class delivery_policy
+{
+    /// every value is delivered, through a bounded queue. Values which do not fit are dropped.
+    every,
+
+    /// only the newest value is delivered. A value replaced before delivery counts as dropped.
+    latest_only
+};
+
+struct delivery_stats
+{
+    std::uint64_t                       published = 0;
+    std::uint64_t                       delivered = 0;
+    std::uint64_t                       dropped   = 0;
+    std::chrono::steady_clock::duration last_lag {};
+    std::chrono::steady_clock::duration worst_lag {};
+};
+
+/// @brief Hands values from a single producer to a subscriber on the subscriber's own executor.
+///
+/// The producer never blocks and never waits for the subscriber. With delivery_policy::latest_only, publishing is
+/// an atomic exchange of the newest value; with delivery_policy::every it is a push into a bounded lock-free queue.
+/// Neither allocates once the queue has warmed up: latest_only recycles its slots through a free_list.
+/// Either way the subscriber's executor is only posted to when it has nothing scheduled already, so a subscriber
+/// which falls behind sees its pending values delivered in one batch.
+///
+/// Lag is the time from publish to the start of the handler, measured per delivered value.
+/// @tparam T is a nothrow-movable value type, typically a shared_ptr to an immutable snapshot
+template < class T >
+struct delivery_queue : std::enable_shared_from_this< delivery_queue< T > >
+{
+    using handler_type = std::function< void(T) >;
+    using clock_type   = std::chrono::steady_clock;
+
+    static constexpr std::size_t default_capacity = 64;
+
+    delivery_queue(asio::any_io_executor exec,
+                   delivery_policy       policy,
+                   handler_type          handler,
+                   std::size_t           capacity = default_capacity)
+    : exec_(std::move(exec))
+    , policy_(policy)
+    , handler_(std::move(handler))
+    , queue_(policy == delivery_policy::every ? capacity : 2)
+    {
+    }
+
+    /// @brief Offer a value to the subscriber. Producer only. Never blocks.
+    /// @return false if the queue has been cancelled, in which case the producer should stop publishing to it
+    bool
+    publish(T value)
+    {
+        if (cancelled_.load(std::memory_order_relaxed))
+            return false;
+
+        auto now = clock_type::now();
+        published_.fetch_add(1, std::memory_order_relaxed);
+        if (policy_ == delivery_policy::latest_only)
+        {
+            auto fresh = spare_slot();
+            fresh->value     = std::move(value);
+            fresh->published = now;
+            if (auto stale = latest_.exchange(fresh.release(), std::memory_order_acq_rel))
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                stale->value = T();
+                spare_.emplace_back(stale);
+            }
+        }
+        else if (!queue_.try_send(stamped { std::move(value), now }))
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // pairs with drain clearing the flag then looking for values
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!scheduled_.load(std::memory_order_relaxed) && !scheduled_.exchange(true, std::memory_order_relaxed))
+            asio::post(exec_, bind_recycling_allocator([self = this->shared_from_this()] { self->drain(); }));
+        return true;
+    }
+
+    /// @brief Stop delivery. Values not yet delivered are discarded. Thread-safe.
+    void
+    cancel()
+    {
+        cancelled_.store(true, std::memory_order_relaxed);
+    }
+
+    bool
+    cancelled() const
+    {
+        return cancelled_.load(std::memory_order_relaxed);
+    }
+
+    delivery_policy
+    policy() const
+    {
+        return policy_;
+    }
+
+    /// @brief A snapshot of the counters. Thread-safe.
+    delivery_stats
+    stats() const
+    {
+        auto result      = delivery_stats();
+        result.published = published_.load(std::memory_order_relaxed);
+        result.delivered = delivered_.load(std::memory_order_relaxed);
+        result.dropped   = dropped_.load(std::memory_order_relaxed);
+        result.last_lag  = clock_type::duration(last_lag_.load(std::memory_order_relaxed));
+        result.worst_lag = clock_type::duration(worst_lag_.load(std::memory_order_relaxed));
+        return result;
+    }
+
+    /// @brief Deliver to the subscriber whatever the producer publishes to a signal.
+    ///
+    /// The slot disconnects itself at the first emission after the queue is cancelled, so cancelling from the
+    /// subscriber's thread is enough to unsubscribe. Connect on the signal owner's executor.
+    template < class Signal >
+    void
+    attach(Signal &sig)
+    {
+        source_ = sig.connect(
+            [self = this->shared_from_this()](T const &value)
+            {
+                if (!self->publish(value))
+                    self->source_.disconnect();
+            });
+    }
+
+    ~delivery_queue()
+    {
+        delete latest_.exchange(nullptr);
+    }
+
+  private:
+    struct stamped
+    {
+        T                      value;
+        clock_type::time_point published;
+    };
+
+    struct latest_slot
+    : stamped
+    , free_list_hook
+    {
+    };
+
+    std::unique_ptr< latest_slot >
+    spare_slot()
+    {
+        if (spare_.empty())
+            returned_.reclaim([this](std::unique_ptr< latest_slot > p) { spare_.push_back(std::move(p)); });
+        if (spare_.empty())
+            return std::make_unique< latest_slot >();
+        auto p = std::move(spare_.back());
+        spare_.pop_back();
+        return p;
+    }
+
+    void
+    drain()
+    {
+        // clear first: a value published from here on schedules another drain
+        scheduled_.store(false, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (policy_ == delivery_policy::latest_only)
+        {
+            if (auto p = std::unique_ptr< latest_slot >(latest_.exchange(nullptr, std::memory_order_acq_rel)))
+            {
+                deliver(std::move(*p));
+                p->value = T();
+                returned_.release(std::move(p));
+            }
+        }
+        else
+        {
+            // anything beyond what was queued when the flag was cleared has a drain of its own coming, and
+            // stopping here stops a fast producer from starving the subscriber's executor
+            auto s = stamped();
+            for (auto n = queue_.capacity(); n-- && queue_.try_receive(s);)
+                deliver(std::move(s));
+        }
+    }
+
+    void
+    deliver(stamped &&s)
+    {
+        if (cancelled_.load(std::memory_order_relaxed))
+            return;
+        auto lag = (clock_type::now() - s.published).count();
+        last_lag_.store(lag, std::memory_order_relaxed);
+        if (lag > worst_lag_.load(std::memory_order_relaxed))
+            worst_lag_.store(lag, std::memory_order_relaxed);
+        delivered_.fetch_add(1, std::memory_order_relaxed);
+        handler_(std::move(s.value));
+    }
+
+    asio::any_io_executor const exec_;
+    delivery_policy const       policy_;
+    handler_type                handler_;
+
+    // owned by the producer
+    connection                                     source_;
+    std::vector< std::unique_ptr< latest_slot > > spare_;
+
+    spsc_channel< stamped >      queue_;
+    std::atomic< latest_slot * > latest_ { nullptr };
+    free_list< latest_slot >     returned_;
+    std::atomic< bool >          scheduled_ { false };
+    std::atomic< bool >          cancelled_ { false };
+
+    std::atomic< std::uint64_t >             published_ { 0 };
+    std::atomic< std::uint64_t >             delivered_ { 0 };
+    std::atomic< std::uint64_t >             dropped_ { 0 };
+    std::atomic< clock_type::duration::rep > last_lag_ { 0 };
+    std::atomic< clock_type::duration::rep > worst_lag_ { 0 };
+};
+
+/// @brief The subscriber's handle to a delivery_queue. Cancels delivery when destroyed.
+template < class T >
+struct delivery_subscription
+{
+    delivery_subscription() = default;
+
+    explicit delivery_subscription(std::shared_ptr< delivery_queue< T > > queue)
+    : queue_(std::move(queue))
+    {
+    }
+
+    delivery_subscription(delivery_subscription &&other) noexcept = default;
+
+    delivery_subscription &
+    operator=(delivery_subscription &&other) noexcept
+    {
+        if (this != &other)
+        {
+            cancel();
+            queue_ = std::move(other.queue_);
+        }
+        return *this;
+    }
+
+    ~delivery_subscription() { cancel(); }
+
+    void
+    cancel()
+    {
+        if (auto q = std::exchange(queue_, nullptr))
+            q->cancel();
+    }
+
+    bool
+    active() const
+    {
+        return queue_ && !queue_->cancelled();
+    }
+
+    delivery_stats
+    stats() const
+    {
+        return queue_ ? queue_->stats() : delivery_stats();
+    }
+
+  private:
+    std::shared_ptr< delivery_queue< T > > queue_;
+};
+
+}   // namespace arby::util
+
+#endif   // ARBY_LIB_UTIL_DELIVERY_QUEUE_HPP
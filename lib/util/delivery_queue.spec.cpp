@@ -0,0 +1,122 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "util/delivery_queue.hpp"
+
+#include <doctest/doctest.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace arby;
+
+TEST_SUITE("util")
+{
+    TEST_CASE("delivery_queue every")
+    {
+        auto ioc  = asio::io_context();
+        auto seen = std::vector< int >();
+        auto q    = std::make_shared< util::delivery_queue< int > >(
+            ioc.get_executor(), util::delivery_policy::every, [&](int v) { seen.push_back(v); }, 4);
+
+        // the subscriber is not running: the first four fit, the rest are dropped
+        for (int i = 0; i < 10; ++i)
+            CHECK(q->publish(i));
+        ioc.run();
+
+        CHECK(seen == std::vector< int > { 0, 1, 2, 3 });
+        auto stats = q->stats();
+        CHECK(stats.published == 10);
+        CHECK(stats.delivered == 4);
+        CHECK(stats.dropped == 6);
+    }
+
+    TEST_CASE("delivery_queue latest_only")
+    {
+        auto ioc  = asio::io_context();
+        auto seen = std::vector< int >();
+        auto q    = std::make_shared< util::delivery_queue< std::shared_ptr< int const > > >(
+            ioc.get_executor(),
+            util::delivery_policy::latest_only,
+            [&](std::shared_ptr< int const > v) { seen.push_back(*v); });
+
+        for (int i = 0; i < 10; ++i)
+            q->publish(std::make_shared< int const >(i));
+        ioc.run();
+        CHECK(seen == std::vector< int > { 9 });
+
+        q->publish(std::make_shared< int const >(10));
+        ioc.restart();
+        ioc.run();
+        CHECK(seen == std::vector< int > { 9, 10 });
+
+        auto stats = q->stats();
+        CHECK(stats.published == 11);
+        CHECK(stats.delivered == 2);
+        CHECK(stats.dropped == 9);
+        CHECK(stats.worst_lag >= stats.last_lag);
+    }
+
+    TEST_CASE("delivery_subscription detaches from the signal")
+    {
+        auto ioc   = asio::io_context();
+        auto sig   = util::signal< void(int) >();
+        auto count = 0;
+        auto q     = std::make_shared< util::delivery_queue< int > >(
+            ioc.get_executor(), util::delivery_policy::every, [&](int) { ++count; });
+        q->attach(sig);
+        auto sub = util::delivery_subscription< int >(q);
+        q.reset();
+
+        sig(1);
+        sig(2);
+        ioc.run();
+        CHECK(count == 2);
+        CHECK(sub.stats().delivered == 2);
+
+        sub.cancel();
+        CHECK_FALSE(sub.active());
+        sig(3);
+        CHECK(sig.empty());
+        ioc.restart();
+        ioc.run();
+        CHECK(count == 2);
+    }
+
+    TEST_CASE("delivery_queue across threads")
+    {
+        constexpr int total = 200000;
+
+        auto ioc      = asio::io_context();
+        auto guard    = asio::make_work_guard(ioc);
+        auto last     = -1;
+        auto in_order = true;
+        auto q        = std::make_shared< util::delivery_queue< int > >(
+            ioc.get_executor(),
+            util::delivery_policy::latest_only,
+            [&](int v)
+            {
+                in_order &= v > last;
+                last = v;
+            });
+
+        auto consumer = std::thread([&] { ioc.run(); });
+        for (int i = 0; i < total; ++i)
+            q->publish(i);
+        asio::post(ioc, [&] { guard.reset(); });
+        consumer.join();
+
+        auto stats = q->stats();
+        CHECK(in_order);
+        CHECK(last == total - 1);
+        CHECK(stats.delivered + stats.dropped == total);
+        MESSAGE("delivered " << stats.delivered << " of " << total);
+    }
+}
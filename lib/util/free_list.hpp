@@ -0,0 +1,119 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_LIB_UTIL_FREE_LIST_HPP
+#define ARBY_LIB_UTIL_FREE_LIST_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace arby::util
+{
+/// @brief The intrusive link of an object which can be returned to a free_list.
+struct free_list_hook
+{
+    free_list_hook() = default;
+
+    // an object's place on a free list is not part of its value
+    free_list_hook(free_list_hook const &) noexcept {}
+    free_list_hook &
+    operator=(free_list_hook const &) noexcept
+    {
+        return *this;
+    }
+
+  private:
+    template < class T >
+    friend struct free_list;
+
+    free_list_hook *free_list_next_ = nullptr;
+};
+
+/// @brief A lock-free stack of released objects, for recycling objects which are released on other threads.
+///
+/// Any thread may release an object with a single compare-and-swap. The owner reclaims everything released so far
+/// with a single exchange. Because objects are never popped one at a time there is no ABA problem, so no tagged
+/// pointers are needed.
+///
+/// The pool is normally held in a shared_ptr which the shared_ptr deleter of each handed-out object also holds, so
+/// that objects released after their owner has gone are still deleted, when the pool is.
+template < class T >
+struct free_list
+{
+    static_assert(std::is_base_of_v< free_list_hook, T >);
+
+    /// @brief A shared_ptr deleter which releases the object to the pool.
+    struct deleter
+    {
+        std::shared_ptr< free_list > pool;
+
+        void
+        operator()(T *p) const noexcept
+        {
+            pool->release(std::unique_ptr< T >(p));
+        }
+    };
+
+    free_list() = default;
+
+    free_list(free_list const &) = delete;
+    free_list &
+    operator=(free_list const &) = delete;
+
+    ~free_list()
+    {
+        reclaim([](std::unique_ptr< T >) {});
+    }
+
+    /// @brief Return an object to the pool. Thread-safe.
+    void
+    release(std::unique_ptr< T > p) noexcept
+    {
+        free_list_hook *node  = p.release();
+        node->free_list_next_ = head_.load(std::memory_order_relaxed);
+        while (!head_.compare_exchange_weak(
+            node->free_list_next_, node, std::memory_order_release, std::memory_order_relaxed))
+            ;
+    }
+
+    /// @brief Take every object released so far, most recent first. Thread-safe.
+    /// @param f is invoked with each object as a std::unique_ptr< T >
+    /// @return the number of objects reclaimed
+    template < class F >
+    std::size_t
+    reclaim(F &&f)
+    {
+        std::size_t count = 0;
+        auto       *node  = head_.exchange(nullptr, std::memory_order_acquire);
+        while (node)
+        {
+            auto *next = std::exchange(node->free_list_next_, nullptr);
+            f(std::unique_ptr< T >(static_cast< T * >(node)));
+            node = next;
+            ++count;
+        }
+        return count;
+    }
+
+    bool
+    empty() const
+    {
+        return !head_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::atomic< free_list_hook * > head_ { nullptr };
+};
+
+}   // namespace arby::util
+
+#endif   // ARBY_LIB_UTIL_FREE_LIST_HPP
@@ -0,0 +1,80 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "util/free_list.hpp"
+
+#include <doctest/doctest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace arby;
+
+namespace
+{
+std::atomic< int > live_items { 0 };
+
+struct item : util::free_list_hook
+{
+    item() { ++live_items; }
+    ~item() { --live_items; }
+
+    int value = 0;
+};
+}   // namespace
+
+TEST_SUITE("util")
+{
+    TEST_CASE("free_list")
+    {
+        constexpr int threads = 4;
+        constexpr int per     = 10000;
+
+        auto pool = std::make_shared< util::free_list< item > >();
+        {
+            auto handed_out = std::vector< std::shared_ptr< item > >();
+            for (int i = 0; i < threads * per; ++i)
+                handed_out.push_back(std::shared_ptr< item >(new item, util::free_list< item >::deleter { pool }));
+
+            // subscribers release on their own threads while the owner reclaims
+            auto releasers = std::vector< std::thread >();
+            for (int t = 0; t < threads; ++t)
+                releasers.emplace_back(
+                    [&, t]
+                    {
+                        for (int i = t * per; i < (t + 1) * per; ++i)
+                            handed_out[i].reset();
+                    });
+
+            auto reclaimed = std::vector< std::unique_ptr< item > >();
+            auto take      = [&](std::unique_ptr< item > p) { reclaimed.push_back(std::move(p)); };
+            while (reclaimed.size() < std::size_t(threads * per))
+                pool->reclaim(take);
+            for (auto &t : releasers)
+                t.join();
+
+            CHECK(pool->empty());
+            CHECK(live_items == threads * per);
+        }
+        CHECK(live_items == 0);
+    }
+
+    TEST_CASE("free_list outlives its owner")
+    {
+        auto snap = std::shared_ptr< item >();
+        {
+            auto pool = std::make_shared< util::free_list< item > >();
+            snap      = std::shared_ptr< item >(new item, util::free_list< item >::deleter { pool });
+        }
+        CHECK(live_items == 1);
+        snap.reset();
+        CHECK(live_items == 0);
+    }
+}
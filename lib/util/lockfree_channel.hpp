@@ -0,0 +1,349 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_LIB_UTIL_LOCKFREE_CHANNEL_HPP
+#define ARBY_LIB_UTIL_LOCKFREE_CHANNEL_HPP
+
+#include "config/asio.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace arby::util
+{
+enum class producers
+{
+    single,
+    multiple
+};
+
+namespace detail
+{
+    /// A parked async_wait. Ownership passes to whoever takes it out of the channel's waiter slot.
+    struct channel_wait_op
+    {
+        /// Complete the wait by posting to the waiter's executor. May be called from any thread.
+        virtual void
+        complete(error_code ec) = 0;
+
+      protected:
+        ~channel_wait_op() = default;
+    };
+
+    template < class Executor, class Handler >
+    struct channel_wait_op_model final : channel_wait_op
+    {
+        using allocator_type = asio::associated_allocator_t< Handler >;
+
+        static channel_wait_op_model *
+        construct(Executor e, Handler handler)
+        {
+            auto alloc  = rebound(asio::get_associated_allocator(handler));
+            auto traits = std::allocator_traits< decltype(alloc) >();
+            auto pmem   = traits.allocate(alloc, 1);
+            try
+            {
+                return new (pmem) channel_wait_op_model(std::move(e), std::move(handler));
+            }
+            catch (...)
+            {
+                traits.deallocate(alloc, pmem, 1);
+                throw;
+            }
+        }
+
+        template < class Cancel >
+        void
+        on_cancel(Cancel cancel)
+        {
+            auto slot = asio::get_associated_cancellation_slot(handler_);
+            if (slot.is_connected())
+                slot.assign(
+                    [cancel](asio::cancellation_type type)
+                    {
+                        if (!!(type & (asio::cancellation_type::terminal | asio::cancellation_type::partial |
+                                       asio::cancellation_type::total)))
+                            cancel();
+                    });
+        }
+
+        void
+        complete(error_code ec) override
+        {
+            // the handler's cancellation slot may only be touched on the waiter's executor
+            auto e = work_guard_.get_executor();
+            asio::post(e, asio::bind_allocator(asio::get_associated_allocator(handler_), [this, ec] { invoke(ec); }));
+        }
+
+      private:
+        channel_wait_op_model(Executor e, Handler handler)
+        : work_guard_(std::move(e))
+        , handler_(std::move(handler))
+        {
+        }
+
+        static auto
+        rebound(allocator_type const &halloc)
+        {
+            return typename std::allocator_traits< allocator_type >::template rebind_alloc< channel_wait_op_model >(halloc);
+        }
+
+        void
+        invoke(error_code ec)
+        {
+            asio::get_associated_cancellation_slot(handler_).clear();
+            auto g     = std::move(work_guard_);
+            auto h     = std::move(handler_);
+            auto alloc = rebound(asio::get_associated_allocator(h));
+            std::destroy_at(this);
+            std::allocator_traits< decltype(alloc) >::deallocate(alloc, this, 1);
+            std::move(h)(ec);
+        }
+
+        asio::executor_work_guard< Executor > work_guard_;
+        Handler                               handler_;
+    };
+}   // namespace detail
+
+/// @brief A bounded, lock-free queue with an asio-compatible wait for its single consumer.
+///
+/// Producers call try_send from any thread. Sending never blocks or allocates: when the queue is full the value
+/// is rejected and counted. With producers::single there must be at most one producer thread at a time, which
+/// saves a compare-and-swap per item.
+///
+/// The consumer drains with try_receive or try_receive_n and, when it finds the queue empty, parks with
+/// async_wait. Only the transition from empty to non-empty wakes the consumer, so a busy consumer does no
+/// per-item executor work at all.
+/// @note all consumer functions must be called from one thread at a time.
+template < class T, producers Producers = producers::multiple >
+struct basic_lockfree_channel
+{
+    static_assert(std::is_nothrow_move_constructible_v< T > && std::is_nothrow_destructible_v< T >);
+
+    /// @param capacity is rounded up to a power of two
+    explicit basic_lockfree_channel(std::size_t capacity)
+    : mask_(std::bit_ceil(std::max< std::size_t >(capacity, 2)) - 1)
+    , cells_(new cell[mask_ + 1])
+    {
+        for (std::size_t i = 0; i <= mask_; ++i)
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    basic_lockfree_channel(basic_lockfree_channel const &) = delete;
+    basic_lockfree_channel &
+    operator=(basic_lockfree_channel const &) = delete;
+
+    /// Values still queued are destroyed. A pending async_wait completes with operation_aborted.
+    ~basic_lockfree_channel()
+    {
+        if (auto op = waiter_.exchange(nullptr))
+            op->complete(asio::error::operation_aborted);
+        while (pop([](T &&) {}))
+            ;
+    }
+
+    std::size_t
+    capacity() const
+    {
+        return mask_ + 1;
+    }
+
+    /// @brief Queue a value. Thread-safe.
+    /// @return false if the channel is closed or full. A full channel counts the rejection.
+    bool
+    try_send(T value)
+    {
+        if (closed_.load(std::memory_order_relaxed))
+            return false;
+
+        auto  pos = enqueue_pos_.load(std::memory_order_relaxed);
+        cell *c;
+        for (;;)
+        {
+            c        = &cells_[pos & mask_];
+            auto seq = c->seq.load(std::memory_order_acquire);
+            auto dif = static_cast< std::intptr_t >(seq) - static_cast< std::intptr_t >(pos);
+            if (dif == 0)
+            {
+                if constexpr (Producers == producers::single)
+                {
+                    enqueue_pos_.store(pos + 1, std::memory_order_relaxed);
+                    break;
+                }
+                else if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (dif < 0)
+            {
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+
+        ::new (static_cast< void * >(c->storage)) T(std::move(value));
+        c->seq.store(pos + 1, std::memory_order_release);
+        wake();
+        return true;
+    }
+
+    /// @brief Take the oldest value, if any. Consumer only.
+    bool
+    try_receive(T &out)
+    {
+        return pop([&](T &&v) { out = std::move(v); });
+    }
+
+    /// @brief Take up to n values, oldest first. Consumer only.
+    /// @return the number of values written to out
+    template < class OutputIterator >
+    std::size_t
+    try_receive_n(OutputIterator out, std::size_t n)
+    {
+        std::size_t count = 0;
+        while (count < n && pop([&](T &&v) { *out++ = std::move(v); }))
+            ++count;
+        return count;
+    }
+
+    /// @brief Stop accepting values and wake the consumer. Values already queued can still be received. Thread-safe.
+    void
+    close()
+    {
+        closed_.store(true, std::memory_order_relaxed);
+        wake();
+    }
+
+    bool
+    is_closed() const
+    {
+        return closed_.load(std::memory_order_relaxed);
+    }
+
+    /// @brief The number of values rejected because the channel was full.
+    std::uint64_t
+    rejected() const
+    {
+        return rejected_.load(std::memory_order_relaxed);
+    }
+
+    /// @brief Wait until a value may be available. Consumer only.
+    ///
+    /// Completes with no error once the channel is non-empty or has been closed, with error::eof if the channel is
+    /// closed and empty, and with operation_aborted on cancellation or destruction of the channel. A wake-up does not
+    /// guarantee that try_receive will succeed. At most one wait may be outstanding.
+    /// @note The completion handler is invoked as if by post to its associated executor.
+    template < BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code)) WaitToken >
+    BOOST_ASIO_INITFN_RESULT_TYPE(WaitToken, void(error_code))
+    async_wait(WaitToken &&token)
+    {
+        return asio::async_initiate< WaitToken, void(error_code) >(
+            [this]< class Handler >(Handler &&handler)
+            {
+                assert(!waiter_.load());
+                auto e = asio::get_associated_executor(handler);
+                if (ready())
+                {
+                    auto ec = empty() ? error_code(asio::error::eof) : error_code();
+                    asio::post(std::move(e), asio::experimental::append(std::forward< Handler >(handler), ec));
+                    return;
+                }
+
+                using model_type = detail::channel_wait_op_model< decltype(e), std::decay_t< Handler > >;
+                auto *op         = model_type::construct(std::move(e), std::forward< Handler >(handler));
+                op->on_cancel(
+                    [this]
+                    {
+                        if (auto parked = waiter_.exchange(nullptr))
+                            parked->complete(asio::error::operation_aborted);
+                    });
+
+                // park, then look again: a producer which pushed before seeing the waiter will not wake it
+                waiter_.store(op);
+                if (ready())
+                    if (auto parked = waiter_.exchange(nullptr))
+                        parked->complete(error_code());
+            },
+            token);
+    }
+
+  private:
+    struct cell
+    {
+        std::atomic< std::size_t > seq;
+        alignas(T) unsigned char   storage[sizeof(T)];
+    };
+
+    bool
+    empty() const
+    {
+        return cells_[dequeue_pos_ & mask_].seq.load(std::memory_order_acquire) != dequeue_pos_ + 1;
+    }
+
+    bool
+    ready() const
+    {
+        return !empty() || closed_.load();
+    }
+
+    template < class Consume >
+    bool
+    pop(Consume &&consume)
+    {
+        auto &c = cells_[dequeue_pos_ & mask_];
+        if (c.seq.load(std::memory_order_acquire) != dequeue_pos_ + 1)
+            return false;
+        auto *p = std::launder(reinterpret_cast< T * >(c.storage));
+        consume(std::move(*p));
+        std::destroy_at(p);
+        c.seq.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+        ++dequeue_pos_;
+        return true;
+    }
+
+    void
+    wake()
+    {
+        // pairs with the consumer parking then looking again
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiter_.load(std::memory_order_relaxed))
+            if (auto op = waiter_.exchange(nullptr))
+                op->complete(error_code());
+    }
+
+    std::size_t const           mask_;
+    std::unique_ptr< cell[] > cells_;
+
+    // written by producers, read by producers on every send
+    alignas(64) std::atomic< std::size_t > enqueue_pos_ { 0 };
+    std::atomic< detail::channel_wait_op * > waiter_ { nullptr };
+    std::atomic< std::uint64_t >             rejected_ { 0 };
+    std::atomic< bool >                      closed_ { false };
+
+    // owned by the consumer
+    alignas(64) std::size_t dequeue_pos_ = 0;
+};
+
+template < class T >
+using spsc_channel = basic_lockfree_channel< T, producers::single >;
+
+template < class T >
+using mpsc_channel = basic_lockfree_channel< T, producers::multiple >;
+
+}   // namespace arby::util
+
+#endif   // ARBY_LIB_UTIL_LOCKFREE_CHANNEL_HPP
@@ -0,0 +1,129 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "util/lockfree_channel.hpp"
+
+#include <doctest/doctest.h>
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace arby;
+
+TEST_SUITE("util")
+{
+    TEST_CASE("spsc_channel")
+    {
+        auto ch = util::spsc_channel< std::unique_ptr< int > >(3);
+        CHECK(ch.capacity() == 4);
+
+        for (int i = 0; i < 4; ++i)
+            CHECK(ch.try_send(std::make_unique< int >(i)));
+        CHECK_FALSE(ch.try_send(std::make_unique< int >(4)));
+        CHECK(ch.rejected() == 1);
+
+        auto out = std::vector< std::unique_ptr< int > >();
+        CHECK(ch.try_receive_n(std::back_inserter(out), 3) == 3);
+        REQUIRE(out.size() == 3);
+        CHECK(*out[0] == 0);
+        CHECK(*out[2] == 2);
+
+        // the ring wraps
+        CHECK(ch.try_send(std::make_unique< int >(5)));
+        auto v = std::unique_ptr< int >();
+        CHECK(ch.try_receive(v));
+        CHECK(*v == 3);
+        CHECK(ch.try_receive(v));
+        CHECK(*v == 5);
+        CHECK_FALSE(ch.try_receive(v));
+
+        ch.close();
+        CHECK_FALSE(ch.try_send(std::make_unique< int >(6)));
+        CHECK(ch.rejected() == 1);
+    }
+
+    TEST_CASE("mpsc_channel async_wait")
+    {
+        constexpr int producers = 4;
+        constexpr int per       = 50000;
+
+        auto ioc = asio::io_context();
+        auto ch  = util::mpsc_channel< std::pair< int, int > >(1024);
+
+        auto next     = std::array< int, producers > {};
+        auto received = 0;
+        auto in_order = true;
+        auto wakeups  = 0;
+        auto final_ec = error_code();
+
+        std::function< void() > consume = [&]
+        {
+            ch.async_wait(asio::bind_executor(
+                ioc.get_executor(),
+                [&](error_code ec)
+                {
+                    ++wakeups;
+                    if (ec)
+                    {
+                        final_ec = ec;
+                        return;
+                    }
+                    auto batch = std::array< std::pair< int, int >, 64 > {};
+                    while (auto n = ch.try_receive_n(batch.begin(), batch.size()))
+                        for (std::size_t i = 0; i < n; ++i)
+                        {
+                            auto [p, seq] = batch[i];
+                            in_order &= seq == next[p]++;
+                            ++received;
+                        }
+                    consume();
+                }));
+        };
+        consume();
+
+        auto threads = std::vector< std::thread >();
+        for (int p = 0; p < producers; ++p)
+            threads.emplace_back(
+                [&, p]
+                {
+                    for (int i = 0; i < per;)
+                        if (ch.try_send({ p, i }))
+                            ++i;
+                        else
+                            std::this_thread::yield();
+                });
+
+        auto consumer = std::thread([&] { ioc.run(); });
+        for (auto &t : threads)
+            t.join();
+        ch.close();
+        consumer.join();
+
+        CHECK(received == producers * per);
+        CHECK(in_order);
+        CHECK(final_ec == asio::error::eof);
+        MESSAGE("wakeups for " << received << " items: " << wakeups);
+    }
+
+    TEST_CASE("lockfree_channel aborts a pending wait on destruction")
+    {
+        auto ioc    = asio::io_context();
+        auto result = error_code();
+        {
+            auto ch = util::mpsc_channel< int >(8);
+            ch.async_wait(asio::bind_executor(ioc.get_executor(), [&](error_code ec) { result = ec; }));
+            ioc.poll();
+        }
+        ioc.run();
+        CHECK(result == asio::error::operation_aborted);
+    }
+}
@@ -13,72 +13,199 @@
 #include <fmt/ostream.h>
 #include <spdlog/spdlog.h>
 
-#include <tuple>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
 
 namespace arby::util
 {
-std::unordered_map< std::string, std::size_t > monitor::next_index_;
-std::set< instance >                           monitor::instances_;
+/// Per-thread monitor state.
+///
+/// Counters are only ever incremented by the owning thread and are read by the reporter, so relaxed atomics suffice.
+/// The live list is mutated by the owning thread when a sentinel is created and by whichever thread destroys the
+/// sentinel, so it is protected by a mutex which is uncontended in the common case.
+struct monitor::registry
+{
+    struct counters
+    {
+        std::atomic< std::uint64_t >                                   started { 0 };
+        std::atomic< std::uint64_t >                                   completed { 0 };
+        std::atomic< std::uint64_t >                                   failed { 0 };
+        std::array< std::atomic< std::uint64_t >, histogram_buckets > histogram {};
+    };
 
-std::ostream &
-operator<<(std::ostream &os, instance const &i)
+    static void
+    bump(std::atomic< std::uint64_t > &counter)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void
+    link(sentinel *s)
+    {
+        bump(probes[s->probe_].started);
+        auto lock = std::unique_lock(m);
+        s->next_  = head;
+        if (head)
+            head->prev_ = s;
+        head = s;
+    }
+
+    static void
+    unlink(sentinel *s)
+    {
+        auto *owner = s->owner_;
+        auto  lock  = std::unique_lock(owner->m);
+        if (s->prev_)
+            s->prev_->next_ = s->next_;
+        else
+            owner->head = s->next_;
+        if (s->next_)
+            s->next_->prev_ = s->prev_;
+    }
+
+    void
+    complete(sentinel const *s, clock::duration elapsed, bool failed)
+    {
+        auto &c  = probes[s->probe_];
+        auto  us = static_cast< std::uint64_t >(std::chrono::duration_cast< std::chrono::microseconds >(elapsed).count());
+        bump(c.histogram[std::min< std::size_t >(std::bit_width(us), histogram_buckets - 1)]);
+        bump(failed ? c.failed : c.completed);
+    }
+
+    /// Accumulate this registry's counters and live instances into the report, which is indexed by probe id.
+    void
+    collect(std::vector< probe_report > &report, clock::time_point now)
+    {
+        for (std::size_t id = 0; id < report.size(); ++id)
+        {
+            auto &c = probes[id];
+            auto &r = report[id];
+            r.started += c.started.load(std::memory_order_relaxed);
+            r.completed += c.completed.load(std::memory_order_relaxed);
+            r.failed += c.failed.load(std::memory_order_relaxed);
+            for (std::size_t b = 0; b < histogram_buckets; ++b)
+                r.histogram[b] += c.histogram[b].load(std::memory_order_relaxed);
+        }
+
+        auto lock = std::unique_lock(m);
+        for (auto *s = head; s; s = s->next_)
+        {
+            if (s->probe_ >= report.size())
+                continue;
+            auto &r = report[s->probe_];
+            ++r.live;
+            r.oldest = std::max(r.oldest, now - s->start_);
+        }
+    }
+
+    std::mutex                          m;
+    sentinel                           *head = nullptr;
+    std::array< counters, max_probes > probes;
+};
+
+namespace
 {
-    fmt::print(os, "{}:{}:{}", i.name, i.version, i.creation_time);
-    return os;
-}
+struct global_state
+{
+    std::mutex                                                m;
+    std::vector< std::string >                                names;
+    std::unordered_map< std::string, monitor::probe_id >      ids;
+    std::vector< std::unique_ptr< monitor::registry > >       registries;
+
+    static global_state &
+    get()
+    {
+        // intentionally leaked so that sentinels in static or detached coroutines can be destroyed at exit
+        static auto *const state = new global_state();
+        return *state;
+    }
+};
 
-bool
-operator<(instance const &l, instance const &r)
+monitor::registry &
+local_registry()
 {
-    return std::tie(l.name, l.version, l.creation_time) < std::tie(r.name, r.version, r.creation_time);
+    // registries outlive their threads so that sentinels which migrate to other threads can still unlink themselves
+    // and so that completed counts are retained in the report
+    thread_local monitor::registry *local = []
+    {
+        auto &g    = global_state::get();
+        auto  reg  = std::make_unique< monitor::registry >();
+        auto *p    = reg.get();
+        auto  lock = std::unique_lock(g.m);
+        g.registries.push_back(std::move(reg));
+        return p;
+    }();
+    return *local;
 }
+}   // namespace
 
-monitor::sentinel::sentinel(monitor::instance_iter it)
-: iter(it)
-, valid(true)
+monitor::sentinel::sentinel(probe_id probe)
+: probe_(probe)
+, uncaught_(std::uncaught_exceptions())
+, start_(clock::now())
+, owner_(&local_registry())
 {
+    assert(probe_ < max_probes);
+    owner_->link(this);
 }
-monitor::sentinel::sentinel(monitor::sentinel &&other)
-: iter(other.iter)
-, valid(std::exchange(other.valid, false))
+
+monitor::sentinel::~sentinel()
 {
+    registry::unlink(this);
+    local_registry().complete(this, clock::now() - start_, std::uncaught_exceptions() > uncaught_);
 }
-monitor::sentinel::~sentinel()
+
+monitor::probe_id
+monitor::register_probe(std::string_view name)
 {
-    if (valid)
-    {
-        monitor::erase(iter, std::current_exception());
-    }
+    auto &g    = global_state::get();
+    auto  lock = std::unique_lock(g.m);
+    auto  key  = std::string(name);
+    if (auto i = g.ids.find(key); i != g.ids.end())
+        return i->second;
+    if (g.names.size() >= max_probes)
+        throw std::length_error("monitor: too many probes");
+    auto id = static_cast< probe_id >(g.names.size());
+    g.names.push_back(key);
+    g.ids.emplace(std::move(key), id);
+    return id;
 }
-monitor::sentinel
-monitor::record(std::string name)
+
+std::vector< monitor::probe_report >
+monitor::report()
 {
-    auto version = next_index_[name]++;
-    auto time    = std::chrono::system_clock::now();
-    auto result =
-        sentinel(instances_.insert(instance { .name = std::move(name), .version = version, .creation_time = time }).first);
-    spdlog::debug("monitor: create {}", *result.iter);
+    auto &g    = global_state::get();
+    auto  now  = clock::now();
+    auto  lock = std::unique_lock(g.m);
+
+    auto result = std::vector< probe_report >(g.names.size());
+    for (std::size_t id = 0; id < result.size(); ++id)
+        result[id].name = g.names[id];
+    for (auto &reg : g.registries)
+        reg->collect(result, now);
     return result;
 }
-void
-monitor::erase(monitor::instance_iter iter, std::exception_ptr ep)
+
+std::ostream &
+operator<<(std::ostream &os, monitor::probe_report const &r)
 {
-    try
-    {
-        if (ep)
-            std::rethrow_exception(ep);
-        spdlog::debug("monitor: destroy {}", *iter);
-    }
-    catch (std::exception &e)
-    {
-        spdlog::error("monitor: destroy {} with exception {}", *iter, e.what());
-    }
-    catch (...)
-    {
-        spdlog::error("monitor: destroy {} with unknown exception");
-    }
-    instances_.erase(iter);
+    fmt::print(os,
+               "{}: live {} oldest {} started {} completed {} failed {}",
+               r.name,
+               r.live,
+               std::chrono::duration_cast< std::chrono::milliseconds >(r.oldest),
+               r.started,
+               r.completed,
+               r.failed);
+    return os;
 }
+
 asio::awaitable< void >
 monitor::mon()
 {
@@ -88,10 +215,9 @@ monitor::mon()
         timer.expires_after(std::chrono::seconds(60));
         co_await timer.async_wait(asio::use_awaitable);
         spdlog::debug("monitor::mon:-");
-        for (auto &i : instances_)
-        {
-            spdlog::debug(" - {}", i);
-        }
+        for (auto &r : report())
+            if (r.started)
+                spdlog::debug(" - {}", r);
     }
 }
 }   // namespace arby::util
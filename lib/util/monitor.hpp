@@ -12,56 +12,94 @@
 
 #include "config/asio.hpp"
 
+#include <array>
 #include <chrono>
+#include <cstdint>
 #include <ostream>
-#include <set>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <vector>
 
 namespace arby::util
 {
-struct instance
+/// Instrumentation of long-running coroutines.
+///
+/// A coroutine registers a named probe once, typically in a function-local static, and records a sentinel for the
+/// duration of its body:
+/// @code
+/// static const auto probe = util::monitor::register_probe("http_server::session");
+/// auto sentinel = util::monitor::record(probe);
+/// @endcode
+/// Recording does not format strings and touches only registries owned by the threads involved, so it is cheap
+/// enough to leave on in production. All functions are thread-safe.
+struct monitor
 {
-    std::string                           name;
-    std::size_t                           version;
-    std::chrono::system_clock::time_point creation_time;
-};
+    using probe_id = std::uint32_t;
+    using clock    = std::chrono::steady_clock;
 
-std::ostream &
-operator<<(std::ostream &os, instance const &i);
+    static constexpr std::size_t max_probes = 256;
 
-bool
-operator<(instance const &l, instance const &r);
+    /// Completion times are bucketed by powers of two of microseconds. The last bucket collects everything longer.
+    static constexpr std::size_t histogram_buckets = 32;
 
-struct monitor
-{
-    static std::unordered_map< std::string, std::size_t > next_index_;
-    static std::set< instance >                           instances_;
-    using instance_iter = std::set< instance >::iterator;
+    struct registry;
 
     struct sentinel
     {
-        sentinel(instance_iter it);
-        sentinel(sentinel &&other);
+        explicit sentinel(probe_id probe);
 
+        sentinel(sentinel const &) = delete;
         sentinel &
         operator=(sentinel const &) = delete;
+
         ~sentinel();
 
-        instance_iter iter;
-        bool          valid;
+      private:
+        friend registry;
+
+        probe_id          probe_;
+        int               uncaught_;
+        clock::time_point start_;
+        registry         *owner_;
+        sentinel         *prev_ = nullptr;
+        sentinel         *next_ = nullptr;
     };
 
+    /// Register a named probe, returning its id. Registering the same name twice returns the same id.
+    /// @throws std::length_error if more than max_probes distinct names are registered
+    static probe_id
+    register_probe(std::string_view name);
+
+    /// Record a live instance of the probe until the returned sentinel is destroyed.
     static sentinel
-    record(std::string name);
+    record(probe_id probe)
+    {
+        return sentinel(probe);
+    }
 
-    static void
-    erase(instance_iter iter, std::exception_ptr ep);
+    struct probe_report
+    {
+        std::string                                      name;
+        std::uint64_t                                    live      = 0;
+        std::uint64_t                                    started   = 0;
+        std::uint64_t                                    completed = 0;
+        std::uint64_t                                    failed    = 0;
+        clock::duration                                  oldest    = clock::duration::zero();
+        std::array< std::uint64_t, histogram_buckets > histogram = {};
+    };
 
+    /// Aggregate the registries of all threads into one report per registered probe.
+    static std::vector< probe_report >
+    report();
+
+    /// Periodically log the report at debug level.
     static asio::awaitable< void >
     mon();
 };
 
+std::ostream &
+operator<<(std::ostream &os, monitor::probe_report const &r);
+
 }   // namespace arby::util
 
 #endif   // ARBY_LIB_UTIL_MONITOR_HPP
@@ -0,0 +1,89 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "util/monitor.hpp"
+
+#include <doctest/doctest.h>
+
+#include <optional>
+#include <thread>
+
+using namespace arby;
+
+namespace
+{
+util::monitor::probe_report
+find_report(util::monitor::probe_id id)
+{
+    auto reports = util::monitor::report();
+    REQUIRE(id < reports.size());
+    return reports[id];
+}
+}   // namespace
+
+TEST_SUITE("util")
+{
+    TEST_CASE("monitor")
+    {
+        auto probe = util::monitor::register_probe("monitor.spec::probe");
+        CHECK(util::monitor::register_probe("monitor.spec::probe") == probe);
+
+        auto before = find_report(probe);
+        CHECK(before.name == "monitor.spec::probe");
+
+        {
+            auto s1 = util::monitor::record(probe);
+            auto s2 = util::monitor::record(probe);
+            auto r  = find_report(probe);
+            CHECK(r.live == before.live + 2);
+            CHECK(r.started == before.started + 2);
+        }
+
+        auto after = find_report(probe);
+        CHECK(after.live == before.live);
+        CHECK(after.completed == before.completed + 2);
+
+        std::uint64_t total = 0;
+        for (auto n : after.histogram)
+            total += n;
+        CHECK(total == after.completed + after.failed);
+    }
+
+    TEST_CASE("monitor across threads")
+    {
+        auto probe = util::monitor::register_probe("monitor.spec::cross_thread");
+
+        // a sentinel created on one thread and destroyed on another, as happens when a coroutine migrates
+        auto s = std::optional< util::monitor::sentinel >();
+        std::thread([&] { s.emplace(probe); }).join();
+        CHECK(find_report(probe).live == 1);
+        s.reset();
+
+        auto r = find_report(probe);
+        CHECK(r.live == 0);
+        CHECK(r.started == 1);
+        CHECK(r.completed == 1);
+    }
+
+    TEST_CASE("monitor failure")
+    {
+        auto probe = util::monitor::register_probe("monitor.spec::failure");
+        try
+        {
+            auto s = util::monitor::record(probe);
+            throw std::runtime_error("fail");
+        }
+        catch (std::runtime_error &)
+        {
+        }
+        auto r = find_report(probe);
+        CHECK(r.failed == 1);
+        CHECK(r.completed == 0);
+    }
+}
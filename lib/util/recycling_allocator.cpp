@@ -0,0 +1,237 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "recycling_allocator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <mutex>
+#include <vector>
+
+namespace arby::util
+{
+namespace
+{
+    constexpr std::size_t min_shift  = 4;   // 16 bytes
+    constexpr std::size_t classes    = 9;   // up to 4096 bytes
+    constexpr std::size_t max_cached = 1024;
+
+    struct free_block
+    {
+        free_block *next;
+    };
+
+    /// Where blocks freed on other threads are sent back to the thread which allocated them. One lock-free stack per
+    /// size class: any thread pushes with a compare-and-swap, and the owner takes the whole stack with an exchange,
+    /// so there is no ABA problem.
+    ///
+    /// Depots are never deleted, because a block may be freed after the thread which allocated it has exited. The
+    /// depot of an exited thread is adopted by the next thread to start, blocks and all, so there are only ever as
+    /// many depots as there have been threads alive at once.
+    struct depot
+    {
+        std::array< std::atomic< free_block * >, classes > remote = {};
+    };
+
+    /// Precedes each cached block, so that the block can be sent home wherever it is freed. A null owner means the
+    /// block was allocated after its thread's cache was destroyed, and goes back to the heap.
+    struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) block_header
+    {
+        depot *owner;
+    };
+
+    struct spare_depots
+    {
+        std::mutex             mutex;
+        std::vector< depot * > depots;
+    };
+
+    // deliberately leaked: threads may exit after static destruction has begun
+    spare_depots &
+    spares()
+    {
+        static auto *instance = new spare_depots;
+        return *instance;
+    }
+
+    depot *
+    adopt_depot()
+    {
+        auto &s    = spares();
+        auto  lock = std::lock_guard(s.mutex);
+        if (s.depots.empty())
+            return new depot;
+        auto *d = s.depots.back();
+        s.depots.pop_back();
+        return d;
+    }
+
+    void
+    release_depot(depot *d)
+    {
+        auto &s    = spares();
+        auto  lock = std::lock_guard(s.mutex);
+        s.depots.push_back(d);
+    }
+
+    void
+    free_chain(free_block *b) noexcept
+    {
+        while (b)
+        {
+            auto *next = b->next;
+            ::operator delete(reinterpret_cast< block_header * >(b) - 1);
+            b = next;
+        }
+    }
+
+    struct thread_cache
+    {
+        thread_cache()
+        : home(adopt_depot())
+        {
+        }
+
+        ~thread_cache()
+        {
+            for (std::size_t c = 0; c < classes; ++c)
+            {
+                free_chain(std::exchange(heads[c], nullptr));
+                free_chain(home->remote[c].exchange(nullptr, std::memory_order_acquire));
+            }
+            // blocks freed by later thread_local destructors are sent home, or to the heap if they were ours
+            release_depot(std::exchange(home, nullptr));
+        }
+
+        /// Take the blocks of a size class which other threads have sent back, up to the cap.
+        free_block *
+        take_returned(std::size_t c) noexcept
+        {
+            auto *b = home->remote[c].exchange(nullptr, std::memory_order_acquire);
+            if (!b)
+                return nullptr;
+
+            auto *result = std::exchange(b, b->next);
+            while (b)
+            {
+                auto *next = b->next;
+                if (counts[c] == max_cached)
+                    ::operator delete(reinterpret_cast< block_header * >(b) - 1);
+                else
+                {
+                    b->next  = heads[c];
+                    heads[c] = b;
+                    ++counts[c];
+                    ++stats.cached;
+                }
+                b = next;
+            }
+            return result;
+        }
+
+        depot                              *home;
+        std::array< free_block *, classes > heads  = {};
+        std::array< std::size_t, classes >  counts = {};
+        recycling_stats                     stats;
+    };
+
+    thread_local thread_cache cache;
+
+    /// The size class of a request, or classes if it is not cached.
+    std::size_t
+    size_class(std::size_t bytes, std::size_t align)
+    {
+        if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__ || bytes > (std::size_t(1) << (min_shift + classes - 1)))
+            return classes;
+        auto shift = std::bit_width(std::max(bytes, std::size_t(1) << min_shift) - 1);
+        return static_cast< std::size_t >(shift) - min_shift;
+    }
+}   // namespace
+
+namespace detail
+{
+    void *
+    recycling_cache::allocate(std::size_t bytes, std::size_t align)
+    {
+        auto c = size_class(bytes, align);
+        if (c == classes)
+        {
+            ++cache.stats.allocated;
+            if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+                return ::operator new(bytes, std::align_val_t(align));
+            return ::operator new(bytes);
+        }
+
+        if (auto *b = cache.heads[c])
+        {
+            cache.heads[c] = b->next;
+            --cache.counts[c];
+            --cache.stats.cached;
+            ++cache.stats.recycled;
+            return b;
+        }
+
+        if (cache.home)
+            if (auto *b = cache.take_returned(c))
+            {
+                ++cache.stats.recycled;
+                return b;
+            }
+
+        ++cache.stats.allocated;
+        auto *h = ::new (::operator new(sizeof(block_header) + (std::size_t(1) << (c + min_shift))))
+            block_header { cache.home };
+        return h + 1;
+    }
+
+    void
+    recycling_cache::deallocate(void *p, std::size_t bytes, std::size_t align) noexcept
+    {
+        auto c = size_class(bytes, align);
+        if (c == classes)
+        {
+            if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+                ::operator delete(p, std::align_val_t(align));
+            else
+                ::operator delete(p);
+            return;
+        }
+
+        auto *h     = static_cast< block_header * >(p) - 1;
+        auto *owner = h->owner;
+        if (!owner)
+            ::operator delete(h);
+        else if (owner != cache.home)
+        {
+            // freed on another thread: send it home, where the owner will allocate it again
+            auto *b = ::new (p) free_block { owner->remote[c].load(std::memory_order_relaxed) };
+            while (!owner->remote[c].compare_exchange_weak(b->next, b, std::memory_order_release, std::memory_order_relaxed))
+                ;
+            ++cache.stats.returned;
+        }
+        else if (cache.counts[c] == max_cached)
+            ::operator delete(h);
+        else
+        {
+            cache.heads[c] = ::new (p) free_block { cache.heads[c] };
+            ++cache.counts[c];
+            ++cache.stats.cached;
+        }
+    }
+}   // namespace detail
+
+recycling_stats
+recycling_allocator_stats()
+{
+    return cache.stats;
+}
+
+}   // namespace arby::util
@@ -0,0 +1,103 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_LIB_UTIL_RECYCLING_ALLOCATOR_HPP
+#define ARBY_LIB_UTIL_RECYCLING_ALLOCATOR_HPP
+
+#include "config/asio.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+namespace arby::util
+{
+namespace detail
+{
+    /// Thread-local free lists of blocks in power-of-two size classes from 16 to 4096 bytes. Larger or over-aligned
+    /// requests go straight to the heap. A block may be freed on a different thread from the one which allocated it;
+    /// it is then sent back to the allocating thread, so that a handler posted across threads is recycled by the
+    /// thread which posts the next one.
+    struct recycling_cache
+    {
+        static void *
+        allocate(std::size_t bytes, std::size_t align);
+
+        static void
+        deallocate(void *p, std::size_t bytes, std::size_t align) noexcept;
+    };
+}   // namespace detail
+
+/// Counters of the calling thread's recycling cache.
+struct recycling_stats
+{
+    std::uint64_t recycled  = 0;   // allocations satisfied from a free list
+    std::uint64_t allocated = 0;   // allocations which went to the heap
+    std::uint64_t cached    = 0;   // blocks currently held on free lists
+    std::uint64_t returned  = 0;   // blocks freed here and sent back to the thread which allocated them
+};
+
+/// @brief The recycling counters of the calling thread.
+recycling_stats
+recycling_allocator_stats();
+
+/// @brief An allocator which recycles blocks through per-thread free lists.
+///
+/// Intended as the associated allocator of completion handlers which are dispatched on every tick, so that steady
+/// state traffic does not touch the global heap. It is stateless: all instances compare equal.
+template < class T >
+struct recycling_allocator
+{
+    using value_type = T;
+
+    template < class U >
+    struct rebind
+    {
+        using other = recycling_allocator< U >;
+    };
+
+    constexpr recycling_allocator() noexcept = default;
+
+    template < class U >
+    constexpr recycling_allocator(recycling_allocator< U > const &) noexcept
+    {
+    }
+
+    T *
+    allocate(std::size_t n)
+    {
+        return static_cast< T * >(detail::recycling_cache::allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void
+    deallocate(T *p, std::size_t n) noexcept
+    {
+        detail::recycling_cache::deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    template < class U >
+    constexpr bool
+    operator==(recycling_allocator< U > const &) const noexcept
+    {
+        return true;
+    }
+};
+
+/// @brief Associate the recycling allocator with a completion handler.
+template < class Handler >
+auto
+bind_recycling_allocator(Handler &&handler)
+{
+    return asio::bind_allocator(recycling_allocator< void >(), std::forward< Handler >(handler));
+}
+
+}   // namespace arby::util
+
+#endif   // ARBY_LIB_UTIL_RECYCLING_ALLOCATOR_HPP
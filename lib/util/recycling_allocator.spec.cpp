@@ -0,0 +1,172 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "util/recycling_allocator.hpp"
+
+#include <doctest/doctest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace
+{
+std::atomic< std::uint64_t > heap_allocations { 0 };
+}
+
+// count every global allocation made by the test executable
+void *
+operator new(std::size_t bytes)
+{
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto p = std::malloc(bytes ? bytes : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void
+operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+using namespace arby;
+
+namespace
+{
+/// Post a burst of handlers, as a tick burst would, and return the number of heap allocations made per handler
+/// while posting and running them.
+template < class Wrap >
+double
+allocations_per_handler(asio::io_context &ioc, Wrap wrap)
+{
+    constexpr int burst = 1000;
+
+    auto payload = std::make_shared< int >(0);
+    auto before  = heap_allocations.load();
+    for (int i = 0; i < burst; ++i)
+        asio::post(ioc.get_executor(), wrap([payload, i] { *payload += i; }));
+    ioc.run();
+    ioc.restart();
+    return double(heap_allocations.load() - before) / burst;
+}
+
+/// As allocations_per_handler, but the handlers run on the thread which runs ioc, as a tick posted from a connector
+/// to a listener's executor would.
+template < class Wrap >
+double
+allocations_per_cross_thread_handler(asio::io_context &ioc, Wrap wrap)
+{
+    constexpr int burst = 1000;
+
+    auto done   = std::atomic< int >(0);
+    auto before = heap_allocations.load();
+    for (int i = 0; i < burst; ++i)
+        asio::post(ioc.get_executor(), wrap([&done] { done.fetch_add(1, std::memory_order_release); }));
+    while (done.load(std::memory_order_acquire) != burst)
+        std::this_thread::yield();
+    return double(heap_allocations.load() - before) / burst;
+}
+}   // namespace
+
+TEST_SUITE("util")
+{
+    TEST_CASE("recycling_allocator")
+    {
+        auto alloc = util::recycling_allocator< int >();
+        auto other = util::recycling_allocator< double >(alloc);
+        CHECK(alloc == other);
+
+        auto before = util::recycling_allocator_stats();
+
+        auto blocks = std::vector< int * >();
+        for (int i = 0; i < 10; ++i)
+            blocks.push_back(alloc.allocate(5));
+        for (auto *p : blocks)
+            alloc.deallocate(p, 5);
+        blocks.clear();
+
+        // same size class, so served from the free list
+        for (int i = 0; i < 10; ++i)
+            blocks.push_back(alloc.allocate(7));
+        for (auto *p : blocks)
+            alloc.deallocate(p, 7);
+
+        auto after = util::recycling_allocator_stats();
+        CHECK(after.recycled - before.recycled >= 10);
+        CHECK(after.cached >= 10);
+
+        // large blocks are not cached
+        auto *big = other.allocate(100000);
+        other.deallocate(big, 100000);
+        CHECK(util::recycling_allocator_stats().cached == after.cached);
+    }
+
+    TEST_CASE("recycling_allocator steady state handler allocations")
+    {
+        auto ioc = asio::io_context();
+
+        auto plain    = [](auto f) { return f; };
+        auto recycled = [](auto f) { return util::bind_recycling_allocator(std::move(f)); };
+
+        // warm up
+        allocations_per_handler(ioc, plain);
+        allocations_per_handler(ioc, recycled);
+
+        auto with_default   = 0.0;
+        auto with_recycling = 0.0;
+        for (int round = 0; round < 5; ++round)
+        {
+            with_default   = allocations_per_handler(ioc, plain);
+            with_recycling = allocations_per_handler(ioc, recycled);
+        }
+        MESSAGE("heap allocations per handler: default " << with_default << ", recycling " << with_recycling);
+
+        CHECK(with_recycling < 0.01);
+        CHECK(with_recycling < with_default);
+    }
+
+    TEST_CASE("recycling_allocator returns blocks freed on another thread")
+    {
+        auto ioc      = asio::io_context();
+        auto work     = asio::make_work_guard(ioc);
+        auto consumer = std::thread([&] { ioc.run(); });
+
+        auto recycled = [](auto f) { return util::bind_recycling_allocator(std::move(f)); };
+
+        // warm up. The cache grows to the most handlers in flight at once, which depends on the consumer's timing
+        for (int round = 0; round < 3; ++round)
+            allocations_per_cross_thread_handler(ioc, recycled);
+
+        auto before         = util::recycling_allocator_stats();
+        auto with_recycling = 0.0;
+        for (int round = 0; round < 5; ++round)
+            with_recycling = allocations_per_cross_thread_handler(ioc, recycled);
+        auto after = util::recycling_allocator_stats();
+        MESSAGE("heap allocations per cross-thread handler: recycling " << with_recycling);
+
+        // each handler is freed on the consumer thread and sent back here, where the next post finds it. Without that
+        // every handler would be a heap allocation.
+        CHECK(with_recycling < 0.05);
+        CHECK(after.allocated - before.allocated < 250);
+        CHECK(after.recycled - before.recycled >= 4750);
+
+        work.reset();
+        consumer.join();
+    }
+}
@@ -0,0 +1,56 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "bench/bench.hpp"
+#include "util/signal.hpp"
+
+#include <boost/signals2.hpp>
+
+#include <memory>
+#include <vector>
+
+using namespace arby;
+
+namespace
+{
+using arg_type = std::shared_ptr< int const >;
+using signals2 =
+    boost::signals2::signal_type< void(arg_type), boost::signals2::keywords::mutex_type< boost::signals2::dummy_mutex > >::type;
+
+template < class Signal >
+void
+emit(bench::state &state, Signal &sig)
+{
+    auto arg = std::make_shared< int const >(1);
+    state.set_items_per_iteration(double(state.arg()));
+    for (auto _ : state)
+        sig(arg);
+}
+}   // namespace
+
+ARBY_BENCHMARK("signal/emit", 1, 10, 100)
+{
+    auto sum  = 0;
+    auto sig  = util::signal< void(arg_type) >();
+    auto keep = std::vector< util::scoped_connection >();
+    for (int i = 0; i < state.arg(); ++i)
+        keep.emplace_back(sig.connect([&](arg_type const &p) { sum += *p; }));
+    emit(state, sig);
+    bench::do_not_optimize(sum);
+}
+
+ARBY_BENCHMARK("signals2/emit", 1, 10, 100)
+{
+    auto sum = 0;
+    auto sig = signals2();
+    for (int i = 0; i < state.arg(); ++i)
+        sig.connect([&](arg_type const &p) { sum += *p; });
+    emit(state, sig);
+    bench::do_not_optimize(sum);
+}
@@ -0,0 +1,46 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "signal.hpp"
+
+namespace arby::util
+{
+void
+connection::disconnect() noexcept
+{
+    if (state_)
+        state_->connected = false;
+}
+
+bool
+connection::connected() const noexcept
+{
+    return state_ && state_->connected;
+}
+
+scoped_connection &
+scoped_connection::operator=(scoped_connection &&other) noexcept
+{
+    if (this != &other)
+    {
+        connection_.disconnect();
+        connection_ = other.release();
+    }
+    return *this;
+}
+
+scoped_connection &
+scoped_connection::operator=(connection c) noexcept
+{
+    connection_.disconnect();
+    connection_ = std::move(c);
+    return *this;
+}
+
+}   // namespace arby::util
@@ -0,0 +1,213 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#ifndef ARBY_LIB_UTIL_SIGNAL_HPP
+#define ARBY_LIB_UTIL_SIGNAL_HPP
+
+#include <boost/container/small_vector.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+
+namespace arby::util
+{
+namespace detail
+{
+    struct slot_state
+    {
+        bool connected = true;
+    };
+}   // namespace detail
+
+/// @brief A handle to a slot connected to a util::signal.
+///
+/// Disconnecting is O(1) and may be done from within an emission, including by the slot itself. A connection may
+/// outlive its signal.
+struct connection
+{
+    connection() = default;
+
+    explicit connection(std::shared_ptr< detail::slot_state > state)
+    : state_(std::move(state))
+    {
+    }
+
+    void
+    disconnect() noexcept;
+
+    bool
+    connected() const noexcept;
+
+  private:
+    std::shared_ptr< detail::slot_state > state_;
+};
+
+/// @brief A connection which disconnects when it is destroyed or reassigned.
+struct scoped_connection
+{
+    scoped_connection() = default;
+
+    explicit scoped_connection(connection c)
+    : connection_(std::move(c))
+    {
+    }
+
+    scoped_connection(scoped_connection &&other) = default;
+
+    scoped_connection &
+    operator=(scoped_connection &&other) noexcept;
+
+    scoped_connection &
+    operator=(connection c) noexcept;
+
+    ~scoped_connection() { connection_.disconnect(); }
+
+    void
+    disconnect() noexcept
+    {
+        connection_.disconnect();
+    }
+
+    bool
+    connected() const noexcept
+    {
+        return connection_.connected();
+    }
+
+    /// @brief Give up ownership without disconnecting.
+    connection
+    release() noexcept
+    {
+        return std::exchange(connection_, connection());
+    }
+
+  private:
+    connection connection_;
+};
+
+template < class Signature >
+struct signal;
+
+/// @brief A single-threaded signal for the hot fan-out paths.
+///
+/// Compared with boost::signals2 there are no slot groups, combiners, tracked objects or mutexes, and emission
+/// copies nothing: slots are held in a small inline vector and invoked in connection order. Connecting allocates
+/// the slot once. Disconnected slots are dropped lazily, at the end of the next emission or on the next connect.
+/// @note not thread-safe. Connect, disconnect and emit on the owner's executor only.
+template < class... Args >
+struct signal< void(Args...) >
+{
+    using slot_type = std::function< void(Args...) >;
+
+    signal() = default;
+
+    signal(signal const &) = delete;
+    signal &
+    operator=(signal const &) = delete;
+
+    ~signal()
+    {
+        for (auto &s : slots_)
+        {
+            s->connected = false;
+            s->fn        = nullptr;
+        }
+    }
+
+    connection
+    connect(slot_type fn)
+    {
+        // slots may also be disconnected between emissions
+        if (!emitting_)
+            compact();
+        auto s = std::make_shared< slot >(std::move(fn));
+        slots_.push_back(s);
+        return connection(std::move(s));
+    }
+
+    /// @brief Invoke each connected slot. Slots connected during the emission are not invoked by it.
+    void
+    operator()(Args const &...args)
+    {
+        auto const n = slots_.size();
+        ++emitting_;
+        try
+        {
+            // index rather than iterate: a slot may connect another, reallocating the vector
+            for (std::size_t i = 0; i < n; ++i)
+                if (auto &s = *slots_[i]; s.connected)
+                    s.fn(args...);
+                else
+                    dead_ = true;
+        }
+        catch (...)
+        {
+            --emitting_;
+            throw;
+        }
+        if (--emitting_ == 0 && dead_)
+            compact();
+    }
+
+    /// @brief True if no slot is connected.
+    bool
+    empty() const
+    {
+        return std::none_of(slots_.begin(), slots_.end(), [](auto const &s) { return s->connected; });
+    }
+
+    /// @brief The number of connected slots.
+    std::size_t
+    num_slots() const
+    {
+        return std::count_if(slots_.begin(), slots_.end(), [](auto const &s) { return s->connected; });
+    }
+
+  private:
+    struct slot : detail::slot_state
+    {
+        explicit slot(slot_type fn)
+        : fn(std::move(fn))
+        {
+        }
+
+        slot_type fn;
+    };
+
+    void
+    compact()
+    {
+        auto out = slots_.begin();
+        for (auto i = slots_.begin(); i != slots_.end(); ++i)
+            if ((*i)->connected)
+            {
+                if (out != i)
+                    *out = std::move(*i);
+                ++out;
+            }
+            else
+            {
+                // release what the slot captured, even if a connection still refers to it
+                (*i)->fn = nullptr;
+            }
+        slots_.erase(out, slots_.end());
+        dead_ = false;
+    }
+
+    boost::container::small_vector< std::shared_ptr< slot >, 4 > slots_;
+    int                                                           emitting_ = 0;
+    bool                                                          dead_     = false;
+};
+
+}   // namespace arby::util
+
+#endif   // ARBY_LIB_UTIL_SIGNAL_HPP
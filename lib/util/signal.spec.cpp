@@ -0,0 +1,82 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "util/signal.hpp"
+
+#include <doctest/doctest.h>
+
+#include <memory>
+#include <vector>
+
+using namespace arby;
+
+TEST_SUITE("util")
+{
+    TEST_CASE("signal")
+    {
+        auto sig   = util::signal< void(int) >();
+        auto calls = std::vector< int >();
+
+        auto c1 = sig.connect([&](int x) { calls.push_back(x); });
+        auto c2 = util::scoped_connection(sig.connect([&](int x) { calls.push_back(x * 10); }));
+        CHECK(sig.num_slots() == 2);
+
+        sig(1);
+        CHECK(calls == std::vector< int > { 1, 10 });
+
+        c1.disconnect();
+        CHECK_FALSE(c1.connected());
+        sig(2);
+        CHECK(calls == std::vector< int > { 1, 10, 20 });
+
+        {
+            auto moved = std::move(c2);
+        }
+        CHECK(sig.empty());
+        sig(3);
+        CHECK(calls.size() == 3);
+    }
+
+    TEST_CASE("signal reentrancy")
+    {
+        auto sig   = util::signal< void() >();
+        auto count = 0;
+        auto conns = std::vector< util::connection >();
+
+        // a slot which disconnects itself and connects another
+        auto self = util::connection();
+        self      = sig.connect(
+            [&]
+            {
+                ++count;
+                self.disconnect();
+                conns.push_back(sig.connect([&] { count += 100; }));
+            });
+
+        sig();
+        CHECK(count == 1);
+        sig();
+        CHECK(count == 101);
+        CHECK(sig.num_slots() == 1);
+    }
+
+    TEST_CASE("signal connection outlives signal")
+    {
+        auto captured = std::make_shared< int >(0);
+        auto conn     = util::connection();
+        {
+            auto sig = util::signal< void() >();
+            conn     = sig.connect([captured] { ++*captured; });
+            CHECK(conn.connected());
+        }
+        CHECK_FALSE(conn.connected());
+        CHECK(captured.use_count() == 1);
+        conn.disconnect();
+    }
+}
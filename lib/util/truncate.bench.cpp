@@ -0,0 +1,36 @@
+//
+// Copyright (c) 2022 Richard Hodges (hodges.r@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/madmongo1/arby
+//
+
+#include "bench/bench.hpp"
+#include "util/truncate.hpp"
+
+#include <sstream>
+#include <string>
+
+using namespace arby;
+
+// inputs either side of the default limit of 256
+ARBY_BENCHMARK("truncate/to_string", 64, 256, 4096)
+{
+    auto s = std::string(state.arg(), 'x');
+    for (auto _ : state)
+        bench::do_not_optimize(to_string(util::truncate(s)));
+}
+
+ARBY_BENCHMARK("truncate/stream", 64, 256, 4096)
+{
+    auto s  = std::string(state.arg(), 'x');
+    auto os = std::ostringstream();
+    for (auto _ : state)
+    {
+        os.str({});
+        os << util::truncate(s);
+    }
+    bench::do_not_optimize(os.str());
+}